@@ -73,6 +73,103 @@ func (bf *BitcoinBloomFilter) finalizer() {
 	// No-op for disabled builds
 }
 
+// KeyBatch is a batch of fixed-width keys for one FFI call (disabled for non-CGO builds)
+type KeyBatch struct {
+	disabled bool
+}
+
+// UTXOKeySize is the width of a txid || little-endian vout key
+const UTXOKeySize = 36
+
+// Mode flags for NewBitcoinBloomFilterProper, mirroring BLOOM_FLAG_* in bloom_filter.h
+const (
+	BloomFlagBlocked  = 0x04
+	BloomFlagFastHash = 0x08
+	BloomFlagLean     = 0x10
+)
+
+// NewKeyBatch creates a key batch (disabled in non-CGO builds)
+func NewKeyBatch(stride, capacity int) *KeyBatch {
+	return &KeyBatch{disabled: true}
+}
+
+func (b *KeyBatch) Add(key []byte) error {
+	return errors.New("Bitcoin Bloom filter not available in non-CGO builds")
+}
+
+func (b *KeyBatch) AddUTXO(txHash []byte, outputIndex uint32) error {
+	return errors.New("Bitcoin Bloom filter not available in non-CGO builds")
+}
+
+func (b *KeyBatch) Len() int {
+	return 0
+}
+
+func (b *KeyBatch) Hit(i int) bool {
+	return false
+}
+
+func (b *KeyBatch) Hits() int {
+	return 0
+}
+
+func (b *KeyBatch) Reset() {
+	// No-op for disabled builds
+}
+
+// BitcoinBloomFilterProper is the universal-filter binding (disabled for non-CGO builds)
+type BitcoinBloomFilterProper struct {
+	disabled bool
+}
+
+// NewBitcoinBloomFilterProper creates a Bitcoin Bloom filter (disabled in non-CGO builds)
+func NewBitcoinBloomFilterProper(sizeBits uint64, numHashes uint8, tweak uint32, flags uint8, maxAgeSeconds uint64, batchSize uint64) (*BitcoinBloomFilterProper, error) {
+	return nil, errors.New("Bitcoin Bloom filter not available in non-CGO builds")
+}
+
+func (bf *BitcoinBloomFilterProper) InsertBatch(b *KeyBatch) error {
+	return errors.New("Bitcoin Bloom filter not available in non-CGO builds")
+}
+
+func (bf *BitcoinBloomFilterProper) ContainsBatch(b *KeyBatch) (int, error) {
+	return 0, errors.New("Bitcoin Bloom filter not available in non-CGO builds")
+}
+
+// SeenSet is the relay deduplication set (disabled for non-CGO builds)
+type SeenSet struct {
+	disabled bool
+}
+
+// SeenSetStats contains seen-set counters
+type SeenSetStats struct {
+	Queries               uint64 `json:"queries"`
+	Duplicates            uint64 `json:"duplicates"`
+	FalsePositivesAvoided uint64 `json:"false_positives_avoided"`
+	Rotations             uint64 `json:"rotations"`
+	CachedKeys            uint64 `json:"cached_keys"`
+}
+
+// NewSeenSet creates a seen-set (disabled in non-CGO builds)
+func NewSeenSet(network string, sizeBits uint64, numHashes uint8, windowSeconds uint64, generations uint8, cacheEntries uint64) (*SeenSet, error) {
+	return nil, errors.New("seen-set not available in non-CGO builds")
+}
+
+func (s *SeenSet) TestAndInsert(key []byte) (bool, error) {
+	return false, errors.New("seen-set not available in non-CGO builds")
+}
+
+func (s *SeenSet) TestAndInsertBatch(b *KeyBatch) (int, error) {
+	return 0, errors.New("seen-set not available in non-CGO builds")
+}
+
+func (s *SeenSet) GetStats() (*SeenSetStats, error) {
+	return &SeenSetStats{}, errors.New("seen-set not available in non-CGO builds")
+}
+
+func (s *SeenSet) Free() {
+	// No-op for disabled builds
+}
+
 // UTXOEntry represents a UTXO entry for batch operations
 type UTXOEntry struct {
 	TxHash       []byte `json:"tx_hash"`
@@ -119,6 +119,134 @@ func (bf *BitcoinBloomFilterProper) ContainsUTXO(txHash []byte, outputIndex uint
 	return bool(result), nil
 }
 
+// KeyBatch is a reusable buffer of fixed-width keys sent to the filter in a single
+// cgo call; per-key calls pay the Go/C crossing on every lookup
+type KeyBatch struct {
+	stride int
+	keys   []byte
+	count  int
+	bitmap []byte
+	hits   int
+}
+
+// UTXOKeySize is the width of a txid || little-endian vout key
+const UTXOKeySize = 36
+
+// Mode flags for NewBitcoinBloomFilterProper, mirroring BLOOM_FLAG_* in bloom_filter.h
+const (
+	BloomFlagBlocked  = C.BLOOM_FLAG_BLOCKED
+	BloomFlagFastHash = C.BLOOM_FLAG_FAST_HASH
+	BloomFlagLean     = C.BLOOM_FLAG_LEAN
+)
+
+// NewKeyBatch allocates a batch of stride-byte keys with room for capacity keys
+func NewKeyBatch(stride, capacity int) *KeyBatch {
+	return &KeyBatch{
+		stride: stride,
+		keys:   make([]byte, 0, stride*capacity),
+		bitmap: make([]byte, 0, (capacity+7)/8),
+	}
+}
+
+// Add appends a key, which must be exactly the batch stride
+func (b *KeyBatch) Add(key []byte) error {
+	if len(key) != b.stride {
+		return fmt.Errorf("key is %d bytes, batch stride is %d", len(key), b.stride)
+	}
+	b.keys = append(b.keys, key...)
+	b.count++
+	return nil
+}
+
+// AddUTXO appends the same txid || vout key InsertUTXO builds, without allocating
+func (b *KeyBatch) AddUTXO(txHash []byte, outputIndex uint32) error {
+	if len(txHash)+4 != b.stride {
+		return fmt.Errorf("UTXO key is %d bytes, batch stride is %d", len(txHash)+4, b.stride)
+	}
+	b.keys = append(b.keys, txHash...)
+	b.keys = append(b.keys, byte(outputIndex), byte(outputIndex>>8), byte(outputIndex>>16), byte(outputIndex>>24))
+	b.count++
+	return nil
+}
+
+// Len returns the number of keys in the batch
+func (b *KeyBatch) Len() int {
+	return b.count
+}
+
+// Hit reports key i's result from the last ContainsBatch
+func (b *KeyBatch) Hit(i int) bool {
+	return i < b.count && i/8 < len(b.bitmap) && b.bitmap[i/8]&(1<<(i%8)) != 0
+}
+
+// Hits returns the number of hits from the last ContainsBatch
+func (b *KeyBatch) Hits() int {
+	return b.hits
+}
+
+// Reset empties the batch, keeping its buffers for reuse
+func (b *KeyBatch) Reset() {
+	b.keys = b.keys[:0]
+	b.bitmap = b.bitmap[:0]
+	b.count = 0
+	b.hits = 0
+}
+
+// InsertBatch adds every key in the batch with one FFI call
+func (bf *BitcoinBloomFilterProper) InsertBatch(b *KeyBatch) error {
+	if bf.handle == nil {
+		return errors.New("bloom filter is null")
+	}
+	if b.count == 0 {
+		return nil
+	}
+
+	result := C.bloom_filter_insert_batch(
+		(*C.UniversalBloomFilter)(bf.handle),
+		(*C.uint8_t)(unsafe.Pointer(&b.keys[0])),
+		C.uint64_t(b.stride),
+		C.uint64_t(b.count),
+	)
+	runtime.KeepAlive(bf)
+
+	if !result {
+		return errors.New("failed to insert batch into bloom filter")
+	}
+	return nil
+}
+
+// ContainsBatch looks up every key in the batch with one FFI call; read results
+// with Hit. Returns the number of keys that might be present.
+func (bf *BitcoinBloomFilterProper) ContainsBatch(b *KeyBatch) (int, error) {
+	if bf.handle == nil {
+		return 0, errors.New("bloom filter is null")
+	}
+	if n := (b.count + 7) / 8; n <= cap(b.bitmap) {
+		b.bitmap = b.bitmap[:n]
+	} else {
+		b.bitmap = make([]byte, n)
+	}
+	b.hits = 0
+	if b.count == 0 {
+		return 0, nil
+	}
+
+	hits := C.bloom_filter_contains_batch(
+		(*C.UniversalBloomFilter)(bf.handle),
+		(*C.uint8_t)(unsafe.Pointer(&b.keys[0])),
+		C.uint64_t(b.stride),
+		C.uint64_t(b.count),
+		(*C.uint8_t)(unsafe.Pointer(&b.bitmap[0])),
+	)
+	runtime.KeepAlive(bf)
+
+	if hits < 0 {
+		return 0, errors.New("failed to query batch against bloom filter")
+	}
+	b.hits = int(hits)
+	return b.hits, nil
+}
+
 // GetStats returns bloom filter statistics
 func (bf *BitcoinBloomFilterProper) GetStats() (*BloomFilterStatsProper, error) {
 	if bf.handle == nil {
@@ -151,3 +279,126 @@ func (bf *BitcoinBloomFilterProper) finalizer() {
 		bf.handle = nil
 	}
 }
+
+// SeenSet is the relay deduplication set: a windowed Bloom filter plus an exact cache
+// of recent keys, recording a key and reporting whether it was seen in one call
+type SeenSet struct {
+	handle unsafe.Pointer
+}
+
+// SeenSetStats contains seen-set counters
+type SeenSetStats struct {
+	Queries               uint64 `json:"queries"`
+	Duplicates            uint64 `json:"duplicates"`
+	FalsePositivesAvoided uint64 `json:"false_positives_avoided"`
+	Rotations             uint64 `json:"rotations"`
+	CachedKeys            uint64 `json:"cached_keys"`
+}
+
+// NewSeenSet creates a seen-set over a sliding window of windowSeconds, split into
+// generations (at least 2) of sizeBits each, with an exact cache of cacheEntries keys
+func NewSeenSet(network string, sizeBits uint64, numHashes uint8, windowSeconds uint64, generations uint8, cacheEntries uint64) (*SeenSet, error) {
+	config := C.BloomConfig{
+		network:         C.CString(network),
+		size:            C.uint64_t(sizeBits),
+		num_hashes:      C.uint8_t(numHashes),
+		flags:           C.BLOOM_FLAG_BLOCKED,
+		max_age_seconds: C.uint64_t(windowSeconds),
+		batch_size:      1000,
+		generations:     C.uint8_t(generations),
+	}
+
+	var err C.BloomFilterErrorCode
+	handle := C.bloom_seen_new(&config, C.uint64_t(cacheEntries), &err)
+	C.free(unsafe.Pointer(config.network))
+
+	if handle == nil || err != C.BLOOM_OK {
+		return nil, fmt.Errorf("failed to create seen-set: error code %d", err)
+	}
+
+	seen := &SeenSet{handle: unsafe.Pointer(handle)}
+	runtime.SetFinalizer(seen, (*SeenSet).Free)
+	return seen, nil
+}
+
+// TestAndInsert records key and reports whether it was already seen within the window
+func (s *SeenSet) TestAndInsert(key []byte) (bool, error) {
+	if s.handle == nil {
+		return false, errors.New("seen-set is null")
+	}
+	if len(key) == 0 {
+		return false, errors.New("key cannot be empty")
+	}
+
+	result := C.bloom_seen_test_and_insert(
+		(*C.BloomSeenSet)(s.handle),
+		(*C.uint8_t)(unsafe.Pointer(&key[0])),
+		C.uint64_t(len(key)),
+	)
+	runtime.KeepAlive(s)
+
+	if result < 0 {
+		return false, errors.New("seen-set test-and-insert failed")
+	}
+	return result == 1, nil
+}
+
+// TestAndInsertBatch records every key in the batch with one FFI call; Hit(i) then
+// reports whether key i was a duplicate. Returns the number of duplicates.
+func (s *SeenSet) TestAndInsertBatch(b *KeyBatch) (int, error) {
+	if s.handle == nil {
+		return 0, errors.New("seen-set is null")
+	}
+	if n := (b.count + 7) / 8; n <= cap(b.bitmap) {
+		b.bitmap = b.bitmap[:n]
+	} else {
+		b.bitmap = make([]byte, n)
+	}
+	b.hits = 0
+	if b.count == 0 {
+		return 0, nil
+	}
+
+	dups := C.bloom_seen_test_and_insert_batch(
+		(*C.BloomSeenSet)(s.handle),
+		(*C.uint8_t)(unsafe.Pointer(&b.keys[0])),
+		C.uint64_t(b.stride),
+		C.uint64_t(b.count),
+		(*C.uint8_t)(unsafe.Pointer(&b.bitmap[0])),
+	)
+	runtime.KeepAlive(s)
+
+	if dups < 0 {
+		return 0, errors.New("seen-set batch test-and-insert failed")
+	}
+	b.hits = int(dups)
+	return b.hits, nil
+}
+
+// GetStats returns the seen-set counters
+func (s *SeenSet) GetStats() (*SeenSetStats, error) {
+	if s.handle == nil {
+		return nil, errors.New("seen-set is null")
+	}
+
+	var stats C.BloomSeenStats
+	if !C.bloom_seen_stats((*C.BloomSeenSet)(s.handle), &stats) {
+		return nil, errors.New("failed to read seen-set stats")
+	}
+	return &SeenSetStats{
+		Queries:               uint64(stats.queries),
+		Duplicates:            uint64(stats.duplicates),
+		FalsePositivesAvoided: uint64(stats.false_positives_avoided),
+		Rotations:             uint64(stats.rotations),
+		CachedKeys:            uint64(stats.cached_keys),
+	}, nil
+}
+
+// Free releases the seen-set
+func (s *SeenSet) Free() {
+	if s.handle != nil {
+		C.bloom_seen_free((*C.BloomSeenSet)(s.handle))
+		s.handle = nil
+		runtime.SetFinalizer(s, nil)
+	}
+}
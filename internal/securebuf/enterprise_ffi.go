@@ -15,9 +15,11 @@ package securebuf
 */
 import "C"
 import (
+	"context"
 	"errors"
 	"fmt"
 	"runtime"
+	"time"
 	"unsafe"
 )
 
@@ -47,6 +49,30 @@ type EnterpriseBuffer struct {
 	securityLevel SecurityLevel
 }
 
+// NewKeyBuffer copies key into a new buffer, e.g. to key HMACInto or SignHMACSHA256
+func NewKeyBuffer(key []byte) (*Buffer, error) {
+	if len(key) == 0 {
+		return nil, errors.New("invalid key: must not be empty")
+	}
+
+	handle := C.securebuffer_new(C.size_t(len(key)))
+	if handle == nil {
+		return nil, errors.New("failed to allocate key buffer")
+	}
+	if result := C.securebuffer_copy(handle, (*C.uint8_t)(unsafe.Pointer(&key[0])), C.size_t(len(key))); result != C.SECUREBUFFER_SUCCESS {
+		C.securebuffer_free(handle)
+		return nil, fmt.Errorf("failed to load key: error %d", result)
+	}
+
+	buffer := &Buffer{
+		handle: C.SecureBufferHandle(handle),
+		locked: false,
+	}
+
+	runtime.SetFinalizer(buffer, (*Buffer).finalizer)
+	return buffer, nil
+}
+
 // NewWithSecurityLevel creates a new secure buffer with specified security level
 func NewWithSecurityLevel(capacity int, level SecurityLevel) (*EnterpriseBuffer, error) {
 	if capacity <= 0 {
@@ -218,54 +244,132 @@ func (b *Buffer) RefreshEntropy() error {
 
 // HMACHex computes HMAC and returns hex string
 func (b *Buffer) HMACHex(data []byte) (string, error) {
-	if b == nil || b.handle == nil {
-		return "", errors.New("buffer is nil or freed")
+	var out [C.SECUREBUFFER_HMAC_HEX_SIZE]byte
+	n, err := b.hmacInto(data, out[:], hmacHex)
+	if err != nil {
+		return "", err
 	}
+	return string(out[:n]), nil
+}
 
-	var dataPtr *C.uint8_t
-	if len(data) > 0 {
-		dataPtr = (*C.uint8_t)(unsafe.Pointer(&data[0]))
+// HMACBase64URL computes HMAC and returns base64url string
+func (b *Buffer) HMACBase64URL(data []byte) (string, error) {
+	var out [C.SECUREBUFFER_HMAC_BASE64URL_SIZE]byte
+	n, err := b.hmacInto(data, out[:], hmacBase64URL)
+	if err != nil {
+		return "", err
 	}
+	return string(out[:n]), nil
+}
 
-	cResult := C.securebuffer_hmac_hex(
-		(*C.SecureBuffer)(unsafe.Pointer(b.handle)),
-		dataPtr,
-		C.size_t(len(data)),
-	)
-
-	if cResult == nil {
-		return "", errors.New("failed to compute HMAC")
-	}
+// HMACInto writes the raw 32-byte HMAC into out and returns the bytes written.
+// Nothing is allocated on either side of the FFI.
+func (b *Buffer) HMACInto(data, out []byte) (int, error) {
+	return b.hmacInto(data, out, hmacRaw)
+}
 
-	result := C.GoString(cResult)
-	C.securebuffer_free_cstr(cResult)
-	return result, nil
+// HMACHexInto writes the 64-character hex HMAC into out and returns its length
+func (b *Buffer) HMACHexInto(data, out []byte) (int, error) {
+	return b.hmacInto(data, out, hmacHex)
 }
 
-// HMACBase64URL computes HMAC and returns base64url string
-func (b *Buffer) HMACBase64URL(data []byte) (string, error) {
+type hmacEncoding int
+
+const (
+	hmacRaw hmacEncoding = iota
+	hmacHex
+	hmacBase64URL
+)
+
+func (b *Buffer) hmacInto(data, out []byte, encoding hmacEncoding) (int, error) {
 	if b == nil || b.handle == nil {
-		return "", errors.New("buffer is nil or freed")
+		return 0, errors.New("buffer is nil or freed")
+	}
+	if len(data) == 0 || len(out) == 0 {
+		return 0, errors.New("failed to compute HMAC")
+	}
+
+	buf := (*C.SecureBuffer)(unsafe.Pointer(b.handle))
+	dataPtr := (*C.uint8_t)(unsafe.Pointer(&data[0]))
+	var outLen C.size_t
+	var result C.SecureBufferError
+	switch encoding {
+	case hmacHex:
+		result = C.securebuffer_hmac_hex_into(buf, dataPtr, C.size_t(len(data)), (*C.char)(unsafe.Pointer(&out[0])), C.size_t(len(out)), &outLen)
+	case hmacBase64URL:
+		result = C.securebuffer_hmac_base64url_into(buf, dataPtr, C.size_t(len(data)), (*C.char)(unsafe.Pointer(&out[0])), C.size_t(len(out)), &outLen)
+	default:
+		result = C.securebuffer_hmac_into(buf, dataPtr, C.size_t(len(data)), (*C.uint8_t)(unsafe.Pointer(&out[0])), C.size_t(len(out)), &outLen)
+	}
+	runtime.KeepAlive(b)
+
+	switch result {
+	case C.SECUREBUFFER_SUCCESS:
+		return int(outLen), nil
+	case C.SECUREBUFFER_ERROR_BUFFER_OVERFLOW:
+		return 0, fmt.Errorf("HMAC output needs %d bytes, have %d", outLen, len(out))
+	default:
+		return 0, errors.New("failed to compute HMAC")
 	}
+}
 
-	var dataPtr *C.uint8_t
-	if len(data) > 0 {
-		dataPtr = (*C.uint8_t)(unsafe.Pointer(&data[0]))
+// SignHMACSHA256 returns HMAC-SHA256(key = buffer contents, message) in one lock-free
+// call. It may run on any number of goroutines while RotateKey replaces the key.
+func (b *Buffer) SignHMACSHA256(message []byte) ([32]byte, error) {
+	var digest [32]byte
+	if b == nil || b.handle == nil {
+		return digest, errors.New("buffer is nil or freed")
 	}
+	var msg *C.uint8_t
+	if len(message) > 0 {
+		msg = (*C.uint8_t)(unsafe.Pointer(&message[0]))
+	}
+	result := C.securebuffer_sign_hmac_sha256_into((*C.SecureBuffer)(unsafe.Pointer(b.handle)), msg, C.size_t(len(message)), (*C.uint8_t)(unsafe.Pointer(&digest[0])))
+	runtime.KeepAlive(b)
+	if result != C.SECUREBUFFER_SUCCESS {
+		return digest, errors.New("failed to compute HMAC")
+	}
+	return digest, nil
+}
 
-	cResult := C.securebuffer_hmac_base64url(
-		(*C.SecureBuffer)(unsafe.Pointer(b.handle)),
-		dataPtr,
-		C.size_t(len(data)),
-	)
-
-	if cResult == nil {
-		return "", errors.New("failed to compute HMAC")
+// ReadConsistent copies the contents into out as of a single key version, without
+// taking the buffer's read lock
+func (b *Buffer) ReadConsistent(out []byte) (int, error) {
+	if b == nil || b.handle == nil {
+		return 0, errors.New("buffer is nil or freed")
+	}
+	var dst *C.uint8_t
+	if len(out) > 0 {
+		dst = (*C.uint8_t)(unsafe.Pointer(&out[0]))
+	} else {
+		var scratch C.uint8_t
+		dst = &scratch
+	}
+	var n C.size_t
+	result := C.securebuffer_read_consistent((*C.SecureBuffer)(unsafe.Pointer(b.handle)), dst, C.size_t(len(out)), &n)
+	runtime.KeepAlive(b)
+	switch result {
+	case C.SECUREBUFFER_SUCCESS:
+		return int(n), nil
+	case C.SECUREBUFFER_ERROR_BUFFER_OVERFLOW:
+		return 0, fmt.Errorf("buffer contents need %d bytes, have %d", n, len(out))
+	default:
+		return 0, fmt.Errorf("failed to read buffer: error %d", result)
 	}
+}
 
-	result := C.GoString(cResult)
-	C.securebuffer_free_cstr(cResult)
-	return result, nil
+// RotateKey replaces the contents with fresh random bytes of the same length,
+// published atomically to concurrent SignHMACSHA256 and ReadConsistent callers
+func (b *Buffer) RotateKey() error {
+	if b == nil || b.handle == nil {
+		return errors.New("buffer is nil or freed")
+	}
+	result := C.securebuffer_rotate_key((*C.SecureBuffer)(unsafe.Pointer(b.handle)))
+	runtime.KeepAlive(b)
+	if result != C.SECUREBUFFER_SUCCESS {
+		return fmt.Errorf("failed to rotate key: error %d", result)
+	}
+	return nil
 }
 
 // === HARDWARE-BACKED SECURITY ===
@@ -332,6 +436,26 @@ func (eb *EnterpriseBuffer) IsTampered() bool {
 	return bool(C.securebuffer_is_tampered((*C.SecureBuffer)(unsafe.Pointer(eb.Buffer.handle))))
 }
 
+// ScheduleIntegrityVerification verifies chunksPerTick 4 KiB chunks every interval on a
+// shared background thread, so IsTampered reflects out-of-band writes without a full
+// rehash per check. A zero interval cancels. Requires EnableTamperDetection.
+func (eb *EnterpriseBuffer) ScheduleIntegrityVerification(interval time.Duration, chunksPerTick int) error {
+	if eb == nil || eb.Buffer == nil || eb.Buffer.handle == nil {
+		return errors.New("buffer is nil or freed")
+	}
+	if interval < 0 || chunksPerTick < 0 {
+		return errors.New("invalid integrity verification schedule")
+	}
+
+	result := C.securebuffer_schedule_integrity_verification((*C.SecureBuffer)(unsafe.Pointer(eb.Buffer.handle)),
+		C.uint64_t(interval/time.Millisecond), C.size_t(chunksPerTick))
+	runtime.KeepAlive(eb)
+	if result != C.SECUREBUFFER_SUCCESS {
+		return fmt.Errorf("failed to schedule integrity verification: error %d", result)
+	}
+	return nil
+}
+
 // === AUDIT AND COMPLIANCE ===
 
 // GetSecurityAuditLog returns security audit log for the buffer
@@ -394,6 +518,32 @@ func IsAuditLoggingEnabled() bool {
 	return bool(C.securebuffer_is_audit_logging_enabled())
 }
 
+// AuditBackpressure selects what a goroutine's thread does when its audit queue is full
+type AuditBackpressure int
+
+const (
+	AuditDrop  AuditBackpressure = C.SECUREBUFFER_AUDIT_DROP
+	AuditBlock AuditBackpressure = C.SECUREBUFFER_AUDIT_BLOCK
+)
+
+// SetAuditBackpressure chooses between dropping audit records (counted) and waiting
+func SetAuditBackpressure(policy AuditBackpressure) error {
+	result := C.securebuffer_set_audit_backpressure(C.SecureBufferAuditBackpressure(policy))
+	if result != C.SECUREBUFFER_SUCCESS {
+		return fmt.Errorf("failed to set audit backpressure: error %d", result)
+	}
+	return nil
+}
+
+// FlushAuditLog writes and syncs every audit record queued so far
+func FlushAuditLog() error {
+	result := C.securebuffer_flush_audit_log()
+	if result != C.SECUREBUFFER_SUCCESS {
+		return fmt.Errorf("failed to flush audit log: error %d", result)
+	}
+	return nil
+}
+
 // GetComplianceReport returns global compliance report
 func GetComplianceReport() (string, error) {
 	cResult := C.securebuffer_get_compliance_report()
@@ -419,6 +569,145 @@ func SetEnterprisePolicy(policyJSON string) error {
 	return nil
 }
 
+// === KEY DERIVATION ===
+
+// ErrKDFQueueFull is returned when a KDFService already has max queued derivations
+var ErrKDFQueueFull = errors.New("key derivation queue is full")
+
+// KDFService runs PBKDF2-HMAC-SHA256 on a fixed pool of Rust worker threads, so
+// expensive derivations never occupy Go's OS threads or stall request handlers
+type KDFService struct {
+	handle *C.SecureKdfService
+}
+
+// NewKDFService starts workers threads (0 = half the cores) that accept at most maxQueue
+// waiting derivations of at most maxIterations each (0 = library default)
+func NewKDFService(workers, maxQueue int, maxIterations uint32) (*KDFService, error) {
+	if workers < 0 || maxQueue <= 0 {
+		return nil, errors.New("invalid KDF service parameters")
+	}
+
+	handle := C.securebuffer_kdf_service_new(C.size_t(workers), C.size_t(maxQueue), C.uint32_t(maxIterations))
+	if handle == nil {
+		return nil, errors.New("failed to start KDF service")
+	}
+
+	s := &KDFService{handle: handle}
+	runtime.SetFinalizer(s, (*KDFService).Close)
+	return s, nil
+}
+
+// DeriveKey derives keyLen bytes into a new Buffer. Completion is polled with a short
+// backoff rather than a blocking wait; if ctx ends first the derivation is abandoned.
+func (s *KDFService) DeriveKey(ctx context.Context, password, salt []byte, iterations uint32, keyLen int) (*Buffer, error) {
+	if s == nil || s.handle == nil {
+		return nil, errors.New("KDF service is closed")
+	}
+	out, err := New(keyLen)
+	if err != nil {
+		return nil, err
+	}
+
+	var pw, sl *C.uint8_t
+	if len(password) > 0 {
+		pw = (*C.uint8_t)(unsafe.Pointer(&password[0]))
+	}
+	if len(salt) > 0 {
+		sl = (*C.uint8_t)(unsafe.Pointer(&salt[0]))
+	}
+	var job *C.SecureKdfJob
+	result := C.securebuffer_kdf_submit(s.handle, pw, C.size_t(len(password)), sl, C.size_t(len(salt)),
+		C.uint32_t(iterations), C.size_t(keyLen), nil, nil, &job)
+	runtime.KeepAlive(s)
+	switch result {
+	case C.SECUREBUFFER_SUCCESS:
+	case C.SECUREBUFFER_ERROR_QUEUE_FULL:
+		return nil, ErrKDFQueueFull
+	case C.SECUREBUFFER_ERROR_POLICY_VIOLATION:
+		return nil, fmt.Errorf("key derivation iterations %d exceed the service limit", iterations)
+	default:
+		return nil, fmt.Errorf("failed to submit key derivation: error %d", result)
+	}
+	defer C.securebuffer_kdf_job_free(job)
+
+	delay := 200 * time.Microsecond
+	timer := time.NewTimer(delay)
+	defer timer.Stop()
+	for C.securebuffer_kdf_poll(job) == 0 {
+		select {
+		case <-ctx.Done():
+			return nil, ctx.Err()
+		case <-timer.C:
+		}
+		if delay < 5*time.Millisecond {
+			delay *= 2
+		}
+		timer.Reset(delay)
+	}
+
+	result = C.securebuffer_kdf_take(job, (*C.SecureBuffer)(unsafe.Pointer(out.handle)))
+	runtime.KeepAlive(out)
+	if result != C.SECUREBUFFER_SUCCESS {
+		return nil, fmt.Errorf("failed to collect derived key: error %d", result)
+	}
+	return out, nil
+}
+
+// Close stops the service once queued derivations finish
+func (s *KDFService) Close() {
+	if s != nil && s.handle != nil {
+		C.securebuffer_kdf_service_free(s.handle)
+		s.handle = nil
+		runtime.SetFinalizer(s, nil)
+	}
+}
+
+// === OPERATION METRICS ===
+
+// Op identifies an operation with a latency histogram
+type Op int
+
+const (
+	OpAlloc         Op = C.SECUREBUFFER_OP_ALLOC
+	OpHMAC          Op = C.SECUREBUFFER_OP_HMAC
+	OpAEAD          Op = C.SECUREBUFFER_OP_AEAD
+	OpDerive        Op = C.SECUREBUFFER_OP_DERIVE
+	OpPoolSend      Op = C.SECUREBUFFER_OP_POOL_SEND
+	OpBloomInsert   Op = C.SECUREBUFFER_OP_BLOOM_INSERT
+	OpBloomContains Op = C.SECUREBUFFER_OP_BLOOM_CONTAINS
+	OpCount            = int(C.SECUREBUFFER_OP_COUNT)
+)
+
+// OpLatency is the process-wide latency of one operation. Samples counts the timed
+// calls behind the percentiles; Bloom operations time one call in 16.
+type OpLatency struct {
+	Count, Samples uint64
+	Sum, Max       time.Duration
+	P50, P99, P999 time.Duration
+}
+
+// OperationLatencies returns per-operation latency, indexed by Op. The library merges
+// its per-thread histograms without allocating, so this is cheap to poll.
+func OperationLatencies() ([OpCount]OpLatency, error) {
+	var snapshot C.SecureBufferMetricsSnapshot
+	var out [OpCount]OpLatency
+	if result := C.securebuffer_get_metrics_snapshot(&snapshot); result != C.SECUREBUFFER_SUCCESS {
+		return out, fmt.Errorf("failed to read metrics snapshot: error %d", result)
+	}
+	for i, op := range snapshot.ops {
+		out[i] = OpLatency{
+			Count:   uint64(op.count),
+			Samples: uint64(op.samples),
+			Sum:     time.Duration(op.sum_ns),
+			Max:     time.Duration(op.max_ns),
+			P50:     time.Duration(op.p50_ns),
+			P99:     time.Duration(op.p99_ns),
+			P999:    time.Duration(op.p999_ns),
+		}
+	}
+	return out, nil
+}
+
 // === DIRECT ENTROPY FUNCTIONS ===
 
 // FastEntropy returns 32 bytes of fast entropy
@@ -431,6 +720,19 @@ func FastEntropy() ([]byte, error) {
 	return output, nil
 }
 
+// FillEntropy fills p from the calling thread's entropy reservoir. Intended for
+// nonces and session IDs on hot paths; it does not make a syscall per call.
+func FillEntropy(p []byte) error {
+	if len(p) == 0 {
+		return nil
+	}
+	result := C.securebuffer_fill_entropy((*C.uint8_t)(unsafe.Pointer(&p[0])), C.size_t(len(p)))
+	if result != C.SECUREBUFFER_SUCCESS {
+		return fmt.Errorf("failed to fill entropy: error %d", result)
+	}
+	return nil
+}
+
 // HybridEntropy returns entropy using Bitcoin headers
 func HybridEntropy(blockHeaders [][]byte) ([]byte, error) {
 	output := make([]byte, 32)
@@ -0,0 +1,184 @@
+//go:build cgo
+// +build cgo
+
+package securebuf
+
+// cgo side of the FFI benchmark suite. The Rust example ffi_bench times the same entry
+// points from native code; the difference between the two is the cost of crossing from
+// Go. Run with:
+//
+//	go test -run '^$' -bench . -benchmem ./internal/securebuf | tee new.txt
+//	benchstat old.txt new.txt
+
+import (
+	"encoding/binary"
+	"fmt"
+	"testing"
+)
+
+const benchKeys = 1 << 14
+
+func benchKeyBuffer(b *testing.B) *Buffer {
+	buf, err := NewKeyBuffer(benchOutpoints(1)[0][:32])
+	if err != nil {
+		b.Fatal(err)
+	}
+	return buf
+}
+
+// benchOutpoints returns n txid || vout keys from a fixed-seed generator
+func benchOutpoints(n int) [][]byte {
+	state := uint64(0x9e3779b97f4a7c15)
+	keys := make([][]byte, n)
+	for i := range keys {
+		key := make([]byte, UTXOKeySize)
+		for off := 0; off < 32; off += 8 {
+			state ^= state >> 12
+			state ^= state << 25
+			state ^= state >> 27
+			binary.LittleEndian.PutUint64(key[off:], state*0x2545f4914f6cdd1d)
+		}
+		binary.LittleEndian.PutUint32(key[32:], uint32(i))
+		keys[i] = key
+	}
+	return keys
+}
+
+//go:noinline
+func goCallBaseline(b *Buffer) int {
+	if b == nil {
+		return 0
+	}
+	return 1
+}
+
+// BenchmarkCrossing compares a trivial cgo call with a plain Go call
+func BenchmarkCrossing(b *testing.B) {
+	buf := benchKeyBuffer(b)
+	b.Run("go", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			goCallBaseline(buf)
+		}
+	})
+	b.Run("cgo", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			buf.Len()
+		}
+	})
+}
+
+func BenchmarkHMAC(b *testing.B) {
+	buf := benchKeyBuffer(b)
+	out := make([]byte, 32)
+	for _, size := range []int{64, 1024} {
+		msg := make([]byte, size)
+		b.Run(fmt.Sprintf("into/%d", size), func(b *testing.B) {
+			b.SetBytes(int64(size))
+			for i := 0; i < b.N; i++ {
+				if _, err := buf.HMACInto(msg, out); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+		b.Run(fmt.Sprintf("sign/%d", size), func(b *testing.B) {
+			b.SetBytes(int64(size))
+			for i := 0; i < b.N; i++ {
+				if _, err := buf.SignHMACSHA256(msg); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
+
+func BenchmarkFillEntropy(b *testing.B) {
+	for _, size := range []int{32, 4096} {
+		p := make([]byte, size)
+		b.Run(fmt.Sprint(size), func(b *testing.B) {
+			b.SetBytes(int64(size))
+			for i := 0; i < b.N; i++ {
+				if err := FillEntropy(p); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
+
+// BenchmarkBloom reports per-key cost of single calls against batches of each size
+func BenchmarkBloom(b *testing.B) {
+	filter, err := NewBitcoinBloomFilterProper(1<<23, 6, 0x5eed, BloomFlagBlocked|BloomFlagFastHash|BloomFlagLean, 86400, 0)
+	if err != nil {
+		b.Fatal(err)
+	}
+	defer filter.Free()
+	keys := benchOutpoints(benchKeys)
+	for _, key := range keys[:benchKeys/2] {
+		if err := filter.InsertUTXO(key[:32], binary.LittleEndian.Uint32(key[32:])); err != nil {
+			b.Fatal(err)
+		}
+	}
+
+	b.Run("contains/single", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			key := keys[i%benchKeys]
+			if _, err := filter.ContainsUTXO(key[:32], binary.LittleEndian.Uint32(key[32:])); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+	for _, size := range []int{16, 256, 4096} {
+		batch := NewKeyBatch(UTXOKeySize, size)
+		b.Run(fmt.Sprintf("contains/batch/%d", size), func(b *testing.B) {
+			for i := 0; i < b.N; i += size {
+				batch.Reset()
+				for j := 0; j < size; j++ {
+					_ = batch.Add(keys[(i+j)%benchKeys])
+				}
+				if _, err := filter.ContainsBatch(batch); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+		b.Run(fmt.Sprintf("insert/batch/%d", size), func(b *testing.B) {
+			for i := 0; i < b.N; i += size {
+				batch.Reset()
+				for j := 0; j < size; j++ {
+					_ = batch.Add(keys[(i+j)%benchKeys])
+				}
+				if err := filter.InsertBatch(batch); err != nil {
+					b.Fatal(err)
+				}
+			}
+		})
+	}
+}
+
+func BenchmarkSeenSet(b *testing.B) {
+	seen, err := NewSeenSet("bitcoin", 1<<20, 6, 600, 2, 4096)
+	if err != nil {
+		b.Fatal(err)
+	}
+	defer seen.Free()
+	keys := benchOutpoints(benchKeys)
+
+	b.Run("single", func(b *testing.B) {
+		for i := 0; i < b.N; i++ {
+			if _, err := seen.TestAndInsert(keys[i%benchKeys]); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+	b.Run("batch/256", func(b *testing.B) {
+		batch := NewKeyBatch(UTXOKeySize, 256)
+		for i := 0; i < b.N; i += 256 {
+			batch.Reset()
+			for j := 0; j < 256; j++ {
+				_ = batch.Add(keys[(i+j)%benchKeys])
+			}
+			if _, err := seen.TestAndInsertBatch(batch); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}
@@ -0,0 +1,172 @@
+//go:build cgo && linux
+// +build cgo,linux
+
+package securebuf
+
+// Shared-memory ring FFI
+// Zero-copy record hand-off between processes through a sealed memfd
+
+/*
+#include "../../secure/rust/include/securebuffer.h"
+#include <stdlib.h>
+#include <stdint.h>
+*/
+import "C"
+import (
+	"errors"
+	"fmt"
+	"math"
+	"runtime"
+	"time"
+	"unsafe"
+)
+
+// ErrRingFull is returned when a push finds no room before its timeout
+var ErrRingFull = errors.New("shared ring is full")
+
+// ErrRingCorrupt is returned by ReadBatch once a producer has written a record whose
+// length runs past the ring; the ring cannot be read past that point
+var ErrRingCorrupt = errors.New("shared ring holds a malformed record")
+
+// Ring is one process's mapping of a shared record ring. Any goroutine may push to a
+// ring created multi-producer; ReadBatch must only be called by the single consumer.
+type Ring struct {
+	handle   *C.SecureRing
+	batch    *C.SecureBufferIoVec // consumer-side scratch, batchLen entries
+	batchLen int
+}
+
+// NewRing creates a ring with capacity data bytes (a power of two, 4 KiB to 1 GiB).
+// Pass Fd() to the peer process, which maps the same pages with AttachRing.
+func NewRing(capacity int, multiProducer bool) (*Ring, error) {
+	handle := C.securebuffer_ring_create(C.size_t(capacity), C.bool(multiProducer))
+	if handle == nil {
+		return nil, fmt.Errorf("failed to create shared ring of %d bytes", capacity)
+	}
+	return newRing(handle), nil
+}
+
+// AttachRing maps a ring from an fd received from its creator. The fd is duplicated,
+// so the caller may close its copy.
+func AttachRing(fd int) (*Ring, error) {
+	handle := C.securebuffer_ring_attach(C.int(fd))
+	if handle == nil {
+		return nil, errors.New("fd is not a compatible shared ring")
+	}
+	return newRing(handle), nil
+}
+
+func newRing(handle *C.SecureRing) *Ring {
+	r := &Ring{handle: handle}
+	runtime.SetFinalizer(r, (*Ring).Close)
+	return r
+}
+
+// Fd returns the ring's memfd, valid until Close
+func (r *Ring) Fd() int {
+	fd := int(C.securebuffer_ring_fd(r.handle))
+	runtime.KeepAlive(r)
+	return fd
+}
+
+// ringTimeout maps timeout to the C convention: negative waits forever, zero never waits
+func ringTimeout(timeout time.Duration) C.uint64_t {
+	if timeout < 0 {
+		return C.uint64_t(math.MaxUint64)
+	}
+	return C.uint64_t(timeout / time.Millisecond)
+}
+
+// Push appends one record, waiting up to timeout for room
+func (r *Ring) Push(p []byte, timeout time.Duration) error {
+	return r.PushParts(timeout, p)
+}
+
+// PushParts appends the concatenation of parts as one record, e.g. a header and a
+// payload, without joining them in Go first
+func (r *Ring) PushParts(timeout time.Duration, parts ...[]byte) error {
+	if r == nil || r.handle == nil {
+		return errors.New("shared ring is closed")
+	}
+	var result C.SecureBufferError
+	if len(parts) == 1 {
+		var data *C.uint8_t
+		if len(parts[0]) > 0 {
+			data = (*C.uint8_t)(unsafe.Pointer(&parts[0][0]))
+		}
+		result = C.securebuffer_ring_push(r.handle, data, C.size_t(len(parts[0])), ringTimeout(timeout))
+	} else {
+		// C memory may only hold Go pointers that are pinned, so pin every part for the
+		// duration of the call before storing it in the C-allocated iovec array
+		var pinner runtime.Pinner
+		defer pinner.Unpin()
+		iov := (*C.SecureBufferIoVec)(C.malloc(C.size_t(len(parts)) * C.size_t(unsafe.Sizeof(C.SecureBufferIoVec{}))))
+		defer C.free(unsafe.Pointer(iov))
+		entries := unsafe.Slice(iov, len(parts))
+		for i, part := range parts {
+			entries[i].base, entries[i].len = nil, C.size_t(len(part))
+			if len(part) > 0 {
+				pinner.Pin(&part[0])
+				entries[i].base = (*C.uint8_t)(unsafe.Pointer(&part[0]))
+			}
+		}
+		result = C.securebuffer_ring_push_iov(r.handle, iov, C.size_t(len(parts)), ringTimeout(timeout))
+	}
+	runtime.KeepAlive(parts)
+	runtime.KeepAlive(r)
+	switch result {
+	case C.SECUREBUFFER_SUCCESS:
+		return nil
+	case C.SECUREBUFFER_ERROR_QUEUE_FULL:
+		return ErrRingFull
+	case C.SECUREBUFFER_ERROR_BUFFER_OVERFLOW:
+		return errors.New("record exceeds half the ring capacity")
+	default:
+		return fmt.Errorf("failed to push to shared ring: error %d", result)
+	}
+}
+
+// ReadBatch waits up to timeout for records and passes up to max of them to fn in order,
+// as slices of the shared mapping. The slices are wiped once fn returns for the last
+// record, so fn must copy anything it keeps. Returns 0 when the timeout expires.
+func (r *Ring) ReadBatch(max int, timeout time.Duration, fn func([]byte)) (int, error) {
+	if r == nil || r.handle == nil {
+		return 0, errors.New("shared ring is closed")
+	}
+	if max <= 0 {
+		return 0, nil
+	}
+	if max > r.batchLen {
+		C.free(unsafe.Pointer(r.batch))
+		r.batch = (*C.SecureBufferIoVec)(C.malloc(C.size_t(max) * C.size_t(unsafe.Sizeof(C.SecureBufferIoVec{}))))
+		r.batchLen = max
+	}
+
+	var count C.size_t
+	result := C.securebuffer_ring_read_batch(r.handle, r.batch, C.size_t(max), ringTimeout(timeout), &count)
+	switch result {
+	case C.SECUREBUFFER_SUCCESS:
+	case C.SECUREBUFFER_ERROR_EXPIRED:
+		return 0, nil
+	case C.SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED:
+		return 0, ErrRingCorrupt
+	default:
+		return 0, fmt.Errorf("failed to read shared ring: error %d", result)
+	}
+	defer C.securebuffer_ring_commit_read(r.handle)
+	for _, rec := range unsafe.Slice(r.batch, int(count)) {
+		fn(unsafe.Slice((*byte)(unsafe.Pointer(rec.base)), int(rec.len)))
+	}
+	runtime.KeepAlive(r)
+	return int(count), nil
+}
+
+// Close unmaps the ring; peers that still map it are unaffected
+func (r *Ring) Close() {
+	if r != nil && r.handle != nil {
+		C.securebuffer_ring_free(r.handle)
+		C.free(unsafe.Pointer(r.batch))
+		r.handle, r.batch, r.batchLen = nil, nil, 0
+		runtime.SetFinalizer(r, nil)
+	}
+}
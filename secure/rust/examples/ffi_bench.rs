@@ -0,0 +1,599 @@
+//! FFI benchmark suite: times the hot entry points of securebuffer.h and bloom_filter.h
+//! through their C ABI and writes one JSON document.
+//!
+//!   cargo run --release --example ffi_bench -- [--quick] [--filter bloom] [--cpu 2]
+//!       [--out results.json] [--baseline previous.json] [--threshold 10]
+//!
+//! Every case is calibrated to about `target` per sample, warmed up once and then sampled
+//! `samples` times; `ns_per_op` is the median sample, with the fastest and slowest beside it.
+//! Keys and messages come from a fixed-seed generator, so runs on one machine are comparable.
+//! Bloom cases are sized from the cache hierarchy in sysfs: filters that fit L1, L2, L3 and
+//! one several times larger than L3. With --baseline, cases whose median is more than
+//! `threshold` percent slower are listed and the process exits with status 2.
+//!
+//! Results are one object per line so two runs diff cleanly. The Go side of the boundary
+//! (cgo crossing cost) is covered by `go test -bench . ./internal/securebuf`.
+
+use std::ffi::CStr;
+use std::fmt::Write as _;
+use std::os::raw::c_char;
+use std::hint::black_box;
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
+
+use securebuffer::*;
+
+const BLOOM_FLAG_BLOCKED: u8 = 0x04;
+const BLOOM_FLAG_FAST_HASH: u8 = 0x08;
+const BLOOM_FLAG_LEAN: u8 = 0x10;
+const OUTPOINT_LEN: usize = 36;
+const BLOOM_BATCH: usize = 256;
+const HASH_SHA256: i32 = 0;
+const HASH_SHA512: i32 = 1;
+
+struct Options {
+    quick: bool,
+    filter: Option<String>,
+    cpu: Option<usize>,
+    out: Option<String>,
+    baseline: Option<String>,
+    threshold: f64,
+}
+
+impl Options {
+    fn parse() -> Self {
+        let mut options = Options { quick: false, filter: None, cpu: None, out: None, baseline: None, threshold: 10.0 };
+        let mut args = std::env::args().skip(1);
+        while let Some(arg) = args.next() {
+            let mut value = |name: &str| args.next().unwrap_or_else(|| usage(&format!("{} needs a value", name)));
+            match arg.as_str() {
+                "--quick" => options.quick = true,
+                "--filter" => options.filter = Some(value("--filter")),
+                "--cpu" => options.cpu = Some(value("--cpu").parse().unwrap_or_else(|_| usage("--cpu takes a CPU number"))),
+                "--out" => options.out = Some(value("--out")),
+                "--baseline" => options.baseline = Some(value("--baseline")),
+                "--threshold" => {
+                    options.threshold = value("--threshold").parse().unwrap_or_else(|_| usage("--threshold takes a percentage"))
+                }
+                "--bench" => {} // passed through by `cargo bench`-style runners
+                other => usage(&format!("unknown argument {}", other)),
+            }
+        }
+        options
+    }
+}
+
+fn usage(message: &str) -> ! {
+    eprintln!("ffi_bench: {}", message);
+    eprintln!("usage: ffi_bench [--quick] [--filter SUBSTR] [--cpu N] [--out FILE] [--baseline FILE] [--threshold PCT]");
+    std::process::exit(1)
+}
+
+/// One measured case
+struct Record {
+    group: &'static str,
+    name: String,
+    params: Vec<(&'static str, u64)>,
+    iterations: u64,
+    samples: Vec<f64>,
+    items_per_op: u64,
+    bytes_per_op: u64,
+}
+
+impl Record {
+    fn median(&self) -> f64 {
+        self.samples[self.samples.len() / 2]
+    }
+
+    fn to_json(&self) -> String {
+        let median = self.median();
+        let mut params = String::new();
+        for (i, (key, value)) in self.params.iter().enumerate() {
+            let _ = write!(params, "{}\"{}\":{}", if i > 0 { "," } else { "" }, key, value);
+        }
+        let mut line = format!(
+            "{{\"group\":\"{}\",\"name\":\"{}\",\"params\":{{{}}},\"iterations\":{},\"samples\":{},\"ns_per_op\":{:.2},\"ns_per_op_min\":{:.2},\"ns_per_op_max\":{:.2}",
+            self.group,
+            self.name,
+            params,
+            self.iterations,
+            self.samples.len(),
+            median,
+            self.samples[0],
+            self.samples[self.samples.len() - 1],
+        );
+        if self.items_per_op > 1 {
+            let _ = write!(line, ",\"ns_per_item\":{:.2}", median / self.items_per_op as f64);
+        }
+        let _ = write!(line, ",\"items_per_sec\":{:.0}", self.items_per_op as f64 * 1e9 / median);
+        if self.bytes_per_op > 0 {
+            let _ = write!(line, ",\"bytes_per_sec\":{:.0}", self.bytes_per_op as f64 * 1e9 / median);
+        }
+        line.push('}');
+        line
+    }
+}
+
+struct Bench {
+    filter: Option<String>,
+    target: Duration,
+    samples: usize,
+    records: Vec<Record>,
+}
+
+impl Bench {
+    fn enabled(&self, name: &str) -> bool {
+        self.filter.as_deref().map_or(true, |f| name.contains(f))
+    }
+
+    /// Time `op`, which performs one operation of `items_per_op` items and `bytes_per_op` bytes
+    fn run(
+        &mut self,
+        group: &'static str,
+        name: String,
+        params: &[(&'static str, u64)],
+        items_per_op: u64,
+        bytes_per_op: u64,
+        mut op: impl FnMut(),
+    ) {
+        if !self.enabled(&name) {
+            return;
+        }
+
+        // Calibrate: grow the batch until one sample takes a measurable slice of the target
+        let mut iterations: u64 = 1;
+        loop {
+            let start = Instant::now();
+            for _ in 0..iterations {
+                op();
+            }
+            let elapsed = start.elapsed();
+            if elapsed >= self.target / 4 || iterations >= 1 << 32 {
+                let per_op = elapsed.as_nanos().max(1) as f64 / iterations as f64;
+                iterations = ((self.target.as_nanos() as f64 / per_op) as u64).max(1);
+                break;
+            }
+            iterations *= if elapsed < self.target / 64 { 8 } else { 2 };
+        }
+
+        let mut samples = Vec::with_capacity(self.samples);
+        for _ in 0..self.samples {
+            let start = Instant::now();
+            for _ in 0..iterations {
+                op();
+            }
+            samples.push(start.elapsed().as_nanos() as f64 / iterations as f64);
+        }
+        samples.sort_by(|a, b| a.total_cmp(b));
+
+        let record = Record { group, name, params: params.to_vec(), iterations, samples, items_per_op, bytes_per_op };
+        eprintln!("{:<44} {:>12.1} ns/op  (min {:.1}, max {:.1})", record.name, record.median(), record.samples[0], record.samples[record.samples.len() - 1]);
+        self.records.push(record);
+    }
+}
+
+/// xorshift64*: fixed-seed filler for keys and messages
+struct Rng(u64);
+
+impl Rng {
+    fn fill(&mut self, out: &mut [u8]) {
+        for chunk in out.chunks_mut(8) {
+            self.0 ^= self.0 >> 12;
+            self.0 ^= self.0 << 25;
+            self.0 ^= self.0 >> 27;
+            let word = self.0.wrapping_mul(0x2545_f491_4f6c_dd1d).to_le_bytes();
+            chunk.copy_from_slice(&word[..chunk.len()]);
+        }
+    }
+
+    fn bytes(&mut self, len: usize) -> Vec<u8> {
+        let mut out = vec![0u8; len];
+        self.fill(&mut out);
+        out
+    }
+}
+
+#[derive(Clone, Copy)]
+struct Caches {
+    l1d: u64,
+    l2: u64,
+    l3: u64,
+}
+
+/// Data and unified cache sizes of CPU 0, with common defaults where sysfs is unavailable
+fn cache_sizes() -> Caches {
+    let mut caches = Caches { l1d: 32 << 10, l2: 1 << 20, l3: 32 << 20 };
+    for index in 0..8 {
+        let dir = format!("/sys/devices/system/cpu/cpu0/cache/index{}", index);
+        let read = |file: &str| std::fs::read_to_string(format!("{}/{}", dir, file)).ok().map(|s| s.trim().to_string());
+        let (Some(level), Some(kind), Some(size)) = (read("level"), read("type"), read("size")) else {
+            continue;
+        };
+        if kind == "Instruction" {
+            continue;
+        }
+        let bytes = match size.strip_suffix('K') {
+            Some(k) => k.parse::<u64>().map(|k| k << 10),
+            None => match size.strip_suffix('M') {
+                Some(m) => m.parse::<u64>().map(|m| m << 20),
+                None => size.parse::<u64>(),
+            },
+        };
+        let Ok(bytes) = bytes else { continue };
+        match level.as_str() {
+            "1" => caches.l1d = bytes,
+            "2" => caches.l2 = bytes,
+            "3" => caches.l3 = bytes,
+            _ => {}
+        }
+    }
+    caches
+}
+
+fn cpu_model() -> String {
+    std::fs::read_to_string("/proc/cpuinfo")
+        .ok()
+        .and_then(|info| info.lines().find(|l| l.starts_with("model name")).and_then(|l| l.split(':').nth(1)).map(|m| m.trim().to_string()))
+        .unwrap_or_else(|| std::env::consts::ARCH.to_string())
+}
+
+fn acceleration_info() -> String {
+    let raw = securebuffer_get_acceleration_info();
+    if raw.is_null() {
+        return String::new();
+    }
+    // SAFETY: non-null results are NUL-terminated strings owned by the caller
+    unsafe {
+        let info = CStr::from_ptr(raw).to_string_lossy().into_owned();
+        securebuffer_free_cstr(raw);
+        info
+    }
+}
+
+#[cfg(target_os = "linux")]
+fn pin_to_cpu(cpu: usize) -> bool {
+    // SAFETY: the set is a local, fully initialised cpu_set_t
+    unsafe {
+        let mut set: libc::cpu_set_t = std::mem::zeroed();
+        libc::CPU_SET(cpu, &mut set);
+        libc::sched_setaffinity(0, std::mem::size_of::<libc::cpu_set_t>(), &set) == 0
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+fn pin_to_cpu(_cpu: usize) -> bool {
+    false
+}
+
+fn json_escape(s: &str) -> String {
+    s.chars()
+        .map(|c| match c {
+            '"' => "\\\"".to_string(),
+            '\\' => "\\\\".to_string(),
+            c if (c as u32) < 0x20 => format!("\\u{:04x}", c as u32),
+            c => c.to_string(),
+        })
+        .collect()
+}
+
+/// Largest power-of-two bit count whose array fits in `bytes`
+fn filter_bits(bytes: u64) -> u64 {
+    let bits = (bytes * 8).max(1 << 13);
+    1 << (63 - bits.leading_zeros())
+}
+
+fn bench_ffi(bench: &mut Bench) {
+    let buffer = securebuffer_new(32);
+    bench.run("ffi", "ffi/securebuffer_len".into(), &[], 1, 0, || {
+        // SAFETY: buffer is live for the whole case
+        black_box(unsafe { securebuffer_len(black_box(buffer)) });
+    });
+    // SAFETY: created above and not shared
+    unsafe { securebuffer_free(buffer) };
+}
+
+fn bench_bloom(bench: &mut Bench, caches: Caches, quick: bool, rng: &mut Rng) {
+    let key_count = if quick { 1 << 14 } else { 1 << 16 };
+    let keys = rng.bytes(key_count * OUTPOINT_LEN);
+    let dram = if quick { caches.l3 * 4 } else { (caches.l3 * 8).max(256 << 20) }.min(1 << 30);
+    let cases = [("l1", caches.l1d / 2, true), ("l2", caches.l2 / 2, true), ("l2", caches.l2 / 2, false), ("l3", caches.l3 / 2, true), ("dram", dram, true)];
+    let mut bitmap = vec![0u8; (BLOOM_BATCH + 7) / 8];
+
+    for (tier, bytes, fast) in cases {
+        let size = filter_bits(bytes);
+        let hash = if fast { "siphash" } else { "sha256d" };
+        let ops = ["insert", "contains", "insert_batch", "contains_batch"];
+        if !ops.iter().any(|op| bench.enabled(&format!("bloom/{}/{}/{}", op, hash, tier))) {
+            continue; // don't allocate a filter no case will use
+        }
+        let config = CBloomConfig {
+            network: b"bitcoin\0".as_ptr() as *const c_char,
+            size,
+            num_hashes: 6,
+            tweak: 0x5eed,
+            flags: BLOOM_FLAG_BLOCKED | BLOOM_FLAG_LEAN | if fast { BLOOM_FLAG_FAST_HASH } else { 0 },
+            max_age_seconds: 86_400,
+            batch_size: 0,
+            enable_compression: false,
+            enable_metrics: false,
+            generations: 1,
+            storage: 0,
+        };
+        // SAFETY: config and the key array outlive every call below; the filter is freed last
+        unsafe {
+            let filter = bloom_filter_new(&config, std::ptr::null_mut());
+            if filter.is_null() {
+                eprintln!("skipping bloom {} ({} bits): filter allocation failed", tier, size);
+                continue;
+            }
+            // Half the keys present, so lookups split between hits and misses
+            bloom_filter_insert_batch(filter, keys.as_ptr(), OUTPOINT_LEN, key_count / 2);
+            let params = [("filter_bytes", size / 8), ("keys", key_count as u64)];
+            let batch_params = [("filter_bytes", size / 8), ("keys", key_count as u64), ("batch", BLOOM_BATCH as u64)];
+
+            let mut i = 0;
+            bench.run("bloom", format!("bloom/insert/{}/{}", hash, tier), &params, 1, 0, || {
+                black_box(bloom_filter_insert(filter, keys.as_ptr().add(i * OUTPOINT_LEN), OUTPOINT_LEN));
+                i = (i + 1) % key_count;
+            });
+            let mut i = 0;
+            bench.run("bloom", format!("bloom/contains/{}/{}", hash, tier), &params, 1, 0, || {
+                black_box(bloom_filter_contains(filter, keys.as_ptr().add(i * OUTPOINT_LEN), OUTPOINT_LEN));
+                i = (i + 1) % key_count;
+            });
+            let mut i = 0;
+            bench.run("bloom", format!("bloom/insert_batch/{}/{}", hash, tier), &batch_params, BLOOM_BATCH as u64, 0, || {
+                black_box(bloom_filter_insert_batch(filter, keys.as_ptr().add(i * OUTPOINT_LEN), OUTPOINT_LEN, BLOOM_BATCH));
+                i = (i + BLOOM_BATCH) % key_count;
+            });
+            let mut i = 0;
+            bench.run("bloom", format!("bloom/contains_batch/{}/{}", hash, tier), &batch_params, BLOOM_BATCH as u64, 0, || {
+                black_box(bloom_filter_contains_batch(filter, keys.as_ptr().add(i * OUTPOINT_LEN), OUTPOINT_LEN, BLOOM_BATCH, bitmap.as_mut_ptr()));
+                i = (i + BLOOM_BATCH) % key_count;
+            });
+            bloom_filter_free(filter);
+        }
+    }
+}
+
+fn bench_hmac(bench: &mut Bench, rng: &mut Rng) {
+    let key = rng.bytes(32);
+    let buffer = securebuffer_new(key.len());
+    let max_batch = 256;
+    let messages: Vec<Vec<u8>> = (0..max_batch).map(|_| rng.bytes(64)).collect();
+    let pointers: Vec<*const u8> = messages.iter().map(|m| m.as_ptr()).collect();
+    let lengths = vec![64usize; max_batch];
+    let mut out = vec![0u8; max_batch * 64];
+    let mut out_len = 0usize;
+    let long = rng.bytes(1024);
+
+    // SAFETY: buffer, contexts and message arrays live until the frees at the end
+    unsafe {
+        securebuffer_copy(buffer, key.as_ptr(), key.len());
+        for (algorithm, label) in [(HASH_SHA256, "sha256"), (HASH_SHA512, "sha512")] {
+            let ctx = securebuffer_hmac_context_new(buffer, algorithm);
+            if ctx.is_null() {
+                continue;
+            }
+            for len in [64usize, 1024] {
+                bench.run("hmac", format!("hmac/context/{}/{}", label, len), &[("message_bytes", len as u64)], 1, len as u64, || {
+                    black_box(securebuffer_hmac_context_compute_into(ctx, long.as_ptr(), len, out.as_mut_ptr(), out.len(), &mut out_len));
+                });
+            }
+            for batch in [1usize, 4, 8, 16, 64, 256] {
+                let params = [("message_bytes", 64), ("batch", batch as u64)];
+                bench.run("hmac", format!("hmac/context_batch/{}/{}", label, batch), &params, batch as u64, 64 * batch as u64, || {
+                    black_box(securebuffer_hmac_context_compute_batch_into(
+                        ctx,
+                        pointers.as_ptr(),
+                        lengths.as_ptr(),
+                        batch,
+                        out.as_mut_ptr(),
+                        out.len(),
+                        &mut out_len,
+                    ));
+                });
+            }
+            securebuffer_hmac_context_free(ctx);
+        }
+
+        let message = &messages[0];
+        bench.run("hmac", "hmac/buffer/sha256/64".into(), &[("message_bytes", 64)], 1, 64, || {
+            black_box(securebuffer_hmac_into(buffer, message.as_ptr(), message.len(), out.as_mut_ptr(), out.len(), &mut out_len));
+        });
+        bench.run("hmac", "hmac/buffer_batch/sha256/64".into(), &[("message_bytes", 64), ("batch", 64)], 64, 64 * 64, || {
+            black_box(securebuffer_hmac_batch_into(buffer, pointers.as_ptr(), lengths.as_ptr(), 64, out.as_mut_ptr(), out.len()));
+        });
+        bench.run("hmac", "hmac/sign_hmac_sha256/64".into(), &[("message_bytes", 64)], 1, 64, || {
+            black_box(securebuffer_sign_hmac_sha256_into(buffer, message.as_ptr(), message.len(), out.as_mut_ptr()));
+        });
+        bench.run("buffer", "buffer/read_consistent/32".into(), &[("bytes", 32)], 1, 32, || {
+            black_box(securebuffer_read_consistent(buffer, out.as_mut_ptr(), out.len(), &mut out_len));
+        });
+        securebuffer_free(buffer);
+    }
+}
+
+fn bench_aead(bench: &mut Bench, quick: bool, rng: &mut Rng) {
+    let key = rng.bytes(32);
+    let nonce = rng.bytes(12);
+    let sizes: &[usize] = if quick { &[64, 1500, 16 << 10] } else { &[64, 1500, 16 << 10, 1 << 20] };
+    let largest = sizes[sizes.len() - 1];
+    let input = rng.bytes(largest);
+    let mut output = vec![0u8; largest];
+    let mut tag = [0u8; 16];
+
+    // SAFETY: every context is created and freed inside one iteration
+    unsafe {
+        for &len in sizes {
+            bench.run("aead", format!("aead/seal/{}", len), &[("message_bytes", len as u64)], 1, len as u64, || {
+                let ctx = securebuffer_aead_new(key.as_ptr(), key.len(), nonce.as_ptr(), nonce.len(), true);
+                securebuffer_aead_update(ctx, input.as_ptr(), output.as_mut_ptr(), len);
+                black_box(securebuffer_aead_final(ctx, tag.as_mut_ptr()));
+                securebuffer_aead_free(ctx);
+            });
+        }
+
+        let plain = securebuffer_new(1500);
+        let sealed = securebuffer_new(1500 + 16);
+        securebuffer_copy(plain, input.as_ptr(), 1500);
+        bench.run("aead", "aead/buffer_seal/1500".into(), &[("message_bytes", 1500)], 1, 1500, || {
+            black_box(securebuffer_encrypt_aes256_gcm(plain, key.as_ptr(), nonce.as_ptr(), sealed));
+        });
+        securebuffer_free(sealed);
+        securebuffer_free(plain);
+    }
+}
+
+fn bench_pool(bench: &mut Bench) {
+    let pool = securebuffer_pool_new(0);
+    if pool.is_null() {
+        eprintln!("skipping pool: arena allocation failed");
+        return;
+    }
+    // SAFETY: every slot goes back to the pool before the next acquire; the pool is freed last
+    unsafe {
+        for size in [32usize, 256, 4096] {
+            bench.run("pool", format!("pool/acquire_release/{}", size), &[("slot_bytes", size as u64)], 1, 0, || {
+                let slot = securebuffer_pool_acquire(pool, size);
+                black_box(securebuffer_pool_release(pool, black_box(slot)));
+            });
+        }
+        securebuffer_pool_free(pool);
+    }
+}
+
+#[cfg(target_os = "linux")]
+fn bench_ring(bench: &mut Bench, rng: &mut Rng) {
+    const BATCH: usize = 32;
+    let ring = securebuffer_ring_create(1 << 20, false);
+    if ring.is_null() {
+        eprintln!("skipping ring: memfd mapping failed");
+        return;
+    }
+    let record = rng.bytes(1024);
+    let mut iov: Vec<CSecureBufferIoVec> = (0..BATCH).map(|_| CSecureBufferIoVec { base: std::ptr::null_mut(), len: 0 }).collect();
+    let mut count = 0usize;
+
+    // SAFETY: single-threaded producer and consumer on a ring freed at the end
+    unsafe {
+        for len in [64usize, 1024] {
+            bench.run("ring", format!("ring/send_receive/{}", len), &[("record_bytes", len as u64)], 1, len as u64, || {
+                securebuffer_ring_push(ring, record.as_ptr(), len, 0);
+                securebuffer_ring_read_batch(ring, iov.as_mut_ptr(), 1, 0, &mut count);
+                securebuffer_ring_commit_read(ring);
+            });
+            let params = [("record_bytes", len as u64), ("batch", BATCH as u64)];
+            bench.run("ring", format!("ring/send_receive_batch/{}", len), &params, BATCH as u64, (len * BATCH) as u64, || {
+                for _ in 0..BATCH {
+                    securebuffer_ring_push(ring, record.as_ptr(), len, 0);
+                }
+                securebuffer_ring_read_batch(ring, iov.as_mut_ptr(), BATCH, 0, &mut count);
+                securebuffer_ring_commit_read(ring);
+            });
+        }
+        securebuffer_ring_free(ring);
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+fn bench_ring(_bench: &mut Bench, _rng: &mut Rng) {}
+
+fn bench_entropy(bench: &mut Bench) {
+    let mut out = vec![0u8; 4096];
+    // SAFETY: out is writable for its whole length
+    unsafe {
+        for len in [32usize, 4096] {
+            bench.run("entropy", format!("entropy/fill/{}", len), &[("bytes", len as u64)], 1, len as u64, || {
+                black_box(securebuffer_fill_entropy(out.as_mut_ptr(), len));
+            });
+        }
+        bench.run("entropy", "entropy/fast_entropy_c/32".into(), &[("bytes", 32)], 1, 32, || {
+            black_box(fast_entropy_c(out.as_mut_ptr()));
+        });
+    }
+}
+
+/// (name, ns_per_op) pairs from a previous run's output
+fn read_baseline(path: &str) -> Vec<(String, f64)> {
+    let text = std::fs::read_to_string(path).unwrap_or_else(|e| usage(&format!("cannot read baseline {}: {}", path, e)));
+    let field = |line: &str, key: &str| -> Option<String> {
+        let start = line.find(&format!("\"{}\":", key))? + key.len() + 3;
+        let rest = &line[start..];
+        let rest = rest.strip_prefix('"').unwrap_or(rest);
+        Some(rest[..rest.find(|c| c == '"' || c == ',' || c == '}')?].to_string())
+    };
+    text.lines()
+        .filter_map(|line| Some((field(line, "name")?, field(line, "ns_per_op")?.parse().ok()?)))
+        .collect()
+}
+
+fn main() {
+    let options = Options::parse();
+    let pinned = options.cpu.filter(|&cpu| pin_to_cpu(cpu));
+    if options.cpu.is_some() && pinned.is_none() {
+        eprintln!("ffi_bench: could not pin to CPU {:?}; running unpinned", options.cpu);
+    }
+
+    let caches = cache_sizes();
+    let mut bench = Bench {
+        filter: options.filter.clone(),
+        target: Duration::from_millis(if options.quick { 20 } else { 100 }),
+        samples: if options.quick { 5 } else { 15 },
+        records: Vec::new(),
+    };
+    let mut rng = Rng(0x9e37_79b9_7f4a_7c15);
+
+    bench_ffi(&mut bench);
+    bench_bloom(&mut bench, caches, options.quick, &mut rng);
+    bench_hmac(&mut bench, &mut rng);
+    bench_aead(&mut bench, options.quick, &mut rng);
+    bench_pool(&mut bench);
+    bench_ring(&mut bench, &mut rng);
+    bench_entropy(&mut bench);
+
+    let timestamp = SystemTime::now().duration_since(UNIX_EPOCH).map_or(0, |d| d.as_secs());
+    let mut json = String::new();
+    let _ = writeln!(json, "{{\"schema\":1,\"suite\":\"securebuffer-ffi\",\"version\":\"{}\",\"timestamp\":{},", env!("CARGO_PKG_VERSION"), timestamp);
+    let _ = writeln!(
+        json,
+        "\"host\":{{\"os\":\"{}\",\"arch\":\"{}\",\"cpu_model\":\"{}\",\"logical_cpus\":{},\"numa_nodes\":{},\"l1d_bytes\":{},\"l2_bytes\":{},\"l3_bytes\":{},\"acceleration\":\"{}\",\"hardware_acceleration\":{},\"pinned_cpu\":{}}},",
+        std::env::consts::OS,
+        std::env::consts::ARCH,
+        json_escape(&cpu_model()),
+        std::thread::available_parallelism().map_or(1, |n| n.get()),
+        securebuffer_numa_node_count(),
+        caches.l1d,
+        caches.l2,
+        caches.l3,
+        json_escape(&acceleration_info()),
+        securebuffer_has_hardware_acceleration(),
+        pinned.map_or("null".to_string(), |cpu| cpu.to_string()),
+    );
+    let _ = writeln!(json, "\"config\":{{\"quick\":{},\"samples\":{},\"target_ms\":{}}},", options.quick, bench.samples, bench.target.as_millis());
+    json.push_str("\"results\":[\n");
+    for (i, record) in bench.records.iter().enumerate() {
+        json.push_str(&record.to_json());
+        json.push_str(if i + 1 < bench.records.len() { ",\n" } else { "\n" });
+    }
+    json.push_str("]}\n");
+
+    match &options.out {
+        Some(path) => std::fs::write(path, &json).unwrap_or_else(|e| usage(&format!("cannot write {}: {}", path, e))),
+        None => print!("{}", json),
+    }
+
+    if let Some(path) = &options.baseline {
+        let mut regressions = 0;
+        for (name, before) in read_baseline(path) {
+            let Some(record) = bench.records.iter().find(|r| r.name == name) else { continue };
+            let change = (record.median() - before) / before * 100.0;
+            if change > options.threshold {
+                eprintln!("REGRESSION {:<40} {:>10.1} -> {:>10.1} ns/op ({:+.1}%)", name, before, record.median(), change);
+                regressions += 1;
+            }
+        }
+        if regressions > 0 {
+            std::process::exit(2);
+        }
+    }
+}
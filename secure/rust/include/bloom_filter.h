@@ -15,6 +15,28 @@ extern "C" {
 // Opaque type for UniversalBloomFilter
 typedef struct UniversalBloomFilter UniversalBloomFilter;
 
+// Opaque buffered insert handle; one per ingest thread
+typedef struct BloomWriter BloomWriter;
+
+// Mode flags for BloomConfig.flags (bits 0-1 keep their BIP37 update meaning)
+#define BLOOM_FLAG_BLOCKED 0x04 // All k bits of a key live in one 64-byte block: one cache line per lookup
+#define BLOOM_FLAG_FAST_HASH 0x08 // Keyed SipHash-1-3 instead of double SHA256; keep unset for adversarial keys
+#define BLOOM_FLAG_LEAN 0x10      // Bits only: no per-key timestamp map or exact-match verification
+#define BLOOM_FLAG_COUNTING 0x20  // 4-bit saturating counters (128 per block) so keys can be removed;
+                                  // requires BLOOM_FLAG_BLOCKED and a single generation
+#define BLOOM_FLAG_SINGLE_WRITER 0x40 // Caller guarantees one inserting thread: plain stores instead of
+                                      // atomic read-modify-write (lookups may still run concurrently)
+#define BLOOM_FLAG_REMOVE_SPENT 0x80  // Block loads also remove spent outpoints; requires BLOOM_FLAG_COUNTING
+                                      // and a filter holding the complete UTXO set (see bloom_filter_load_block)
+
+// Storage bits for BloomConfig.storage; arrays of 2 MiB and up are always mmap-backed with THP advice
+#define BLOOM_STORAGE_HUGE_PAGES 0x01 // Explicit huge pages (MAP_HUGETLB), falling back to transparent ones
+#define BLOOM_STORAGE_LOCKED 0x02     // mlock the bit array (best effort)
+// NUMA modes (ignored on single-node hosts); at most one, and replication excludes BLOOM_FLAG_COUNTING
+#define BLOOM_STORAGE_NUMA_INTERLEAVE 0x04 // Interleave pages across nodes: write-heavy filters
+#define BLOOM_STORAGE_NUMA_REPLICATE 0x08  // One copy per node, read locally and written to all (memory x nodes);
+                                           // batch calls run on workers pinned to the caller's node
+
 // Configuration struct for Bloom Filter
 typedef struct {
     const char* network;
@@ -26,6 +48,9 @@ typedef struct {
     uint64_t batch_size;
     bool enable_compression;
     bool enable_metrics;
+    uint8_t generations;      // Aging ring of sub-filters of `size` bits each, every one covering
+                              // max_age_seconds / generations (0 or 1 = single filter)
+    uint8_t storage;          // BLOOM_STORAGE_* bits
 } BloomConfig;
 
 // Error codes
@@ -35,7 +60,8 @@ typedef enum {
     BLOOM_ERR_INVALID_INPUT = 2,
     BLOOM_ERR_HASH_ERROR = 3,
     BLOOM_ERR_MEMORY = 4,
-    BLOOM_ERR_CONCURRENCY = 5
+    BLOOM_ERR_CONCURRENCY = 5,
+    BLOOM_ERR_IO = 6
 } BloomFilterErrorCode;
 
 // Create a new Bloom Filter
@@ -44,21 +70,149 @@ UniversalBloomFilter* bloom_filter_new(const BloomConfig* config, BloomFilterErr
 // Destroy Bloom Filter
 void bloom_filter_free(UniversalBloomFilter* filter);
 
-// Insert data into Bloom Filter
+// Insert data into Bloom Filter, returns true on success
 bool bloom_filter_insert(UniversalBloomFilter* filter, const uint8_t* data, uint64_t len);
 
+// Batched calls: one FFI crossing for many keys. Keys are either packed back to back at a
+// fixed stride, or variable width with key i at keys[offsets[i] .. offsets[i + 1]] (count + 1
+// offsets). Lookup results go to a bitmap of (count + 7) / 8 bytes, bit i % 8 of byte i / 8.
+bool bloom_filter_insert_batch(UniversalBloomFilter* filter, const uint8_t* keys, uint64_t stride, uint64_t count);
+bool bloom_filter_insert_batch_offsets(UniversalBloomFilter* filter, const uint8_t* keys, const uint64_t* offsets,
+                                       uint64_t count);
+// Return the number of hits, or -1 on invalid input
+int64_t bloom_filter_contains_batch(const UniversalBloomFilter* filter, const uint8_t* keys, uint64_t stride,
+                                    uint64_t count, uint8_t* bitmap);
+int64_t bloom_filter_contains_batch_offsets(const UniversalBloomFilter* filter, const uint8_t* keys,
+                                            const uint64_t* offsets, uint64_t count, uint8_t* bitmap);
+
+// Remove data from a BLOOM_FLAG_COUNTING filter; returns true if it was present.
+// Only remove keys that were inserted (e.g. outpoints spent by a connected block):
+// removing a false positive decrements counters that belong to other keys.
+bool bloom_filter_remove(UniversalBloomFilter* filter, const uint8_t* data, uint64_t len);
+
+// Insert data and report whether it was already present, in one hash and one pass over the
+// bits: 1 seen, 0 new, -1 on error. Not supported on BLOOM_FLAG_COUNTING filters.
+int32_t bloom_filter_test_and_insert(UniversalBloomFilter* filter, const uint8_t* data, uint64_t len);
+
+// Load a wire-format block: every output it creates is inserted as a 36-byte outpoint key
+// (txid, little-endian vout). Returns the number inserted, or -1 if the block does not parse.
+// With BLOOM_FLAG_REMOVE_SPENT every outpoint the block spends is then removed. That is only
+// correct when the filter holds the complete UTXO set, built from genesis or a full snapshot:
+// spending an outpoint the filter never saw decrements counters that belong to other keys
+// and turns them into false negatives. Filters over a subset of outputs must leave it unset.
+int64_t bloom_filter_load_block(UniversalBloomFilter* filter, const uint8_t* block, uint64_t len);
+
+// Buffered inserts: keys are hashed and queued per hash-prefix shard, and a full shard is
+// applied in one sweep. Lookups see a key only after its shard fills, bloom_writer_flush
+// or bloom_writer_free. The filter must outlive its writers; a writer is single-threaded.
+BloomWriter* bloom_filter_writer_new(UniversalBloomFilter* filter);
+bool bloom_writer_insert(BloomWriter* writer, const uint8_t* data, uint64_t len);
+void bloom_writer_flush(BloomWriter* writer);
+void bloom_writer_free(BloomWriter* writer);
+
 // Check if data is present
 bool bloom_filter_contains(const UniversalBloomFilter* filter, const uint8_t* data, uint64_t len);
 
-// Get item count
+// Get item count (summed from per-thread counter stripes)
 uint64_t bloom_filter_count(const UniversalBloomFilter* filter);
 
-// Get false positive rate
+// Get theoretical false positive rate for the configured layout and current item count
 double bloom_filter_false_positive_rate(const UniversalBloomFilter* filter);
 
+// Bytes reserved for the bit array (including huge-page rounding)
+uint64_t bloom_filter_memory_usage(const UniversalBloomFilter* filter);
+
+// Fault in the whole bit array now (each NUMA replica from its own node) instead of on the
+// first lookups; returns false for a null filter
+bool bloom_filter_prefault(const UniversalBloomFilter* filter);
+
+// Set config->size (power of two, up to 2^36 bits) and config->num_hashes for the expected
+// item count and target FP rate, honouring config->flags; returns false if unreachable
+bool bloom_filter_config_for_capacity(uint64_t expected_items, double fp_rate, BloomConfig* config);
+
 // Reset Bloom Filter
 void bloom_filter_reset(UniversalBloomFilter* filter);
 
+// Expire the oldest generation (O(size) memset) and make it the insert target;
+// returns the number of items that aged out. With one generation this clears the filter.
+uint64_t bloom_filter_rotate(UniversalBloomFilter* filter);
+
+// Snapshots: a one-page versioned header (config, seeds, tweak, per-generation item counts,
+// chain tip, checksums) followed by the raw bit array. The file holds the hash seeds and is
+// created with mode 0600.
+
+// Write a snapshot to path (written to path.tmp, renamed into place, then the directory is synced)
+BloomFilterErrorCode bloom_filter_save(const UniversalBloomFilter* filter, const char* path);
+
+// Map a snapshot copy-on-write; only the header is read, bit pages fault in on first lookup.
+// The timestamp map is not persisted, so the filter opens with BLOOM_FLAG_LEAN set.
+// verify_data also checks the bit array checksum, which reads the whole file.
+UniversalBloomFilter* bloom_filter_open_mmap(const char* path, bool verify_data, BloomFilterErrorCode* err);
+
+// Newest block height covered; restart by replaying blocks above it. Raw blocks carry no
+// height, so bloom_filter_load_block leaves it unchanged: set it after each load.
+uint64_t bloom_filter_chain_tip(const UniversalBloomFilter* filter);
+void bloom_filter_set_chain_tip(UniversalBloomFilter* filter, uint64_t height);
+
+// Multi-network registry: one handle owning a filter per chain. Each network has its own
+// bit array, so one chain's keys never share cache lines with another's. Key i of a batch
+// is keys[offsets[i] .. offsets[i + 1]] and belongs to network tags[i]; every key must match
+// its network's key width. Register networks before sharing the handle between threads.
+typedef struct BloomRegistry BloomRegistry;
+
+typedef struct {
+    uint64_t transactions_processed;
+    uint64_t blocks_processed;
+    uint64_t queries_per_second;   // Both rates cover the window since the previous stats call
+    uint64_t average_query_time_ns;
+    double false_positive_rate;
+    uint64_t memory_usage_bytes;
+    uint64_t last_updated;
+} BloomNetworkStats;
+
+BloomRegistry* bloom_registry_new(void);
+void bloom_registry_free(BloomRegistry* registry);
+
+// Returns the network's tag, or -1 (err set); key_width 0 uses the network's hash size
+// (32-byte txids, 64-byte Solana signatures)
+int32_t bloom_registry_add(BloomRegistry* registry, const BloomConfig* config, uint32_t key_width, BloomFilterErrorCode* err);
+int32_t bloom_registry_network_id(const BloomRegistry* registry, const char* name);
+
+// Tagged batches; a bad tag or key width fails the whole call before anything is applied
+bool bloom_registry_insert_batch(BloomRegistry* registry, const uint16_t* tags, const uint8_t* keys,
+                                 const uint64_t* offsets, uint64_t count);
+bool bloom_registry_contains_batch(const BloomRegistry* registry, const uint16_t* tags, const uint8_t* keys,
+                                   const uint64_t* offsets, uint64_t count, bool* results);
+bool bloom_registry_load_block(BloomRegistry* registry, uint16_t network, const uint8_t* block, uint64_t len);
+bool bloom_registry_stats(const BloomRegistry* registry, uint16_t network, BloomNetworkStats* stats);
+
+// Seen-set for deduplication over a sliding window of max_age_seconds: a lean filter with at
+// least two generations (rotated automatically), plus an exact cache of the most recent
+// cache_entries keys. While the cache still holds every key seen within the window, its
+// answer overrules the filter, so hot keys never see false positives. Expiry slides from a
+// key's last sighting. Concurrent calls with the same key see it as new exactly once.
+typedef struct BloomSeenSet BloomSeenSet;
+
+typedef struct {
+    uint64_t queries;
+    uint64_t duplicates;
+    uint64_t false_positives_avoided;   // Filter hits the exact cache proved new
+    uint64_t rotations;
+    uint64_t cached_keys;
+} BloomSeenStats;
+
+// cache_entries 0 answers from the filter alone
+BloomSeenSet* bloom_seen_new(const BloomConfig* config, uint64_t cache_entries, BloomFilterErrorCode* err);
+void bloom_seen_free(BloomSeenSet* seen);
+
+// 1 if data was seen within the window, 0 if new (it is now recorded), -1 on error
+int32_t bloom_seen_test_and_insert(const BloomSeenSet* seen, const uint8_t* data, uint64_t len);
+// Packed keys as for bloom_filter_contains_batch; bit i is set for each duplicate, including
+// repeats within the batch. Returns the duplicate count, or -1 on invalid input.
+int64_t bloom_seen_test_and_insert_batch(const BloomSeenSet* seen, const uint8_t* keys, uint64_t stride,
+                                         uint64_t count, uint8_t* bitmap);
+bool bloom_seen_stats(const BloomSeenSet* seen, BloomSeenStats* stats);
+
 #ifdef __cplusplus
 }
 #endif
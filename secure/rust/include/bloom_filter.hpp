@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: MIT
+// Universal Sprint Bloom Filter - C++20 bindings
+// Header-only layer over bloom_filter.h. Keys are fixed-width value types whose size is
+// checked at compile time, so any contiguous range of them is passed to the packed-stride
+// entry points as-is; handles are move-only and freed exactly once.
+
+#ifndef BLOOM_FILTER_HPP
+#define BLOOM_FILTER_HPP
+
+#include "bloom_filter.h"
+
+#include <array>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bloom {
+
+using ErrorCode = BloomFilterErrorCode;
+using Bytes = std::span<const uint8_t>;
+
+// Thrown when a filter, seen-set or registry entry cannot be created
+class error : public std::runtime_error {
+public:
+    error(ErrorCode code, const char* what)
+        : std::runtime_error(std::string(what) + " (bloom error " + std::to_string(code) + ")"), code_(code) {}
+    ErrorCode code() const noexcept { return code_; }
+
+private:
+    ErrorCode code_;
+};
+
+// A key is a packed byte array: its object representation is exactly its `width` bytes
+template <class K>
+concept Key = std::is_trivially_copyable_v<K> && std::has_unique_object_representations_v<K> &&
+              sizeof(K) == K::width && requires(const K& key) {
+                  { key.data() } -> std::same_as<const uint8_t*>;
+              };
+
+template <std::size_t N>
+struct FixedKey {
+    static constexpr std::size_t width = N;
+    std::array<uint8_t, N> bytes{};
+
+    constexpr FixedKey() noexcept = default;
+    constexpr explicit FixedKey(std::span<const uint8_t, N> src) noexcept {
+        for (std::size_t i = 0; i < N; ++i) bytes[i] = src[i];
+    }
+
+    constexpr const uint8_t* data() const noexcept { return bytes.data(); }
+    constexpr Bytes view() const noexcept { return Bytes(bytes); }
+    friend constexpr auto operator<=>(const FixedKey&, const FixedKey&) = default;
+};
+
+using Hash32 = FixedKey<32>;  // txids and block hashes
+using Hash64 = FixedKey<64>;  // Solana signatures
+
+// Transaction outpoint: txid followed by the output index as 4 little-endian bytes
+struct Outpoint {
+    static constexpr std::size_t width = 36;
+    std::array<uint8_t, width> bytes{};
+
+    constexpr Outpoint() noexcept = default;
+    constexpr Outpoint(std::span<const uint8_t, 32> txid, uint32_t vout) noexcept {
+        for (std::size_t i = 0; i < 32; ++i) bytes[i] = txid[i];
+        for (std::size_t i = 0; i < 4; ++i) bytes[32 + i] = static_cast<uint8_t>(vout >> (8 * i));
+    }
+    constexpr Outpoint(const Hash32& txid, uint32_t vout) noexcept : Outpoint(std::span<const uint8_t, 32>(txid.bytes), vout) {}
+
+    constexpr const uint8_t* data() const noexcept { return bytes.data(); }
+    constexpr Bytes view() const noexcept { return Bytes(bytes); }
+    constexpr uint32_t vout() const noexcept {
+        return uint32_t(bytes[32]) | uint32_t(bytes[33]) << 8 | uint32_t(bytes[34]) << 16 | uint32_t(bytes[35]) << 24;
+    }
+    friend constexpr auto operator<=>(const Outpoint&, const Outpoint&) = default;
+};
+
+static_assert(Key<Hash32> && Key<Hash64> && Key<Outpoint>);
+
+// A batch of keys: std::span, std::vector, std::array or anything else laid out contiguously
+template <class R>
+concept KeyRange = std::ranges::contiguous_range<R> && std::ranges::sized_range<R> && Key<std::ranges::range_value_t<R>>;
+
+// Bytes of result bitmap needed for a batch of count keys
+constexpr std::size_t bitmap_size(std::size_t count) noexcept { return (count + 7) / 8; }
+
+constexpr bool bitmap_test(std::span<const uint8_t> bitmap, std::size_t i) noexcept {
+    return (bitmap[i / 8] >> (i % 8)) & 1;
+}
+
+namespace detail {
+
+template <class T, void (*Free)(T*)>
+class Handle {
+public:
+    Handle() noexcept = default;
+    explicit Handle(T* ptr) noexcept : ptr_(ptr) {}
+    Handle(Handle&& other) noexcept : ptr_(std::exchange(other.ptr_, nullptr)) {}
+    Handle& operator=(Handle&& other) noexcept {
+        reset(std::exchange(other.ptr_, nullptr));
+        return *this;
+    }
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+    ~Handle() { reset(); }
+
+    T* get() const noexcept { return ptr_; }
+    void reset(T* ptr = nullptr) noexcept {
+        if (T* old = std::exchange(ptr_, ptr)) Free(old);
+    }
+
+private:
+    T* ptr_ = nullptr;
+};
+
+template <KeyRange R>
+const uint8_t* packed(const R& keys) noexcept {
+    return reinterpret_cast<const uint8_t*>(std::ranges::data(keys));
+}
+
+template <KeyRange R>
+constexpr std::size_t width = std::ranges::range_value_t<R>::width;
+
+}  // namespace detail
+
+class Writer;
+
+class Filter {
+public:
+    explicit Filter(const BloomConfig& config) {
+        ErrorCode err = BLOOM_OK;
+        handle_.reset(bloom_filter_new(&config, &err));
+        if (!handle_.get()) throw error(err, "failed to create bloom filter");
+    }
+
+    // Size `base` for the expected item count and FP rate, keeping its other fields
+    static Filter for_capacity(uint64_t expected_items, double fp_rate, BloomConfig base) {
+        if (!bloom_filter_config_for_capacity(expected_items, fp_rate, &base))
+            throw error(BLOOM_ERR_INVALID_CONFIG, "no layout reaches the requested false positive rate");
+        return Filter(base);
+    }
+
+    static Filter open_mmap(const char* path, bool verify_data = false) {
+        ErrorCode err = BLOOM_OK;
+        UniversalBloomFilter* raw = bloom_filter_open_mmap(path, verify_data, &err);
+        if (!raw) throw error(err, "failed to open bloom filter snapshot");
+        return Filter(raw);
+    }
+
+    UniversalBloomFilter* get() const noexcept { return handle_.get(); }
+
+    bool insert(Bytes key) noexcept { return bloom_filter_insert(get(), key.data(), key.size()); }
+    bool contains(Bytes key) const noexcept { return bloom_filter_contains(get(), key.data(), key.size()); }
+    bool remove(Bytes key) noexcept { return bloom_filter_remove(get(), key.data(), key.size()); }
+    // 1 seen, 0 new, -1 on error
+    int32_t test_and_insert(Bytes key) noexcept { return bloom_filter_test_and_insert(get(), key.data(), key.size()); }
+    // Outpoints inserted, or -1; see bloom_filter_load_block for the BLOOM_FLAG_REMOVE_SPENT contract
+    int64_t load_block(Bytes block) noexcept { return bloom_filter_load_block(get(), block.data(), block.size()); }
+
+    template <Key K>
+    bool insert(const K& key) noexcept { return bloom_filter_insert(get(), key.data(), K::width); }
+    template <Key K>
+    bool contains(const K& key) const noexcept { return bloom_filter_contains(get(), key.data(), K::width); }
+    template <Key K>
+    bool remove(const K& key) noexcept { return bloom_filter_remove(get(), key.data(), K::width); }
+    template <Key K>
+    int32_t test_and_insert(const K& key) noexcept { return bloom_filter_test_and_insert(get(), key.data(), K::width); }
+
+    template <KeyRange R>
+    bool insert_batch(const R& keys) noexcept {
+        if (std::ranges::empty(keys)) return true;
+        return bloom_filter_insert_batch(get(), detail::packed(keys), detail::width<R>, std::ranges::size(keys));
+    }
+
+    // Sets bit i of bitmap for each hit; returns the hit count, or -1 if bitmap is too small
+    template <KeyRange R>
+    int64_t contains_batch(const R& keys, std::span<uint8_t> bitmap) const noexcept {
+        if (std::ranges::empty(keys)) return 0;
+        if (bitmap.size() < bitmap_size(std::ranges::size(keys))) return -1;
+        return bloom_filter_contains_batch(get(), detail::packed(keys), detail::width<R>, std::ranges::size(keys), bitmap.data());
+    }
+
+    // Variable-width keys: key i is keys[offsets[i] .. offsets[i + 1]]
+    bool insert_batch(Bytes keys, std::span<const uint64_t> offsets) noexcept {
+        if (offsets.empty()) return true;
+        return bloom_filter_insert_batch_offsets(get(), keys.data(), offsets.data(), offsets.size() - 1);
+    }
+    int64_t contains_batch(Bytes keys, std::span<const uint64_t> offsets, std::span<uint8_t> bitmap) const noexcept {
+        if (offsets.empty()) return 0;
+        if (bitmap.size() < bitmap_size(offsets.size() - 1)) return -1;
+        return bloom_filter_contains_batch_offsets(get(), keys.data(), offsets.data(), offsets.size() - 1, bitmap.data());
+    }
+
+    uint64_t count() const noexcept { return bloom_filter_count(get()); }
+    double false_positive_rate() const noexcept { return bloom_filter_false_positive_rate(get()); }
+    uint64_t memory_usage() const noexcept { return bloom_filter_memory_usage(get()); }
+    void prefault() const noexcept { (void)bloom_filter_prefault(get()); }
+    void reset() noexcept { bloom_filter_reset(get()); }
+    uint64_t rotate() noexcept { return bloom_filter_rotate(get()); }
+    ErrorCode save(const char* path) const noexcept { return bloom_filter_save(get(), path); }
+    uint64_t chain_tip() const noexcept { return bloom_filter_chain_tip(get()); }
+    void set_chain_tip(uint64_t height) noexcept { bloom_filter_set_chain_tip(get(), height); }
+
+private:
+    explicit Filter(UniversalBloomFilter* raw) noexcept : handle_(raw) {}
+
+    detail::Handle<UniversalBloomFilter, &bloom_filter_free> handle_;
+};
+
+// Buffered inserts for one ingest thread; flushes on destruction, so it must not outlive its filter
+class Writer {
+public:
+    explicit Writer(Filter& filter) : handle_(bloom_filter_writer_new(filter.get())) {
+        if (!handle_.get()) throw error(BLOOM_ERR_INVALID_INPUT, "failed to create bloom writer");
+    }
+
+    BloomWriter* get() const noexcept { return handle_.get(); }
+
+    bool insert(Bytes key) noexcept { return bloom_writer_insert(get(), key.data(), key.size()); }
+    template <Key K>
+    bool insert(const K& key) noexcept { return bloom_writer_insert(get(), key.data(), K::width); }
+    void flush() noexcept { bloom_writer_flush(get()); }
+
+private:
+    detail::Handle<BloomWriter, &bloom_writer_free> handle_;
+};
+
+class SeenSet {
+public:
+    SeenSet(const BloomConfig& config, uint64_t cache_entries) {
+        ErrorCode err = BLOOM_OK;
+        handle_.reset(bloom_seen_new(&config, cache_entries, &err));
+        if (!handle_.get()) throw error(err, "failed to create seen set");
+    }
+
+    BloomSeenSet* get() const noexcept { return handle_.get(); }
+
+    // 1 seen within the window, 0 new (now recorded), -1 on error
+    int32_t test_and_insert(Bytes key) const noexcept { return bloom_seen_test_and_insert(get(), key.data(), key.size()); }
+    template <Key K>
+    int32_t test_and_insert(const K& key) const noexcept { return bloom_seen_test_and_insert(get(), key.data(), K::width); }
+
+    // Sets bit i for each duplicate; returns the duplicate count, or -1 if bitmap is too small
+    template <KeyRange R>
+    int64_t test_and_insert_batch(const R& keys, std::span<uint8_t> bitmap) const noexcept {
+        if (std::ranges::empty(keys)) return 0;
+        if (bitmap.size() < bitmap_size(std::ranges::size(keys))) return -1;
+        return bloom_seen_test_and_insert_batch(get(), detail::packed(keys), detail::width<R>, std::ranges::size(keys), bitmap.data());
+    }
+
+    BloomSeenStats stats() const noexcept {
+        BloomSeenStats stats{};
+        bloom_seen_stats(get(), &stats);
+        return stats;
+    }
+
+private:
+    detail::Handle<BloomSeenSet, &bloom_seen_free> handle_;
+};
+
+class Registry {
+public:
+    Registry() : handle_(bloom_registry_new()) {
+        if (!handle_.get()) throw error(BLOOM_ERR_MEMORY, "failed to create bloom registry");
+    }
+
+    BloomRegistry* get() const noexcept { return handle_.get(); }
+
+    // Returns the network's tag; key_width 0 uses the network's hash size
+    uint16_t add(const BloomConfig& config, uint32_t key_width = 0) {
+        ErrorCode err = BLOOM_OK;
+        int32_t tag = bloom_registry_add(get(), &config, key_width, &err);
+        if (tag < 0) throw error(err, "failed to register network");
+        return static_cast<uint16_t>(tag);
+    }
+    template <Key K>
+    uint16_t add(const BloomConfig& config) { return add(config, K::width); }
+
+    // -1 if the network is not registered
+    int32_t network_id(const char* name) const noexcept { return bloom_registry_network_id(get(), name); }
+
+    // Key i is keys[offsets[i] .. offsets[i + 1]] and belongs to network tags[i]
+    bool insert_batch(std::span<const uint16_t> tags, Bytes keys, std::span<const uint64_t> offsets) noexcept {
+        if (offsets.size() != tags.size() + 1) return false;
+        return bloom_registry_insert_batch(get(), tags.data(), keys.data(), offsets.data(), tags.size());
+    }
+    bool contains_batch(std::span<const uint16_t> tags, Bytes keys, std::span<const uint64_t> offsets,
+                        std::span<bool> results) const noexcept {
+        if (offsets.size() != tags.size() + 1 || results.size() < tags.size()) return false;
+        return bloom_registry_contains_batch(get(), tags.data(), keys.data(), offsets.data(), tags.size(), results.data());
+    }
+
+    bool load_block(uint16_t network, Bytes block) noexcept {
+        return bloom_registry_load_block(get(), network, block.data(), block.size());
+    }
+
+    bool stats(uint16_t network, BloomNetworkStats& out) const noexcept { return bloom_registry_stats(get(), network, &out); }
+
+private:
+    detail::Handle<BloomRegistry, &bloom_registry_free> handle_;
+};
+
+// Key batches need not be spans
+static_assert(requires(Filter& filter, SeenSet& seen, const std::vector<Outpoint>& keys, std::span<uint8_t> bitmap) {
+    { filter.insert_batch(keys) } -> std::same_as<bool>;
+    { filter.contains_batch(keys, bitmap) } -> std::same_as<int64_t>;
+    { seen.test_and_insert_batch(keys, bitmap) } -> std::same_as<int64_t>;
+});
+
+}  // namespace bloom
+
+#endif  // BLOOM_FILTER_HPP
@@ -22,6 +22,11 @@
 #define SECUREBUFFER_BATCH_MAX_SIZE 1024			   // Maximum batch operation size
 #define SECUREBUFFER_UUID_LENGTH 37					   // UUID string length including null terminator
 
+// HMAC output sizes for the _into variants (text forms are not NUL-terminated)
+#define SECUREBUFFER_HMAC_SIZE 32
+#define SECUREBUFFER_HMAC_HEX_SIZE 64
+#define SECUREBUFFER_HMAC_BASE64URL_SIZE 43
+
 // Cross-platform API export macro
 #if defined(_WIN32) || defined(_WIN64)
 #define SECUREBUFFER_API __declspec(dllexport)
@@ -48,7 +53,8 @@ typedef enum
 	SECUREBUFFER_ERROR_EXPIRED = -11,
 	SECUREBUFFER_ERROR_SIDE_CHANNEL_ATTACK = -12,
 	SECUREBUFFER_ERROR_ZERO_COPY_FAILED = -13,
-	SECUREBUFFER_ERROR_BATCH_OPERATION_FAILED = -14
+	SECUREBUFFER_ERROR_BATCH_OPERATION_FAILED = -14,
+	SECUREBUFFER_ERROR_QUEUE_FULL = -15
 } SecureBufferError;
 
 // Security levels
@@ -87,8 +93,92 @@ typedef struct
 	uint64_t zero_copy_operations_count;
 	uint64_t tamper_detection_events;
 	uint64_t side_channel_protection_activations;
+	uint64_t pool_acquisitions;
+	uint64_t pool_releases;
+	uint64_t pool_exhaustions;	// Acquires refused because a size class was full
+	uint64_t pool_bytes_locked; // Arena bytes pinned across all pools
 } SecureBufferMetrics;
 
+// What a thread does when its audit queue is full
+typedef enum
+{
+	SECUREBUFFER_AUDIT_DROP = 0, // Discard and count in securebuffer_audit_dropped_total
+	SECUREBUFFER_AUDIT_BLOCK = 1 // Wait for the writer, or write the batch inline if it is not running
+} SecureBufferAuditBackpressure;
+
+// Operations with per-thread latency histograms
+typedef enum
+{
+	SECUREBUFFER_OP_ALLOC = 0,
+	SECUREBUFFER_OP_HMAC = 1,
+	SECUREBUFFER_OP_AEAD = 2,
+	SECUREBUFFER_OP_DERIVE = 3,
+	SECUREBUFFER_OP_POOL_SEND = 4, // Channel pool request, submit to completion
+	SECUREBUFFER_OP_BLOOM_INSERT = 5,
+	SECUREBUFFER_OP_BLOOM_CONTAINS = 6,
+	SECUREBUFFER_OP_COUNT = 7
+} SecureBufferOp;
+
+#define SECUREBUFFER_LATENCY_BUCKETS 544
+
+// Latency of one operation; percentiles are within 1/16 of the true value
+typedef struct
+{
+	uint64_t count;	  // Calls
+	uint64_t samples; // Timed calls; Bloom operations time one call in 16
+	uint64_t sum_ns;
+	uint64_t max_ns;
+	uint64_t p50_ns;
+	uint64_t p99_ns;
+	uint64_t p999_ns;
+} SecureBufferLatency;
+
+typedef struct
+{
+	SecureBufferMetrics totals;
+	SecureBufferLatency ops[SECUREBUFFER_OP_COUNT]; // Indexed by SecureBufferOp
+} SecureBufferMetricsSnapshot;
+
+// Buffer pool statistics
+typedef struct
+{
+	uint64_t acquisitions;
+	uint64_t releases;
+	uint64_t exhaustions;
+	uint64_t invalid_releases; // Double or foreign releases rejected
+	uint64_t in_use;
+	uint64_t bytes_reserved;
+	uint64_t bytes_locked;
+} SecureBufferPoolStats;
+
+// Key-derivation service statistics
+typedef struct
+{
+	uint64_t submitted;
+	uint64_t completed;
+	uint64_t rejected; // Refused by the queue bound, the iteration cap or bad parameters
+	uint64_t queued;
+	uint64_t workers;
+} SecureKdfStats;
+
+// Channel pool options; zero sizes and timeouts take the securechannel_pool_new defaults
+typedef struct
+{
+	size_t max_connections; // 0 = 100
+	size_t min_idle; // Opened at creation and kept idle by the health task; 0 = none
+	size_t pipeline_depth; // 0 = 16
+	uint32_t connect_timeout_ms; // 0 = 5000
+	bool enable_early_data; // Let the *_idempotent calls send as 0-RTT early data
+	uint32_t prewarm_wait_ms; // Block in new for the min_idle handshakes; 0 = return at once
+} SecureChannelPoolOptions;
+
+// Scatter-gather element for securebuffer_aead_update_iov and the ring functions
+typedef struct
+{
+	uint8_t *base;
+	size_t len;
+} SecureBufferIoVec;
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -98,6 +188,14 @@ extern "C"
 	typedef struct SecureBuffer SecureBuffer;
 	typedef struct SecureBuffer *SecureBufferHandle;
 	typedef struct SecureChannelPool SecureChannelPool;
+	typedef struct SecureBufferPool SecureBufferPool;
+	typedef struct SecureHmacContext SecureHmacContext;
+	typedef struct SecureAeadContext SecureAeadContext;
+	typedef struct SecureKdfService SecureKdfService;
+	typedef struct SecureKdfJob SecureKdfJob;
+	typedef void (*SecureKdfCallback)(SecureKdfJob *job, void *user_data);
+	typedef struct SecureChannelRequest SecureChannelRequest;
+	typedef void (*SecureChannelCallback)(SecureChannelRequest *request, void *user_data);
 
 	// === Core Buffer Operations ===
 	SECUREBUFFER_API SecureBuffer *securebuffer_new(size_t size);
@@ -109,6 +207,21 @@ extern "C"
 	SECUREBUFFER_API size_t securebuffer_len(const SecureBuffer *buf);
 	SECUREBUFFER_API size_t securebuffer_capacity(const SecureBuffer *buf);
 
+	// === Buffer Pool ===
+	// Size classes of 32..4096 bytes, each carved from one mlock'ed arena (mapped on first use,
+	// guard page on either side), instead of an alloc + mlock per buffer. Acquire and release
+	// are lock-free; released slots are zeroized. arena_bytes is per class, 0 = 1 MiB.
+	SECUREBUFFER_API SecureBufferPool *securebuffer_pool_new(size_t arena_bytes);
+	// arena_bytes per size class on each NUMA node; threads acquire from their own node first
+	SECUREBUFFER_API SecureBufferPool *securebuffer_pool_new_numa(size_t arena_bytes);
+	SECUREBUFFER_API void securebuffer_pool_free(SecureBufferPool *pool);
+	// NULL when size is 0 or above 4096 or its class is exhausted
+	SECUREBUFFER_API uint8_t *securebuffer_pool_acquire(SecureBufferPool *pool, size_t size);
+	// 0 on success, -1 for a double release or a pointer that is not one of the pool's slots
+	SECUREBUFFER_API int securebuffer_pool_release(SecureBufferPool *pool, uint8_t *slot);
+	SECUREBUFFER_API size_t securebuffer_pool_slot_size(const SecureBufferPool *pool, const uint8_t *slot);
+	SECUREBUFFER_API int securebuffer_pool_get_stats(const SecureBufferPool *pool, SecureBufferPoolStats *stats);
+
 	// === Memory Protection ===
 	SECUREBUFFER_API SecureBufferError securebuffer_lock_memory(SecureBuffer *buf);
 	SECUREBUFFER_API SecureBufferError securebuffer_unlock_memory(SecureBuffer *buf);
@@ -120,11 +233,80 @@ extern "C"
 	SECUREBUFFER_API char *securebuffer_hmac_hex(SecureBuffer *buf, const uint8_t *data, size_t data_len);
 	SECUREBUFFER_API char *securebuffer_hmac_base64url(SecureBuffer *buf, const uint8_t *data, size_t data_len);
 	SECUREBUFFER_API char *securebuffer_hmac_with_algorithm(SecureBuffer *buf, const uint8_t *data, size_t data_len, SecureBufferHashAlgorithm algo);
+
+	// Allocation-free variants: write into out[0 .. out_cap) and set *out_len. When out_cap is
+	// too small they return SECUREBUFFER_ERROR_BUFFER_OVERFLOW with *out_len set to the size needed.
+	SECUREBUFFER_API SecureBufferError securebuffer_hmac_into(SecureBuffer *buf, const uint8_t *data, size_t data_len, uint8_t *out, size_t out_cap, size_t *out_len);
+	SECUREBUFFER_API SecureBufferError securebuffer_hmac_hex_into(SecureBuffer *buf, const uint8_t *data, size_t data_len, char *out, size_t out_cap, size_t *out_len);
+	SECUREBUFFER_API SecureBufferError securebuffer_hmac_base64url_into(SecureBuffer *buf, const uint8_t *data, size_t data_len, char *out, size_t out_cap, size_t *out_len);
+	// PBKDF2-HMAC-SHA256 filling the buffer's full capacity, on the calling thread
 	SECUREBUFFER_API SecureBufferError securebuffer_derive_key(SecureBuffer *buf, const uint8_t *password, size_t password_len, const uint8_t *salt, size_t salt_len, uint32_t iterations);
+
+	// Asynchronous PBKDF2-HMAC-SHA256 on a bounded worker pool. Each worker runs up to eight
+	// derivations in lockstep on the multi-buffer SHA-256 engine. submit never blocks: a full
+	// queue returns SECUREBUFFER_ERROR_QUEUE_FULL and iterations above the cap return
+	// SECUREBUFFER_ERROR_POLICY_VIOLATION. The password is not retained. Completion is
+	// reported through the optional callback (on a worker thread, must not block), poll or
+	// wait; take moves the key into a SecureBuffer. The callback runs before poll and wait
+	// report the job ready and may itself take the key. Freeing the service waits for queued jobs.
+	SECUREBUFFER_API SecureKdfService *securebuffer_kdf_service_new(size_t workers, size_t max_queue, uint32_t max_iterations);
+	SECUREBUFFER_API SecureBufferError securebuffer_kdf_submit(
+		const SecureKdfService *service,
+		const uint8_t *password,
+		size_t password_len,
+		const uint8_t *salt,
+		size_t salt_len,
+		uint32_t iterations,
+		size_t out_len,
+		SecureKdfCallback callback,
+		void *user_data,
+		SecureKdfJob **job_out);
+	SECUREBUFFER_API int securebuffer_kdf_poll(const SecureKdfJob *job); // 1 ready, 0 pending
+	SECUREBUFFER_API SecureBufferError securebuffer_kdf_wait(const SecureKdfJob *job, uint64_t timeout_ms);
+	SECUREBUFFER_API SecureBufferError securebuffer_kdf_take(const SecureKdfJob *job, SecureBuffer *dest);
+	SECUREBUFFER_API void securebuffer_kdf_job_free(SecureKdfJob *job);
+	SECUREBUFFER_API int securebuffer_kdf_get_stats(const SecureKdfService *service, SecureKdfStats *stats);
+	SECUREBUFFER_API void securebuffer_kdf_service_free(SecureKdfService *service);
+	// 32-byte key, 12-byte nonce; output holds ciphertext || 16-byte tag. Pass buf as output to
+	// work in place (encryption then needs 16 bytes of spare capacity). A failed decryption
+	// returns SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED and wipes the output.
 	SECUREBUFFER_API SecureBufferError securebuffer_encrypt_aes256_gcm(SecureBuffer *buf, const uint8_t *key, const uint8_t *nonce, SecureBuffer *output);
 	SECUREBUFFER_API SecureBufferError securebuffer_decrypt_aes256_gcm(SecureBuffer *buf, const uint8_t *key, const uint8_t *nonce, SecureBuffer *output);
+
+	// Streaming AES-256-GCM: update_aad, then update / update_iov in chunks of any size, then
+	// final (encrypt) or verify (decrypt). Updates work in place when input == output, so a
+	// large payload needs no second locked copy. Decrypted bytes are unauthenticated until
+	// verify succeeds and must be discarded if it fails.
+	SECUREBUFFER_API SecureAeadContext *securebuffer_aead_new(const uint8_t *key, size_t key_len, const uint8_t *nonce, size_t nonce_len, bool encrypt);
+	SECUREBUFFER_API SecureBufferError securebuffer_aead_update_aad(SecureAeadContext *ctx, const uint8_t *aad, size_t aad_len);
+	SECUREBUFFER_API SecureBufferError securebuffer_aead_update(SecureAeadContext *ctx, const uint8_t *input, uint8_t *output, size_t len);
+	SECUREBUFFER_API SecureBufferError securebuffer_aead_update_iov(SecureAeadContext *ctx, const SecureBufferIoVec *iov, size_t count);
+	SECUREBUFFER_API SecureBufferError securebuffer_aead_final(SecureAeadContext *ctx, uint8_t tag[16]);
+	SECUREBUFFER_API SecureBufferError securebuffer_aead_verify(SecureAeadContext *ctx, const uint8_t *tag, size_t tag_len);
+	SECUREBUFFER_API void securebuffer_aead_free(SecureAeadContext *ctx);
 	SECUREBUFFER_API SecureBufferError securebuffer_rotate_key(SecureBuffer *buf);
 
+	// Precomputed HMAC (RFC 2104) keyed with the buffer's contents: the padded-key blocks are
+	// absorbed once and each message starts from a copy of the inner/outer midstates, halving
+	// the compression calls for short messages. SECUREBUFFER_HASH_BLAKE3 uses BLAKE3's keyed mode
+	// instead of HMAC: a 32-byte buffer is the key as-is, any other length is run through
+	// derive_key, and large messages are hashed across SIMD lanes and threads. The context lives in
+	// locked memory; any change to the source buffer (write, zero, rotate_key, free) makes
+	// compute_into return SECUREBUFFER_ERROR_EXPIRED until a new context is created.
+	SECUREBUFFER_API SecureHmacContext *securebuffer_hmac_context_new(const SecureBuffer *buf, SecureBufferHashAlgorithm algo);
+	SECUREBUFFER_API void securebuffer_hmac_context_free(SecureHmacContext *ctx);
+	SECUREBUFFER_API SecureBufferError securebuffer_hmac_context_compute_into(const SecureHmacContext *ctx, const uint8_t *data, size_t data_len, uint8_t *out, size_t out_cap, size_t *out_len);
+	// Batch form: digest i at out[i * digest size]; SHA256 batches run on the multi-buffer engine,
+	// BLAKE3 parallelizes within each message
+	SECUREBUFFER_API SecureBufferError securebuffer_hmac_context_compute_batch_into(
+		const SecureHmacContext *ctx,
+		const uint8_t **data_list,
+		const size_t *data_lens,
+		size_t count,
+		uint8_t *out,
+		size_t out_cap,
+		size_t *out_len);
+
 	// === Hardware-backed Security ===
 	SECUREBUFFER_API SecureBufferError securebuffer_bind_to_hardware(SecureBuffer *buf);
 	SECUREBUFFER_API bool securebuffer_is_hardware_backed(const SecureBuffer *buf);
@@ -137,15 +319,54 @@ extern "C"
 	SECUREBUFFER_API SecureBufferError securebuffer_share_with_process(SecureBuffer *buf, int pid);
 #endif
 
+#if defined(__linux__)
+	// Lock-free record ring in a sealed, locked memfd. Hand securebuffer_ring_fd to another
+	// process (SCM_RIGHTS or /proc/<pid>/fd/<n>) and securebuffer_ring_attach it there. One
+	// consumer; one producer, or any number across processes when created with mpsc. Waits
+	// sleep on futexes in the shared pages. timeout_ms 0 never waits, UINT64_MAX waits
+	// forever; a push that finds no room returns SECUREBUFFER_ERROR_QUEUE_FULL and a read
+	// that finds no records SECUREBUFFER_ERROR_EXPIRED. read_batch points into the mapping
+	// without copying; commit_read wipes those records and frees their space. A record whose
+	// length would run past the ring poisons the reader: read_batch then returns
+	// SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED.
+	typedef struct SecureRing SecureRing;
+	SECUREBUFFER_API SecureRing *securebuffer_ring_create(size_t capacity, bool mpsc);
+	SECUREBUFFER_API SecureRing *securebuffer_ring_attach(int fd);
+	SECUREBUFFER_API int securebuffer_ring_fd(const SecureRing *ring);
+	SECUREBUFFER_API SecureBufferError securebuffer_ring_push(const SecureRing *ring, const uint8_t *data, size_t len, uint64_t timeout_ms);
+	SECUREBUFFER_API SecureBufferError securebuffer_ring_push_iov(const SecureRing *ring, const SecureBufferIoVec *iov, size_t count, uint64_t timeout_ms);
+	SECUREBUFFER_API SecureBufferError securebuffer_ring_read_batch(const SecureRing *ring, SecureBufferIoVec *out, size_t max, uint64_t timeout_ms, size_t *count);
+	SECUREBUFFER_API void securebuffer_ring_commit_read(const SecureRing *ring);
+	SECUREBUFFER_API void securebuffer_ring_free(SecureRing *ring);
+#endif
+
 	// === Batch Crypto Operations ===
+	// Batches are hashed side by side: 8 SHA-256 streams per pass on AVX2, or back to back on
+	// SHA-NI / ARMv8 SHA2, whichever securebuffer_get_acceleration_info reports
 	SECUREBUFFER_API char **securebuffer_hmac_batch(
 		SecureBuffer *buf,
 		const uint8_t **data_list,
 		size_t *data_lens,
 		size_t count);
 	SECUREBUFFER_API void securebuffer_free_batch_results(char **results, size_t count);
+	// Raw digests for count inputs, digest i at out[i * SECUREBUFFER_HMAC_SIZE]; out_cap must be
+	// at least count * SECUREBUFFER_HMAC_SIZE
+	SECUREBUFFER_API SecureBufferError securebuffer_hmac_batch_into(
+		SecureBuffer *buf,
+		const uint8_t **data_list,
+		const size_t *data_lens,
+		size_t count,
+		uint8_t *out,
+		size_t out_cap);
 
 	// === Thread Safety ===
+	// Lock-free reads for read-mostly keys: one call, no shared writes, so readers scale with
+	// cores. securebuffer_rotate_key publishes a new key as one version and may run
+	// concurrently; a read it overlaps retries. out_len always receives the contents' length.
+	SECUREBUFFER_API SecureBufferError securebuffer_read_consistent(const SecureBuffer *buf, uint8_t *out, size_t out_cap, size_t *out_len);
+	// HMAC-SHA256 of message keyed with the buffer's contents; out holds SECUREBUFFER_HMAC_SIZE bytes
+	SECUREBUFFER_API SecureBufferError securebuffer_sign_hmac_sha256_into(const SecureBuffer *buf, const uint8_t *message, size_t message_len, uint8_t *out);
+	// Advisory reader/writer lock around multi-call sequences; buffer calls themselves do not take it
 	SECUREBUFFER_API SecureBufferError securebuffer_acquire_read_lock(SecureBuffer *buf);
 	SECUREBUFFER_API SecureBufferError securebuffer_acquire_write_lock(SecureBuffer *buf);
 	SECUREBUFFER_API SecureBufferError securebuffer_release_lock(SecureBuffer *buf);
@@ -160,9 +381,43 @@ extern "C"
 	SECUREBUFFER_API bool securebuffer_is_expired(const SecureBuffer *buf);
 
 	// === SecureChannelPool Operations ===
+	// TLS channels to one host:port, verified against the platform roots. Requests and
+	// responses are framed as a 4-byte big-endian length and the payload. Idle channels are
+	// kept in a lock-free list and health-checked in the background, not at checkout.
+	// max_connections 0 = 100. Freeing the pool fails requests still queued.
+	// Every channel resumes from one shared session-ticket cache. securechannel_pool_new
+	// starts opening 10 idle channels in the background. A channel nearing its lifetime
+	// or latency eviction gets a spare opened ahead of time.
 	SECUREBUFFER_API SecureChannelPool *securechannel_pool_new(size_t max_connections, const char *endpoint);
+	SECUREBUFFER_API SecureChannelPool *securechannel_pool_new_with_options(const char *endpoint, const SecureChannelPoolOptions *options);
 	SECUREBUFFER_API void securechannel_pool_free(SecureChannelPool *pool);
 	SECUREBUFFER_API SecureBufferError securechannel_pool_send(SecureChannelPool *pool, const uint8_t *data, size_t len, SecureBuffer *response);
+	// Only for requests that are safe to process twice. With enable_early_data, a request
+	// that needs a new channel goes out as 0-RTT early data, which an attacker can replay.
+	SECUREBUFFER_API SecureBufferError securechannel_pool_send_idempotent(SecureChannelPool *pool, const uint8_t *data, size_t len, SecureBuffer *response);
+	// Non-blocking: queued requests are written up to pipeline_depth at a time on one
+	// channel and their responses read back in order. A full queue returns
+	// SECUREBUFFER_ERROR_QUEUE_FULL. The callback (on a pool thread, must not block) runs
+	// before poll and wait report the request done; take returns the response or the
+	// request's error.
+	SECUREBUFFER_API SecureBufferError securechannel_pool_submit(
+		SecureChannelPool *pool,
+		const uint8_t *data,
+		size_t len,
+		SecureChannelCallback callback,
+		void *user_data,
+		SecureChannelRequest **request_out);
+	SECUREBUFFER_API SecureBufferError securechannel_pool_submit_idempotent(
+		SecureChannelPool *pool,
+		const uint8_t *data,
+		size_t len,
+		SecureChannelCallback callback,
+		void *user_data,
+		SecureChannelRequest **request_out);
+	SECUREBUFFER_API int securechannel_request_poll(const SecureChannelRequest *request); // 1 done, 0 pending
+	SECUREBUFFER_API SecureBufferError securechannel_request_wait(const SecureChannelRequest *request, uint64_t timeout_ms);
+	SECUREBUFFER_API SecureBufferError securechannel_request_take(const SecureChannelRequest *request, SecureBuffer *response);
+	SECUREBUFFER_API void securechannel_request_free(SecureChannelRequest *request);
 	SECUREBUFFER_API bool securechannel_pool_is_healthy(const SecureChannelPool *pool);
 	SECUREBUFFER_API char *securechannel_pool_get_status_json(const SecureChannelPool *pool);
 	SECUREBUFFER_API double securechannel_pool_get_health_score(const SecureChannelPool *pool);
@@ -171,7 +426,14 @@ extern "C"
 	SECUREBUFFER_API SecureBufferMetrics securebuffer_get_global_metrics(void);
 	SECUREBUFFER_API char *securebuffer_get_metrics_json(void);
 	SECUREBUFFER_API void securebuffer_reset_metrics(void);
+	// Includes securebuffer_kdf_queue_depth, _running, the _latency_seconds histogram and
+	// per-op securebuffer_operation_latency_seconds quantiles
 	SECUREBUFFER_API char *securebuffer_get_prometheus_metrics(void);
+	// Allocation-free: merges the per-thread shards on the stack, cheap enough to poll
+	SECUREBUFFER_API SecureBufferError securebuffer_get_metrics_snapshot(SecureBufferMetricsSnapshot *out);
+	// Copies up to capacity bucket counts; returns SECUREBUFFER_LATENCY_BUCKETS or an error
+	SECUREBUFFER_API int securebuffer_get_latency_histogram(SecureBufferOp op, uint64_t *counts, size_t capacity);
+	SECUREBUFFER_API uint64_t securebuffer_latency_bucket_upper_ns(size_t index);
 
 	// === Utility Functions ===
 	SECUREBUFFER_API void securebuffer_free_cstr(char *s);
@@ -181,22 +443,37 @@ extern "C"
 	SECUREBUFFER_API char *securebuffer_get_build_info(void);
 
 	// === Advanced Enterprise Features ===
+	// Tamper detection keeps a CRC32C tag per 4 KiB chunk (SSE4.2 / ARMv8 CRC when present).
+	// Library writes retag only the chunks they change, and securebuffer_integrity_check
+	// retags in-place edits and verifies the rest. Once a verification schedule is set, a
+	// shared background thread verifies chunks_per_tick chunks every interval_ms and
+	// securebuffer_integrity_check costs only the chunks changed since the last check;
+	// securebuffer_is_tampered reports what the sweep found. interval_ms 0 cancels.
 	SECUREBUFFER_API SecureBufferError securebuffer_enable_tamper_detection(SecureBuffer *buf);
 	SECUREBUFFER_API bool securebuffer_is_tampered(const SecureBuffer *buf);
+	SECUREBUFFER_API SecureBufferError securebuffer_schedule_integrity_verification(const SecureBuffer *buf, uint64_t interval_ms, size_t chunks_per_tick);
 	SECUREBUFFER_API SecureBufferError securebuffer_force_zeroization_schedule(SecureBuffer *buf, uint64_t interval_seconds);
 	SECUREBUFFER_API char *securebuffer_get_security_audit_log(const SecureBuffer *buf);
 	SECUREBUFFER_API SecureBufferError securebuffer_validate_policy_compliance(const SecureBuffer *buf);
 
 	// === Performance Optimizations ===
 	SECUREBUFFER_API bool securebuffer_has_hardware_acceleration(void);
+	// Selected kernels, e.g. "sha256=avx2-8way lanes=8 aes-gcm=aes-ni+pclmul crc32c=sse4.2"; free with securebuffer_free_cstr
 	SECUREBUFFER_API char *securebuffer_get_acceleration_info(void);
+	// Fault the buffer's pages in from the calling thread, so they land on its NUMA node
 	SECUREBUFFER_API SecureBufferError securebuffer_prefault_pages(SecureBuffer *buf);
+	SECUREBUFFER_API size_t securebuffer_numa_node_count(void); // Nodes with CPUs; 1 without NUMA
 	SECUREBUFFER_API double securebuffer_benchmark_operations(size_t buffer_size, size_t iterations);
 
 	// === Enterprise Features ===
+	// Audited operations queue a 32-byte binary record on a per-thread lock-free queue; a
+	// background writer appends them with writev and one fdatasync per batch (at most
+	// every 20 ms). securebuffer_get_security_audit_log serves recent records from memory.
 	SECUREBUFFER_API SecureBufferError securebuffer_enable_audit_logging(const char *log_path);
-	SECUREBUFFER_API SecureBufferError securebuffer_disable_audit_logging(void);
+	SECUREBUFFER_API SecureBufferError securebuffer_disable_audit_logging(void); // Writes queued records first
 	SECUREBUFFER_API bool securebuffer_is_audit_logging_enabled(void);
+	SECUREBUFFER_API SecureBufferError securebuffer_set_audit_backpressure(SecureBufferAuditBackpressure policy);
+	SECUREBUFFER_API SecureBufferError securebuffer_flush_audit_log(void);
 	SECUREBUFFER_API char *securebuffer_get_compliance_report(void);
 	SECUREBUFFER_API SecureBufferError securebuffer_set_enterprise_policy(const char *policy_json);
 
@@ -220,10 +497,10 @@ extern "C"
 		const uint8_t *additional_data_ptr,
 		size_t additional_data_len);
 
-	// Create new buffer pre-filled with fast entropy
+	// Create new buffer pre-filled with fast entropy; free with securebuffer_free
 	SECUREBUFFER_API void *securebuffer_new_with_fast_entropy(size_t capacity);
 
-	// Create new buffer pre-filled with hybrid entropy
+	// Create new buffer pre-filled with hybrid entropy; free with securebuffer_free
 	SECUREBUFFER_API void *securebuffer_new_with_hybrid_entropy(
 		size_t capacity,
 		const uint8_t *headers_ptr,
@@ -284,6 +561,9 @@ extern "C"
 		bool *results);
 
 	// Load entire Bitcoin block into bloom filter
+	// block_data is a wire-format block; every output it creates is inserted as (txid, vout)
+	// (filters with BLOOM_FLAG_REMOVE_SPENT also remove every outpoint the block spends,
+	// which requires the filter to hold the complete UTXO set; see bloom_filter_load_block)
 	SECUREBUFFER_API int bitcoin_bloom_filter_load_block(
 		void *filter,
 		const uint8_t *block_data,
@@ -302,14 +582,17 @@ extern "C"
 	// Get theoretical false positive rate
 	SECUREBUFFER_API double bitcoin_bloom_filter_false_positive_rate(void *filter);
 
-	// Cleanup old entries to maintain performance
+	// Cleanup old entries to maintain performance (rotates out the oldest generation when windowed)
 	SECUREBUFFER_API int bitcoin_bloom_filter_cleanup(void *filter);
 
 	// Auto-cleanup if needed (call periodically)
 	SECUREBUFFER_API int bitcoin_bloom_filter_auto_cleanup(void *filter);
 
 	// === Direct Entropy Functions ===
+	// Served from a per-thread ChaCha20 reservoir reseeded from the OS RNG every 1 MiB and
+	// after fork, and from block headers passed to the hybrid/mix functions; no syscall per call
 	SECUREBUFFER_API int fast_entropy_c(unsigned char *output);
+	SECUREBUFFER_API SecureBufferError securebuffer_fill_entropy(uint8_t *output, size_t len);
 	SECUREBUFFER_API int hybrid_entropy_c(
 		const unsigned char **headers,
 		const size_t *header_lengths,
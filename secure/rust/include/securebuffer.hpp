@@ -0,0 +1,535 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - C++20 SecureBuffer bindings
+// Header-only layer over securebuffer.h: move-only owners that free each handle exactly
+// once, std::span arguments passed straight to the flat-array entry points, fixed-extent
+// spans for keys, nonces and digests, and scoped guards for the advisory buffer lock.
+// Calls return SecureBufferError as the C API does; only constructors throw.
+
+#ifndef SECUREBUFFER_HPP
+#define SECUREBUFFER_HPP
+
+#include "securebuffer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace securebuffer
+{
+	using Error = SecureBufferError;
+
+	inline constexpr std::size_t hmac_size = SECUREBUFFER_HMAC_SIZE;
+	inline constexpr std::size_t hmac_hex_size = SECUREBUFFER_HMAC_HEX_SIZE;
+	inline constexpr std::size_t aead_key_size = 32;
+	inline constexpr std::size_t aead_nonce_size = 12;
+	inline constexpr std::size_t aead_tag_size = 16;
+
+	using Bytes = std::span<const uint8_t>;
+	using MutableBytes = std::span<uint8_t>;
+	using DigestOut = std::span<uint8_t, hmac_size>;
+	using AeadKey = std::span<const uint8_t, aead_key_size>;
+	using AeadNonce = std::span<const uint8_t, aead_nonce_size>;
+
+	// Thrown when a constructor cannot produce a usable handle
+	class error : public std::runtime_error
+	{
+	public:
+		error(Error code, const char *what) : std::runtime_error(std::string(what) + " (error " + std::to_string(code) + ")"), code_(code) {}
+		Error code() const noexcept { return code_; }
+
+	private:
+		Error code_;
+	};
+
+	namespace detail
+	{
+		// Unique owner of a C handle released by Free
+		template <class T, void (*Free)(T *)>
+		class Handle
+		{
+		public:
+			Handle() noexcept = default;
+			explicit Handle(T *ptr) noexcept : ptr_(ptr) {}
+			Handle(Handle &&other) noexcept : ptr_(std::exchange(other.ptr_, nullptr)) {}
+			Handle &operator=(Handle &&other) noexcept
+			{
+				reset(std::exchange(other.ptr_, nullptr));
+				return *this;
+			}
+			Handle(const Handle &) = delete;
+			Handle &operator=(const Handle &) = delete;
+			~Handle() { reset(); }
+
+			T *get() const noexcept { return ptr_; }
+			T *release() noexcept { return std::exchange(ptr_, nullptr); }
+			void reset(T *ptr = nullptr) noexcept
+			{
+				if (T *old = std::exchange(ptr_, ptr))
+					Free(old);
+			}
+			explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+		private:
+			T *ptr_ = nullptr;
+		};
+
+		// The C API takes const uint8_t ** for read-only pointer lists
+		inline const uint8_t **pointer_list(std::span<const uint8_t *const> list) noexcept
+		{
+			return const_cast<const uint8_t **>(list.data());
+		}
+	} // namespace detail
+
+	// String returned by the library, freed with securebuffer_free_cstr
+	class CString : public detail::Handle<char, &securebuffer_free_cstr>
+	{
+	public:
+		using Handle::Handle;
+		std::string_view view() const noexcept { return get() ? std::string_view(get()) : std::string_view(); }
+	};
+
+	// Hex digests from securebuffer_hmac_batch, freed together
+	class BatchResults
+	{
+	public:
+		BatchResults() noexcept = default;
+		BatchResults(char **results, std::size_t count) noexcept : results_(results), count_(results ? count : 0) {}
+		BatchResults(BatchResults &&other) noexcept
+			: results_(std::exchange(other.results_, nullptr)), count_(std::exchange(other.count_, 0)) {}
+		BatchResults &operator=(BatchResults &&other) noexcept
+		{
+			reset();
+			results_ = std::exchange(other.results_, nullptr);
+			count_ = std::exchange(other.count_, 0);
+			return *this;
+		}
+		BatchResults(const BatchResults &) = delete;
+		BatchResults &operator=(const BatchResults &) = delete;
+		~BatchResults() { reset(); }
+
+		std::size_t size() const noexcept { return count_; }
+		std::string_view operator[](std::size_t i) const noexcept { return results_[i] ? std::string_view(results_[i]) : std::string_view(); }
+		explicit operator bool() const noexcept { return results_ != nullptr; }
+
+	private:
+		void reset() noexcept
+		{
+			if (results_)
+				securebuffer_free_batch_results(std::exchange(results_, nullptr), std::exchange(count_, 0));
+		}
+
+		char **results_ = nullptr;
+		std::size_t count_ = 0;
+	};
+
+	// Locked, zeroized-on-free memory owned by one SecureBuffer handle
+	class Buffer
+	{
+	public:
+		explicit Buffer(std::size_t capacity, SecureBufferSecurityLevel level = SECUREBUFFER_SECURITY_STANDARD)
+			: handle_(level == SECUREBUFFER_SECURITY_STANDARD ? securebuffer_new(capacity)
+															  : securebuffer_new_with_security_level(capacity, level))
+		{
+			if (!handle_)
+				throw std::bad_alloc();
+		}
+
+		// Take ownership of a handle from the C API, e.g. securebuffer_new_with_fast_entropy
+		static Buffer adopt(SecureBuffer *raw) noexcept { return Buffer(raw); }
+
+		SecureBuffer *get() const noexcept { return handle_.get(); }
+		SecureBuffer *release() noexcept { return handle_.release(); }
+		explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+		std::size_t size() const noexcept { return securebuffer_len(get()); }
+		std::size_t capacity() const noexcept { return securebuffer_capacity(get()); }
+
+		// Valid until the contents next change; hold a ReadLock while another thread may write
+		Bytes contents() const noexcept
+		{
+			const uint8_t *data = securebuffer_data_readonly(get());
+			return data ? Bytes(data, size()) : Bytes();
+		}
+
+		[[nodiscard]] Error assign(Bytes data) noexcept { return securebuffer_copy(get(), data.data(), data.size()); }
+		[[nodiscard]] Error rotate_key() noexcept { return securebuffer_rotate_key(get()); }
+
+		// Lock-free snapshot; len receives the contents' length even when out is too small
+		[[nodiscard]] Error read_consistent(MutableBytes out, std::size_t &len) const noexcept
+		{
+			return securebuffer_read_consistent(get(), out.data(), out.size(), &len);
+		}
+
+		[[nodiscard]] Error hmac_into(Bytes message, DigestOut out) noexcept
+		{
+			std::size_t len = 0;
+			return securebuffer_hmac_into(get(), message.data(), message.size(), out.data(), out.size(), &len);
+		}
+
+		[[nodiscard]] Error hmac_hex_into(Bytes message, std::span<char, hmac_hex_size> out) noexcept
+		{
+			std::size_t len = 0;
+			return securebuffer_hmac_hex_into(get(), message.data(), message.size(), out.data(), out.size(), &len);
+		}
+
+		// Digest i lands at out[i * hmac_size]; messages and lengths are parallel arrays
+		[[nodiscard]] Error hmac_batch_into(std::span<const uint8_t *const> messages, std::span<const std::size_t> lengths, MutableBytes out) noexcept
+		{
+			if (messages.size() != lengths.size())
+				return SECUREBUFFER_ERROR_INVALID_SIZE;
+			return securebuffer_hmac_batch_into(get(), detail::pointer_list(messages), lengths.data(), messages.size(), out.data(), out.size());
+		}
+
+		BatchResults hmac_batch_hex(std::span<const uint8_t *const> messages, std::span<std::size_t> lengths) noexcept
+		{
+			if (messages.size() != lengths.size())
+				return {};
+			return BatchResults(securebuffer_hmac_batch(get(), detail::pointer_list(messages), lengths.data(), messages.size()), messages.size());
+		}
+
+		// HMAC-SHA256 of message keyed with the contents; safe against a concurrent rotate_key
+		[[nodiscard]] Error sign_hmac_sha256(Bytes message, DigestOut out) const noexcept
+		{
+			return securebuffer_sign_hmac_sha256_into(get(), message.data(), message.size(), out.data());
+		}
+
+		[[nodiscard]] Error seal_into(AeadKey key, AeadNonce nonce, Buffer &out) noexcept
+		{
+			return securebuffer_encrypt_aes256_gcm(get(), key.data(), nonce.data(), out.get());
+		}
+		[[nodiscard]] Error seal_in_place(AeadKey key, AeadNonce nonce) noexcept
+		{
+			return securebuffer_encrypt_aes256_gcm(get(), key.data(), nonce.data(), get());
+		}
+		[[nodiscard]] Error open_into(AeadKey key, AeadNonce nonce, Buffer &out) noexcept
+		{
+			return securebuffer_decrypt_aes256_gcm(get(), key.data(), nonce.data(), out.get());
+		}
+		[[nodiscard]] Error open_in_place(AeadKey key, AeadNonce nonce) noexcept
+		{
+			return securebuffer_decrypt_aes256_gcm(get(), key.data(), nonce.data(), get());
+		}
+
+		[[nodiscard]] Error derive_key(Bytes password, Bytes salt, uint32_t iterations) noexcept
+		{
+			return securebuffer_derive_key(get(), password.data(), password.size(), salt.data(), salt.size(), iterations);
+		}
+
+		[[nodiscard]] Error enable_tamper_detection() noexcept { return securebuffer_enable_tamper_detection(get()); }
+		bool is_tampered() const noexcept { return securebuffer_is_tampered(get()); }
+		bool integrity_check() const noexcept { return securebuffer_integrity_check(get()); }
+		[[nodiscard]] Error schedule_integrity_verification(uint64_t interval_ms, std::size_t chunks_per_tick) const noexcept
+		{
+			return securebuffer_schedule_integrity_verification(get(), interval_ms, chunks_per_tick);
+		}
+
+		CString security_audit_log() const noexcept { return CString(securebuffer_get_security_audit_log(get())); }
+
+	private:
+		explicit Buffer(SecureBuffer *raw) noexcept : handle_(raw) {}
+
+		detail::Handle<SecureBuffer, &securebuffer_free> handle_;
+	};
+
+	// Shared hold of a buffer's advisory lock for the guard's scope
+	class ReadLock
+	{
+	public:
+		explicit ReadLock(Buffer &buffer) noexcept : buffer_(&buffer) { (void)securebuffer_acquire_read_lock(buffer.get()); }
+		ReadLock(ReadLock &&other) noexcept : buffer_(std::exchange(other.buffer_, nullptr)) {}
+		ReadLock(const ReadLock &) = delete;
+		ReadLock &operator=(const ReadLock &) = delete;
+		ReadLock &operator=(ReadLock &&) = delete;
+		~ReadLock()
+		{
+			if (buffer_)
+				(void)securebuffer_release_lock(buffer_->get());
+		}
+
+		Bytes contents() const noexcept { return buffer_->contents(); }
+
+	private:
+		Buffer *buffer_;
+	};
+
+	// Exclusive hold of a buffer's advisory lock for the guard's scope
+	class WriteLock
+	{
+	public:
+		explicit WriteLock(Buffer &buffer) noexcept : buffer_(&buffer) { (void)securebuffer_acquire_write_lock(buffer.get()); }
+		WriteLock(WriteLock &&other) noexcept : buffer_(std::exchange(other.buffer_, nullptr)) {}
+		WriteLock(const WriteLock &) = delete;
+		WriteLock &operator=(const WriteLock &) = delete;
+		WriteLock &operator=(WriteLock &&) = delete;
+		~WriteLock()
+		{
+			if (buffer_)
+				(void)securebuffer_release_lock(buffer_->get());
+		}
+
+		Buffer &buffer() const noexcept { return *buffer_; }
+		[[nodiscard]] Error assign(Bytes data) const noexcept { return buffer_->assign(data); }
+
+	private:
+		Buffer *buffer_;
+	};
+
+	// Precomputed HMAC keyed with a buffer; expires when that buffer changes
+	class HmacContext
+	{
+	public:
+		explicit HmacContext(const Buffer &key, SecureBufferHashAlgorithm algorithm = SECUREBUFFER_HASH_SHA256)
+			: handle_(securebuffer_hmac_context_new(key.get(), algorithm))
+		{
+			if (!handle_)
+				throw error(SECUREBUFFER_ERROR_INVALID_SIZE, "failed to create HMAC context");
+		}
+
+		SecureHmacContext *get() const noexcept { return handle_.get(); }
+
+		[[nodiscard]] Error compute_into(Bytes message, MutableBytes out, std::size_t &len) const noexcept
+		{
+			return securebuffer_hmac_context_compute_into(get(), message.data(), message.size(), out.data(), out.size(), &len);
+		}
+
+		[[nodiscard]] Error compute_batch_into(std::span<const uint8_t *const> messages, std::span<const std::size_t> lengths, MutableBytes out, std::size_t &len) const noexcept
+		{
+			if (messages.size() != lengths.size())
+				return SECUREBUFFER_ERROR_INVALID_SIZE;
+			return securebuffer_hmac_context_compute_batch_into(get(), detail::pointer_list(messages), lengths.data(), messages.size(), out.data(), out.size(), &len);
+		}
+
+	private:
+		detail::Handle<SecureHmacContext, &securebuffer_hmac_context_free> handle_;
+	};
+
+	// Streaming AES-256-GCM; see securebuffer_aead_new
+	class AeadContext
+	{
+	public:
+		AeadContext(AeadKey key, AeadNonce nonce, bool encrypt)
+			: handle_(securebuffer_aead_new(key.data(), key.size(), nonce.data(), nonce.size(), encrypt))
+		{
+			if (!handle_)
+				throw error(SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED, "failed to create AEAD context");
+		}
+
+		SecureAeadContext *get() const noexcept { return handle_.get(); }
+
+		[[nodiscard]] Error update_aad(Bytes aad) noexcept { return securebuffer_aead_update_aad(get(), aad.data(), aad.size()); }
+		[[nodiscard]] Error update(Bytes input, MutableBytes output) noexcept
+		{
+			if (output.size() < input.size())
+				return SECUREBUFFER_ERROR_BUFFER_OVERFLOW;
+			return securebuffer_aead_update(get(), input.data(), output.data(), input.size());
+		}
+		[[nodiscard]] Error update_in_place(MutableBytes data) noexcept { return securebuffer_aead_update(get(), data.data(), data.data(), data.size()); }
+		[[nodiscard]] Error update_iov(std::span<const SecureBufferIoVec> iov) noexcept { return securebuffer_aead_update_iov(get(), iov.data(), iov.size()); }
+		[[nodiscard]] Error finalize(std::span<uint8_t, aead_tag_size> tag) noexcept { return securebuffer_aead_final(get(), tag.data()); }
+		[[nodiscard]] Error verify(std::span<const uint8_t, aead_tag_size> tag) noexcept { return securebuffer_aead_verify(get(), tag.data(), tag.size()); }
+
+	private:
+		detail::Handle<SecureAeadContext, &securebuffer_aead_free> handle_;
+	};
+
+	class Pool;
+
+	// One pool slot, returned (and zeroized) when the owner goes out of scope
+	class PoolSlot
+	{
+	public:
+		PoolSlot() noexcept = default;
+		PoolSlot(PoolSlot &&other) noexcept
+			: pool_(std::exchange(other.pool_, nullptr)), data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+		PoolSlot &operator=(PoolSlot &&other) noexcept
+		{
+			reset();
+			pool_ = std::exchange(other.pool_, nullptr);
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+			return *this;
+		}
+		PoolSlot(const PoolSlot &) = delete;
+		PoolSlot &operator=(const PoolSlot &) = delete;
+		~PoolSlot() { reset(); }
+
+		// The whole slot, which may be larger than requested
+		MutableBytes bytes() const noexcept { return MutableBytes(data_, size_); }
+		explicit operator bool() const noexcept { return data_ != nullptr; }
+
+		void reset() noexcept
+		{
+			if (data_)
+				(void)securebuffer_pool_release(pool_, std::exchange(data_, nullptr));
+			size_ = 0;
+		}
+
+	private:
+		friend class Pool;
+		PoolSlot(SecureBufferPool *pool, uint8_t *data) noexcept
+			: pool_(pool), data_(data), size_(data ? securebuffer_pool_slot_size(pool, data) : 0) {}
+
+		SecureBufferPool *pool_ = nullptr;
+		uint8_t *data_ = nullptr;
+		std::size_t size_ = 0;
+	};
+
+	// Size-classed arenas of locked slots; must outlive its slots
+	class Pool
+	{
+	public:
+		explicit Pool(std::size_t arena_bytes = 0) : handle_(securebuffer_pool_new(arena_bytes))
+		{
+			if (!handle_)
+				throw std::bad_alloc();
+		}
+
+		// Arenas on every NUMA node, each thread served from its own
+		static Pool numa(std::size_t arena_bytes = 0) { return Pool(NumaTag{}, arena_bytes); }
+
+		SecureBufferPool *get() const noexcept { return handle_.get(); }
+
+		// Empty when size is 0 or above 4096 or its class is exhausted
+		PoolSlot acquire(std::size_t size) noexcept { return PoolSlot(get(), securebuffer_pool_acquire(get(), size)); }
+
+		SecureBufferPoolStats stats() const noexcept
+		{
+			SecureBufferPoolStats stats{};
+			(void)securebuffer_pool_get_stats(get(), &stats);
+			return stats;
+		}
+
+	private:
+		struct NumaTag
+		{
+		};
+		Pool(NumaTag, std::size_t arena_bytes) : handle_(securebuffer_pool_new_numa(arena_bytes))
+		{
+			if (!handle_)
+				throw std::bad_alloc();
+		}
+
+		detail::Handle<SecureBufferPool, &securebuffer_pool_free> handle_;
+	};
+
+	// A submitted derivation
+	class KdfJob
+	{
+	public:
+		KdfJob() noexcept = default;
+		explicit KdfJob(SecureKdfJob *raw) noexcept : handle_(raw) {}
+
+		SecureKdfJob *get() const noexcept { return handle_.get(); }
+		explicit operator bool() const noexcept { return static_cast<bool>(handle_); }
+
+		bool ready() const noexcept { return securebuffer_kdf_poll(get()) == 1; }
+		[[nodiscard]] Error wait(uint64_t timeout_ms) const noexcept { return securebuffer_kdf_wait(get(), timeout_ms); }
+		[[nodiscard]] Error take(Buffer &dest) const noexcept { return securebuffer_kdf_take(get(), dest.get()); }
+
+	private:
+		detail::Handle<SecureKdfJob, &securebuffer_kdf_job_free> handle_;
+	};
+
+	// Bounded PBKDF2 worker pool; destroying it waits for queued jobs
+	class KdfService
+	{
+	public:
+		KdfService(std::size_t workers, std::size_t max_queue, uint32_t max_iterations)
+			: handle_(securebuffer_kdf_service_new(workers, max_queue, max_iterations))
+		{
+			if (!handle_)
+				throw error(SECUREBUFFER_ERROR_INVALID_SIZE, "failed to start KDF service");
+		}
+
+		SecureKdfService *get() const noexcept { return handle_.get(); }
+
+		[[nodiscard]] Error submit(Bytes password, Bytes salt, uint32_t iterations, std::size_t out_len, KdfJob &job,
+								   SecureKdfCallback callback = nullptr, void *user_data = nullptr) const noexcept
+		{
+			SecureKdfJob *raw = nullptr;
+			Error result = securebuffer_kdf_submit(get(), password.data(), password.size(), salt.data(), salt.size(),
+												   iterations, out_len, callback, user_data, &raw);
+			job = KdfJob(raw);
+			return result;
+		}
+
+		SecureKdfStats stats() const noexcept
+		{
+			SecureKdfStats stats{};
+			(void)securebuffer_kdf_get_stats(get(), &stats);
+			return stats;
+		}
+
+	private:
+		detail::Handle<SecureKdfService, &securebuffer_kdf_service_free> handle_;
+	};
+
+#if defined(__linux__)
+	// Shared-memory record ring; see securebuffer_ring_create
+	class Ring
+	{
+	public:
+		Ring(std::size_t capacity, bool mpsc) : handle_(securebuffer_ring_create(capacity, mpsc))
+		{
+			if (!handle_)
+				throw error(SECUREBUFFER_ERROR_INVALID_SIZE, "failed to create shared ring");
+		}
+
+		static Ring attach(int fd)
+		{
+			SecureRing *raw = securebuffer_ring_attach(fd);
+			if (!raw)
+				throw error(SECUREBUFFER_ERROR_ZERO_COPY_FAILED, "fd is not a compatible shared ring");
+			return Ring(raw);
+		}
+
+		SecureRing *get() const noexcept { return handle_.get(); }
+		int fd() const noexcept { return securebuffer_ring_fd(get()); }
+
+		[[nodiscard]] Error push(Bytes record, uint64_t timeout_ms) const noexcept
+		{
+			return securebuffer_ring_push(get(), record.data(), record.size(), timeout_ms);
+		}
+		[[nodiscard]] Error push(std::span<const SecureBufferIoVec> parts, uint64_t timeout_ms) const noexcept
+		{
+			return securebuffer_ring_push_iov(get(), parts.data(), parts.size(), timeout_ms);
+		}
+
+		// Records point into the mapping until commit_read; consumer side only
+		[[nodiscard]] Error read_batch(std::span<SecureBufferIoVec> out, uint64_t timeout_ms, std::size_t &count) const noexcept
+		{
+			return securebuffer_ring_read_batch(get(), out.data(), out.size(), timeout_ms, &count);
+		}
+		void commit_read() const noexcept { securebuffer_ring_commit_read(get()); }
+
+	private:
+		explicit Ring(SecureRing *raw) noexcept : handle_(raw) {}
+
+		detail::Handle<SecureRing, &securebuffer_ring_free> handle_;
+	};
+#endif
+
+	// Allocation-free view of every counter and per-operation latency
+	inline SecureBufferMetricsSnapshot metrics_snapshot() noexcept
+	{
+		SecureBufferMetricsSnapshot snapshot{};
+		(void)securebuffer_get_metrics_snapshot(&snapshot);
+		return snapshot;
+	}
+
+	inline CString prometheus_metrics() noexcept { return CString(securebuffer_get_prometheus_metrics()); }
+	inline CString acceleration_info() noexcept { return CString(securebuffer_get_acceleration_info()); }
+
+	[[nodiscard]] inline Error fill_entropy(MutableBytes out) noexcept
+	{
+		return static_cast<Error>(securebuffer_fill_entropy(out.data(), out.size()));
+	}
+} // namespace securebuffer
+
+#endif // SECUREBUFFER_HPP
@@ -0,0 +1,516 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - Asynchronous security audit log
+// Audited operations append a fixed-size binary record to a per-thread single-producer
+// queue: a clock read, five stores and a release, with no lock, allocation or formatting.
+// One background writer drains every queue straight from the queue memory with writev
+// and makes each batch durable with a single fdatasync (group commit), then keeps the
+// most recent records in memory for `securebuffer_get_security_audit_log`. Readers of
+// that ring copy still-queued records into it themselves and never touch the file.
+//
+// The file starts with a 16-byte header (magic, version, record size) followed by
+// records in drain order, which is in order per thread; sort by timestamp to merge threads.
+
+use std::cell::UnsafeCell;
+use std::collections::VecDeque;
+use std::fmt::Write as _;
+use std::fs::{File, OpenOptions};
+use std::io::{self, IoSlice, Write};
+#[cfg(unix)]
+use std::os::unix::fs::OpenOptionsExt;
+use std::path::Path;
+use std::sync::atomic::{AtomicBool, AtomicU32, AtomicU64, AtomicU8, Ordering};
+use std::sync::{Arc, Condvar, Mutex, MutexGuard, OnceLock};
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+/// Slots per thread queue
+const QUEUE_RECORDS: usize = 1024;
+/// The writer is woken early once a queue is this full
+const WAKE_THRESHOLD: u64 = (QUEUE_RECORDS / 2) as u64;
+/// Longest a record waits in a queue before it is written
+const FLUSH_INTERVAL: Duration = Duration::from_millis(20);
+/// Records kept for `recent`
+const RECENT_RECORDS: usize = 4096;
+
+const FILE_MAGIC: [u8; 8] = *b"SBAUDIT\0";
+const FILE_VERSION: u32 = 1;
+
+/// Audited operations
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+#[repr(u16)]
+pub enum AuditKind {
+    LoggingStarted = 1,
+    LoggingStopped = 2,
+    BufferCreated = 3,
+    BufferDestroyed = 4,
+    KeyRotated = 5,
+    Sealed = 6,
+    Opened = 7,
+    KeyDerived = 8,
+    TamperDetected = 9,
+}
+
+impl AuditKind {
+    fn from_raw(raw: u16) -> Option<Self> {
+        Some(match raw {
+            1 => Self::LoggingStarted,
+            2 => Self::LoggingStopped,
+            3 => Self::BufferCreated,
+            4 => Self::BufferDestroyed,
+            5 => Self::KeyRotated,
+            6 => Self::Sealed,
+            7 => Self::Opened,
+            8 => Self::KeyDerived,
+            9 => Self::TamperDetected,
+            _ => return None,
+        })
+    }
+
+    pub fn name(self) -> &'static str {
+        match self {
+            Self::LoggingStarted => "LOGGING_STARTED",
+            Self::LoggingStopped => "LOGGING_STOPPED",
+            Self::BufferCreated => "BUFFER_CREATED",
+            Self::BufferDestroyed => "BUFFER_DESTROYED",
+            Self::KeyRotated => "KEY_ROTATED",
+            Self::Sealed => "SEALED",
+            Self::Opened => "OPENED",
+            Self::KeyDerived => "KEY_DERIVED",
+            Self::TamperDetected => "TAMPER_DETECTED",
+        }
+    }
+}
+
+/// One audit record as written to the log, little-endian
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+#[repr(C)]
+pub struct AuditRecord {
+    pub timestamp_ns: u64,
+    /// `SecureBuffer` id, 0 for process-wide events
+    pub buffer: u64,
+    /// Kind-specific: capacity, key epoch, bytes processed or iterations
+    pub value: u64,
+    pub thread: u32,
+    pub kind: u16,
+    /// 0 on success, otherwise the operation's `SECUREBUFFER_ERROR_*` code
+    pub status: i16,
+}
+
+const RECORD_LEN: usize = std::mem::size_of::<AuditRecord>();
+const _: () = assert!(RECORD_LEN == 32);
+
+impl AuditRecord {
+    /// One line of `securebuffer_get_security_audit_log`
+    fn write_line(&self, out: &mut String) {
+        let kind = AuditKind::from_raw(self.kind).map_or("UNKNOWN", AuditKind::name);
+        let (secs, nanos) = (self.timestamp_ns / 1_000_000_000, self.timestamp_ns % 1_000_000_000);
+        let _ = writeln!(
+            out,
+            "{secs}.{nanos:09} thread={} buffer={} {kind} value={} status={}",
+            self.thread, self.buffer, self.value, self.status
+        );
+    }
+}
+
+/// What a full queue does to the thread recording into it
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Backpressure {
+    /// Discard the record and count it in `dropped`
+    Drop = 0,
+    /// Wait for the writer; never loses a record while logging is enabled
+    Block = 1,
+}
+
+/// Process-wide audit counters
+pub struct AuditCounters {
+    pub recorded: AtomicU64,
+    pub written: AtomicU64,
+    pub dropped: AtomicU64,
+    pub batches: AtomicU64,
+    pub write_errors: AtomicU64,
+}
+
+pub static GLOBAL_AUDIT_COUNTERS: AuditCounters = AuditCounters {
+    recorded: AtomicU64::new(0),
+    written: AtomicU64::new(0),
+    dropped: AtomicU64::new(0),
+    batches: AtomicU64::new(0),
+    write_errors: AtomicU64::new(0),
+};
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+static BACKPRESSURE: AtomicU8 = AtomicU8::new(Backpressure::Drop as u8);
+static NEXT_THREAD: AtomicU32 = AtomicU32::new(1);
+
+/// True while audit records are being collected; one relaxed load
+#[inline]
+pub fn is_enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+pub fn set_backpressure(policy: Backpressure) {
+    BACKPRESSURE.store(policy as u8, Ordering::Relaxed);
+}
+
+pub fn backpressure() -> Backpressure {
+    if BACKPRESSURE.load(Ordering::Relaxed) == Backpressure::Block as u8 { Backpressure::Block } else { Backpressure::Drop }
+}
+
+/// Single-producer, single-consumer ring owned by one recording thread
+#[repr(C, align(128))]
+struct ThreadQueue {
+    head: AtomicU64, // Written by the owning thread
+    _pad: [u8; 120],
+    tail: AtomicU64, // Written by the writer
+    /// Records before this are already in the recent ring; guarded by RECENT
+    recent_mark: AtomicU64,
+    thread: u32,
+    closed: AtomicBool,
+    slots: Box<[UnsafeCell<AuditRecord>]>,
+}
+
+// One producer writes slots between tail and head; the consumer only reads below head
+unsafe impl Sync for ThreadQueue {}
+unsafe impl Send for ThreadQueue {}
+
+impl ThreadQueue {
+    fn new(thread: u32) -> Self {
+        Self {
+            head: AtomicU64::new(0),
+            _pad: [0; 120],
+            tail: AtomicU64::new(0),
+            recent_mark: AtomicU64::new(0),
+            thread,
+            closed: AtomicBool::new(false),
+            slots: (0..QUEUE_RECORDS).map(|_| UnsafeCell::new(AuditRecord::default())).collect(),
+        }
+    }
+
+    /// The queued records as up to two contiguous byte runs, oldest first
+    fn pending(&self, tail: u64, head: u64) -> [&[u8]; 2] {
+        let start = (tail % QUEUE_RECORDS as u64) as usize;
+        let len = (head - tail) as usize;
+        let first = len.min(QUEUE_RECORDS - start);
+        let bytes = |from: usize, count: usize| unsafe {
+            std::slice::from_raw_parts(self.slots[from].get() as *const u8, count * RECORD_LEN)
+        };
+        [bytes(start, first), bytes(0, len - first)]
+    }
+}
+
+/// Every live thread's queue; threads lock it once, on their first record
+static QUEUES: Mutex<Vec<Arc<ThreadQueue>>> = Mutex::new(Vec::new());
+
+struct QueueHandle(Arc<ThreadQueue>);
+
+impl Drop for QueueHandle {
+    fn drop(&mut self) {
+        self.0.closed.store(true, Ordering::Release);
+    }
+}
+
+thread_local! {
+    static QUEUE: QueueHandle = {
+        let queue = Arc::new(ThreadQueue::new(NEXT_THREAD.fetch_add(1, Ordering::Relaxed)));
+        lock(&QUEUES).push(Arc::clone(&queue));
+        QueueHandle(queue)
+    };
+}
+
+struct Sink {
+    file: Option<File>,
+}
+
+/// Writer state; also taken by `flush` callers, and by recording threads only when no
+/// writer thread is running
+static SINK: Mutex<Sink> = Mutex::new(Sink { file: None });
+/// Most recent records, oldest first. Held only for in-memory copies, never across I/O,
+/// and always taken after SINK.
+static RECENT: Mutex<VecDeque<AuditRecord>> = Mutex::new(VecDeque::new());
+static WAKE: Condvar = Condvar::new();
+static WAKE_PENDING: Mutex<bool> = Mutex::new(false);
+static WRITER: OnceLock<()> = OnceLock::new();
+static WRITER_RUNNING: AtomicBool = AtomicBool::new(false);
+
+fn lock<T>(mutex: &Mutex<T>) -> MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(|e| e.into_inner())
+}
+
+fn wake_writer() {
+    *lock(&WAKE_PENDING) = true;
+    WAKE.notify_one();
+}
+
+fn now_ns() -> u64 {
+    SystemTime::now().duration_since(UNIX_EPOCH).map_or(0, |d| d.as_nanos() as u64)
+}
+
+/// Record an audited operation; a no-op unless logging is enabled
+#[inline]
+pub fn record(kind: AuditKind, buffer: u64, value: u64, status: i32) {
+    if is_enabled() {
+        push(kind, buffer, value, status);
+    }
+}
+
+fn push(kind: AuditKind, buffer: u64, value: u64, status: i32) {
+    let status = status.clamp(i16::MIN as i32, i16::MAX as i32) as i16;
+    // Threads being torn down have no queue left; their events are dropped
+    let pushed = QUEUE.try_with(|handle| {
+        let queue = &*handle.0;
+        let head = queue.head.load(Ordering::Relaxed);
+        let mut tail = queue.tail.load(Ordering::Acquire);
+        while head - tail >= QUEUE_RECORDS as u64 {
+            if backpressure() == Backpressure::Drop || !is_enabled() {
+                return false;
+            }
+            if WRITER_RUNNING.load(Ordering::Acquire) {
+                wake_writer();
+                std::thread::sleep(Duration::from_micros(50));
+            } else {
+                // Nobody else will make room, so write the batch from this thread
+                drain(&mut lock(&SINK));
+            }
+            tail = queue.tail.load(Ordering::Acquire);
+        }
+        let slot = queue.slots[(head % QUEUE_RECORDS as u64) as usize].get();
+        unsafe {
+            slot.write(AuditRecord { timestamp_ns: now_ns(), buffer, value, thread: queue.thread, kind: kind as u16, status });
+        }
+        queue.head.store(head + 1, Ordering::Release);
+        if head + 1 - tail == WAKE_THRESHOLD {
+            wake_writer();
+        }
+        true
+    });
+    if pushed == Ok(true) {
+        GLOBAL_AUDIT_COUNTERS.recorded.fetch_add(1, Ordering::Relaxed);
+    } else {
+        GLOBAL_AUDIT_COUNTERS.dropped.fetch_add(1, Ordering::Relaxed);
+    }
+}
+
+/// Drain every queue: one writev pass and one fdatasync for the whole batch
+fn drain(sink: &mut Sink) {
+    let mut queues = lock(&QUEUES).clone();
+    let marks: Vec<(u64, u64)> = queues.iter()
+        .map(|q| (q.tail.load(Ordering::Relaxed), q.head.load(Ordering::Acquire)))
+        .collect();
+    let total: u64 = marks.iter().map(|(tail, head)| head - tail).sum();
+
+    if total > 0 {
+        let mut parts: Vec<&[u8]> = Vec::with_capacity(queues.len() * 2);
+        for (queue, &(tail, head)) in queues.iter().zip(&marks) {
+            parts.extend(queue.pending(tail, head).into_iter().filter(|run| !run.is_empty()));
+        }
+        if let Some(file) = sink.file.as_mut() {
+            match write_all_vectored(file, &parts).and_then(|()| file.sync_data()) {
+                Ok(()) => {
+                    GLOBAL_AUDIT_COUNTERS.written.fetch_add(total, Ordering::Relaxed);
+                    GLOBAL_AUDIT_COUNTERS.batches.fetch_add(1, Ordering::Relaxed);
+                }
+                Err(_) => {
+                    GLOBAL_AUDIT_COUNTERS.write_errors.fetch_add(1, Ordering::Relaxed);
+                }
+            }
+        }
+
+        let mut recent = lock(&RECENT);
+        collect_recent(&mut recent, queues.iter().zip(&marks).map(|(queue, &(_, head))| (&**queue, head)));
+        for (queue, &(_, head)) in queues.iter().zip(&marks) {
+            queue.tail.store(head, Ordering::Release);
+        }
+    }
+
+    // Forget queues whose thread has exited once they are empty
+    queues.retain(|q| q.closed.load(Ordering::Acquire) && q.tail.load(Ordering::Relaxed) == q.head.load(Ordering::Acquire));
+    if !queues.is_empty() {
+        lock(&QUEUES).retain(|q| !queues.iter().any(|gone| Arc::ptr_eq(q, gone)));
+    }
+}
+
+/// Append each queue's records up to `head` that the recent ring has not seen yet.
+/// Only reads queue memory; the caller holds RECENT.
+fn collect_recent<'a>(recent: &mut VecDeque<AuditRecord>, queues: impl Iterator<Item = (&'a ThreadQueue, u64)>) {
+    let mut batch: Vec<AuditRecord> = Vec::new();
+    for (queue, head) in queues {
+        let start = queue.tail.load(Ordering::Acquire).max(queue.recent_mark.load(Ordering::Relaxed));
+        if start < head {
+            batch.extend((start..head).map(|i| unsafe { *queue.slots[(i % QUEUE_RECORDS as u64) as usize].get() }));
+            queue.recent_mark.store(head, Ordering::Relaxed);
+        }
+    }
+    batch.sort_by_key(|r| r.timestamp_ns);
+    let excess = (recent.len() + batch.len()).saturating_sub(RECENT_RECORDS);
+    recent.drain(..excess.min(recent.len()));
+    let skip = batch.len().saturating_sub(RECENT_RECORDS);
+    recent.extend(&batch[skip..]);
+}
+
+/// writev until every part is written, resuming after short writes
+fn write_all_vectored(file: &mut File, parts: &[&[u8]]) -> io::Result<()> {
+    let (mut index, mut offset) = (0, 0);
+    while index < parts.len() {
+        let slices: Vec<IoSlice<'_>> = std::iter::once(IoSlice::new(&parts[index][offset..]))
+            .chain(parts[index + 1..].iter().map(|part| IoSlice::new(part)))
+            .collect();
+        match file.write_vectored(&slices) {
+            Ok(0) => return Err(io::ErrorKind::WriteZero.into()),
+            Ok(mut written) => {
+                while index < parts.len() && written >= parts[index].len() - offset {
+                    written -= parts[index].len() - offset;
+                    (index, offset) = (index + 1, 0);
+                }
+                offset += written;
+            }
+            Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    Ok(())
+}
+
+fn start_writer() {
+    WRITER.get_or_init(|| {
+        let spawned = std::thread::Builder::new().name("securebuffer-audit".into()).spawn(|| loop {
+            {
+                let mut pending = lock(&WAKE_PENDING);
+                while !*pending {
+                    let timeout = if is_enabled() { FLUSH_INTERVAL } else { Duration::from_secs(3600) };
+                    let (guard, result) = WAKE.wait_timeout(pending, timeout).unwrap_or_else(|e| e.into_inner());
+                    pending = guard;
+                    if result.timed_out() {
+                        break;
+                    }
+                }
+                *pending = false;
+            }
+            drain(&mut lock(&SINK));
+        });
+        // Without a writer thread, records still reach the log through `flush` and
+        // `disable`, and blocking producers drain their own batches
+        WRITER_RUNNING.store(spawned.is_ok(), Ordering::Release);
+    });
+}
+
+/// Write everything recorded so far before returning
+pub fn flush() {
+    drain(&mut lock(&SINK));
+}
+
+/// Start logging to `path`, appending to an existing log. Switching paths flushes the
+/// old log first.
+pub fn enable(path: &Path) -> io::Result<()> {
+    let mut options = OpenOptions::new();
+    options.create(true).append(true);
+    #[cfg(unix)]
+    options.mode(0o600);
+    let mut file = options.open(path)?;
+    if file.metadata()?.len() == 0 {
+        let mut header = [0u8; 16];
+        header[..8].copy_from_slice(&FILE_MAGIC);
+        header[8..12].copy_from_slice(&FILE_VERSION.to_le_bytes());
+        header[12..].copy_from_slice(&(RECORD_LEN as u32).to_le_bytes());
+        file.write_all(&header)?;
+    }
+    {
+        let mut sink = lock(&SINK);
+        drain(&mut sink);
+        sink.file = Some(file);
+    }
+    start_writer();
+    ENABLED.store(true, Ordering::Relaxed);
+    wake_writer();
+    record(AuditKind::LoggingStarted, 0, 0, 0);
+    Ok(())
+}
+
+/// Stop collecting records, write out what is queued and close the log
+pub fn disable() {
+    record(AuditKind::LoggingStopped, 0, 0, 0);
+    ENABLED.store(false, Ordering::Relaxed);
+    let mut sink = lock(&SINK);
+    drain(&mut sink);
+    sink.file = None;
+}
+
+/// Recent records for `buffer` (every record when 0) as text, oldest first. Records
+/// still queued are copied in without writing them; durability stays with the writer.
+pub fn recent(buffer: u64) -> String {
+    let queues = lock(&QUEUES).clone();
+    let mut recent = lock(&RECENT);
+    collect_recent(&mut recent, queues.iter().map(|queue| (&**queue, queue.head.load(Ordering::Acquire))));
+    let mut out = String::new();
+    for record in recent.iter().filter(|r| buffer == 0 || r.buffer == buffer) {
+        record.write_line(&mut out);
+    }
+    out
+}
+
+impl AuditCounters {
+    /// Prometheus text for the audit log
+    pub fn write_prometheus(&self, out: &mut String) {
+        let load = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+        for (name, help, value) in [
+            ("securebuffer_audit_records_total", "Audit records queued", load(&self.recorded)),
+            ("securebuffer_audit_written_total", "Audit records made durable", load(&self.written)),
+            ("securebuffer_audit_dropped_total", "Audit records dropped by backpressure", load(&self.dropped)),
+            ("securebuffer_audit_batches_total", "Group commits to the audit log", load(&self.batches)),
+            ("securebuffer_audit_write_errors_total", "Audit batches that failed to write", load(&self.write_errors)),
+        ] {
+            let _ = writeln!(out, "# HELP {name} {help}\n# TYPE {name} counter\n{name} {value}");
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_audit_records_reach_log_and_ring() {
+        let path = std::env::temp_dir().join(format!("securebuffer-audit-{}.log", std::process::id()));
+        let _ = std::fs::remove_file(&path);
+        set_backpressure(Backpressure::Block);
+        enable(&path).unwrap();
+
+        // Overfill a thread's queue several times over; blocking loses nothing
+        let writers: Vec<_> = (0..3u64)
+            .map(|t| std::thread::spawn(move || {
+                for i in 0..3 * QUEUE_RECORDS as u64 {
+                    record(AuditKind::Sealed, 1_000_000 + t, i, 0);
+                }
+            }))
+            .collect();
+        writers.into_iter().for_each(|w| w.join().unwrap());
+        // With no writer thread running, a blocked producer drains its own queue
+        WRITER_RUNNING.store(false, Ordering::Release);
+        std::thread::spawn(|| {
+            for i in 0..3 * QUEUE_RECORDS as u64 {
+                record(AuditKind::Sealed, 1_000_003, i, 0);
+            }
+        })
+        .join()
+        .unwrap();
+        WRITER_RUNNING.store(true, Ordering::Release);
+        record(AuditKind::TamperDetected, 424_242, 7, -5);
+        let recent_text = recent(424_242);
+        disable();
+        set_backpressure(Backpressure::Drop);
+
+        assert!(recent_text.contains("buffer=424242 TAMPER_DETECTED value=7 status=-5"));
+        let log = std::fs::read(&path).unwrap();
+        let _ = std::fs::remove_file(&path);
+        assert_eq!(&log[..8], &FILE_MAGIC);
+        assert_eq!((log.len() - 16) % RECORD_LEN, 0);
+        let records: Vec<AuditRecord> = log[16..].chunks_exact(RECORD_LEN)
+            .map(|r| unsafe { std::ptr::read_unaligned(r.as_ptr() as *const AuditRecord) })
+            .collect();
+        for t in 0..4u64 {
+            let values: Vec<u64> = records.iter().filter(|r| r.buffer == 1_000_000 + t).map(|r| r.value).collect();
+            assert_eq!(values, (0..3 * QUEUE_RECORDS as u64).collect::<Vec<_>>());
+        }
+        // Other tests' buffers may log meanwhile, so only check both markers are present
+        assert!(records.iter().any(|r| r.kind == AuditKind::LoggingStarted as u16));
+        assert!(records.iter().any(|r| r.kind == AuditKind::LoggingStopped as u16));
+    }
+}
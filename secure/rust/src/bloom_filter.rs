@@ -3,7 +3,10 @@
 // Master Scientist Optimization: Maximum Performance, Stability, Security
 // Supports all blockchain networks like Alchemy, Infura - fastest and most secure
 
-use std::sync::atomic::{AtomicU64, Ordering};
+use std::fs::File;
+use std::io::{Read, Seek, SeekFrom, Write};
+use std::path::Path;
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
 use std::sync::Arc;
 use std::time::{SystemTime, UNIX_EPOCH};
 use rayon::prelude::*;
@@ -12,6 +15,78 @@
 use rand::RngCore;
 use bitcoin_hashes::{Hash, HashEngine};
 
+use crate::bloom_storage::{BloomStorage, BLOOM_STORAGE_NUMA_INTERLEAVE, BLOOM_STORAGE_NUMA_REPLICATE};
+use crate::numa;
+use crate::op_metrics::{self, MetricOp};
+use crate::sha256_batch::{self, Sha256Job};
+
+/// `BloomConfig::flags` bits 0-1 keep their BIP37 update meaning; higher bits select filter modes.
+/// Place all k bits of a key inside one 64-byte block (one cache line per lookup)
+pub const BLOOM_FLAG_BLOCKED: u8 = 0x04;
+
+/// Hash keys with keyed SipHash-1-3 instead of double SHA256 (txids are already uniform);
+/// leave unset for adversarially chosen inputs
+pub const BLOOM_FLAG_FAST_HASH: u8 = 0x08;
+
+/// Keep only bits: no per-key timestamp map, no exact-match verification on contains.
+/// Aging is left to a compact structure instead of an exact key map
+pub const BLOOM_FLAG_LEAN: u8 = 0x10;
+
+/// Replace each bit with a 4-bit saturating counter (128 per 64-byte block) so keys can be
+/// removed; requires `BLOOM_FLAG_BLOCKED` and a single generation. `size` still counts bits
+pub const BLOOM_FLAG_COUNTING: u8 = 0x20;
+
+/// The caller guarantees a single inserting thread (lookups may still run concurrently):
+/// bits are set with plain load/store instead of locked read-modify-write instructions
+pub const BLOOM_FLAG_SINGLE_WRITER: u8 = 0x40;
+
+/// `load_raw_block` also removes every outpoint the block spends; requires
+/// `BLOOM_FLAG_COUNTING`. Only correct when the filter holds the complete UTXO set: a spent
+/// outpoint that was never inserted decrements counters owned by other keys
+pub const BLOOM_FLAG_REMOVE_SPENT: u8 = 0x80;
+
+/// Upper bound on `BloomConfig::size`: 2^36 bits (8 GiB) per generation
+pub const BLOOM_MAX_BITS: usize = 1 << 36;
+
+/// Upper bound on `BloomConfig::generations`
+pub const BLOOM_MAX_GENERATIONS: u8 = 64;
+
+/// Keys hashed together by the batch kernel; two AVX2 registers per SipHash state word
+const HASH_LANES: usize = 8;
+
+/// Txid width of the flat outpoint arrays used by the batch FFI
+const OUTPOINT_TXID_LEN: usize = 32;
+
+/// Longest key hashed from a stack buffer: 64-byte signature plus a 4-byte index
+const MAX_STACK_KEY: usize = 68;
+
+/// Bits per cache-line block: 8 x 64-bit words
+pub const BLOOM_BLOCK_BITS: usize = 512;
+const BLOOM_BLOCK_WORDS: usize = BLOOM_BLOCK_BITS / 64;
+
+/// Counters per block in counting mode: 16 nibbles per word
+const BLOOM_BLOCK_COUNTERS: usize = BLOOM_BLOCK_BITS / 4;
+
+/// Hash-prefix shards a `BloomWriter` buffers into
+const WRITER_SHARDS: usize = 16;
+
+/// Keys a `BloomWriter` shard holds before it is applied to the filter
+const WRITER_SHARD_CAPACITY: usize = 64;
+
+/// Lowest bit of every nibble; counting masks mark a counter by its low bit
+const NIBBLE_LOW: u64 = 0x1111_1111_1111_1111;
+
+/// Odd multipliers deriving the in-block bit positions (one per hash function)
+const BLOCK_SALTS: [u64; 7] = [
+    0x9E37_79B9_7F4A_7C15,
+    0xC2B2_AE3D_27D4_EB4F,
+    0x1656_67B1_9E37_79F9,
+    0xD6E8_FEB8_6659_FD93,
+    0xFF51_AFD7_ED55_8CCD,
+    0xC4CE_B9FE_1A85_EC53,
+    0xA076_1D64_78BD_642F,
+];
+
 /// Network-agnostic hash trait for blockchain data
 pub trait BlockchainHash {
     fn as_bytes(&self) -> &[u8];
@@ -87,6 +162,16 @@ pub struct NetworkConfig {
 }
 
 impl NetworkConfig {
+    /// Look up a built-in network, treating unknown names as custom proof-of-work chains
+    pub fn by_name(name: &str) -> Self {
+        match name {
+            "bitcoin" => Self::bitcoin(),
+            "ethereum" => Self::ethereum(),
+            "solana" => Self::solana(),
+            _ => Self::custom(name, 32, 600, 4_000_000, "pow"),
+        }
+    }
+
     pub fn bitcoin() -> Self {
         Self {
             name: "bitcoin".to_string(),
@@ -110,7 +195,7 @@ pub fn ethereum() -> Self {
     pub fn solana() -> Self {
         Self {
             name: "solana".to_string(),
-            hash_size: 32,
+            hash_size: 64, // Transactions are identified by their first ed25519 signature
             block_time_seconds: 1,
             max_block_size: 50_000_000,
             consensus_mechanism: "proof-of-stake".to_string(),
@@ -136,8 +221,10 @@ pub struct BloomConfig {
     pub size: usize,                // Filter size in bits (must be power of two)
     pub num_hashes: u8,             // Number of hash functions (2-7)
     pub tweak: u32,                 // Random value to modify hash functions
-    pub flags: u8,                  // Filter update flags
+    pub flags: u8,                  // BIP37 update flags (bits 0-1) and BLOOM_FLAG_* modes
     pub max_age_seconds: u64,       // Maximum age for entries before eviction
+    pub generations: u8,            // Sub-filters in the aging ring (0/1 = single filter)
+    pub storage: u8,                // BLOOM_STORAGE_* bits: huge pages, mlock
     pub batch_size: usize,          // Optimal batch size for parallel operations
     pub enable_compression: bool,   // Enable compressed storage for large filters
     pub enable_metrics: bool,       // Enable detailed performance metrics
@@ -177,12 +264,55 @@ pub fn for_network(network: NetworkConfig) -> Self {
             tweak: rand::random(),
             flags: 0,
             max_age_seconds: 86400, // 24 hours
+            generations: 1,
+            storage: 0,
             batch_size,
             enable_compression: false,
             enable_metrics: true,
         }
     }
 
+    /// Create configuration sized for `expected_items` at `fp_rate`
+    pub fn for_capacity(network: NetworkConfig, expected_items: u64, fp_rate: f64) -> Result<Self, BloomFilterError> {
+        let mut config = Self::for_network(network);
+        config.fit_capacity(expected_items, fp_rate)?;
+        Ok(config)
+    }
+
+    /// Pick `size` and `num_hashes` for `expected_items` at `fp_rate` under the current
+    /// layout flags. Size is rounded up to a power of two, so the achieved rate is at or
+    /// below the target; blocked layouts grow further until their rate meets it.
+    pub fn fit_capacity(&mut self, expected_items: u64, fp_rate: f64) -> Result<(), BloomFilterError> {
+        if expected_items == 0 || !(fp_rate > 0.0 && fp_rate < 1.0) {
+            return Err(BloomFilterError::InvalidConfiguration("Capacity needs items > 0 and 0 < fp_rate < 1".into()));
+        }
+
+        let n = expected_items as f64;
+        let ln2 = std::f64::consts::LN_2;
+        let (bits_per_cell, block_cells) = if self.is_counting() { (4, BLOOM_BLOCK_COUNTERS) } else { (1, BLOOM_BLOCK_BITS) };
+        let optimal_bits = (-n * fp_rate.ln() / (ln2 * ln2)).ceil() * bits_per_cell as f64;
+        if optimal_bits > BLOOM_MAX_BITS as f64 {
+            return Err(BloomFilterError::InvalidConfiguration("Capacity exceeds the maximum filter size".into()));
+        }
+        let mut size = (optimal_bits as usize).max(1024).next_power_of_two();
+
+        // Optimal k for the rounded size; the layouts support 2-7 hash functions
+        let num_hashes = ((size as f64 / bits_per_cell as f64 / n) * ln2).round().clamp(2.0, 7.0) as u8;
+
+        if self.is_blocked() {
+            while blocked_false_positive_rate(n, (size / BLOOM_BLOCK_BITS) as f64, num_hashes as f64, block_cells as f64) > fp_rate {
+                if size >= BLOOM_MAX_BITS {
+                    return Err(BloomFilterError::InvalidConfiguration("Capacity exceeds the maximum filter size".into()));
+                }
+                size *= 2;
+            }
+        }
+
+        self.size = size;
+        self.num_hashes = num_hashes;
+        Ok(())
+    }
+
     /// Create high-performance configuration for maximum throughput
     pub fn high_performance(network: NetworkConfig) -> Self {
         let mut config = Self::for_network(network);
@@ -195,6 +325,83 @@ pub fn high_performance(network: NetworkConfig) -> Self {
         config
     }
 
+    /// Create cache-blocked configuration: every lookup touches a single 64-byte line
+    pub fn cache_blocked(network: NetworkConfig) -> Self {
+        let mut config = Self::for_network(network);
+        config.flags |= BLOOM_FLAG_BLOCKED;
+        config
+    }
+
+    /// Create fast-hash configuration for trusted, already-uniform keys such as txids
+    pub fn fast_hash(network: NetworkConfig) -> Self {
+        let mut config = Self::cache_blocked(network);
+        config.flags |= BLOOM_FLAG_FAST_HASH;
+        config
+    }
+
+    /// Create lean configuration: blocked, fast-hashed, bits only (no per-key state)
+    pub fn lean(network: NetworkConfig) -> Self {
+        let mut config = Self::fast_hash(network);
+        config.flags |= BLOOM_FLAG_LEAN;
+        config
+    }
+
+    /// Create counting configuration: blocked 4-bit counters, so spent outpoints can be removed
+    pub fn counting(network: NetworkConfig) -> Self {
+        let mut config = Self::cache_blocked(network);
+        config.flags |= BLOOM_FLAG_COUNTING;
+        config
+    }
+
+    /// Create windowed configuration: a ring of `generations` lean sub-filters,
+    /// each covering `max_age_seconds / generations`
+    pub fn windowed(network: NetworkConfig, max_age_seconds: u64, generations: u8) -> Self {
+        let mut config = Self::lean(network);
+        config.max_age_seconds = max_age_seconds;
+        config.generations = generations;
+        config
+    }
+
+    /// Number of sub-filters in the aging ring (at least one)
+    pub fn generation_count(&self) -> usize {
+        self.generations.max(1) as usize
+    }
+
+    /// Seconds covered by each generation before it is rotated out
+    pub fn rotation_interval_seconds(&self) -> u64 {
+        (self.max_age_seconds / self.generation_count() as u64).max(1)
+    }
+
+    /// Whether the filter keeps only bits and no per-key timestamp map
+    pub fn is_lean(&self) -> bool {
+        self.flags & BLOOM_FLAG_LEAN != 0
+    }
+
+    /// Whether only one thread inserts, so bit updates need no atomic read-modify-write
+    pub fn is_single_writer(&self) -> bool {
+        self.flags & BLOOM_FLAG_SINGLE_WRITER != 0
+    }
+
+    /// Whether cells are 4-bit counters that support removal
+    pub fn is_counting(&self) -> bool {
+        self.flags & BLOOM_FLAG_COUNTING != 0
+    }
+
+    /// Whether loading a block removes the outpoints it spends
+    pub fn removes_spent(&self) -> bool {
+        self.flags & BLOOM_FLAG_REMOVE_SPENT != 0
+    }
+
+    /// Whether keys are hashed with keyed SipHash rather than double SHA256
+    pub fn uses_fast_hash(&self) -> bool {
+        self.flags & BLOOM_FLAG_FAST_HASH != 0
+    }
+
+    /// Whether all bits of a key are confined to one cache-line block
+    pub fn is_blocked(&self) -> bool {
+        self.flags & BLOOM_FLAG_BLOCKED != 0
+    }
+
     /// Create memory-optimized configuration for resource-constrained environments
     pub fn memory_optimized(network: NetworkConfig) -> Self {
         let mut config = Self::for_network(network);
@@ -208,20 +415,135 @@ pub fn memory_optimized(network: NetworkConfig) -> Self {
     }
 }
 
+/// One cache line of filter bits; the bit array is a vector of these so blocks never straddle lines
+#[repr(C, align(64))]
+pub struct BloomBlock {
+    words: [AtomicU64; BLOOM_BLOCK_WORDS],
+}
+
+impl BloomBlock {
+    pub(crate) fn new() -> Self {
+        Self { words: Default::default() }
+    }
+
+    #[cfg_attr(unix, allow(dead_code))]
+    pub(crate) fn words(&self) -> &[AtomicU64; BLOOM_BLOCK_WORDS] {
+        &self.words
+    }
+}
+
+/// One cache line of counters, so stripes owned by different threads never share a line
+#[repr(C, align(64))]
+struct CounterLine {
+    slots: [AtomicU64; 8],
+}
+
+/// Source of per-thread stripe indices
+static NEXT_COUNTER_STRIPE: AtomicUsize = AtomicUsize::new(0);
+
+thread_local! {
+    static COUNTER_STRIPE: usize = NEXT_COUNTER_STRIPE.fetch_add(1, Ordering::Relaxed);
+}
+
+/// Per-generation item counts striped across threads: each thread adds to its own
+/// cache line and readers sum the stripes, so a hot insert path never bounces one
+/// shared counter line between cores. Sums wrap, so removals may land in any stripe.
+struct StripedCounters {
+    lines: Vec<CounterLine>,
+    generations: usize,
+    stripe_lines: usize,
+    stripe_mask: usize,
+}
+
+impl StripedCounters {
+    fn new(generations: usize) -> Self {
+        let stripes = std::thread::available_parallelism().map_or(8, |n| n.get()).next_power_of_two().min(64);
+        let stripe_lines = generations.div_ceil(8);
+        Self {
+            lines: (0..stripes * stripe_lines).map(|_| CounterLine { slots: Default::default() }).collect(),
+            generations,
+            stripe_lines,
+            stripe_mask: stripes - 1,
+        }
+    }
+
+    fn len(&self) -> usize {
+        self.generations
+    }
+
+    #[inline]
+    fn slot(&self, stripe: usize, generation: usize) -> &AtomicU64 {
+        &self.lines[stripe * self.stripe_lines + generation / 8].slots[generation % 8]
+    }
+
+    #[inline]
+    fn local_slot(&self, generation: usize) -> &AtomicU64 {
+        self.slot(COUNTER_STRIPE.with(|s| *s) & self.stripe_mask, generation)
+    }
+
+    /// Add to the calling thread's stripe
+    #[inline]
+    fn add(&self, generation: usize, n: u64) {
+        self.local_slot(generation).fetch_add(n, Ordering::Relaxed);
+    }
+
+    /// Add without a locked instruction; only valid when one thread ever writes
+    #[inline]
+    fn add_exclusive(&self, generation: usize, n: u64) {
+        let slot = self.slot(0, generation);
+        slot.store(slot.load(Ordering::Relaxed).wrapping_add(n), Ordering::Relaxed);
+    }
+
+    #[inline]
+    fn sub(&self, generation: usize, n: u64) {
+        self.local_slot(generation).fetch_sub(n, Ordering::Relaxed);
+    }
+
+    /// Aggregate a generation's count across stripes
+    fn load(&self, generation: usize) -> u64 {
+        let total = (0..=self.stripe_mask).fold(0u64, |sum, s| sum.wrapping_add(self.slot(s, generation).load(Ordering::Relaxed)));
+        // Transiently negative when a removal is summed before its insert
+        if (total as i64) < 0 { 0 } else { total }
+    }
+
+    /// Zero a generation, returning what it held
+    fn take(&self, generation: usize) -> u64 {
+        let total = (0..=self.stripe_mask).fold(0u64, |sum, s| sum.wrapping_add(self.slot(s, generation).swap(0, Ordering::Relaxed)));
+        if (total as i64) < 0 { 0 } else { total }
+    }
+
+    fn set(&self, generation: usize, value: u64) {
+        self.take(generation);
+        self.slot(0, generation).store(value, Ordering::Relaxed);
+    }
+
+    fn total(&self) -> u64 {
+        (0..self.generations).map(|g| self.load(g)).sum()
+    }
+}
+
 /// Universal Sprint Bloom Filter - Network Agnostic High-Performance Filter
 /// Supports all blockchain networks with maximum performance and security
 /// Similar to Alchemy, Infura - the fastest and most secure blockchain API
+///
+/// The bit array holds `generations` equally sized sub-filters. Inserts go to the
+/// current generation, lookups OR across all of them, and rotation clears the
+/// oldest one, so aging costs a memset of one generation instead of a key scan.
 pub struct UniversalBloomFilter {
-    filter_data: Vec<AtomicU64>,
+    filter_data: BloomStorage,
+    replicas: Box<[BloomStorage]>, // BLOOM_STORAGE_NUMA_REPLICATE copies for nodes 1..; filter_data is node 0's
     config: BloomConfig,
-    item_count: AtomicU64,
+    blocks_per_generation: usize,
+    current_generation: AtomicUsize,
+    rotating: AtomicBool,               // Held by the one `rotate` call clearing a generation
+    generation_counts: StripedCounters, // Items inserted into each live generation
     hash_seeds: [u32; 8],
     timestamps: Arc<DashMap<Vec<u8>, u64>>,
     false_positive_count: AtomicU64,
+    chain_tip: AtomicU64,   // Highest block height loaded, persisted in snapshots
     last_cleanup: AtomicU64,
-    entropy_pool: Vec<u8>, // Additional entropy for seeding
-    #[allow(dead_code)]
-    network_stats: Arc<DashMap<String, NetworkStats>>, // Per-network statistics
+    entropy_pool: [u8; 32], // Additional entropy for seeding
+    sip_keys: [u64; 2],     // SipHash key for BLOOM_FLAG_FAST_HASH, derived from seeds and entropy
 }
 
 /// Network-specific performance statistics
@@ -241,24 +563,14 @@ impl UniversalBloomFilter {
     /// Supports all blockchain networks with maximum performance and security
     pub fn new(config: Option<BloomConfig>) -> Result<Self, BloomFilterError> {
         let cfg = config.unwrap_or_default();
+        Self::validate_config(&cfg)?;
 
-        // Validate configuration for security and performance
-        if !cfg.size.is_power_of_two() {
-            return Err(BloomFilterError::InvalidConfiguration("Size must be power of two".into()));
-        }
-        if !(2..=7).contains(&cfg.num_hashes) {
-            return Err(BloomFilterError::InvalidConfiguration("Number of hashes must be 2-7".into()));
-        }
-        if cfg.size < 1024 || cfg.size > 1_000_000 {
-            return Err(BloomFilterError::InvalidConfiguration("Size must be between 1024 and 1M bits".into()));
-        }
-
-    #[allow(clippy::manual_div_ceil)]
-    let bucket_count = (cfg.size + 63) / 64;
+        // Size is a power of two >= 1024, so each generation splits into whole 512-bit blocks
+        let blocks = cfg.size / BLOOM_BLOCK_BITS * cfg.generation_count();
         let mut hash_seeds = [0u32; 8];
 
         // Cryptographically secure seed generation with additional entropy
-        let mut entropy_pool = vec![0u8; 32];
+        let mut entropy_pool = [0u8; 32];
         rand::thread_rng().fill_bytes(&mut entropy_pool);
 
         let seed_bytes = cfg.tweak.to_le_bytes();
@@ -271,28 +583,96 @@ pub fn new(config: Option<BloomConfig>) -> Result<Self, BloomFilterError> {
             ]);
         }
 
+        // Large arrays come back as a huge-page mapping, already zeroed
+        let (filter_data, replicas) = if cfg.storage & BLOOM_STORAGE_NUMA_REPLICATE != 0 && numa::is_numa() {
+            let replicas = (1..numa::node_count())
+                .map(|node| BloomStorage::allocate_replica(blocks, cfg.storage, node))
+                .collect::<Result<_, _>>()?;
+            (BloomStorage::allocate_replica(blocks, cfg.storage, 0)?, replicas)
+        } else {
+            (BloomStorage::allocate(blocks, cfg.storage)?, Box::default())
+        };
+
+        Self::from_parts(cfg, hash_seeds, entropy_pool, filter_data, replicas)
+    }
+
+    /// Validate configuration for security and performance
+    fn validate_config(cfg: &BloomConfig) -> Result<(), BloomFilterError> {
+        if !cfg.size.is_power_of_two() {
+            return Err(BloomFilterError::InvalidConfiguration("Size must be power of two".into()));
+        }
+        if !(2..=7).contains(&cfg.num_hashes) {
+            return Err(BloomFilterError::InvalidConfiguration("Number of hashes must be 2-7".into()));
+        }
+        if cfg.size < 1024 || cfg.size > BLOOM_MAX_BITS {
+            return Err(BloomFilterError::InvalidConfiguration("Size must be between 1024 and 2^36 bits".into()));
+        }
+        if cfg.generations > BLOOM_MAX_GENERATIONS {
+            return Err(BloomFilterError::InvalidConfiguration("Generations must be at most 64".into()));
+        }
+        if cfg.is_counting() && (!cfg.is_blocked() || cfg.generation_count() > 1) {
+            return Err(BloomFilterError::InvalidConfiguration("Counting mode needs the blocked layout and one generation".into()));
+        }
+        if cfg.removes_spent() && !cfg.is_counting() {
+            return Err(BloomFilterError::InvalidConfiguration("Spend removal requires BLOOM_FLAG_COUNTING".into()));
+        }
+        if cfg.storage & BLOOM_STORAGE_NUMA_REPLICATE != 0 && (cfg.is_counting() || cfg.storage & BLOOM_STORAGE_NUMA_INTERLEAVE != 0) {
+            return Err(BloomFilterError::InvalidConfiguration("NUMA replication excludes counting mode and interleaving".into()));
+        }
+        Ok(())
+    }
+
+    /// Assemble a filter around a bit array (and any per-node replicas) and seeds, either
+    /// fresh or restored from a snapshot
+    fn from_parts(
+        cfg: BloomConfig,
+        hash_seeds: [u32; 8],
+        entropy_pool: [u8; 32],
+        filter_data: BloomStorage,
+        replicas: Box<[BloomStorage]>,
+    ) -> Result<Self, BloomFilterError> {
+        let blocks_per_generation = cfg.size / BLOOM_BLOCK_BITS;
+        let generations = cfg.generation_count();
+
+        let mut sip_keys = [0u64; 2];
+        for (i, key) in sip_keys.iter_mut().enumerate() {
+            let seeds = (hash_seeds[4 * i] as u64) << 32 | hash_seeds[4 * i + 1] as u64;
+            let pool = u64::from_le_bytes(entropy_pool[16 * i..16 * i + 8].try_into().unwrap_or_default());
+            *key = seeds ^ pool;
+        }
+
+        // Lean filters never populate the key map; skip its up-front reservation
+        let timestamps = Arc::new(if cfg.is_lean() { DashMap::new() } else { DashMap::with_capacity(10000) });
+
         Ok(UniversalBloomFilter {
-            filter_data: (0..bucket_count).map(|_| AtomicU64::new(0)).collect(),
+            filter_data,
+            replicas,
             config: cfg,
-            item_count: AtomicU64::new(0),
+            blocks_per_generation,
+            current_generation: AtomicUsize::new(0),
+            rotating: AtomicBool::new(false),
+            generation_counts: StripedCounters::new(generations),
             hash_seeds,
-            timestamps: Arc::new(DashMap::with_capacity(10000)),
+            timestamps,
             false_positive_count: AtomicU64::new(0),
+            chain_tip: AtomicU64::new(0),
             last_cleanup: AtomicU64::new(match SystemTime::now().duration_since(UNIX_EPOCH) {
                 Ok(duration) => duration.as_secs(),
                 Err(_) => return Err(BloomFilterError::SystemTimeError),
             }),
             entropy_pool,
-            network_stats: Arc::new(DashMap::new()),
+            sip_keys,
         })
     }
 
     /// Insert a single UTXO with maximum performance optimization
     pub fn insert_utxo(&self, txid: &TransactionId, vout: u32) -> Result<(), BloomFilterError> {
-    let mut preimage = Vec::with_capacity(36);
-    preimage.extend_from_slice(txid.as_bytes());
-        preimage.extend_from_slice(&vout.to_le_bytes());
-        self.insert(&preimage)
+        self.insert_outpoint(txid.as_bytes(), vout)
+    }
+
+    /// Insert an outpoint from raw txid bytes without building a `TransactionId`
+    pub fn insert_outpoint(&self, txid: &[u8], vout: u32) -> Result<(), BloomFilterError> {
+        with_outpoint_key(txid, vout, |key| self.insert(key))
     }
 
     /// Insert a batch of UTXOs in parallel with optimal chunking
@@ -307,13 +687,12 @@ pub fn insert_batch(&self, batch: &[(TransactionId, u32)]) -> Result<(), BloomFi
         };
 
         // Process in optimal chunks for maximum parallelism
-        batch.par_chunks(self.config.batch_size).for_each(|chunk| {
-            chunk.iter().for_each(|(txid, vout)| {
-                let mut preimage = Vec::with_capacity(36);
-                preimage.extend_from_slice(txid.as_bytes());
-                preimage.extend_from_slice(&vout.to_le_bytes());
-                let _ = self.insert_with_timestamp(&preimage, now);
-            });
+        self.on_local_workers(|| {
+            batch.par_chunks(self.config.batch_size).for_each(|chunk| {
+                chunk.iter().for_each(|(txid, vout)| {
+                    let _ = with_outpoint_key(txid.as_bytes(), *vout, |key| self.insert_with_timestamp(key, now));
+                });
+            })
         });
 
         Ok(())
@@ -321,6 +700,10 @@ pub fn insert_batch(&self, batch: &[(TransactionId, u32)]) -> Result<(), BloomFi
 
     /// Internal insert with timestamp tracking
     fn insert(&self, data: &[u8]) -> Result<(), BloomFilterError> {
+        let _timer = op_metrics::sampled_timer(MetricOp::BloomInsert);
+        if self.config.is_lean() {
+            return self.insert_lean(data);
+        }
         let now = match SystemTime::now().duration_since(UNIX_EPOCH) {
             Ok(duration) => duration.as_secs(),
             Err(_) => return Err(BloomFilterError::SystemTimeError),
@@ -330,34 +713,142 @@ fn insert(&self, data: &[u8]) -> Result<(), BloomFilterError> {
 
     /// Insert with timestamp and entropy seeding for maximum performance
     fn insert_with_timestamp(&self, data: &[u8], timestamp: u64) -> Result<(), BloomFilterError> {
+        if self.config.is_lean() {
+            return self.insert_lean(data);
+        }
         if data.is_empty() {
             return Err(BloomFilterError::InvalidInput("Data cannot be empty".into()));
         }
 
         let hashes = self.compute_hashes(data)?;
+        self.set_bits(hashes);
+        self.timestamps.insert(data.to_vec(), timestamp);
 
-        // Parallel bit setting for maximum performance
-        (0..self.config.num_hashes).into_par_iter().for_each(|i| {
-            let bit_pos = self.murmur_hash3(hashes, i as u32) % self.config.size as u64;
-            let bucket_idx = (bit_pos >> 6) as usize;
-            let bit_mask = 1u64 << (bit_pos & 0x3F);
+        Ok(())
+    }
 
-            // Atomic OR for thread safety
-            self.filter_data[bucket_idx].fetch_or(bit_mask, Ordering::Relaxed);
-        });
+    /// Insert a key and report whether it was (probably) already present, hashing once and
+    /// reading each touched word through the same atomic OR that sets it. Re-inserting a
+    /// present key refreshes it into the current generation, so expiry slides from the last
+    /// sighting. Not supported on counting filters, where a re-insert would double count.
+    pub fn test_and_insert(&self, data: &[u8]) -> Result<bool, BloomFilterError> {
+        if data.is_empty() {
+            return Err(BloomFilterError::InvalidInput("Data cannot be empty".into()));
+        }
+        if self.config.is_counting() {
+            return Err(BloomFilterError::InvalidConfiguration("Test-and-insert is not supported by BLOOM_FLAG_COUNTING".into()));
+        }
 
-        self.item_count.fetch_add(1, Ordering::Relaxed);
-        self.timestamps.insert(data.to_vec(), timestamp);
+        let present = self.test_and_set_bits(self.compute_hashes(data)?);
+        if self.config.is_lean() {
+            return Ok(present);
+        }
+        let verified = present && self.verify_hit(data)?;
+        let now = match SystemTime::now().duration_since(UNIX_EPOCH) {
+            Ok(duration) => duration.as_secs(),
+            Err(_) => return Err(BloomFilterError::SystemTimeError),
+        };
+        self.timestamps.insert(data.to_vec(), now);
+        Ok(verified)
+    }
+
+    /// Set a key's bits in the current generation, returning whether they were all set
+    /// there already or the key is present in an older generation. Only keys that were
+    /// new to the current generation are counted.
+    pub(crate) fn test_and_set_bits(&self, hashes: [u64; 2]) -> bool {
+        let generation = self.current_generation.load(Ordering::Acquire);
+        // Picked once: the thread may migrate, and the other copies are "all but this one"
+        let local = self.local_data();
+        let blocks = self.generation_blocks_in(local, generation);
+
+        let mut present = true;
+        if self.config.is_blocked() {
+            let (block, masks) = self.block_masks(blocks, hashes);
+            for (word, mask) in block.words.iter().zip(masks) {
+                if mask != 0 {
+                    present &= self.fetch_or_word(word, mask) & mask == mask;
+                }
+            }
+        } else {
+            for i in 0..self.config.num_hashes as u32 {
+                let bit_pos = self.murmur_hash3(hashes, i) % self.config.size as u64;
+                let mask = 1u64 << (bit_pos & 0x3F);
+                present &= self.fetch_or_word(word_at(blocks, (bit_pos >> 6) as usize), mask) & mask != 0;
+            }
+        }
+        if present {
+            return true;
+        }
+        // Bits already set locally were set in every copy by whoever set them
+        for data in self.copies().filter(|data| !std::ptr::eq(*data, local)) {
+            self.set_key_bits(self.generation_blocks_in(data, generation), hashes);
+        }
+        self.count_inserts(generation, 1);
+
+        let generations = self.generation_counts.len();
+        (1..generations).any(|age| {
+            let older = (generation + generations - age) % generations;
+            self.test_bits_in(self.generation_blocks(older), hashes)
+        })
+    }
+
+    /// Remove a key from a counting filter. Returns false, changing nothing, when the key
+    /// is not present. Saturated counters are left alone (a stale positive at worst).
+    /// Only remove keys that were inserted: removing a false positive decrements
+    /// counters that belong to other keys.
+    pub fn remove(&self, data: &[u8]) -> Result<bool, BloomFilterError> {
+        if !self.config.is_counting() {
+            return Err(BloomFilterError::InvalidConfiguration("Remove requires BLOOM_FLAG_COUNTING".into()));
+        }
+        if data.is_empty() {
+            return Err(BloomFilterError::InvalidInput("Data cannot be empty".into()));
+        }
+
+        let hashes = self.compute_hashes(data)?;
+        if !self.test_bits(hashes) {
+            return Ok(false);
+        }
+        let (block, masks) = self.block_masks(self.generation_blocks(0), hashes);
+        for (word, mask) in block.words.iter().zip(masks) {
+            if mask != 0 {
+                // Only nonzero, unsaturated counters step down, so no nibble borrows
+                self.update_word(word, |w| w - (mask & nibble_nonzero(w) & !nibble_saturated(w)));
+            }
+        }
+        if self.config.is_single_writer() {
+            self.generation_counts.add_exclusive(0, 1u64.wrapping_neg());
+        } else {
+            self.generation_counts.sub(0, 1);
+        }
+        if !self.config.is_lean() {
+            self.timestamps.remove(data);
+        }
+        Ok(true)
+    }
 
+    /// Remove a spent outpoint from a counting filter
+    pub fn remove_outpoint(&self, txid: &[u8], vout: u32) -> Result<bool, BloomFilterError> {
+        with_outpoint_key(txid, vout, |key| self.remove(key))
+    }
+
+    /// Lean insert: hash and set bits, nothing else (no clock read, no allocation)
+    #[inline]
+    fn insert_lean(&self, data: &[u8]) -> Result<(), BloomFilterError> {
+        if data.is_empty() {
+            return Err(BloomFilterError::InvalidInput("Data cannot be empty".into()));
+        }
+        self.set_bits(self.compute_hashes(data)?);
         Ok(())
     }
 
     /// Check if a single UTXO is present with false positive tracking
     pub fn contains_utxo(&self, txid: &TransactionId, vout: u32) -> Result<bool, BloomFilterError> {
-        let mut preimage = Vec::with_capacity(36);
-                preimage.extend_from_slice(txid.as_bytes());
-        preimage.extend_from_slice(&vout.to_le_bytes());
-        self.contains(&preimage)
+        self.contains_outpoint(txid.as_bytes(), vout)
+    }
+
+    /// Check an outpoint from raw txid bytes without building a `TransactionId`
+    pub fn contains_outpoint(&self, txid: &[u8], vout: u32) -> Result<bool, BloomFilterError> {
+        with_outpoint_key(txid, vout, |key| self.contains(key))
     }
 
     /// Check a batch of UTXOs with optimal parallelism
@@ -366,124 +857,603 @@ pub fn contains_batch(&self, batch: &[(TransactionId, u32)]) -> Result<Vec<bool>
             return Ok(Vec::new());
         }
 
-        let results: Vec<bool> = batch.par_iter()
-            .map(|(txid, vout)| self.contains_utxo(txid, *vout).unwrap_or(false))
-            .collect();
+        let results: Vec<bool> = self.on_local_workers(|| {
+            batch.par_iter()
+                .map(|(txid, vout)| self.contains_utxo(txid, *vout).unwrap_or(false))
+                .collect()
+        });
 
         Ok(results)
     }
 
     /// Internal contains check with performance optimizations
     fn contains(&self, data: &[u8]) -> Result<bool, BloomFilterError> {
+        let _timer = op_metrics::sampled_timer(MetricOp::BloomContains);
         if data.is_empty() {
             return Ok(false);
         }
 
         let hashes = self.compute_hashes(data)?;
+        let all_present = self.test_bits(hashes);
 
-        // Early exit optimization - check all bits in parallel
-        let all_present = (0..self.config.num_hashes).into_par_iter().all(|i| {
-            let bit_pos = self.murmur_hash3(hashes, i as u32) % self.config.size as u64;
-            let bucket_idx = (bit_pos >> 6) as usize;
-            let bit_mask = 1u64 << (bit_pos & 0x3F);
-            (self.filter_data[bucket_idx].load(Ordering::Relaxed) & bit_mask) != 0
-        });
+        // Lean filters answer from the bits alone
+        if !all_present || self.config.is_lean() {
+            return Ok(all_present);
+        }
+        self.verify_hit(data)
+    }
 
+    /// Confirm a bit-level hit against the key timestamp map (non-lean filters)
+    fn verify_hit(&self, data: &[u8]) -> Result<bool, BloomFilterError> {
         // Track false positives for analytics
-        if all_present {
-            // Verify with timestamp to reduce false positives
-            if let Some(entry_time) = self.timestamps.get(data) {
-                let now = match SystemTime::now().duration_since(UNIX_EPOCH) {
-                    Ok(duration) => duration.as_secs(),
-                    Err(_) => return Err(BloomFilterError::SystemTimeError),
-                };
-
-                if now.saturating_sub(*entry_time) > self.config.max_age_seconds {
-                    // Entry is too old, treat as false positive
-                    self.false_positive_count.fetch_add(1, Ordering::Relaxed);
-                    return Ok(false);
-                }
-            } else {
-                // No timestamp entry, likely false positive
+        // Verify with timestamp to reduce false positives
+        if let Some(entry_time) = self.timestamps.get(data) {
+            let now = match SystemTime::now().duration_since(UNIX_EPOCH) {
+                Ok(duration) => duration.as_secs(),
+                Err(_) => return Err(BloomFilterError::SystemTimeError),
+            };
+
+            if now.saturating_sub(*entry_time) > self.config.max_age_seconds {
+                // Entry is too old, treat as false positive
                 self.false_positive_count.fetch_add(1, Ordering::Relaxed);
                 return Ok(false);
             }
+        } else {
+            // No timestamp entry, likely false positive
+            self.false_positive_count.fetch_add(1, Ordering::Relaxed);
+            return Ok(false);
         }
 
-        Ok(all_present)
+        Ok(true)
     }
 
-    /// Compute double SHA256 hashes with entropy mixing for maximum security
-    fn compute_hashes(&self, data: &[u8]) -> Result<[u64; 2], BloomFilterError> {
-        let mut engine = bitcoin_hashes::sha256::HashEngine::default();
-        engine.input(data);
-        let hash1 = bitcoin_hashes::sha256::Hash::from_engine(engine);
-
-        // Mix with entropy pool for additional security
-        let mut mixed_data = Vec::with_capacity(data.len() + self.entropy_pool.len());
-        mixed_data.extend_from_slice(data);
-        mixed_data.extend_from_slice(&self.entropy_pool);
-
-        let mut engine2 = bitcoin_hashes::sha256::HashEngine::default();
-        engine2.input(&mixed_data);
-        let hash2 = bitcoin_hashes::sha256::Hash::from_engine(engine2);
+    /// Check outpoints given as flat arrays: `txids` holds `vouts.len()` 32-byte txids back
+    /// to back and `results[i]` receives the answer for `(txids[i], vouts[i])`.
+    /// Large batches are split across threads; nothing is allocated per key.
+    pub fn contains_outpoints(&self, txids: &[u8], vouts: &[u32], results: &mut [bool]) -> Result<(), BloomFilterError> {
+        if txids.len() != vouts.len() * OUTPOINT_TXID_LEN || results.len() != vouts.len() {
+            return Err(BloomFilterError::InvalidInput("Batch arrays have mismatched lengths".into()));
+        }
 
-        Ok([
-            u64::from_le_bytes(hash1[0..8].try_into().map_err(|_| BloomFilterError::HashComputationError)?),
-            u64::from_le_bytes(hash2[0..8].try_into().map_err(|_| BloomFilterError::HashComputationError)?),
-        ])
-    }
+        let chunk = self.config.batch_size.max(HASH_LANES);
+        if vouts.len() < 2 * chunk {
+            return self.contains_outpoints_seq(txids, vouts, results);
+        }
 
-    /// Optimized MurmurHash3 with entropy seeding
-    fn murmur_hash3(&self, hash: [u64; 2], hash_num: u32) -> u64 {
-        let h = hash_num.wrapping_mul(0xFBA4C795).wrapping_add(self.config.tweak);
-        let mut v = h as u64 ^ hash[1];
-        v = v.wrapping_mul(0xFF51AFD7ED558CCD);
-        v = v.wrapping_mul(0xC4CEB9FE1A85EC53);
-        v ^= v >> 32;
-        v ^ hash[0] ^ self.hash_seeds[hash_num as usize % 8] as u64
+        self.on_local_workers(|| {
+            results.par_chunks_mut(chunk)
+                .zip(txids.par_chunks(chunk * OUTPOINT_TXID_LEN))
+                .zip(vouts.par_chunks(chunk))
+                .try_for_each(|((results, txids), vouts)| self.contains_outpoints_seq(txids, vouts, results))
+        })
     }
 
-    /// Load all transactions from a block in parallel with maximum optimization
-    pub fn load_block(&self, block: &BlockData) -> Result<(), BloomFilterError> {
-        if block.transactions.is_empty() {
-            return Ok(());
-        }
+    /// Single-threaded batch kernel: per group of `HASH_LANES` keys, hash all keys, prefetch
+    /// every line they touch, then test; the prefetches overlap the group's cache misses
+    fn contains_outpoints_seq(&self, txids: &[u8], vouts: &[u32], results: &mut [bool]) -> Result<(), BloomFilterError> {
+        let mut hashes = [[0u64; 2]; HASH_LANES];
+
+        for ((results, txids), vouts) in results.chunks_mut(HASH_LANES)
+            .zip(txids.chunks(HASH_LANES * OUTPOINT_TXID_LEN))
+            .zip(vouts.chunks(HASH_LANES))
+        {
+            let n = vouts.len();
+            if self.config.uses_fast_hash() && n == HASH_LANES {
+                siphash13_128_outpoints(self.sip_keys, txids, vouts, &mut hashes);
+            } else {
+                for (lane, hash) in hashes[..n].iter_mut().enumerate() {
+                    let txid = &txids[lane * OUTPOINT_TXID_LEN..(lane + 1) * OUTPOINT_TXID_LEN];
+                    *hash = with_outpoint_key(txid, vouts[lane], |key| self.compute_hashes(key))?;
+                }
+            }
 
-        // Process transactions in parallel chunks
-        block.transactions.par_chunks(self.config.batch_size).for_each(|tx_chunk| {
-            tx_chunk.iter().for_each(|tx| {
-                let txid_bytes = tx.as_bytes();
-                let _ = self.insert(txid_bytes);
-            });
-        });
+            for hash in &hashes[..n] {
+                self.prefetch_bits(*hash);
+            }
 
+            for (lane, result) in results.iter_mut().enumerate() {
+                *result = self.test_bits(hashes[lane]);
+                if *result && !self.config.is_lean() {
+                    let txid = &txids[lane * OUTPOINT_TXID_LEN..(lane + 1) * OUTPOINT_TXID_LEN];
+                    *result = with_outpoint_key(txid, vouts[lane], |key| self.verify_hit(key))?;
+                }
+            }
+        }
         Ok(())
     }
 
-    /// Calculate theoretical false positive rate
-    pub fn false_positive_rate(&self) -> f64 {
-        let n = self.item_count.load(Ordering::Relaxed) as f64;
-        let m = self.config.size as f64;
-        let k = self.config.num_hashes as f64;
-
-        if n == 0.0 || m == 0.0 {
-            0.0
-        } else {
-            (1.0 - (-k * n / m).exp()).powf(k)
+    /// Insert `keys.len() / stride` fixed-width keys packed back to back
+    pub fn insert_packed(&self, keys: &[u8], stride: usize) -> Result<(), BloomFilterError> {
+        if stride == 0 || keys.len() % stride != 0 {
+            return Err(BloomFilterError::InvalidInput("Key buffer is not a whole number of strides".into()));
         }
+        self.insert_keyed(keys.len() / stride, |i| &keys[i * stride..(i + 1) * stride])
     }
 
-    /// Get performance statistics
-    pub fn stats(&self) -> BloomFilterStats {
-        let now = SystemTime::now().duration_since(UNIX_EPOCH)
-            .unwrap_or_default().as_secs();
+    /// Insert variable-width keys: key `i` is `keys[offsets[i]..offsets[i + 1]]`
+    pub fn insert_offsets(&self, keys: &[u8], offsets: &[u64]) -> Result<(), BloomFilterError> {
+        let count = validate_offsets(keys, offsets)?;
+        self.insert_keyed(count, |i| &keys[offsets[i] as usize..offsets[i + 1] as usize])
+    }
 
-        BloomFilterStats {
-            item_count: self.item_count.load(Ordering::Relaxed),
-            false_positive_count: self.false_positive_count.load(Ordering::Relaxed),
+    /// Test `keys.len() / stride` packed fixed-width keys; bit `i % 8` of `bitmap[i / 8]`
+    /// receives key `i`'s answer. Returns the number of hits.
+    pub fn contains_packed(&self, keys: &[u8], stride: usize, bitmap: &mut [u8]) -> Result<u64, BloomFilterError> {
+        if stride == 0 || keys.len() % stride != 0 {
+            return Err(BloomFilterError::InvalidInput("Key buffer is not a whole number of strides".into()));
+        }
+        self.contains_keyed(keys.len() / stride, |i| &keys[i * stride..(i + 1) * stride], bitmap)
+    }
+
+    /// Test variable-width keys laid out as for `insert_offsets` into a result bitmap
+    pub fn contains_offsets(&self, keys: &[u8], offsets: &[u64], bitmap: &mut [u8]) -> Result<u64, BloomFilterError> {
+        let count = validate_offsets(keys, offsets)?;
+        self.contains_keyed(count, |i| &keys[offsets[i] as usize..offsets[i + 1] as usize], bitmap)
+    }
+
+    fn insert_keyed<'k>(&self, count: usize, key: impl Fn(usize) -> &'k [u8] + Sync) -> Result<(), BloomFilterError> {
+        if (0..count).any(|i| key(i).is_empty()) {
+            return Err(BloomFilterError::InvalidInput("Data cannot be empty".into()));
+        }
+        let now = match SystemTime::now().duration_since(UNIX_EPOCH) {
+            Ok(duration) => duration.as_secs(),
+            Err(_) => return Err(BloomFilterError::SystemTimeError),
+        };
+
+        let chunk = self.config.batch_size.max(1);
+        let insert_range = |first: usize, end: usize| (first..end).try_for_each(|i| self.insert_with_timestamp(key(i), now));
+        if count < 2 * chunk {
+            return insert_range(0, count);
+        }
+        self.on_local_workers(|| {
+            (0..count.div_ceil(chunk)).into_par_iter()
+                .try_for_each(|c| insert_range(c * chunk, ((c + 1) * chunk).min(count)))
+        })
+    }
+
+    fn contains_keyed<'k>(&self, count: usize, key: impl Fn(usize) -> &'k [u8] + Sync, bitmap: &mut [u8]) -> Result<u64, BloomFilterError> {
+        let bytes = count.div_ceil(8);
+        if bitmap.len() < bytes {
+            return Err(BloomFilterError::InvalidInput("Result bitmap is too small".into()));
+        }
+
+        // Chunks are whole bitmap bytes so each thread owns its output
+        let chunk = self.config.batch_size.max(HASH_LANES).next_multiple_of(HASH_LANES);
+        if count < 2 * chunk {
+            return self.contains_keyed_seq(0, count, &key, &mut bitmap[..bytes]);
+        }
+        self.on_local_workers(|| {
+            bitmap[..bytes].par_chunks_mut(chunk / 8).enumerate()
+                .map(|(c, out)| self.contains_keyed_seq(c * chunk, ((c + 1) * chunk).min(count), &key, out))
+                .collect::<Result<Vec<u64>, _>>()
+                .map(|hits| hits.iter().sum())
+        })
+    }
+
+    /// One bitmap byte per group of `HASH_LANES` keys: hash the group, prefetch it, test it
+    fn contains_keyed_seq<'k>(&self, first: usize, end: usize, key: &impl Fn(usize) -> &'k [u8], out: &mut [u8]) -> Result<u64, BloomFilterError> {
+        let mut hashes = [[0u64; 2]; HASH_LANES];
+        let mut hits = 0u64;
+
+        for (byte, group) in out.iter_mut().zip((first..end).step_by(HASH_LANES)) {
+            let n = (end - group).min(HASH_LANES);
+            for lane in 0..n {
+                let data = key(group + lane);
+                hashes[lane] = if data.is_empty() { [0; 2] } else { self.compute_hashes(data)? };
+            }
+            for hash in &hashes[..n] {
+                self.prefetch_bits(*hash);
+            }
+
+            *byte = 0;
+            for lane in 0..n {
+                let data = key(group + lane);
+                let hit = !data.is_empty()
+                    && self.test_bits(hashes[lane])
+                    && (self.config.is_lean() || self.verify_hit(data)?);
+                *byte |= (hit as u8) << lane;
+                hits += hit as u64;
+            }
+        }
+        Ok(hits)
+    }
+
+    /// Issue software prefetches for every cache line `test_bits` will read for this key
+    #[inline]
+    fn prefetch_bits(&self, hashes: [u64; 2]) {
+        for generation in 0..self.generation_counts.len() {
+            let blocks = self.generation_blocks(generation);
+            if self.config.is_blocked() {
+                let block_idx = self.murmur_hash3(hashes, 0) as usize & (blocks.len() - 1);
+                prefetch_read(&blocks[block_idx] as *const BloomBlock as *const u8);
+            } else {
+                for i in 0..self.config.num_hashes as u32 {
+                    let bit_pos = self.murmur_hash3(hashes, i) % self.config.size as u64;
+                    prefetch_read(word_at(blocks, (bit_pos >> 6) as usize) as *const AtomicU64 as *const u8);
+                }
+            }
+        }
+    }
+
+    /// Compute the key's base hash pair with the configured hash mode
+    #[inline]
+    pub(crate) fn compute_hashes(&self, data: &[u8]) -> Result<[u64; 2], BloomFilterError> {
+        if self.config.uses_fast_hash() {
+            Ok(siphash13_128(self.sip_keys, data))
+        } else {
+            self.compute_sha256_hashes(data)
+        }
+    }
+
+    /// Compute double SHA256 hashes with entropy mixing for maximum security
+    fn compute_sha256_hashes(&self, data: &[u8]) -> Result<[u64; 2], BloomFilterError> {
+        let mut engine = bitcoin_hashes::sha256::HashEngine::default();
+        engine.input(data);
+        let hash1 = bitcoin_hashes::sha256::Hash::from_engine(engine);
+
+        // Mix with entropy pool for additional security (streamed, no concatenation buffer)
+        let mut engine2 = bitcoin_hashes::sha256::HashEngine::default();
+        engine2.input(data);
+        engine2.input(&self.entropy_pool);
+        let hash2 = bitcoin_hashes::sha256::Hash::from_engine(engine2);
+
+        Ok([
+            u64::from_le_bytes(hash1[0..8].try_into().map_err(|_| BloomFilterError::HashComputationError)?),
+            u64::from_le_bytes(hash2[0..8].try_into().map_err(|_| BloomFilterError::HashComputationError)?),
+        ])
+    }
+
+    /// Optimized MurmurHash3 with entropy seeding
+    fn murmur_hash3(&self, hash: [u64; 2], hash_num: u32) -> u64 {
+        let h = hash_num.wrapping_mul(0xFBA4C795).wrapping_add(self.config.tweak);
+        let mut v = h as u64 ^ hash[1];
+        v = v.wrapping_mul(0xFF51AFD7ED558CCD);
+        v = v.wrapping_mul(0xC4CEB9FE1A85EC53);
+        v ^= v >> 32;
+        v ^ hash[0] ^ self.hash_seeds[hash_num as usize % 8] as u64
+    }
+
+    /// Set a key's k bits in the current generation, sequentially within the key
+    #[inline]
+    fn set_bits(&self, hashes: [u64; 2]) {
+        let generation = self.current_generation.load(Ordering::Acquire);
+        for data in self.copies() {
+            self.set_key_bits(self.generation_blocks_in(data, generation), hashes);
+        }
+        self.count_inserts(generation, 1);
+    }
+
+    /// Set one key's bits (or bump its counters) in `blocks`, without touching the counts
+    #[inline]
+    fn set_key_bits(&self, blocks: &[BloomBlock], hashes: [u64; 2]) {
+        if self.config.is_blocked() {
+            let (block, masks) = self.block_masks(blocks, hashes);
+            for (word, mask) in block.words.iter().zip(masks) {
+                if mask == 0 {
+                    continue;
+                }
+                if self.config.is_counting() {
+                    // Saturated counters stick at 15, the rest step up without carrying
+                    self.update_word(word, |w| w + (mask & !nibble_saturated(w)));
+                } else {
+                    // One atomic OR per touched word
+                    self.or_word(word, mask);
+                }
+            }
+        } else {
+            for i in 0..self.config.num_hashes as u32 {
+                let bit_pos = self.murmur_hash3(hashes, i) % self.config.size as u64;
+                self.or_word(word_at(blocks, (bit_pos >> 6) as usize), 1u64 << (bit_pos & 0x3F));
+            }
+        }
+    }
+
+    /// OR bits into a word: atomic for shared writers, plain load/store for a single writer
+    #[inline(always)]
+    fn or_word(&self, word: &AtomicU64, mask: u64) {
+        if self.config.is_single_writer() {
+            word.store(word.load(Ordering::Relaxed) | mask, Ordering::Relaxed);
+        } else {
+            word.fetch_or(mask, Ordering::Relaxed);
+        }
+    }
+
+    /// `or_word` returning the previous value
+    #[inline(always)]
+    fn fetch_or_word(&self, word: &AtomicU64, mask: u64) -> u64 {
+        if self.config.is_single_writer() {
+            let old = word.load(Ordering::Relaxed);
+            word.store(old | mask, Ordering::Relaxed);
+            old
+        } else {
+            word.fetch_or(mask, Ordering::Relaxed)
+        }
+    }
+
+    /// Apply a counter update: CAS loop for shared writers, plain load/store for a single writer
+    #[inline(always)]
+    fn update_word(&self, word: &AtomicU64, f: impl Fn(u64) -> u64) {
+        if self.config.is_single_writer() {
+            word.store(f(word.load(Ordering::Relaxed)), Ordering::Relaxed);
+        } else {
+            let _ = word.fetch_update(Ordering::Relaxed, Ordering::Relaxed, |w| Some(f(w)));
+        }
+    }
+
+    /// Credit `n` inserted keys to a generation
+    #[inline]
+    fn count_inserts(&self, generation: usize, n: u64) {
+        if self.config.is_single_writer() {
+            self.generation_counts.add_exclusive(generation, n);
+        } else {
+            self.generation_counts.add(generation, n);
+        }
+    }
+
+    /// Shard a key by the position of its first bit (or its block), so each
+    /// `BloomWriter` shard covers one contiguous slice of a generation
+    #[inline]
+    fn writer_shard(&self, hashes: [u64; 2]) -> usize {
+        let (position, range) = if self.config.is_blocked() {
+            (self.murmur_hash3(hashes, 0) & (self.blocks_per_generation as u64 - 1), self.blocks_per_generation as u64)
+        } else {
+            (self.murmur_hash3(hashes, 0) % self.config.size as u64, self.config.size as u64)
+        };
+        (position * WRITER_SHARDS as u64 / range) as usize
+    }
+
+    /// Buffered insert handle for one ingest thread
+    pub fn writer(&self) -> BloomWriter<'_> {
+        BloomWriter {
+            filter: self,
+            shards: (0..WRITER_SHARDS).map(|_| Vec::with_capacity(WRITER_SHARD_CAPACITY)).collect(),
+        }
+    }
+
+    /// Test a key's k bits, newest generation first
+    #[inline]
+    fn test_bits(&self, hashes: [u64; 2]) -> bool {
+        let generations = self.generation_counts.len();
+        if generations == 1 {
+            return self.test_bits_in(self.generation_blocks(0), hashes);
+        }
+        let newest = self.current_generation.load(Ordering::Acquire);
+        (0..generations).any(|age| {
+            let generation = (newest + generations - age) % generations;
+            self.test_bits_in(self.generation_blocks(generation), hashes)
+        })
+    }
+
+    /// Test a key's k bits in one generation, stopping at the first clear bit
+    #[inline]
+    fn test_bits_in(&self, blocks: &[BloomBlock], hashes: [u64; 2]) -> bool {
+        if self.config.is_blocked() {
+            // All loads hit the same cache line
+            let (block, masks) = self.block_masks(blocks, hashes);
+            if self.config.is_counting() {
+                return block.words.iter().zip(masks).all(|(word, mask)| nibble_nonzero(word.load(Ordering::Relaxed)) & mask == mask);
+            }
+            return block.words.iter().zip(masks).all(|(word, mask)| word.load(Ordering::Relaxed) & mask == mask);
+        }
+        (0..self.config.num_hashes as u32).all(|i| {
+            let bit_pos = self.murmur_hash3(hashes, i) % self.config.size as u64;
+            word_at(blocks, (bit_pos >> 6) as usize).load(Ordering::Relaxed) & (1u64 << (bit_pos & 0x3F)) != 0
+        })
+    }
+
+    /// Blocks backing one generation of the ring, in the copy local to the calling thread
+    #[inline]
+    fn generation_blocks(&self, generation: usize) -> &[BloomBlock] {
+        self.generation_blocks_in(self.local_data(), generation)
+    }
+
+    #[inline]
+    fn generation_blocks_in<'a>(&self, data: &'a BloomStorage, generation: usize) -> &'a [BloomBlock] {
+        let start = generation * self.blocks_per_generation;
+        &data[start..start + self.blocks_per_generation]
+    }
+
+    /// The bit array lookups should read: this node's replica, or the only copy
+    #[inline]
+    fn local_data(&self) -> &BloomStorage {
+        if self.replicas.is_empty() {
+            return &self.filter_data;
+        }
+        match numa::current_node() {
+            0 => &self.filter_data,
+            node => self.replicas.get(node - 1).unwrap_or(&self.filter_data),
+        }
+    }
+
+    /// Every copy of the bit array; writes go to all of them
+    fn copies(&self) -> impl Iterator<Item = &BloomStorage> {
+        std::iter::once(&self.filter_data).chain(self.replicas.iter())
+    }
+
+    /// Run batch work on workers pinned to the caller's node when the filter is replicated,
+    /// so every lookup reads the local copy and no worker migrates across sockets
+    fn on_local_workers<R: Send>(&self, f: impl FnOnce() -> R + Send) -> R {
+        if self.replicas.is_empty() {
+            f()
+        } else {
+            numa::install_local(f)
+        }
+    }
+
+    /// Fault in every page of the bit array, each replica from a worker on its own node
+    pub fn prefault(&self) {
+        self.filter_data.prefault();
+        for (i, replica) in self.replicas.iter().enumerate() {
+            numa::on_node(i + 1, || replica.prefault());
+        }
+    }
+
+    /// Pick the block for a key and the per-word masks of its k bits inside that block
+    /// (in counting mode, the low bit of each of its k counters)
+    #[inline]
+    fn block_masks<'a>(&self, blocks: &'a [BloomBlock], hashes: [u64; 2]) -> (&'a BloomBlock, [u64; BLOOM_BLOCK_WORDS]) {
+        // Block count is a power of two, so masking is an unbiased reduction
+        let block_idx = self.murmur_hash3(hashes, 0) as usize & (blocks.len() - 1);
+        let bit_hash = self.murmur_hash3(hashes, 1);
+
+        let mut masks = [0u64; BLOOM_BLOCK_WORDS];
+        if self.config.is_counting() {
+            for salt in &BLOCK_SALTS[..self.config.num_hashes as usize] {
+                // Top 7 bits select one of the 128 counters
+                let counter = (bit_hash.wrapping_mul(*salt) >> 57) as usize;
+                masks[counter >> 4] |= 1u64 << ((counter & 0xF) * 4);
+            }
+            return (&blocks[block_idx], masks);
+        }
+        for salt in &BLOCK_SALTS[..self.config.num_hashes as usize] {
+            // Top 9 bits of the salted product select one of the 512 bits
+            let bit = (bit_hash.wrapping_mul(*salt) >> 55) as usize;
+            masks[bit >> 6] |= 1u64 << (bit & 0x3F);
+        }
+        (&blocks[block_idx], masks)
+    }
+
+    /// Expire the oldest generation and make it the insert target.
+    /// Returns the number of items that aged out. Concurrent calls each advance one
+    /// generation in turn, so every expired generation is cleared and counted once.
+    pub fn rotate(&self) -> u64 {
+        // A rotation clears a whole generation, so waiters yield rather than spin
+        while self.rotating.compare_exchange_weak(false, true, Ordering::Acquire, Ordering::Relaxed).is_err() {
+            std::thread::yield_now();
+        }
+        let generations = self.generation_counts.len();
+        let current = self.current_generation.load(Ordering::Acquire);
+        let next = (current + 1) % generations;
+
+        // Clear before publishing so no insert lands in bits that are about to be wiped
+        for data in self.copies() {
+            for block in self.generation_blocks_in(data, next) {
+                for word in &block.words {
+                    word.store(0, Ordering::Relaxed);
+                }
+            }
+        }
+        let expired = self.generation_counts.take(next);
+        self.current_generation.store(next, Ordering::Release);
+        self.rotating.store(false, Ordering::Release);
+        expired
+    }
+
+    /// Clear every generation and all tracking state
+    pub fn reset(&self) {
+        for block in self.copies().flat_map(|data| data.iter()) {
+            for word in &block.words {
+                word.store(0, Ordering::Relaxed);
+            }
+        }
+        for generation in 0..self.generation_counts.len() {
+            self.generation_counts.take(generation);
+        }
+        self.timestamps.clear();
+        self.false_positive_count.store(0, Ordering::Relaxed);
+    }
+
+    /// Bytes reserved for the bit array across all generations and NUMA replicas
+    pub fn memory_usage(&self) -> usize {
+        self.copies().map(BloomStorage::memory_bytes).sum()
+    }
+
+    /// Items currently held across all live generations
+    fn live_items(&self) -> u64 {
+        self.generation_counts.total()
+    }
+
+    /// Load all transactions from a block in parallel with maximum optimization
+    pub fn load_block(&self, block: &BlockData) -> Result<(), BloomFilterError> {
+        self.chain_tip.fetch_max(block.height, Ordering::Relaxed);
+        if block.transactions.is_empty() {
+            return Ok(());
+        }
+
+        // Process transactions in parallel chunks
+        self.on_local_workers(|| {
+            block.transactions.par_chunks(self.config.batch_size).for_each(|tx_chunk| {
+                tx_chunk.iter().for_each(|tx| {
+                    let txid_bytes = tx.as_bytes();
+                    let _ = self.insert(txid_bytes);
+                });
+            })
+        });
+
+        Ok(())
+    }
+
+    /// Load a serialized wire-format block, inserting every output it creates as an
+    /// outpoint key. With `BLOOM_FLAG_REMOVE_SPENT` it also removes every outpoint the block
+    /// spends, which is only sound when the filter tracks the complete UTXO set.
+    /// The bytes are walked in place: one scan finds transaction boundaries, then txids are
+    /// hashed straight from the buffer, a chunk at a time on the multi-buffer SHA-256
+    /// engine, and inserted in parallel.
+    /// Unlike `load_block` this leaves `chain_tip` alone: the wire format carries no height
+    /// (BIP34 puts it in the coinbase script only for version 2+ blocks), so the caller,
+    /// which knows the height, records it with `set_chain_tip` once the block is loaded.
+    /// Returns the number of outpoints inserted.
+    pub fn load_raw_block(&self, block: &[u8]) -> Result<u64, BloomFilterError> {
+        let spans = scan_raw_block(block)?;
+
+        self.on_local_workers(|| {
+            spans.par_chunks(self.config.batch_size.max(1)).try_for_each(|chunk| {
+                let jobs: Vec<Sha256Job> = chunk.iter().map(|span| span.txid_job(block)).collect();
+                let mut txids = vec![[0u8; 32]; jobs.len()];
+                sha256_batch::sha256d_many(&jobs, &mut txids);
+                chunk.iter().zip(&txids).try_for_each(|(span, txid)| {
+                    (0..span.outputs).try_for_each(|vout| self.insert_outpoint(txid, vout))
+                })
+            })
+        })?;
+
+        // Drop what the block spends; this runs after every insert so outputs created and
+        // spent within the block cancel out. The coinbase spends nothing.
+        if self.config.removes_spent() {
+            spans.get(1..).unwrap_or(&[]).par_chunks(self.config.batch_size.max(1)).try_for_each(|chunk| {
+                chunk.iter().try_for_each(|span| {
+                    span.for_each_prevout(block, |txid, vout| self.remove_outpoint(txid, vout).map(|_| ()))
+                })
+            })?;
+        }
+
+        Ok(spans.iter().map(|span| span.outputs as u64).sum())
+    }
+
+    /// Calculate theoretical false positive rate; a lookup that ORs across
+    /// generations misses only if every generation misses
+    pub fn false_positive_rate(&self) -> f64 {
+        let miss = (0..self.generation_counts.len())
+            .map(|generation| 1.0 - self.generation_false_positive_rate(self.generation_counts.load(generation) as f64))
+            .product::<f64>();
+        1.0 - miss
+    }
+
+    /// Theoretical false positive rate of one generation holding `n` items
+    fn generation_false_positive_rate(&self, n: f64) -> f64 {
+        let m = self.config.size as f64;
+        let k = self.config.num_hashes as f64;
+
+        if n == 0.0 || m == 0.0 {
+            0.0
+        } else if self.config.is_blocked() {
+            let cells = if self.config.is_counting() { BLOOM_BLOCK_COUNTERS } else { BLOOM_BLOCK_BITS };
+            blocked_false_positive_rate(n, self.blocks_per_generation as f64, k, cells as f64)
+        } else {
+            (1.0 - (-k * n / m).exp()).powf(k)
+        }
+    }
+
+    /// Get performance statistics
+    pub fn stats(&self) -> BloomFilterStats {
+        let now = SystemTime::now().duration_since(UNIX_EPOCH)
+            .unwrap_or_default().as_secs();
+
+        BloomFilterStats {
+            item_count: self.live_items(),
+            false_positive_count: self.false_positive_count.load(Ordering::Relaxed),
             theoretical_fp_rate: self.false_positive_rate(),
-            memory_usage_bytes: self.filter_data.len() * 8,
+            memory_usage_bytes: self.memory_usage(),
             timestamp_entries: self.timestamps.len(),
             average_age_seconds: self.average_entry_age(now),
         }
@@ -506,7 +1476,9 @@ fn average_entry_age(&self, now: u64) -> f64 {
         }
     }
 
-    /// Cleanup old entries to maintain performance
+    /// Cleanup old entries to maintain performance. With generations this rotates
+    /// out the oldest one in constant time; the key map is only scanned for
+    /// non-lean filters that still keep it.
     pub fn cleanup(&self) -> Result<usize, BloomFilterError> {
         let now = match SystemTime::now().duration_since(UNIX_EPOCH) {
             Ok(duration) => duration.as_secs(),
@@ -514,6 +1486,14 @@ pub fn cleanup(&self) -> Result<usize, BloomFilterError> {
         };
 
         let mut removed = 0usize;
+        if self.generation_counts.len() > 1 {
+            removed += self.rotate() as usize;
+        }
+        if self.config.is_lean() {
+            self.last_cleanup.store(now, Ordering::Relaxed);
+            return Ok(removed);
+        }
+
         let max_age = self.config.max_age_seconds;
 
         // Remove old entries
@@ -538,9 +1518,16 @@ pub fn auto_cleanup(&self) -> Result<bool, BloomFilterError> {
         };
 
         let last_cleanup = self.last_cleanup.load(Ordering::Relaxed);
-        let cleanup_interval = 3600; // 1 hour
+        let cleanup_interval = if self.generation_counts.len() > 1 {
+            self.config.rotation_interval_seconds()
+        } else {
+            3600 // 1 hour
+        };
 
-        if now.saturating_sub(last_cleanup) > cleanup_interval {
+        // Only the caller that claims the interval runs the cleanup
+        if now.saturating_sub(last_cleanup) >= cleanup_interval
+            && self.last_cleanup.compare_exchange(last_cleanup, now, Ordering::AcqRel, Ordering::Relaxed).is_ok()
+        {
             let _ = self.cleanup()?;
             Ok(true)
         } else {
@@ -550,12 +1537,12 @@ pub fn auto_cleanup(&self) -> Result<bool, BloomFilterError> {
 
     /// Get current item count (thread-safe)
     pub fn get_item_count(&self) -> usize {
-        self.item_count.load(Ordering::Relaxed) as usize
+        self.live_items() as usize
     }
 
     /// Get false positive count (thread-safe)
     pub fn get_false_positive_count(&self) -> f64 {
-        let items = self.item_count.load(Ordering::Relaxed) as f64;
+        let items = self.live_items() as f64;
         let false_positives = self.false_positive_count.load(Ordering::Relaxed) as f64;
         if items > 0.0 {
             false_positives / items
@@ -575,6 +1562,689 @@ pub fn contains_data(&self, data: &[u8]) -> Result<bool, BloomFilterError> {
     }
 }
 
+/// Buffered writer: keys are hashed on insert and parked in one of `WRITER_SHARDS`
+/// buffers by hash prefix; a full shard is applied in one sweep over its slice of the
+/// filter, and the item count is bumped once per sweep rather than once per key.
+/// Lookups do not see buffered keys until `flush` (or drop).
+pub struct BloomWriter<'a> {
+    filter: &'a UniversalBloomFilter,
+    shards: Vec<Vec<[u64; 2]>>,
+}
+
+impl<'a> BloomWriter<'a> {
+    pub fn insert(&mut self, data: &[u8]) -> Result<(), BloomFilterError> {
+        if data.is_empty() {
+            return Err(BloomFilterError::InvalidInput("Data cannot be empty".into()));
+        }
+        let filter = self.filter;
+        let hashes = filter.compute_hashes(data)?;
+        if !filter.config.is_lean() {
+            let now = SystemTime::now().duration_since(UNIX_EPOCH).map_err(|_| BloomFilterError::SystemTimeError)?;
+            filter.timestamps.insert(data.to_vec(), now.as_secs());
+        }
+
+        let shard = filter.writer_shard(hashes);
+        self.shards[shard].push(hashes);
+        if self.shards[shard].len() == WRITER_SHARD_CAPACITY {
+            self.flush_shard(shard);
+        }
+        Ok(())
+    }
+
+    pub fn insert_outpoint(&mut self, txid: &[u8], vout: u32) -> Result<(), BloomFilterError> {
+        with_outpoint_key(txid, vout, |key| self.insert(key))
+    }
+
+    /// Keys buffered and not yet visible to lookups
+    pub fn pending(&self) -> usize {
+        self.shards.iter().map(Vec::len).sum()
+    }
+
+    /// Apply every buffered key
+    pub fn flush(&mut self) {
+        for shard in 0..self.shards.len() {
+            self.flush_shard(shard);
+        }
+    }
+
+    fn flush_shard(&mut self, shard: usize) {
+        let keys = &mut self.shards[shard];
+        if keys.is_empty() {
+            return;
+        }
+        let filter = self.filter;
+        let generation = filter.current_generation.load(Ordering::Acquire);
+        for data in filter.copies() {
+            let blocks = filter.generation_blocks_in(data, generation);
+            for hashes in keys.iter() {
+                filter.set_key_bits(blocks, *hashes);
+            }
+        }
+        filter.count_inserts(generation, keys.len() as u64);
+        keys.clear();
+    }
+}
+
+impl Drop for BloomWriter<'_> {
+    fn drop(&mut self) {
+        self.flush();
+    }
+}
+
+/// Snapshot file magic; the version follows it in the header
+const SNAPSHOT_MAGIC: &[u8; 8] = b"SPRBLOOM";
+const SNAPSHOT_VERSION: u32 = 1;
+
+/// Header size: one page, so the bit array that follows maps page aligned
+const SNAPSHOT_HEADER_LEN: usize = 4096;
+
+/// Longest network name kept in a snapshot header
+const SNAPSHOT_NETWORK_LEN: usize = 63;
+
+/// Offset of the header checksum, which covers every header byte before it
+const SNAPSHOT_CHECKSUM_AT: usize = 232 + 8 * BLOOM_MAX_GENERATIONS as usize;
+
+/// Fixed-offset layout of a snapshot header (all integers little endian):
+///
+/// | offset | field                                             |
+/// |--------|---------------------------------------------------|
+/// | 0      | magic, version u32, header length u32             |
+/// | 16     | size u64, num_hashes, flags, generations, storage |
+/// | 28     | tweak u32, max_age u64, batch_size u64            |
+/// | 48     | chain tip u64, current generation u64             |
+/// | 64     | hash seeds [u32; 8], entropy pool [u8; 32]        |
+/// | 128    | network name length u8, name [u8; 63]             |
+/// | 192    | bit array length u64, bit array SHA256            |
+/// | 232    | generation counts [u64; 64]                       |
+/// | 744    | SHA256 of bytes 0..744                            |
+struct SnapshotHeader {
+    config: BloomConfig,
+    chain_tip: u64,
+    current_generation: usize,
+    hash_seeds: [u32; 8],
+    entropy_pool: [u8; 32],
+    data_len: u64,
+    data_checksum: [u8; 32],
+    generation_counts: Vec<u64>,
+}
+
+impl SnapshotHeader {
+    fn encode(&self) -> Vec<u8> {
+        let mut buf = vec![0u8; SNAPSHOT_HEADER_LEN];
+        let cfg = &self.config;
+        let name = &cfg.network.name.as_bytes()[..cfg.network.name.len().min(SNAPSHOT_NETWORK_LEN)];
+
+        buf[0..8].copy_from_slice(SNAPSHOT_MAGIC);
+        buf[8..12].copy_from_slice(&SNAPSHOT_VERSION.to_le_bytes());
+        buf[12..16].copy_from_slice(&(SNAPSHOT_HEADER_LEN as u32).to_le_bytes());
+        buf[16..24].copy_from_slice(&(cfg.size as u64).to_le_bytes());
+        buf[24..28].copy_from_slice(&[cfg.num_hashes, cfg.flags, cfg.generations, cfg.storage]);
+        buf[28..32].copy_from_slice(&cfg.tweak.to_le_bytes());
+        buf[32..40].copy_from_slice(&cfg.max_age_seconds.to_le_bytes());
+        buf[40..48].copy_from_slice(&(cfg.batch_size as u64).to_le_bytes());
+        buf[48..56].copy_from_slice(&self.chain_tip.to_le_bytes());
+        buf[56..64].copy_from_slice(&(self.current_generation as u64).to_le_bytes());
+        for (i, seed) in self.hash_seeds.iter().enumerate() {
+            buf[64 + 4 * i..68 + 4 * i].copy_from_slice(&seed.to_le_bytes());
+        }
+        buf[96..128].copy_from_slice(&self.entropy_pool);
+        buf[128] = name.len() as u8;
+        buf[129..129 + name.len()].copy_from_slice(name);
+        buf[192..200].copy_from_slice(&self.data_len.to_le_bytes());
+        buf[200..232].copy_from_slice(&self.data_checksum);
+        for (i, count) in self.generation_counts.iter().enumerate() {
+            buf[232 + 8 * i..240 + 8 * i].copy_from_slice(&count.to_le_bytes());
+        }
+
+        let checksum = bitcoin_hashes::sha256::Hash::hash(&buf[..SNAPSHOT_CHECKSUM_AT]);
+        buf[SNAPSHOT_CHECKSUM_AT..SNAPSHOT_CHECKSUM_AT + 32].copy_from_slice(&checksum[..]);
+        buf
+    }
+
+    fn decode(buf: &[u8]) -> Result<Self, BloomFilterError> {
+        let invalid = |msg: &str| BloomFilterError::SnapshotError(msg.into());
+        let u32_at = |at: usize| u32::from_le_bytes(buf[at..at + 4].try_into().unwrap_or_default());
+        let u64_at = |at: usize| u64::from_le_bytes(buf[at..at + 8].try_into().unwrap_or_default());
+
+        if buf.len() < SNAPSHOT_HEADER_LEN || &buf[0..8] != SNAPSHOT_MAGIC {
+            return Err(invalid("Not a bloom filter snapshot"));
+        }
+        if u32_at(8) != SNAPSHOT_VERSION || u32_at(12) as usize != SNAPSHOT_HEADER_LEN {
+            return Err(invalid("Unsupported snapshot version"));
+        }
+        let checksum = bitcoin_hashes::sha256::Hash::hash(&buf[..SNAPSHOT_CHECKSUM_AT]);
+        if checksum[..] != buf[SNAPSHOT_CHECKSUM_AT..SNAPSHOT_CHECKSUM_AT + 32] {
+            return Err(invalid("Snapshot header checksum mismatch"));
+        }
+
+        let name_len = (buf[128] as usize).min(SNAPSHOT_NETWORK_LEN);
+        let name = std::str::from_utf8(&buf[129..129 + name_len]).map_err(|_| invalid("Invalid network name"))?;
+
+        let mut config = BloomConfig::for_network(NetworkConfig::by_name(name));
+        config.size = usize::try_from(u64_at(16)).map_err(|_| invalid("Filter too large for this platform"))?;
+        config.num_hashes = buf[24];
+        config.flags = buf[25];
+        config.generations = buf[26];
+        config.storage = buf[27];
+        config.tweak = u32_at(28);
+        config.max_age_seconds = u64_at(32);
+        config.batch_size = (u64_at(40) as usize).max(1);
+
+        let mut hash_seeds = [0u32; 8];
+        for (i, seed) in hash_seeds.iter_mut().enumerate() {
+            *seed = u32_at(64 + 4 * i);
+        }
+        let mut entropy_pool = [0u8; 32];
+        entropy_pool.copy_from_slice(&buf[96..128]);
+        let mut data_checksum = [0u8; 32];
+        data_checksum.copy_from_slice(&buf[200..232]);
+
+        let generations = config.generation_count();
+        Ok(Self {
+            generation_counts: (0..generations).map(|i| u64_at(232 + 8 * i)).collect(),
+            current_generation: (u64_at(56) as usize).min(generations - 1),
+            chain_tip: u64_at(48),
+            hash_seeds,
+            entropy_pool,
+            data_len: u64_at(192),
+            data_checksum,
+            config,
+        })
+    }
+}
+
+/// SHA256 over the bit array as stored on disk (little-endian words)
+fn bit_array_checksum(blocks: &[BloomBlock]) -> [u8; 32] {
+    let mut engine = bitcoin_hashes::sha256::HashEngine::default();
+    for block in blocks {
+        for word in &block.words {
+            engine.input(&word.load(Ordering::Relaxed).to_le_bytes());
+        }
+    }
+    let mut checksum = [0u8; 32];
+    checksum.copy_from_slice(&bitcoin_hashes::sha256::Hash::from_engine(engine)[..]);
+    checksum
+}
+
+impl UniversalBloomFilter {
+    /// Height of the newest block loaded into the filter
+    pub fn chain_tip(&self) -> u64 {
+        self.chain_tip.load(Ordering::Relaxed)
+    }
+
+    /// Record the newest block height covered, for callers that load raw blocks
+    pub fn set_chain_tip(&self, height: u64) {
+        self.chain_tip.store(height, Ordering::Relaxed);
+    }
+
+    /// Write a snapshot that `open_mmap` can map back without replaying blocks.
+    /// The file holds the hash seeds, so it is created owner-only; it is written
+    /// beside `path` as `<file name>.tmp` and renamed into place, so readers never see a
+    /// partial file; the directory is synced after the rename so the new name survives a crash.
+    /// Inserts racing with the save may or may not be captured.
+    pub fn save(&self, path: &Path) -> Result<(), BloomFilterError> {
+        let io_err = |e: std::io::Error| BloomFilterError::SnapshotError(e.to_string());
+        let Some(file_name) = path.file_name() else {
+            return Err(BloomFilterError::SnapshotError("Snapshot path has no file name".into()));
+        };
+        let mut tmp_name = file_name.to_os_string();
+        tmp_name.push(".tmp");
+        let tmp_path = path.with_file_name(tmp_name);
+
+        let mut options = std::fs::OpenOptions::new();
+        options.write(true).create(true).truncate(true);
+        #[cfg(unix)]
+        std::os::unix::fs::OpenOptionsExt::mode(&mut options, 0o600);
+        let mut file = options.open(&tmp_path).map_err(io_err)?;
+
+        let mut header = SnapshotHeader {
+            config: self.config.clone(),
+            chain_tip: self.chain_tip(),
+            current_generation: self.current_generation.load(Ordering::Acquire),
+            hash_seeds: self.hash_seeds,
+            entropy_pool: self.entropy_pool,
+            data_len: (self.filter_data.len() * std::mem::size_of::<BloomBlock>()) as u64,
+            data_checksum: [0u8; 32],
+            generation_counts: (0..self.generation_counts.len()).map(|g| self.generation_counts.load(g)).collect(),
+        };
+
+        // Stream the bits after a placeholder header, then go back for the real one
+        let mut writer = std::io::BufWriter::with_capacity(1 << 20, &mut file);
+        writer.write_all(&[0u8; SNAPSHOT_HEADER_LEN]).map_err(io_err)?;
+        let mut engine = bitcoin_hashes::sha256::HashEngine::default();
+        for block in self.filter_data.iter() {
+            let mut line = [0u8; BLOOM_BLOCK_WORDS * 8];
+            for (bytes, word) in line.chunks_exact_mut(8).zip(&block.words) {
+                bytes.copy_from_slice(&word.load(Ordering::Relaxed).to_le_bytes());
+            }
+            engine.input(&line);
+            writer.write_all(&line).map_err(io_err)?;
+        }
+        writer.flush().map_err(io_err)?;
+        drop(writer);
+        header.data_checksum.copy_from_slice(&bitcoin_hashes::sha256::Hash::from_engine(engine)[..]);
+
+        file.seek(SeekFrom::Start(0)).map_err(io_err)?;
+        file.write_all(&header.encode()).map_err(io_err)?;
+        file.sync_all().map_err(io_err)?;
+        std::fs::rename(&tmp_path, path).map_err(io_err)?;
+
+        // The rename lives in the directory; without this a crash can lose it
+        #[cfg(unix)]
+        {
+            let dir = path.parent().filter(|p| !p.as_os_str().is_empty()).unwrap_or(Path::new("."));
+            File::open(dir).and_then(|d| d.sync_all()).map_err(io_err)?;
+        }
+        Ok(())
+    }
+
+    /// Map a snapshot written by `save`. Only the header is read up front; bit pages
+    /// fault in on first lookup, so opening costs the same at any filter size. The
+    /// mapping is copy-on-write: inserts stay in memory and never touch the file.
+    /// The per-key timestamp map is not persisted, so the filter opens in lean mode.
+    /// `verify_data` additionally checksums the whole bit array (reads every page).
+    pub fn open_mmap(path: &Path, verify_data: bool) -> Result<Self, BloomFilterError> {
+        let io_err = |e: std::io::Error| BloomFilterError::SnapshotError(e.to_string());
+        if cfg!(target_endian = "big") {
+            return Err(BloomFilterError::SnapshotError("Snapshots are little endian".into()));
+        }
+
+        let mut file = File::open(path).map_err(io_err)?;
+        let mut buf = vec![0u8; SNAPSHOT_HEADER_LEN];
+        file.read_exact(&mut buf).map_err(io_err)?;
+        let mut header = SnapshotHeader::decode(&buf)?;
+        Self::validate_config(&header.config)?;
+
+        let blocks = header.config.size / BLOOM_BLOCK_BITS * header.config.generation_count();
+        let expected_len = (blocks * std::mem::size_of::<BloomBlock>()) as u64;
+        let file_len = file.metadata().map_err(io_err)?.len();
+        if header.data_len != expected_len || file_len != SNAPSHOT_HEADER_LEN as u64 + expected_len {
+            return Err(BloomFilterError::SnapshotError("Snapshot length does not match its header".into()));
+        }
+
+        let filter_data = BloomStorage::map_file(&file, SNAPSHOT_HEADER_LEN, blocks)?;
+        if verify_data && bit_array_checksum(&filter_data) != header.data_checksum {
+            return Err(BloomFilterError::SnapshotError("Snapshot bit array checksum mismatch".into()));
+        }
+
+        // The file mapping is one copy placed by first touch, whatever the saving filter used
+        header.config.flags |= BLOOM_FLAG_LEAN;
+        header.config.storage &= !(BLOOM_STORAGE_NUMA_REPLICATE | BLOOM_STORAGE_NUMA_INTERLEAVE);
+        let filter = Self::from_parts(header.config, header.hash_seeds, header.entropy_pool, filter_data, Box::default())?;
+        filter.current_generation.store(header.current_generation, Ordering::Release);
+        for (generation, saved) in header.generation_counts.iter().enumerate() {
+            filter.generation_counts.set(generation, *saved);
+        }
+        filter.chain_tip.store(header.chain_tip, Ordering::Relaxed);
+        Ok(filter)
+    }
+}
+
+/// Check an offsets table for `keys` and return the key count it describes
+fn validate_offsets(keys: &[u8], offsets: &[u64]) -> Result<usize, BloomFilterError> {
+    let monotonic = offsets.windows(2).all(|w| w[0] <= w[1]);
+    if offsets.is_empty() || !monotonic || offsets[offsets.len() - 1] > keys.len() as u64 {
+        return Err(BloomFilterError::InvalidInput("Offsets must be non-decreasing and within the key buffer".into()));
+    }
+    Ok(offsets.len() - 1)
+}
+
+/// Word `idx` of a flat (standard layout) bit array made of blocks
+#[inline]
+fn word_at(blocks: &[BloomBlock], idx: usize) -> &AtomicU64 {
+    &blocks[idx / BLOOM_BLOCK_WORDS].words[idx % BLOOM_BLOCK_WORDS]
+}
+
+/// Run `f` on the outpoint preimage (txid || vout LE), built on the stack for hashes up to 64 bytes
+#[inline]
+fn with_outpoint_key<R>(txid: &[u8], vout: u32, f: impl FnOnce(&[u8]) -> R) -> R {
+    let len = txid.len() + 4;
+    if len <= MAX_STACK_KEY {
+        let mut key = [0u8; MAX_STACK_KEY];
+        key[..txid.len()].copy_from_slice(txid);
+        key[txid.len()..len].copy_from_slice(&vout.to_le_bytes());
+        f(&key[..len])
+    } else {
+        let mut key = Vec::with_capacity(len);
+        key.extend_from_slice(txid);
+        key.extend_from_slice(&vout.to_le_bytes());
+        f(&key)
+    }
+}
+
+/// Keyed SipHash-1-3 with 128-bit output: a PRF that resists hash flooding at a
+/// fraction of the cost of two SHA256 compressions
+fn siphash13_128(keys: [u64; 2], data: &[u8]) -> [u64; 2] {
+    #[inline(always)]
+    fn round(v: &mut [u64; 4]) {
+        v[0] = v[0].wrapping_add(v[1]);
+        v[1] = v[1].rotate_left(13) ^ v[0];
+        v[0] = v[0].rotate_left(32);
+        v[2] = v[2].wrapping_add(v[3]);
+        v[3] = v[3].rotate_left(16) ^ v[2];
+        v[0] = v[0].wrapping_add(v[3]);
+        v[3] = v[3].rotate_left(21) ^ v[0];
+        v[2] = v[2].wrapping_add(v[1]);
+        v[1] = v[1].rotate_left(17) ^ v[2];
+        v[2] = v[2].rotate_left(32);
+    }
+
+    let mut v = [
+        keys[0] ^ 0x736f_6d65_7073_6575,
+        keys[1] ^ 0x646f_7261_6e64_6f6d ^ 0xee,
+        keys[0] ^ 0x6c79_6765_6e65_7261,
+        keys[1] ^ 0x7465_6462_7974_6573,
+    ];
+
+    let mut chunks = data.chunks_exact(8);
+    for chunk in &mut chunks {
+        let m = u64::from_le_bytes(chunk.try_into().unwrap_or_default());
+        v[3] ^= m;
+        round(&mut v);
+        v[0] ^= m;
+    }
+
+    let mut tail = [0u8; 8];
+    tail[..chunks.remainder().len()].copy_from_slice(chunks.remainder());
+    let m = u64::from_le_bytes(tail) | (data.len() as u64) << 56;
+    v[3] ^= m;
+    round(&mut v);
+    v[0] ^= m;
+
+    v[2] ^= 0xee;
+    round(&mut v);
+    round(&mut v);
+    round(&mut v);
+    let h1 = v[0] ^ v[1] ^ v[2] ^ v[3];
+    v[1] ^= 0xdd;
+    round(&mut v);
+    round(&mut v);
+    round(&mut v);
+    let h2 = v[0] ^ v[1] ^ v[2] ^ v[3];
+    [h1, h2]
+}
+
+/// Bitcoin block header length on the wire
+const BLOCK_HEADER_LEN: usize = 80;
+
+/// Byte ranges of one transaction inside a raw block; the txid preimage is
+/// version || body || locktime, which skips the segwit marker and witness data
+struct RawTxSpan {
+    start: usize,
+    body: (usize, usize),
+    locktime: usize,
+    outputs: u32,
+}
+
+impl RawTxSpan {
+    /// Visit the (txid, vout) of every input, re-reading them from the block bytes
+    fn for_each_prevout(&self, block: &[u8], mut f: impl FnMut(&[u8], u32) -> Result<(), BloomFilterError>) -> Result<(), BloomFilterError> {
+        let mut cur = RawCursor { data: &block[..self.body.1], pos: self.body.0 };
+        let inputs = cur.read_count(41)?;
+        for _ in 0..inputs {
+            let at = cur.pos;
+            cur.skip(36)?;
+            let vout = u32::from_le_bytes(block[at + 32..at + 36].try_into().unwrap_or_default());
+            f(&block[at..at + 32], vout)?;
+            cur.skip_var_bytes()?;
+            cur.skip(4)?;
+        }
+        Ok(())
+    }
+
+    /// Txid hashing job over the legacy serialization, read directly from the block bytes
+    fn txid_job<'a>(&self, block: &'a [u8]) -> Sha256Job<'a> {
+        Sha256Job::chain([
+            &block[self.start..self.start + 4],
+            &block[self.body.0..self.body.1],
+            &block[self.locktime..self.locktime + 4],
+        ])
+    }
+}
+
+/// Bounds-checked forward reader over wire-format bytes
+struct RawCursor<'a> {
+    data: &'a [u8],
+    pos: usize,
+}
+
+impl<'a> RawCursor<'a> {
+    fn skip(&mut self, n: usize) -> Result<(), BloomFilterError> {
+        match self.pos.checked_add(n) {
+            Some(end) if end <= self.data.len() => {
+                self.pos = end;
+                Ok(())
+            }
+            _ => Err(BloomFilterError::InvalidInput("Truncated block data".into())),
+        }
+    }
+
+    fn peek(&self, offset: usize) -> Option<u8> {
+        self.data.get(self.pos + offset).copied()
+    }
+
+    fn read_varint(&mut self) -> Result<u64, BloomFilterError> {
+        let prefix = self.peek(0).ok_or_else(|| BloomFilterError::InvalidInput("Truncated block data".into()))?;
+        let width = match prefix {
+            0xfd => 2,
+            0xfe => 4,
+            0xff => 8,
+            _ => {
+                self.pos += 1;
+                return Ok(prefix as u64);
+            }
+        };
+        self.skip(1 + width)?;
+        let mut bytes = [0u8; 8];
+        bytes[..width].copy_from_slice(&self.data[self.pos - width..self.pos]);
+        Ok(u64::from_le_bytes(bytes))
+    }
+
+    /// Read a count and reject values that could not fit in the remaining bytes
+    fn read_count(&mut self, min_item_len: usize) -> Result<usize, BloomFilterError> {
+        let count = self.read_varint()?;
+        let remaining = (self.data.len() - self.pos) as u64;
+        if count.saturating_mul(min_item_len.max(1) as u64) > remaining {
+            return Err(BloomFilterError::InvalidInput("Count exceeds block size".into()));
+        }
+        Ok(count as usize)
+    }
+
+    fn skip_var_bytes(&mut self) -> Result<(), BloomFilterError> {
+        let len = self.read_count(1)?;
+        self.skip(len)
+    }
+}
+
+/// Walk a wire-format block (header, then transactions with optional segwit
+/// marker and witnesses) and record each transaction's byte ranges
+fn scan_raw_block(block: &[u8]) -> Result<Vec<RawTxSpan>, BloomFilterError> {
+    let mut cur = RawCursor { data: block, pos: 0 };
+    cur.skip(BLOCK_HEADER_LEN)?;
+
+    // Smallest legal transaction: version, 1 input, 1 output, locktime
+    let tx_count = cur.read_count(60)?;
+    let mut spans = Vec::with_capacity(tx_count);
+
+    for _ in 0..tx_count {
+        let start = cur.pos;
+        cur.skip(4)?; // version
+
+        let segwit = cur.peek(0) == Some(0x00) && cur.peek(1) == Some(0x01);
+        if segwit {
+            cur.skip(2)?;
+        }
+
+        let body_start = cur.pos;
+        let inputs = cur.read_count(41)?;
+        for _ in 0..inputs {
+            cur.skip(36)?; // previous outpoint
+            cur.skip_var_bytes()?; // script_sig
+            cur.skip(4)?; // sequence
+        }
+        let outputs = cur.read_count(9)?;
+        for _ in 0..outputs {
+            cur.skip(8)?; // value
+            cur.skip_var_bytes()?; // script_pubkey
+        }
+        let body_end = cur.pos;
+
+        if segwit {
+            for _ in 0..inputs {
+                let items = cur.read_count(1)?;
+                for _ in 0..items {
+                    cur.skip_var_bytes()?;
+                }
+            }
+        }
+
+        let locktime = cur.pos;
+        cur.skip(4)?;
+
+        spans.push(RawTxSpan {
+            start,
+            body: (body_start, body_end),
+            locktime,
+            outputs: u32::try_from(outputs).map_err(|_| BloomFilterError::InvalidInput("Too many outputs".into()))?,
+        });
+    }
+
+    if cur.pos != block.len() {
+        return Err(BloomFilterError::InvalidInput("Trailing bytes after block".into()));
+    }
+    Ok(spans)
+}
+
+/// Hint the CPU to pull a cache line into L1 ahead of use (no-op where unsupported)
+#[inline(always)]
+fn prefetch_read(ptr: *const u8) {
+    #[cfg(target_arch = "x86_64")]
+    unsafe {
+        std::arch::x86_64::_mm_prefetch(ptr as *const i8, std::arch::x86_64::_MM_HINT_T0);
+    }
+    #[cfg(target_arch = "aarch64")]
+    unsafe {
+        std::arch::asm!("prfm pldl1keep, [{0}]", in(reg) ptr, options(nostack, preserves_flags, readonly));
+    }
+    #[cfg(not(any(target_arch = "x86_64", target_arch = "aarch64")))]
+    let _ = ptr;
+}
+
+/// SipHash-1-3/128 of `HASH_LANES` 36-byte outpoint keys (txid || vout LE) at once, selecting
+/// the widest vector unit available at runtime. Results match `siphash13_128` per key.
+fn siphash13_128_outpoints(keys: [u64; 2], txids: &[u8], vouts: &[u32], out: &mut [[u64; 2]; HASH_LANES]) {
+    // Word-major message layout so each SipHash step runs across all lanes
+    let mut words = [[0u64; HASH_LANES]; 5];
+    for lane in 0..HASH_LANES {
+        let txid = &txids[lane * OUTPOINT_TXID_LEN..(lane + 1) * OUTPOINT_TXID_LEN];
+        for (w, bytes) in txid.chunks_exact(8).enumerate() {
+            words[w][lane] = u64::from_le_bytes(bytes.try_into().unwrap_or_default());
+        }
+        // Final word: the 4 vout bytes plus the message length in the top byte
+        words[4][lane] = vouts[lane] as u64 | ((OUTPOINT_TXID_LEN as u64 + 4) << 56);
+    }
+
+    #[cfg(target_arch = "x86_64")]
+    {
+        #[target_feature(enable = "avx2")]
+        unsafe fn siphash_lanes_avx2(keys: [u64; 2], words: &[[u64; HASH_LANES]], out: &mut [[u64; 2]; HASH_LANES]) {
+            siphash13_128_lanes(keys, words, out)
+        }
+        if is_x86_feature_detected!("avx2") {
+            return unsafe { siphash_lanes_avx2(keys, &words, out) };
+        }
+    }
+
+    // SSE2 on x86_64 and NEON on aarch64 are baseline, so the generic build still vectorizes
+    siphash13_128_lanes(keys, &words, out)
+}
+
+/// Lane-parallel SipHash-1-3/128 over equal-length messages in word-major layout (the last
+/// word must already carry the length byte). Written as straight lane loops for the vectorizer.
+#[inline(always)]
+fn siphash13_128_lanes(keys: [u64; 2], words: &[[u64; HASH_LANES]], out: &mut [[u64; 2]; HASH_LANES]) {
+    #[inline(always)]
+    fn round(v: &mut [[u64; HASH_LANES]; 4]) {
+        for l in 0..HASH_LANES {
+            v[0][l] = v[0][l].wrapping_add(v[1][l]);
+            v[1][l] = v[1][l].rotate_left(13) ^ v[0][l];
+            v[0][l] = v[0][l].rotate_left(32);
+            v[2][l] = v[2][l].wrapping_add(v[3][l]);
+            v[3][l] = v[3][l].rotate_left(16) ^ v[2][l];
+            v[0][l] = v[0][l].wrapping_add(v[3][l]);
+            v[3][l] = v[3][l].rotate_left(21) ^ v[0][l];
+            v[2][l] = v[2][l].wrapping_add(v[1][l]);
+            v[1][l] = v[1][l].rotate_left(17) ^ v[2][l];
+            v[2][l] = v[2][l].rotate_left(32);
+        }
+    }
+
+    let mut v = [
+        [keys[0] ^ 0x736f_6d65_7073_6575; HASH_LANES],
+        [keys[1] ^ 0x646f_7261_6e64_6f6d ^ 0xee; HASH_LANES],
+        [keys[0] ^ 0x6c79_6765_6e65_7261; HASH_LANES],
+        [keys[1] ^ 0x7465_6462_7974_6573; HASH_LANES],
+    ];
+
+    for m in words {
+        for l in 0..HASH_LANES {
+            v[3][l] ^= m[l];
+        }
+        round(&mut v);
+        for l in 0..HASH_LANES {
+            v[0][l] ^= m[l];
+        }
+    }
+
+    for l in 0..HASH_LANES {
+        v[2][l] ^= 0xee;
+    }
+    round(&mut v);
+    round(&mut v);
+    round(&mut v);
+    for l in 0..HASH_LANES {
+        out[l][0] = v[0][l] ^ v[1][l] ^ v[2][l] ^ v[3][l];
+        v[1][l] ^= 0xdd;
+    }
+    round(&mut v);
+    round(&mut v);
+    round(&mut v);
+    for l in 0..HASH_LANES {
+        out[l][1] = v[0][l] ^ v[1][l] ^ v[2][l] ^ v[3][l];
+    }
+}
+
+/// Per-nibble "counter is nonzero" flags, each in its nibble's low bit
+#[inline(always)]
+fn nibble_nonzero(w: u64) -> u64 {
+    (w | w >> 1 | w >> 2 | w >> 3) & NIBBLE_LOW
+}
+
+/// Per-nibble "counter is 15" flags, each in its nibble's low bit
+#[inline(always)]
+fn nibble_saturated(w: u64) -> u64 {
+    w & (w >> 1) & (w >> 2) & (w >> 3) & NIBBLE_LOW
+}
+
+/// False positive rate of a blocked filter (Putze et al.): keys per block are Poisson
+/// distributed, and a block holding `i` keys behaves like a classic filter of `block_cells`
+fn blocked_false_positive_rate(items: f64, blocks: f64, k: f64, block_cells: f64) -> f64 {
+    let lambda = items / blocks;
+    let span = (lambda + 10.0 * lambda.sqrt() + 10.0).ceil() as u64;
+
+    // Poisson weights are accumulated in log space so dense filters do not underflow
+    let mut ln_weight = -lambda;
+    let mut rate = 0.0;
+    for i in 0..=span {
+        if i > 0 {
+            ln_weight += (lambda / i as f64).ln();
+        }
+        let fill = 1.0 - (1.0 - 1.0 / block_cells).powf(k * i as f64);
+        rate += ln_weight.exp() * fill.powf(k);
+    }
+    rate.min(1.0)
+}
+
 /// Performance and security statistics
 #[derive(Debug, Clone)]
 pub struct BloomFilterStats {
@@ -606,6 +2276,9 @@ pub enum BloomFilterError {
 
     #[error("Concurrent access error")]
     ConcurrencyError,
+
+    #[error("Snapshot error: {0}")]
+    SnapshotError(String),
 }
 
 impl Drop for UniversalBloomFilter {
@@ -613,6 +2286,7 @@ fn drop(&mut self) {
         // Secure cleanup
         self.entropy_pool.zeroize();
         self.hash_seeds.zeroize();
+        self.sip_keys.zeroize();
     }
 }
 
@@ -621,6 +2295,7 @@ fn zeroize(&mut self) {
         // Only zeroize sensitive data
         self.entropy_pool.zeroize();
         self.hash_seeds.zeroize();
+        self.sip_keys.zeroize();
         // Note: bit_array and metadata contain operational data, not secrets
     }
 }
@@ -675,4 +2350,476 @@ fn test_false_positive_rate() {
         let fp_rate = filter.false_positive_rate();
         assert!(fp_rate > 0.0 && fp_rate < 1.0);
     }
+
+    #[test]
+    fn test_fast_hash_mode() {
+        let filter = UniversalBloomFilter::new(Some(BloomConfig::fast_hash(NetworkConfig::bitcoin()))).unwrap();
+
+        let txid = [7u8; 32];
+        assert!(!filter.contains_outpoint(&txid, 1).unwrap());
+        filter.insert_outpoint(&txid, 1).unwrap();
+        assert!(filter.contains_outpoint(&txid, 1).unwrap());
+        assert!(!filter.contains_outpoint(&txid, 2).unwrap());
+
+        // Keyed: the same key hashes differently under another filter's seeds
+        let other = UniversalBloomFilter::new(Some(BloomConfig::fast_hash(NetworkConfig::bitcoin()))).unwrap();
+        assert_ne!(filter.compute_hashes(&txid).unwrap(), other.compute_hashes(&txid).unwrap());
+    }
+
+    #[test]
+    fn test_siphash13_128_length_padding() {
+        let keys = [0x0706_0504_0302_0100, 0x0f0e_0d0c_0b0a_0908];
+        // Zero-padded tails must not collide with explicit zero bytes
+        assert_ne!(siphash13_128(keys, &[1, 2, 3]), siphash13_128(keys, &[1, 2, 3, 0]));
+        assert_ne!(siphash13_128(keys, &[]), siphash13_128(keys, &[0; 8]));
+        assert_eq!(siphash13_128(keys, &[9; 36]), siphash13_128(keys, &[9; 36]));
+    }
+
+    #[test]
+    fn test_lean_mode_keeps_no_keys() {
+        let filter = UniversalBloomFilter::new(Some(BloomConfig::lean(NetworkConfig::bitcoin()))).unwrap();
+
+        for i in 0u32..1000 {
+            filter.insert_outpoint(&[3u8; 32], i).unwrap();
+        }
+        assert!((0u32..1000).all(|i| filter.contains_outpoint(&[3u8; 32], i).unwrap()));
+
+        let stats = filter.stats();
+        assert_eq!(stats.item_count, 1000);
+        assert_eq!(stats.timestamp_entries, 0);
+        assert_eq!(stats.memory_usage_bytes, 32_768 / 8);
+    }
+
+    #[test]
+    fn test_generational_rotation() {
+        let filter = UniversalBloomFilter::new(Some(BloomConfig::windowed(NetworkConfig::bitcoin(), 3600, 4))).unwrap();
+        assert_eq!(filter.config.rotation_interval_seconds(), 900);
+        assert_eq!(filter.stats().memory_usage_bytes, 4 * 32_768 / 8);
+
+        filter.insert_data(b"oldest").unwrap();
+        filter.rotate();
+        filter.insert_data(b"newer").unwrap();
+
+        // Still visible while its generation is live
+        for _ in 0..2 {
+            filter.rotate();
+            assert!(filter.contains_data(b"oldest").unwrap());
+        }
+
+        // The fourth rotation wipes the generation that held it
+        assert_eq!(filter.rotate(), 1);
+        assert!(!filter.contains_data(b"oldest").unwrap());
+        assert!(filter.contains_data(b"newer").unwrap());
+        assert_eq!(filter.get_item_count(), 1);
+
+        filter.reset();
+        assert!(!filter.contains_data(b"newer").unwrap());
+        assert_eq!(filter.get_item_count(), 0);
+
+        // Concurrent rotations each expire their own generation exactly once
+        for generation in 0..4u8 {
+            if generation > 0 {
+                filter.rotate();
+            }
+            filter.insert_data(&[generation; 8]).unwrap();
+        }
+        let start = filter.current_generation.load(Ordering::Acquire);
+        let expired: u64 = std::thread::scope(|scope| {
+            let workers: Vec<_> = (0..4).map(|_| scope.spawn(|| filter.rotate())).collect();
+            workers.into_iter().map(|worker| worker.join().unwrap()).sum()
+        });
+        assert_eq!(expired, 4);
+        assert_eq!(filter.current_generation.load(Ordering::Acquire), start);
+        assert_eq!(filter.get_item_count(), 0);
+    }
+
+    #[test]
+    fn test_siphash_lanes_match_scalar() {
+        let keys = [0x0123_4567_89ab_cdef, 0xfedc_ba98_7654_3210];
+        let txids: Vec<u8> = (0..HASH_LANES * 32).map(|i| (i * 7) as u8).collect();
+        let vouts: Vec<u32> = (0..HASH_LANES as u32).map(|i| i * 1000 + 1).collect();
+
+        let mut lanes = [[0u64; 2]; HASH_LANES];
+        siphash13_128_outpoints(keys, &txids, &vouts, &mut lanes);
+        for lane in 0..HASH_LANES {
+            let expected = with_outpoint_key(&txids[lane * 32..(lane + 1) * 32], vouts[lane], |key| siphash13_128(keys, key));
+            assert_eq!(lanes[lane], expected);
+        }
+    }
+
+    #[test]
+    fn test_contains_outpoints_matches_single() {
+        let configs = [
+            BloomConfig::for_network(NetworkConfig::bitcoin()),
+            BloomConfig::lean(NetworkConfig::bitcoin()),
+            BloomConfig::windowed(NetworkConfig::bitcoin(), 600, 3),
+        ];
+        for mut config in configs {
+            config.batch_size = 16; // exercise the parallel split
+            let filter = UniversalBloomFilter::new(Some(config)).unwrap();
+
+            let count = 101; // not a multiple of the lane count
+            let txids: Vec<u8> = (0..count * 32).map(|i| (i % 251) as u8).collect();
+            let vouts: Vec<u32> = (0..count as u32).collect();
+            for i in (0..count).step_by(2) {
+                filter.insert_outpoint(&txids[i * 32..(i + 1) * 32], vouts[i]).unwrap();
+            }
+
+            let mut results = vec![false; count];
+            filter.contains_outpoints(&txids, &vouts, &mut results).unwrap();
+            for i in 0..count {
+                assert_eq!(results[i], filter.contains_outpoint(&txids[i * 32..(i + 1) * 32], vouts[i]).unwrap());
+                if i % 2 == 0 {
+                    assert!(results[i]);
+                }
+            }
+
+            assert!(filter.contains_outpoints(&txids, &vouts[1..], &mut results[1..]).is_err());
+        }
+    }
+
+    /// Minimal legacy + segwit block: one coinbase-like tx with 2 outputs, one segwit tx with 1
+    fn raw_test_block() -> (Vec<u8>, Vec<Vec<u8>>) {
+        let legacy: Vec<u8> = [
+            &1u32.to_le_bytes()[..],
+            &[1], &[0u8; 36], &[2, 0xaa, 0xbb], &[0xff; 4],
+            &[2], &[0u8; 8], &[1, 0x51], &[1u8; 8], &[0],
+            &[0u8; 4],
+        ].concat();
+        let segwit_stripped: Vec<u8> = [
+            &2u32.to_le_bytes()[..],
+            &[1], &[7u8; 36], &[0], &[0xfe; 4],
+            &[1], &[5u8; 8], &[2, 0x00, 0x14],
+            &[9u8; 4],
+        ].concat();
+        let segwit: Vec<u8> = [
+            &segwit_stripped[..4], &[0x00, 0x01],
+            &segwit_stripped[4..segwit_stripped.len() - 4],
+            &[2, 3, 1, 2, 3, 1, 9], // witness: two items
+            &segwit_stripped[segwit_stripped.len() - 4..],
+        ].concat();
+
+        let mut block = vec![0u8; BLOCK_HEADER_LEN];
+        block.push(2);
+        block.extend_from_slice(&legacy);
+        block.extend_from_slice(&segwit);
+        (block, vec![legacy, segwit_stripped])
+    }
+
+    #[test]
+    fn test_load_raw_block() {
+        let (block, legacy_txs) = raw_test_block();
+        let filter = UniversalBloomFilter::new(None).unwrap();
+
+        assert_eq!(filter.load_raw_block(&block).unwrap(), 3);
+
+        let txids: Vec<[u8; 32]> = legacy_txs.iter()
+            .map(|tx| bitcoin_hashes::sha256d::Hash::hash(tx).to_byte_array())
+            .collect();
+        assert!(filter.contains_outpoint(&txids[0], 0).unwrap());
+        assert!(filter.contains_outpoint(&txids[0], 1).unwrap());
+        assert!(filter.contains_outpoint(&txids[1], 0).unwrap());
+        assert!(!filter.contains_outpoint(&txids[1], 1).unwrap());
+
+        // Truncation, trailing bytes and absurd counts are rejected
+        assert!(filter.load_raw_block(&block[..block.len() - 1]).is_err());
+        assert!(filter.load_raw_block(&[&block[..], &[0]].concat()).is_err());
+        let mut huge = vec![0u8; BLOCK_HEADER_LEN];
+        huge.extend_from_slice(&[0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff]);
+        assert!(filter.load_raw_block(&huge).is_err());
+    }
+
+    #[test]
+    fn test_capacity_sizing() {
+        // ~180M UTXOs at 0.1%: well past the old 1M-bit ceiling
+        let config = BloomConfig::for_capacity(NetworkConfig::bitcoin(), 180_000_000, 0.001).unwrap();
+        assert!(config.size.is_power_of_two());
+        assert!(config.size >= 2_587_000_000);
+        assert_eq!(config.num_hashes, 7);
+
+        let mut blocked = BloomConfig::cache_blocked(NetworkConfig::bitcoin());
+        blocked.fit_capacity(100_000, 0.01).unwrap();
+        assert!(blocked_false_positive_rate(100_000.0, (blocked.size / BLOOM_BLOCK_BITS) as f64, blocked.num_hashes as f64, BLOOM_BLOCK_BITS as f64) <= 0.01);
+
+        assert!(BloomConfig::for_capacity(NetworkConfig::bitcoin(), 0, 0.01).is_err());
+        assert!(BloomConfig::for_capacity(NetworkConfig::bitcoin(), 10, 1.5).is_err());
+        assert!(BloomConfig::for_capacity(NetworkConfig::bitcoin(), u64::MAX, 1e-9).is_err());
+    }
+
+    #[test]
+    fn test_large_mapped_filter() {
+        let mut config = BloomConfig::fast_hash(NetworkConfig::bitcoin());
+        config.size = 1 << 25; // 4 MiB, above the mmap threshold
+        config.storage = crate::bloom_storage::BLOOM_STORAGE_HUGE_PAGES;
+        let filter = UniversalBloomFilter::new(Some(config)).unwrap();
+        assert!(filter.memory_usage() >= (1 << 22));
+
+        filter.insert(b"far-out key").unwrap();
+        assert!(filter.contains(b"far-out key").unwrap());
+        assert!(!filter.contains(b"absent key").unwrap());
+    }
+
+    #[test]
+    fn test_snapshot_round_trip() {
+        let dir = std::env::temp_dir().join(format!("bloom-snapshot-{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let path = dir.join("filter.bloom");
+
+        let filter = UniversalBloomFilter::new(Some(BloomConfig::windowed(NetworkConfig::bitcoin(), 600, 2))).unwrap();
+        for i in 0..500u32 {
+            filter.insert_outpoint(&[7u8; 32], i).unwrap();
+        }
+        filter.rotate();
+        filter.insert(b"newest").unwrap();
+        filter.set_chain_tip(840_000);
+        filter.save(&path).unwrap();
+
+        let restored = UniversalBloomFilter::open_mmap(&path, true).unwrap();
+        assert_eq!(restored.chain_tip(), 840_000);
+        assert_eq!(restored.stats().item_count, 501);
+        assert!(restored.contains(b"newest").unwrap());
+        for i in 0..500u32 {
+            assert!(restored.contains_outpoint(&[7u8; 32], i).unwrap());
+        }
+        assert_eq!(restored.false_positive_rate(), filter.false_positive_rate());
+
+        // Copy-on-write: inserts after opening work and leave the file alone
+        restored.insert(b"after open").unwrap();
+        assert!(restored.contains(b"after open").unwrap());
+        drop(restored);
+        let reopened = UniversalBloomFilter::open_mmap(&path, true).unwrap();
+        assert_eq!(reopened.stats().item_count, 501);
+
+        // The temp file is named after the whole file name: a *.tmp target is not renamed
+        // onto itself, and names differing only by extension never share a temp file
+        let tmp_target = dir.join("filter.tmp");
+        filter.save(&tmp_target).unwrap();
+        assert_eq!(UniversalBloomFilter::open_mmap(&tmp_target, true).unwrap().stats().item_count, 501);
+        assert!(!dir.join("filter.tmp.tmp").exists());
+        assert!(!dir.join("filter.bloom.tmp").exists());
+
+        // Corruption is caught by the header checksum
+        let mut bytes = std::fs::read(&path).unwrap();
+        bytes[20] ^= 1;
+        std::fs::write(&path, &bytes).unwrap();
+        assert!(matches!(UniversalBloomFilter::open_mmap(&path, false), Err(BloomFilterError::SnapshotError(_))));
+
+        std::fs::remove_dir_all(&dir).unwrap();
+    }
+
+    #[test]
+    fn test_counting_mode() {
+        let filter = UniversalBloomFilter::new(Some(BloomConfig::counting(NetworkConfig::bitcoin()))).unwrap();
+        let keys: Vec<[u8; 8]> = (0u64..2000).map(|i| i.to_le_bytes()).collect();
+        for key in &keys {
+            filter.insert(key).unwrap();
+        }
+        for key in &keys[..1000] {
+            assert!(filter.remove(key).unwrap());
+        }
+
+        // Removed keys are gone, the rest survive: no false negatives after removal
+        assert!(keys[..1000].iter().filter(|k| filter.contains(*k).unwrap()).count() < 50);
+        assert!(keys[1000..].iter().all(|k| filter.contains(k).unwrap()));
+        assert_eq!(filter.stats().item_count, 1000);
+        assert!(!filter.remove(b"never inserted").unwrap());
+
+        // Removing everything returns the counters to zero
+        for key in &keys[1000..] {
+            assert!(filter.remove(key).unwrap());
+        }
+        assert!(filter.filter_data.iter().all(|b| b.words.iter().all(|w| w.load(Ordering::Relaxed) == 0)));
+
+        // Counters saturate at 15 and then stop moving
+        let lean = UniversalBloomFilter::new(Some({ let mut c = BloomConfig::counting(NetworkConfig::bitcoin()); c.flags |= BLOOM_FLAG_LEAN; c })).unwrap();
+        for _ in 0..20 {
+            lean.insert(b"hot").unwrap();
+        }
+        for _ in 0..20 {
+            assert!(lean.remove(b"hot").unwrap());
+        }
+        assert!(lean.contains(b"hot").unwrap());
+
+        assert!(UniversalBloomFilter::new(Some({ let mut c = BloomConfig::for_network(NetworkConfig::bitcoin()); c.flags |= BLOOM_FLAG_COUNTING; c })).is_err());
+        assert!(UniversalBloomFilter::new(Some({ let mut c = BloomConfig::cache_blocked(NetworkConfig::bitcoin()); c.flags |= BLOOM_FLAG_REMOVE_SPENT; c })).is_err());
+        assert!(UniversalBloomFilter::new(None).unwrap().remove(b"x").is_err());
+        assert!(UniversalBloomFilter::new(Some({ let mut c = BloomConfig::counting(NetworkConfig::bitcoin()); c.storage = BLOOM_STORAGE_NUMA_REPLICATE; c })).is_err());
+    }
+
+    #[test]
+    fn test_counting_raw_block_removes_spends() {
+        let (block, legacy_txs) = raw_test_block();
+        let mut config = BloomConfig::counting(NetworkConfig::bitcoin());
+        config.flags |= BLOOM_FLAG_LEAN;
+
+        // Without the flag a counting filter leaves spent outpoints alone
+        let partial = UniversalBloomFilter::new(Some(config.clone())).unwrap();
+        partial.insert_outpoint(&[7u8; 32], 0x0707_0707).unwrap();
+        partial.load_raw_block(&block).unwrap();
+        assert!(partial.contains_outpoint(&[7u8; 32], 0x0707_0707).unwrap());
+
+        config.flags |= BLOOM_FLAG_REMOVE_SPENT;
+        let filter = UniversalBloomFilter::new(Some(config)).unwrap();
+
+        // The segwit tx spends outpoint [7; 32]:0x07070707
+        filter.insert_outpoint(&[7u8; 32], 0x0707_0707).unwrap();
+        filter.load_raw_block(&block).unwrap();
+        assert!(!filter.contains_outpoint(&[7u8; 32], 0x0707_0707).unwrap());
+
+        let txid = bitcoin_hashes::sha256d::Hash::hash(&legacy_txs[0]).to_byte_array();
+        assert!(filter.contains_outpoint(&txid, 1).unwrap());
+
+        // A header with no transactions (not even a coinbase) inserts and spends nothing
+        let mut empty = block[..BLOCK_HEADER_LEN].to_vec();
+        empty.push(0);
+        assert_eq!(filter.load_raw_block(&empty).unwrap(), 0);
+    }
+
+    #[test]
+    fn test_buffered_writer() {
+        let filter = UniversalBloomFilter::new(Some(BloomConfig::lean(NetworkConfig::bitcoin()))).unwrap();
+        let keys: Vec<[u8; 8]> = (0u64..3000).map(|i| i.to_le_bytes()).collect();
+
+        std::thread::scope(|scope| {
+            for chunk in keys.chunks(750) {
+                let filter = &filter;
+                scope.spawn(move || {
+                    let mut writer = filter.writer();
+                    for key in chunk {
+                        writer.insert(key).unwrap();
+                    }
+                    assert!(writer.pending() < WRITER_SHARDS * WRITER_SHARD_CAPACITY);
+                });
+            }
+        });
+
+        // Dropping each writer flushed it; counts aggregate across the threads' stripes
+        assert_eq!(filter.stats().item_count, 3000);
+        assert!(keys.iter().all(|k| filter.contains(k).unwrap()));
+
+        let mut writer = filter.writer();
+        writer.insert(b"buffered").unwrap();
+        assert_eq!(writer.pending(), 1);
+        writer.flush();
+        assert!(filter.contains(b"buffered").unwrap());
+    }
+
+    #[test]
+    fn test_single_writer_mode() {
+        for mut config in [BloomConfig::for_network(NetworkConfig::bitcoin()), BloomConfig::counting(NetworkConfig::bitcoin())] {
+            config.flags |= BLOOM_FLAG_SINGLE_WRITER;
+            let filter = UniversalBloomFilter::new(Some(config)).unwrap();
+            for i in 0u64..1000 {
+                filter.insert_data(&i.to_le_bytes()).unwrap();
+            }
+            assert_eq!(filter.stats().item_count, 1000);
+            assert!((0u64..1000).all(|i| filter.contains(&i.to_le_bytes()).unwrap()));
+            if filter.config.is_counting() {
+                assert!(filter.remove(&7u64.to_le_bytes()).unwrap());
+                assert_eq!(filter.stats().item_count, 999);
+            }
+        }
+    }
+
+    #[test]
+    fn test_packed_batches() {
+        for mut config in [BloomConfig::for_network(NetworkConfig::bitcoin()), BloomConfig::lean(NetworkConfig::bitcoin())] {
+            config.batch_size = 16; // exercise the parallel split
+            let filter = UniversalBloomFilter::new(Some(config)).unwrap();
+
+            let count = 203usize;
+            let keys: Vec<u8> = (0..count * 36).map(|i| (i % 253) as u8).collect();
+            filter.insert_packed(&keys[..100 * 36], 36).unwrap();
+
+            let mut bitmap = vec![0xffu8; count.div_ceil(8)];
+            let hits = filter.contains_packed(&keys, 36, &mut bitmap).unwrap();
+            for i in 0..count {
+                let bit = bitmap[i / 8] >> (i % 8) & 1 == 1;
+                assert_eq!(bit, filter.contains(&keys[i * 36..(i + 1) * 36]).unwrap());
+                if i < 100 {
+                    assert!(bit);
+                }
+            }
+            assert_eq!(hits, bitmap.iter().map(|b| b.count_ones() as u64).sum::<u64>());
+
+            // Variable-width keys through an offsets table
+            let offsets = [0u64, 3, 10, 10, 20];
+            filter.insert_offsets(&keys[..20], &[0, 3, 10]).unwrap();
+            let mut bitmap = [0u8; 1];
+            filter.contains_offsets(&keys[..20], &offsets, &mut bitmap).unwrap();
+            assert_eq!(bitmap[0] & 0b0111, 0b0011);
+
+            assert!(filter.insert_offsets(&keys[..20], &[0, 3, 3]).is_err());
+            assert!(filter.contains_packed(&keys[..37], 36, &mut bitmap).is_err());
+            assert!(filter.contains_offsets(&keys[..20], &[0, 30], &mut bitmap).is_err());
+            assert!(filter.contains_packed(&keys, 36, &mut bitmap).is_err());
+        }
+    }
+
+    #[test]
+    fn test_test_and_insert() {
+        for config in [BloomConfig::for_network(NetworkConfig::bitcoin()), BloomConfig::windowed(NetworkConfig::bitcoin(), 60, 4)] {
+            let filter = UniversalBloomFilter::new(Some(config)).unwrap();
+            assert!(!filter.test_and_insert(b"announce").unwrap());
+            assert!(filter.test_and_insert(b"announce").unwrap());
+            assert_eq!(filter.get_item_count(), 1);
+        }
+
+        // Still seen from an older generation, and refreshed into the current one
+        let windowed = UniversalBloomFilter::new(Some(BloomConfig::windowed(NetworkConfig::bitcoin(), 60, 2))).unwrap();
+        assert!(!windowed.test_and_insert(b"announce").unwrap());
+        windowed.rotate();
+        assert!(windowed.test_and_insert(b"announce").unwrap());
+        windowed.rotate();
+        assert!(windowed.contains_data(b"announce").unwrap());
+
+        let counting = UniversalBloomFilter::new(Some(BloomConfig::counting(NetworkConfig::bitcoin()))).unwrap();
+        assert!(counting.test_and_insert(b"announce").is_err());
+    }
+
+    #[test]
+    fn test_blocked_mode() {
+        let filter = UniversalBloomFilter::new(Some(BloomConfig::cache_blocked(NetworkConfig::bitcoin()))).unwrap();
+
+        for i in 0u32..2000 {
+            let mut bytes = [0u8; 32];
+            bytes[0..4].copy_from_slice(&i.to_le_bytes());
+            filter.insert_utxo(&TransactionId::from_bytes(&bytes).unwrap(), i).unwrap();
+        }
+
+        // No false negatives, and every key's bits sit inside a single block
+        for i in 0u32..2000 {
+            let mut bytes = [0u8; 32];
+            bytes[0..4].copy_from_slice(&i.to_le_bytes());
+            let txid = TransactionId::from_bytes(&bytes).unwrap();
+            assert!(filter.contains_utxo(&txid, i).unwrap());
+
+            let mut preimage = bytes.to_vec();
+            preimage.extend_from_slice(&i.to_le_bytes());
+            let (_, masks) = filter.block_masks(filter.generation_blocks(0), filter.compute_hashes(&preimage).unwrap());
+            let bits: u32 = masks.iter().map(|m| m.count_ones()).sum();
+            assert!(bits >= 1 && bits <= filter.config.num_hashes as u32);
+        }
+    }
+
+    #[test]
+    fn test_blocked_false_positive_rate() {
+        let filter = UniversalBloomFilter::new(Some(BloomConfig::cache_blocked(NetworkConfig::bitcoin()))).unwrap();
+        for i in 0u64..3000 {
+            filter.insert_data(&i.to_le_bytes()).unwrap();
+        }
+
+        // Blocking costs a little accuracy versus the classic layout at the same size
+        let theoretical = filter.false_positive_rate();
+        let classic = (1.0 - (-5.0f64 * 3000.0 / 32768.0).exp()).powi(5);
+        assert!(theoretical > classic && theoretical < 2.0 * classic);
+
+        // Observed bit-level rate on absent keys tracks the model
+        let probes = 100_000u64;
+        let hits = (1_000_000..1_000_000 + probes)
+            .filter(|i: &u64| filter.test_bits(filter.compute_hashes(&i.to_le_bytes()).unwrap()))
+            .count();
+        let observed = hits as f64 / probes as f64;
+        assert!((observed - theoretical).abs() < theoretical * 0.5, "observed {} vs model {}", observed, theoretical);
+    }
 }
@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: MIT
+// Universal Sprint - Multi-Network Bloom Filter Registry
+// One handle owning a filter per chain, with tagged batch routing and per-network stats
+
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::Instant;
+
+use crate::bloom_filter::{BloomConfig, BloomFilterError, NetworkStats, UniversalBloomFilter};
+
+/// Networks a registry can hold; tags are `u16` indices below this
+pub const BLOOM_REGISTRY_MAX_NETWORKS: usize = 256;
+
+/// Hot per-network counters, each network on its own cache line so a busy chain's
+/// query accounting never contends with a quiet one's
+#[repr(C, align(64))]
+#[derive(Default)]
+struct NetworkCounters {
+    inserts: AtomicU64,
+    queries: AtomicU64,
+    query_nanos: AtomicU64,
+    blocks: AtomicU64,
+    // Clock, query count and query time at the previous stats() call, for the rate window
+    window_start: AtomicU64,
+    window_queries: AtomicU64,
+    window_query_nanos: AtomicU64,
+}
+
+/// One chain's filter and accounting. Each network has its own bit array, so one
+/// chain's keys never share cache lines with another's
+struct NetworkShard {
+    name: String,
+    key_width: usize,
+    filter: UniversalBloomFilter,
+    counters: NetworkCounters,
+}
+
+/// Registry of per-network filters. Networks are registered up front (`add` takes
+/// `&mut self`); once shared, every operation goes through `&self`.
+pub struct BloomRegistry {
+    networks: Vec<NetworkShard>,
+    created: Instant,
+}
+
+impl Default for BloomRegistry {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl BloomRegistry {
+    pub fn new() -> Self {
+        Self { networks: Vec::new(), created: Instant::now() }
+    }
+
+    /// Register a network's filter and return its tag. Keys for this network must be
+    /// exactly `key_width` bytes; `None` uses the network's hash size (32-byte txids,
+    /// 64-byte Solana signatures).
+    pub fn add(&mut self, config: BloomConfig, key_width: Option<usize>) -> Result<u16, BloomFilterError> {
+        if self.network_id(&config.network.name).is_some() {
+            return Err(BloomFilterError::InvalidConfiguration(format!("Network {} already registered", config.network.name)));
+        }
+        if self.networks.len() >= BLOOM_REGISTRY_MAX_NETWORKS {
+            return Err(BloomFilterError::InvalidConfiguration("Too many networks".into()));
+        }
+        let key_width = key_width.unwrap_or(config.network.hash_size);
+        if key_width == 0 {
+            return Err(BloomFilterError::InvalidConfiguration("Key width must be non-zero".into()));
+        }
+
+        let name = config.network.name.clone();
+        let filter = UniversalBloomFilter::new(Some(config))?;
+        self.networks.push(NetworkShard { name, key_width, filter, counters: NetworkCounters::default() });
+        Ok((self.networks.len() - 1) as u16)
+    }
+
+    /// Tag of a registered network
+    pub fn network_id(&self, name: &str) -> Option<u16> {
+        self.networks.iter().position(|n| n.name == name).map(|i| i as u16)
+    }
+
+    /// Filter behind a tag, for single-network calls
+    pub fn filter(&self, network: u16) -> Option<&UniversalBloomFilter> {
+        self.networks.get(network as usize).map(|n| &n.filter)
+    }
+
+    fn shard(&self, network: u16) -> Result<&NetworkShard, BloomFilterError> {
+        self.networks.get(network as usize)
+            .ok_or_else(|| BloomFilterError::InvalidInput(format!("Unknown network tag {}", network)))
+    }
+
+    /// Check a batch's shape and every key's width before anything is applied
+    fn validate_batch(&self, tags: &[u16], keys: &[u8], offsets: &[u64]) -> Result<(), BloomFilterError> {
+        if offsets.len() != tags.len() + 1 || offsets.last().copied() != Some(keys.len() as u64) {
+            return Err(BloomFilterError::InvalidInput("Offsets must hold count + 1 entries ending at the key buffer length".into()));
+        }
+        for (i, &tag) in tags.iter().enumerate() {
+            let shard = self.shard(tag)?;
+            if offsets[i + 1] < offsets[i] || (offsets[i + 1] - offsets[i]) as usize != shard.key_width {
+                return Err(BloomFilterError::InvalidInput(format!("Key {} does not match the {} key width", i, shard.name)));
+            }
+        }
+        Ok(())
+    }
+
+    /// Split a tagged batch into runs of one network: `f(tag, first, end)` over key indices
+    fn for_each_run(tags: &[u16], mut f: impl FnMut(u16, usize, usize) -> Result<(), BloomFilterError>) -> Result<(), BloomFilterError> {
+        let mut start = 0;
+        while start < tags.len() {
+            let end = tags[start..].iter().position(|&t| t != tags[start]).map_or(tags.len(), |n| start + n);
+            f(tags[start], start, end)?;
+            start = end;
+        }
+        Ok(())
+    }
+
+    /// Insert keys tagged by network: key `i` is `keys[offsets[i]..offsets[i + 1]]` and
+    /// goes to network `tags[i]`. The whole batch is validated first, so a bad key
+    /// leaves every filter untouched.
+    pub fn insert_batch(&self, tags: &[u16], keys: &[u8], offsets: &[u64]) -> Result<(), BloomFilterError> {
+        self.validate_batch(tags, keys, offsets)?;
+        Self::for_each_run(tags, |tag, first, end| {
+            let shard = &self.networks[tag as usize];
+            for i in first..end {
+                shard.filter.insert_data(&keys[offsets[i] as usize..offsets[i + 1] as usize])?;
+            }
+            shard.counters.inserts.fetch_add((end - first) as u64, Ordering::Relaxed);
+            Ok(())
+        })
+    }
+
+    /// Look up keys tagged by network (same layout as `insert_batch`) into `results`.
+    /// Each run of same-network keys is timed once for the query-latency stats.
+    pub fn contains_batch(&self, tags: &[u16], keys: &[u8], offsets: &[u64], results: &mut [bool]) -> Result<(), BloomFilterError> {
+        if results.len() != tags.len() {
+            return Err(BloomFilterError::InvalidInput("Results must hold one entry per key".into()));
+        }
+        self.validate_batch(tags, keys, offsets)?;
+        Self::for_each_run(tags, |tag, first, end| {
+            let shard = &self.networks[tag as usize];
+            let started = Instant::now();
+            for i in first..end {
+                results[i] = shard.filter.contains_data(&keys[offsets[i] as usize..offsets[i + 1] as usize])?;
+            }
+            let counters = &shard.counters;
+            counters.query_nanos.fetch_add(started.elapsed().as_nanos() as u64, Ordering::Relaxed);
+            counters.queries.fetch_add((end - first) as u64, Ordering::Relaxed);
+            Ok(())
+        })
+    }
+
+    /// Load a wire-format block into one network's filter
+    pub fn load_raw_block(&self, network: u16, block: &[u8]) -> Result<u64, BloomFilterError> {
+        let shard = self.shard(network)?;
+        let inserted = shard.filter.load_raw_block(block)?;
+        shard.counters.blocks.fetch_add(1, Ordering::Relaxed);
+        shard.counters.inserts.fetch_add(inserted, Ordering::Relaxed);
+        Ok(inserted)
+    }
+
+    /// Snapshot a network's stats. Both rates (QPS, average query time) cover the same
+    /// window: since the previous call for that network, or since the registry was created.
+    pub fn stats(&self, network: u16) -> Result<NetworkStats, BloomFilterError> {
+        let shard = self.shard(network)?;
+        let counters = &shard.counters;
+
+        let now = self.created.elapsed().as_nanos() as u64;
+        let queries = counters.queries.load(Ordering::Relaxed);
+        let nanos = counters.query_nanos.load(Ordering::Relaxed);
+        let window_start = counters.window_start.swap(now, Ordering::Relaxed);
+        let window_queries = queries.saturating_sub(counters.window_queries.swap(queries, Ordering::Relaxed));
+        let window_nanos = nanos.saturating_sub(counters.window_query_nanos.swap(nanos, Ordering::Relaxed));
+        let window_secs = now.saturating_sub(window_start) as f64 / 1e9;
+
+        Ok(NetworkStats {
+            transactions_processed: counters.inserts.load(Ordering::Relaxed),
+            blocks_processed: counters.blocks.load(Ordering::Relaxed),
+            queries_per_second: if window_secs > 0.0 { (window_queries as f64 / window_secs) as u64 } else { 0 },
+            average_query_time_ns: if window_queries > 0 { window_nanos / window_queries } else { 0 },
+            false_positive_rate: shard.filter.false_positive_rate(),
+            memory_usage_bytes: shard.filter.memory_usage() as u64,
+            last_updated: std::time::SystemTime::now().duration_since(std::time::UNIX_EPOCH).unwrap_or_default().as_secs(),
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::bloom_filter::NetworkConfig;
+
+    #[test]
+    fn test_registry_routes_by_tag() {
+        let mut registry = BloomRegistry::new();
+        let btc = registry.add(BloomConfig::lean(NetworkConfig::bitcoin()), None).unwrap();
+        let sol = registry.add(BloomConfig::lean(NetworkConfig::solana()), None).unwrap();
+        assert_eq!(registry.network_id("solana"), Some(sol));
+        assert!(registry.add(BloomConfig::lean(NetworkConfig::bitcoin()), None).is_err());
+
+        // One 32-byte txid for bitcoin, one 64-byte signature for solana
+        let keys: Vec<u8> = [[1u8; 32].as_slice(), [2u8; 64].as_slice()].concat();
+        let offsets = [0u64, 32, 96];
+        registry.insert_batch(&[btc, sol], &keys, &offsets).unwrap();
+
+        let mut results = [false; 2];
+        registry.contains_batch(&[btc, sol], &keys, &offsets, &mut results).unwrap();
+        assert_eq!(results, [true, true]);
+
+        // Keys stay in their own network's filter
+        registry.contains_batch(&[btc], &keys[..32], &[0, 32], &mut results[..1]).unwrap();
+        assert!(results[0]);
+        assert!(!registry.filter(sol).unwrap().contains_data(&[1u8; 32]).unwrap());
+
+        // Wrong width or tag rejects the whole batch
+        assert!(registry.insert_batch(&[sol, btc], &keys, &offsets).is_err());
+        assert!(registry.insert_batch(&[btc, 9], &keys, &offsets).is_err());
+
+        let stats = registry.stats(sol).unwrap();
+        assert_eq!(stats.transactions_processed, 1);
+        assert!(stats.memory_usage_bytes > 0);
+        assert!(registry.stats(btc).unwrap().average_query_time_ns > 0);
+        // No queries since the last call: both rates see an empty window
+        let idle = registry.stats(btc).unwrap();
+        assert_eq!((idle.queries_per_second, idle.average_query_time_ns), (0, 0));
+    }
+}
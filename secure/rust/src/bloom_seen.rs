@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: MIT
+// Universal Sprint - Seen-Set for relay deduplication
+// A windowed Bloom filter answering "seen before?" and recording the key in one call,
+// backed by a small exact cache of recent keys that overrules false positives
+
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Mutex;
+use std::time::Instant;
+
+use crate::bloom_filter::{BloomConfig, BloomFilterError, UniversalBloomFilter, BLOOM_FLAG_LEAN};
+
+/// Exact-cache stripes; a key always maps to the same stripe, whose lock makes
+/// `test_and_insert` atomic per key
+const SEEN_STRIPES: usize = 64;
+
+/// Seen-set counters, as reported by `SeenSet::stats`
+#[derive(Clone, Debug, Default)]
+pub struct SeenStats {
+    pub queries: u64,
+    pub duplicates: u64,
+    pub false_positives_avoided: u64, // Bloom hits the exact cache proved new
+    pub rotations: u64,
+    pub cached_keys: u64,
+}
+
+/// One cached key: its 128-bit filter hash and when it was last seen
+struct SeenSlot {
+    tag: [u64; 2],
+    seen_at: u64,
+    referenced: bool,
+}
+
+/// Outcome of an exact-cache lookup
+enum CacheLookup {
+    Hit,
+    /// `authoritative`: every key seen within the window is still cached, so a miss
+    /// proves the key is new whatever the Bloom filter says
+    Miss { authoritative: bool },
+}
+
+/// Fixed-capacity CLOCK cache of recently seen keys
+struct SeenCache {
+    index: HashMap<[u64; 2], usize>,
+    slots: Vec<SeenSlot>,
+    capacity: usize,
+    hand: usize,
+    // seen_at of the newest still-live key evicted for space; once it leaves the
+    // window the cache again covers the whole window
+    evicted_live: Option<u64>,
+}
+
+impl SeenCache {
+    fn new(capacity: usize) -> Self {
+        Self { index: HashMap::with_capacity(capacity), slots: Vec::with_capacity(capacity), capacity, hand: 0, evicted_live: None }
+    }
+
+    /// Look a key up and record it as seen at `now`
+    fn test_and_insert(&mut self, tag: [u64; 2], now: u64, window: u64) -> CacheLookup {
+        if let Some(&i) = self.index.get(&tag) {
+            let slot = &mut self.slots[i];
+            let live = now.saturating_sub(slot.seen_at) <= window;
+            slot.seen_at = now;
+            slot.referenced = true;
+            // An expired entry still proves the key was not seen inside the window
+            return if live { CacheLookup::Hit } else { CacheLookup::Miss { authoritative: true } };
+        }
+
+        let authoritative = self.evicted_live.map_or(true, |t| now.saturating_sub(t) > window);
+        self.insert(tag, now, window);
+        CacheLookup::Miss { authoritative }
+    }
+
+    fn insert(&mut self, tag: [u64; 2], now: u64, window: u64) {
+        let slot = SeenSlot { tag, seen_at: now, referenced: false };
+        if self.slots.len() < self.capacity {
+            self.index.insert(tag, self.slots.len());
+            self.slots.push(slot);
+            return;
+        }
+
+        // Second chance for live, recently referenced keys; expired keys go first time round
+        loop {
+            let victim = &mut self.slots[self.hand];
+            let live = now.saturating_sub(victim.seen_at) <= window;
+            if live && victim.referenced {
+                victim.referenced = false;
+                self.hand = (self.hand + 1) % self.capacity;
+                continue;
+            }
+            if live {
+                self.evicted_live = Some(self.evicted_live.map_or(victim.seen_at, |t| t.max(victim.seen_at)));
+            }
+            self.index.remove(&victim.tag);
+            *victim = slot;
+            self.index.insert(tag, self.hand);
+            self.hand = (self.hand + 1) % self.capacity;
+            return;
+        }
+    }
+}
+
+/// Cache stripe on its own cache line
+#[repr(align(64))]
+struct SeenStripe(Mutex<SeenCache>);
+
+/// Deduplication set over a sliding window of `max_age_seconds`. The Bloom filter
+/// remembers every key for the window; the exact cache holds the most recent keys
+/// and settles false positives for them. Expiry slides from a key's last sighting.
+pub struct SeenSet {
+    filter: UniversalBloomFilter,
+    stripes: Vec<SeenStripe>,
+    window_nanos: u64,
+    rotation_nanos: u64,
+    generations: u64,
+    created: Instant,
+    last_rotation: AtomicU64,
+    queries: AtomicU64,
+    duplicates: AtomicU64,
+    false_positives_avoided: AtomicU64,
+    rotations: AtomicU64,
+}
+
+impl SeenSet {
+    /// Build a seen-set from a windowed config (see `BloomConfig::windowed`) holding up to
+    /// `cache_entries` exact keys; 0 disables the cache and answers from the filter alone.
+    /// The filter is always lean: the exact cache replaces the per-key timestamp map.
+    pub fn new(mut config: BloomConfig, cache_entries: usize) -> Result<Self, BloomFilterError> {
+        if config.generation_count() < 2 {
+            return Err(BloomFilterError::InvalidConfiguration("Seen-set needs at least two generations".into()));
+        }
+        if config.max_age_seconds == 0 {
+            return Err(BloomFilterError::InvalidConfiguration("Seen-set window must be non-zero".into()));
+        }
+        config.flags |= BLOOM_FLAG_LEAN;
+
+        let window_nanos = config.max_age_seconds.saturating_mul(1_000_000_000);
+        let rotation_nanos = (window_nanos / config.generation_count() as u64).max(1);
+        let config_generations = config.generation_count() as u64;
+        let per_stripe = cache_entries.div_ceil(SEEN_STRIPES);
+        let filter = UniversalBloomFilter::new(Some(config))?;
+
+        Ok(Self {
+            filter,
+            stripes: (0..SEEN_STRIPES).map(|_| SeenStripe(Mutex::new(SeenCache::new(per_stripe)))).collect(),
+            window_nanos,
+            rotation_nanos,
+            generations: config_generations,
+            created: Instant::now(),
+            last_rotation: AtomicU64::new(0),
+            queries: AtomicU64::new(0),
+            duplicates: AtomicU64::new(0),
+            false_positives_avoided: AtomicU64::new(0),
+            rotations: AtomicU64::new(0),
+        })
+    }
+
+    /// Record `data` and return whether it was already seen within the window. Concurrent
+    /// calls with the same key are serialised, so exactly one of them sees it as new.
+    pub fn test_and_insert(&self, data: &[u8]) -> Result<bool, BloomFilterError> {
+        if data.is_empty() {
+            return Err(BloomFilterError::InvalidInput("Data cannot be empty".into()));
+        }
+        let now = self.created.elapsed().as_nanos() as u64;
+        self.maybe_rotate(now);
+        let seen = self.test_and_insert_at(data, now)?;
+
+        self.queries.fetch_add(1, Ordering::Relaxed);
+        if seen {
+            self.duplicates.fetch_add(1, Ordering::Relaxed);
+        }
+        Ok(seen)
+    }
+
+    /// `test_and_insert` over `keys.len() / stride` packed keys; bit `i % 8` of `bitmap[i / 8]`
+    /// is set when key `i` was already seen (including earlier in the same batch).
+    /// Returns the number of duplicates.
+    pub fn test_and_insert_packed(&self, keys: &[u8], stride: usize, bitmap: &mut [u8]) -> Result<u64, BloomFilterError> {
+        if stride == 0 || keys.len() % stride != 0 {
+            return Err(BloomFilterError::InvalidInput("Key buffer is not a whole number of strides".into()));
+        }
+        let count = keys.len() / stride;
+        if bitmap.len() < count.div_ceil(8) {
+            return Err(BloomFilterError::InvalidInput("Result bitmap is too small".into()));
+        }
+
+        // One clock read and rotation check for the whole batch
+        let now = self.created.elapsed().as_nanos() as u64;
+        self.maybe_rotate(now);
+        bitmap[..count.div_ceil(8)].fill(0);
+        let mut duplicates = 0u64;
+        for (i, key) in keys.chunks_exact(stride).enumerate() {
+            if self.test_and_insert_at(key, now)? {
+                bitmap[i / 8] |= 1 << (i % 8);
+                duplicates += 1;
+            }
+        }
+
+        self.queries.fetch_add(count as u64, Ordering::Relaxed);
+        self.duplicates.fetch_add(duplicates, Ordering::Relaxed);
+        Ok(duplicates)
+    }
+
+    fn test_and_insert_at(&self, data: &[u8], now: u64) -> Result<bool, BloomFilterError> {
+        let hashes = self.filter.compute_hashes(data)?;
+        // Top bits pick the stripe; the filter indexes with the low bits
+        let stripe = &self.stripes[(hashes[1] >> 58) as usize % SEEN_STRIPES];
+        let mut cache = stripe.0.lock().unwrap_or_else(|e| e.into_inner());
+
+        // Always refresh the bits, so the filter's expiry slides with the cache's
+        let bloom_hit = self.filter.test_and_set_bits(hashes);
+        if cache.capacity == 0 {
+            return Ok(bloom_hit);
+        }
+        Ok(match cache.test_and_insert(hashes, now, self.window_nanos) {
+            CacheLookup::Hit => true,
+            CacheLookup::Miss { authoritative: true } => {
+                if bloom_hit {
+                    self.false_positives_avoided.fetch_add(1, Ordering::Relaxed);
+                }
+                false
+            }
+            CacheLookup::Miss { authoritative: false } => bloom_hit,
+        })
+    }
+
+    /// Rotate out every generation whose interval has elapsed; only the caller that
+    /// claims the interval rotates
+    fn maybe_rotate(&self, now: u64) {
+        let last = self.last_rotation.load(Ordering::Relaxed);
+        let due = now.saturating_sub(last) / self.rotation_nanos;
+        if due == 0 {
+            return;
+        }
+        let next = last + due * self.rotation_nanos;
+        if self.last_rotation.compare_exchange(last, next, Ordering::AcqRel, Ordering::Relaxed).is_ok() {
+            // After a whole window of silence every generation is stale
+            let rotations = due.min(self.generations);
+            for _ in 0..rotations {
+                self.filter.rotate();
+            }
+            self.rotations.fetch_add(rotations, Ordering::Relaxed);
+        }
+    }
+
+    /// Underlying filter, for stats and snapshots
+    pub fn filter(&self) -> &UniversalBloomFilter {
+        &self.filter
+    }
+
+    pub fn stats(&self) -> SeenStats {
+        SeenStats {
+            queries: self.queries.load(Ordering::Relaxed),
+            duplicates: self.duplicates.load(Ordering::Relaxed),
+            false_positives_avoided: self.false_positives_avoided.load(Ordering::Relaxed),
+            rotations: self.rotations.load(Ordering::Relaxed),
+            cached_keys: self.stripes.iter()
+                .map(|s| s.0.lock().unwrap_or_else(|e| e.into_inner()).slots.len() as u64)
+                .sum(),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::bloom_filter::NetworkConfig;
+
+    #[test]
+    fn test_seen_set() {
+        let mut config = BloomConfig::windowed(NetworkConfig::solana(), 60, 4);
+        config.size = 1024; // Tiny filter: false positives guaranteed
+        config.num_hashes = 2;
+        let seen = SeenSet::new(config.clone(), 1 << 16).unwrap();
+
+        assert!(!seen.test_and_insert(b"block-1").unwrap());
+        assert!(seen.test_and_insert(b"block-1").unwrap());
+
+        // The cache covers the whole window, so saturated bits never report a new key as seen
+        for i in 0..5000u32 {
+            assert!(!seen.test_and_insert(&i.to_le_bytes()).unwrap());
+        }
+        let stats = seen.stats();
+        assert_eq!(stats.duplicates, 1);
+        assert!(stats.false_positives_avoided > 0);
+
+        // Packed batch, with an in-batch duplicate
+        let keys: Vec<u8> = [1u32, 9000, 9000, 9001].iter().flat_map(|k| k.to_le_bytes()).collect();
+        let mut bitmap = [0u8; 1];
+        assert_eq!(seen.test_and_insert_packed(&keys, 4, &mut bitmap).unwrap(), 2);
+        assert_eq!(bitmap[0], 0b0101);
+
+        // Without the cache the filter alone answers
+        let bare = SeenSet::new(BloomConfig::windowed(NetworkConfig::bitcoin(), 60, 4), 0).unwrap();
+        assert!(!bare.test_and_insert(b"tx").unwrap());
+        assert!(bare.test_and_insert(b"tx").unwrap());
+
+        assert!(SeenSet::new(BloomConfig::lean(NetworkConfig::bitcoin()), 16).is_err());
+    }
+
+    #[test]
+    fn test_seen_cache_eviction_falls_back_to_filter() {
+        let mut cache = SeenCache::new(2);
+        assert!(matches!(cache.test_and_insert([1, 0], 0, 100), CacheLookup::Miss { authoritative: true }));
+        assert!(matches!(cache.test_and_insert([2, 0], 1, 100), CacheLookup::Miss { authoritative: true }));
+        assert!(matches!(cache.test_and_insert([3, 0], 2, 100), CacheLookup::Miss { authoritative: true }));
+        // A live key was evicted for space: misses defer to the filter until it ages out
+        assert!(matches!(cache.test_and_insert([4, 0], 3, 100), CacheLookup::Miss { authoritative: false }));
+        assert!(matches!(cache.test_and_insert([5, 0], 200, 100), CacheLookup::Miss { authoritative: true }));
+    }
+}
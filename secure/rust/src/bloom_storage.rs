@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: MIT
+// Bit-array storage for the Universal Bloom Filter
+// Small filters live on the heap; filters that outgrow the caches are backed by an
+// anonymous mapping with huge pages so a lookup costs a cache miss, not a TLB walk too.
+
+use std::fs::File;
+use std::ops::Deref;
+
+use crate::bloom_filter::{BloomBlock, BloomFilterError};
+use crate::numa::{self, Placement};
+
+/// `BloomConfig::storage` bits: request explicit huge pages (MAP_HUGETLB) for the bit
+/// array, falling back to transparent huge pages when none are reserved
+pub const BLOOM_STORAGE_HUGE_PAGES: u8 = 0x01;
+
+/// `BloomConfig::storage` bits: pin the bit array in RAM (best effort, like SecureBuffer)
+pub const BLOOM_STORAGE_LOCKED: u8 = 0x02;
+
+/// `BloomConfig::storage` bits: interleave the bit array's pages across NUMA nodes, so a
+/// write-heavy filter spreads its traffic over every memory controller
+pub const BLOOM_STORAGE_NUMA_INTERLEAVE: u8 = 0x04;
+
+/// `BloomConfig::storage` bits: keep one copy of the bit array per NUMA node; lookups read
+/// the local copy and inserts write every copy (read-mostly filters)
+pub const BLOOM_STORAGE_NUMA_REPLICATE: u8 = 0x08;
+
+/// Arrays at least this large are mapped rather than heap allocated; also the huge-page size
+pub const BLOOM_MMAP_THRESHOLD: usize = 2 << 20;
+
+/// Zero-initialised, cache-line aligned array of `BloomBlock`s
+pub struct BloomStorage {
+    ptr: *mut BloomBlock,
+    blocks: usize,
+    backing: Backing,
+    locked: bool,
+}
+
+enum Backing {
+    Heap(Vec<BloomBlock>),
+    #[cfg(unix)]
+    Anonymous { map_len: usize, huge_pages: bool },
+    #[cfg(unix)]
+    File { base: *mut libc::c_void, map_len: usize },
+}
+
+// The blocks are atomics and the mapping is owned exclusively by this value
+unsafe impl Send for BloomStorage {}
+unsafe impl Sync for BloomStorage {}
+
+impl BloomStorage {
+    /// Allocate `blocks` zeroed blocks, honouring `BLOOM_STORAGE_*` bits in `storage`
+    pub fn allocate(blocks: usize, storage: u8) -> Result<Self, BloomFilterError> {
+        let interleave = storage & BLOOM_STORAGE_NUMA_INTERLEAVE != 0 && numa::is_numa();
+        Self::allocate_placed(blocks, storage, interleave.then_some(Placement::Interleave))
+    }
+
+    /// Allocate one per-node copy for `BLOOM_STORAGE_NUMA_REPLICATE`, preferring `node`'s memory
+    pub fn allocate_replica(blocks: usize, storage: u8, node: usize) -> Result<Self, BloomFilterError> {
+        Self::allocate_placed(blocks, storage, Some(Placement::Node(node)))
+    }
+
+    fn allocate_placed(blocks: usize, storage: u8, placement: Option<Placement>) -> Result<Self, BloomFilterError> {
+        let bytes = blocks.checked_mul(std::mem::size_of::<BloomBlock>())
+            .ok_or(BloomFilterError::MemoryError)?;
+
+        // A memory policy applies to whole pages, so placed arrays are always mapped
+        let mut this = if bytes >= BLOOM_MMAP_THRESHOLD || storage & BLOOM_STORAGE_HUGE_PAGES != 0 || placement.is_some() {
+            Self::map_anonymous(blocks, bytes, storage)?
+        } else {
+            Self::heap(blocks)
+        };
+
+        // Before mlock, which faults every page in
+        #[cfg(unix)]
+        if let (Some(placement), Backing::Anonymous { map_len, .. }) = (placement, &this.backing) {
+            unsafe { numa::bind(this.ptr as *mut u8, *map_len, placement) };
+        }
+        if storage & BLOOM_STORAGE_LOCKED != 0 {
+            this.locked = unsafe { crate::memory::lock_memory(this.ptr as *mut u8, bytes) }.is_ok();
+        }
+        Ok(this)
+    }
+
+    fn heap(blocks: usize) -> Self {
+        let mut data: Vec<BloomBlock> = (0..blocks).map(|_| BloomBlock::new()).collect();
+        Self { ptr: data.as_mut_ptr(), blocks, backing: Backing::Heap(data), locked: false }
+    }
+
+    #[cfg(unix)]
+    fn map_anonymous(blocks: usize, bytes: usize, storage: u8) -> Result<Self, BloomFilterError> {
+        // Whole huge pages, so MAP_HUGETLB accepts the length and THP can back all of it
+        let map_len = bytes.div_ceil(BLOOM_MMAP_THRESHOLD) * BLOOM_MMAP_THRESHOLD;
+        let base_flags = libc::MAP_PRIVATE | libc::MAP_ANONYMOUS;
+
+        let mapping = |flags: libc::c_int| unsafe {
+            let ptr = libc::mmap(std::ptr::null_mut(), map_len, libc::PROT_READ | libc::PROT_WRITE, flags, -1, 0);
+            (ptr != libc::MAP_FAILED).then_some(ptr)
+        };
+
+        // No MAP_NORESERVE here: the reservation must fail now if the huge page pool is short,
+        // rather than SIGBUS on first touch
+        #[cfg(target_os = "linux")]
+        if storage & BLOOM_STORAGE_HUGE_PAGES != 0 {
+            if let Some(ptr) = mapping(base_flags | libc::MAP_HUGETLB) {
+                return Ok(Self::mapped(ptr, blocks, map_len, true));
+            }
+        }
+        let _ = storage;
+
+        // Untouched pages of a sparse filter stay unbacked
+        let ptr = mapping(base_flags | MAP_NORESERVE).ok_or(BloomFilterError::MemoryError)?;
+        #[cfg(target_os = "linux")]
+        unsafe {
+            // Advisory only: without THP the mapping still works with 4K pages
+            libc::madvise(ptr, map_len, libc::MADV_HUGEPAGE);
+        }
+        Ok(Self::mapped(ptr, blocks, map_len, false))
+    }
+
+    #[cfg(unix)]
+    fn mapped(ptr: *mut libc::c_void, blocks: usize, map_len: usize, huge_pages: bool) -> Self {
+        Self { ptr: ptr as *mut BloomBlock, blocks, backing: Backing::Anonymous { map_len, huge_pages }, locked: false }
+    }
+
+    #[cfg(not(unix))]
+    fn map_anonymous(blocks: usize, _bytes: usize, _storage: u8) -> Result<Self, BloomFilterError> {
+        // No large-page mapping without SeLockMemoryPrivilege; the heap is the portable fallback
+        Ok(Self::heap(blocks))
+    }
+
+    /// Map `blocks` blocks stored in `file` at `offset` (page aligned) as a private,
+    /// copy-on-write view: nothing is read until a page is first touched, and writes
+    /// stay in this process
+    #[cfg(unix)]
+    pub fn map_file(file: &File, offset: usize, blocks: usize) -> Result<Self, BloomFilterError> {
+        use std::os::unix::io::AsRawFd;
+
+        let map_len = offset + blocks * std::mem::size_of::<BloomBlock>();
+        let base = unsafe {
+            libc::mmap(std::ptr::null_mut(), map_len, libc::PROT_READ | libc::PROT_WRITE, libc::MAP_PRIVATE, file.as_raw_fd(), 0)
+        };
+        if base == libc::MAP_FAILED {
+            return Err(BloomFilterError::MemoryError);
+        }
+        unsafe {
+            // Lookups are scattered; readahead would only pull in pages nobody asked for
+            libc::madvise(base, map_len, libc::MADV_RANDOM);
+        }
+
+        let ptr = unsafe { (base as *mut u8).add(offset) } as *mut BloomBlock;
+        Ok(Self { ptr, blocks, backing: Backing::File { base, map_len }, locked: false })
+    }
+
+    /// Portable fallback: read the blocks into a heap array
+    #[cfg(not(unix))]
+    pub fn map_file(file: &File, offset: usize, blocks: usize) -> Result<Self, BloomFilterError> {
+        use std::io::{Read, Seek, SeekFrom};
+
+        let storage = Self::heap(blocks);
+        let mut reader = std::io::BufReader::with_capacity(1 << 20, file);
+        reader.seek(SeekFrom::Start(offset as u64)).map_err(|_| BloomFilterError::MemoryError)?;
+        let mut word = [0u8; 8];
+        for block in storage.iter() {
+            for slot in block.words() {
+                reader.read_exact(&mut word).map_err(|_| BloomFilterError::MemoryError)?;
+                slot.store(u64::from_le_bytes(word), std::sync::atomic::Ordering::Relaxed);
+            }
+        }
+        Ok(storage)
+    }
+
+    /// Bytes reserved for the bit array, including huge-page rounding
+    pub fn memory_bytes(&self) -> usize {
+        match &self.backing {
+            Backing::Heap(data) => data.len() * std::mem::size_of::<BloomBlock>(),
+            #[cfg(unix)]
+            Backing::Anonymous { map_len, .. } => *map_len,
+            #[cfg(unix)]
+            Backing::File { .. } => self.blocks * std::mem::size_of::<BloomBlock>(),
+        }
+    }
+
+    /// Whether the array is backed by explicitly reserved huge pages
+    pub fn uses_huge_pages(&self) -> bool {
+        match &self.backing {
+            #[cfg(unix)]
+            Backing::Anonymous { huge_pages, .. } => *huge_pages,
+            _ => false,
+        }
+    }
+
+    /// Whether the array is mapped rather than heap allocated
+    pub fn is_mapped(&self) -> bool {
+        !matches!(self.backing, Backing::Heap(_))
+    }
+
+    /// Whether `BLOOM_STORAGE_LOCKED` succeeded in pinning the array
+    pub fn is_locked(&self) -> bool {
+        self.locked
+    }
+
+    /// Fault in every page from the calling thread; snapshot mappings are only read in,
+    /// so their pages stay shared with the page cache until written
+    pub fn prefault(&self) {
+        let bytes = self.blocks * std::mem::size_of::<BloomBlock>();
+        #[cfg(unix)]
+        let write = !matches!(self.backing, Backing::File { .. });
+        #[cfg(not(unix))]
+        let write = true;
+        unsafe { numa::populate(self.ptr as *mut u8, bytes, write) };
+    }
+}
+
+impl Deref for BloomStorage {
+    type Target = [BloomBlock];
+
+    fn deref(&self) -> &[BloomBlock] {
+        unsafe { std::slice::from_raw_parts(self.ptr, self.blocks) }
+    }
+}
+
+impl Drop for BloomStorage {
+    fn drop(&mut self) {
+        let bytes = self.blocks * std::mem::size_of::<BloomBlock>();
+        if self.locked {
+            let _ = unsafe { crate::memory::unlock_memory(self.ptr as *mut u8, bytes) };
+        }
+        match &self.backing {
+            Backing::Heap(_) => {}
+            #[cfg(unix)]
+            Backing::Anonymous { map_len, .. } => unsafe {
+                libc::munmap(self.ptr as *mut libc::c_void, *map_len);
+            },
+            #[cfg(unix)]
+            Backing::File { base, map_len } => unsafe {
+                libc::munmap(*base, *map_len);
+            },
+        }
+    }
+}
+
+#[cfg(any(target_os = "linux", target_os = "android"))]
+const MAP_NORESERVE: libc::c_int = libc::MAP_NORESERVE;
+#[cfg(all(unix, not(any(target_os = "linux", target_os = "android"))))]
+const MAP_NORESERVE: libc::c_int = 0;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_heap_and_mapped_storage() {
+        let small = BloomStorage::allocate(64, 0).unwrap();
+        assert_eq!(small.len(), 64);
+        assert!(!small.is_mapped());
+
+        let blocks = BLOOM_MMAP_THRESHOLD / std::mem::size_of::<BloomBlock>() + 1;
+        let large = BloomStorage::allocate(blocks, BLOOM_STORAGE_HUGE_PAGES | BLOOM_STORAGE_LOCKED).unwrap();
+        assert_eq!(large.len(), blocks);
+        assert!(large.memory_bytes() >= blocks * 64);
+        assert_eq!(large.as_ptr() as usize % 64, 0);
+        #[cfg(unix)]
+        assert!(large.is_mapped());
+    }
+}
@@ -0,0 +1,419 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - Chunked SecureBuffer integrity
+// One CRC32C tag per 4 KiB chunk, seeded per buffer. Writers mark the chunks they are
+// about to change dirty and retag only those once done; edits handed out for the caller to
+// finish (`staged`, `contents_mut`) stay dirty until the next check retags them. An
+// optional background sweep verifies a budget of clean chunks per tick, so detecting stray
+// writes costs a steady trickle of CRC work instead of rehashing the whole buffer on every
+// check.
+//
+// CRC32C runs on SSE4.2 / ARMv8 CRC instructions when present (several GB/s per core).
+// It catches corruption and out-of-band writes, not a forger who can also rewrite the
+// tags; those live in a separate heap allocation, not next to the data.
+
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::{Arc, Condvar, Mutex, MutexGuard, OnceLock, Weak};
+use std::time::{Duration, Instant};
+
+use crate::{audit_log, SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED};
+
+/// Bytes covered by one tag
+pub const INTEGRITY_CHUNK: usize = 4096;
+
+/// Process-wide verification counters, folded into `securebuffer_get_global_metrics`
+pub(crate) struct IntegrityCounters {
+    pub chunks_verified: AtomicU64,
+    pub chunks_retagged: AtomicU64,
+    pub failures: AtomicU64,
+    pub tamper_events: AtomicU64,
+}
+
+pub(crate) static GLOBAL_INTEGRITY_COUNTERS: IntegrityCounters = IntegrityCounters {
+    chunks_verified: AtomicU64::new(0),
+    chunks_retagged: AtomicU64::new(0),
+    failures: AtomicU64::new(0),
+    tamper_events: AtomicU64::new(0),
+};
+
+/// CRC32C kernel chosen for this CPU
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Crc32cBackend {
+    Table,
+    Sse42,
+    ArmCrc,
+}
+
+impl Crc32cBackend {
+    pub fn name(self) -> &'static str {
+        match self {
+            Self::Table => "table",
+            Self::Sse42 => "sse4.2",
+            Self::ArmCrc => "armv8-crc",
+        }
+    }
+}
+
+/// Detect the best kernel once per process
+pub fn crc32c_backend() -> Crc32cBackend {
+    static BACKEND: OnceLock<Crc32cBackend> = OnceLock::new();
+    *BACKEND.get_or_init(|| {
+        #[cfg(target_arch = "x86_64")]
+        {
+            if is_x86_feature_detected!("sse4.2") {
+                return Crc32cBackend::Sse42;
+            }
+        }
+        #[cfg(target_arch = "aarch64")]
+        {
+            if std::arch::is_aarch64_feature_detected!("crc") {
+                return Crc32cBackend::ArmCrc;
+            }
+        }
+        Crc32cBackend::Table
+    })
+}
+
+/// Reflected Castagnoli polynomial table for the portable path
+const CRC32C_TABLE: [u32; 256] = {
+    let mut table = [0u32; 256];
+    let mut i = 0;
+    while i < 256 {
+        let mut crc = i as u32;
+        let mut bit = 0;
+        while bit < 8 {
+            crc = if crc & 1 != 0 { (crc >> 1) ^ 0x82f6_3b78 } else { crc >> 1 };
+            bit += 1;
+        }
+        table[i] = crc;
+        i += 1;
+    }
+    table
+};
+
+fn crc32c_table(mut crc: u32, data: &[u8]) -> u32 {
+    for &byte in data {
+        crc = CRC32C_TABLE[((crc ^ byte as u32) & 0xff) as usize] ^ (crc >> 8);
+    }
+    crc
+}
+
+#[cfg(target_arch = "x86_64")]
+#[target_feature(enable = "sse4.2")]
+unsafe fn crc32c_sse42(crc: u32, data: &[u8]) -> u32 {
+    use std::arch::x86_64::{_mm_crc32_u64, _mm_crc32_u8};
+
+    let mut crc = crc as u64;
+    let mut words = data.chunks_exact(8);
+    for word in &mut words {
+        crc = _mm_crc32_u64(crc, u64::from_le_bytes(word.try_into().unwrap()));
+    }
+    let mut crc = crc as u32;
+    for &byte in words.remainder() {
+        crc = _mm_crc32_u8(crc, byte);
+    }
+    crc
+}
+
+#[cfg(target_arch = "aarch64")]
+#[target_feature(enable = "crc")]
+unsafe fn crc32c_arm(mut crc: u32, data: &[u8]) -> u32 {
+    use std::arch::aarch64::{__crc32cb, __crc32cd};
+
+    let mut words = data.chunks_exact(8);
+    for word in &mut words {
+        crc = __crc32cd(crc, u64::from_le_bytes(word.try_into().unwrap()));
+    }
+    for &byte in words.remainder() {
+        crc = __crc32cb(crc, byte);
+    }
+    crc
+}
+
+/// CRC32C (Castagnoli) of `data` continuing from `init`; `crc32c(0, b"123456789")` is 0xe3069283
+pub fn crc32c(init: u32, data: &[u8]) -> u32 {
+    let crc = !init;
+    let crc = match crc32c_backend() {
+        #[cfg(target_arch = "x86_64")]
+        Crc32cBackend::Sse42 => unsafe { crc32c_sse42(crc, data) },
+        #[cfg(target_arch = "aarch64")]
+        Crc32cBackend::ArmCrc => unsafe { crc32c_arm(crc, data) },
+        _ => crc32c_table(crc, data),
+    };
+    !crc
+}
+
+struct TagState {
+    /// Null once the owning buffer has been destroyed
+    data: *const u8,
+    capacity: usize,
+    seed: u32,
+    tags: Vec<u32>,
+    /// One bit per chunk changed in place and not yet retagged
+    dirty: Vec<u64>,
+    /// Next chunk for `verify_step`
+    cursor: usize,
+}
+
+// The data pointer is only dereferenced under the mutex while the buffer is alive
+unsafe impl Send for TagState {}
+
+impl TagState {
+    fn chunks(&self) -> usize {
+        self.tags.len()
+    }
+
+    fn chunk(&self, index: usize) -> &[u8] {
+        let start = index * INTEGRITY_CHUNK;
+        let len = INTEGRITY_CHUNK.min(self.capacity - start);
+        unsafe { std::slice::from_raw_parts(self.data.add(start), len) }
+    }
+
+    fn tag(&self, index: usize) -> u32 {
+        crc32c(self.seed, self.chunk(index))
+    }
+
+    fn is_dirty(&self, index: usize) -> bool {
+        self.dirty[index / 64] & (1 << (index % 64)) != 0
+    }
+
+    fn retag(&mut self, chunks: std::ops::Range<usize>) {
+        for index in chunks.clone() {
+            self.tags[index] = self.tag(index);
+            self.dirty[index / 64] &= !(1 << (index % 64));
+        }
+        GLOBAL_INTEGRITY_COUNTERS.chunks_retagged.fetch_add(chunks.len() as u64, Ordering::Relaxed);
+    }
+
+    /// Verify `index` unless it is dirty; false on a mismatch
+    fn verify(&self, index: usize) -> bool {
+        if self.is_dirty(index) {
+            return true;
+        }
+        GLOBAL_INTEGRITY_COUNTERS.chunks_verified.fetch_add(1, Ordering::Relaxed);
+        self.tag(index) == self.tags[index]
+    }
+}
+
+/// Tags for one buffer, shared with the background scheduler through a `Weak`
+pub struct ChunkIntegrity {
+    state: Mutex<TagState>,
+    tampered: AtomicBool,
+    scheduled: AtomicBool,
+    buffer_id: u64,
+}
+
+impl ChunkIntegrity {
+    /// Tag the current contents of `capacity` bytes at `data`, owned by buffer `buffer_id`
+    pub(crate) fn new(data: *const u8, capacity: usize, buffer_id: u64) -> Arc<Self> {
+        use rand::RngCore;
+
+        let chunks = capacity.div_ceil(INTEGRITY_CHUNK);
+        let mut state = TagState {
+            data,
+            capacity,
+            seed: rand::thread_rng().next_u32(),
+            tags: vec![0; chunks],
+            dirty: vec![0; chunks.div_ceil(64)],
+            cursor: 0,
+        };
+        state.retag(0..chunks);
+        Arc::new(Self { state: Mutex::new(state), tampered: AtomicBool::new(false), scheduled: AtomicBool::new(false), buffer_id })
+    }
+
+    fn lock(&self) -> MutexGuard<'_, TagState> {
+        self.state.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    fn flag(&self) {
+        GLOBAL_INTEGRITY_COUNTERS.failures.fetch_add(1, Ordering::Relaxed);
+        if !self.tampered.swap(true, Ordering::AcqRel) {
+            GLOBAL_INTEGRITY_COUNTERS.tamper_events.fetch_add(1, Ordering::Relaxed);
+            audit_log::record(audit_log::AuditKind::TamperDetected, self.buffer_id, 0, SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED);
+        }
+    }
+
+    /// Mark `[start, end)` dirty ahead of an in-place change. Sweeps skip dirty chunks, so
+    /// they never read one mid-write; `retag` or the next `check` makes it clean again.
+    pub(crate) fn mark_dirty(&self, start: usize, end: usize) {
+        let mut state = self.lock();
+        let end = end.min(state.capacity);
+        if start >= end {
+            return;
+        }
+        for index in start / INTEGRITY_CHUNK..end.div_ceil(INTEGRITY_CHUNK) {
+            state.dirty[index / 64] |= 1 << (index % 64);
+        }
+    }
+
+    /// Retag the chunks overlapping `[0, end)` once a change is complete; bytes past `end`
+    /// must be unchanged
+    pub(crate) fn retag(&self, end: usize) {
+        let mut state = self.lock();
+        if !state.data.is_null() {
+            let chunks = end.min(state.capacity).div_ceil(INTEGRITY_CHUNK);
+            state.retag(0..chunks);
+        }
+    }
+
+    /// Stop touching the buffer's memory; called before it is freed
+    pub(crate) fn detach(&self) {
+        self.lock().data = std::ptr::null();
+    }
+
+    pub fn is_tampered(&self) -> bool {
+        self.tampered.load(Ordering::Acquire)
+    }
+
+    /// Retag dirty chunks, then report whether every chunk still matches. With a background
+    /// schedule the clean chunks are left to the sweep and this costs only the dirty ones.
+    pub fn check(&self) -> bool {
+        let mut state = self.lock();
+        if state.data.is_null() {
+            return false;
+        }
+        for word in 0..state.dirty.len() {
+            while state.dirty[word] != 0 {
+                let index = word * 64 + state.dirty[word].trailing_zeros() as usize;
+                state.retag(index..index + 1);
+            }
+        }
+        if !self.scheduled.load(Ordering::Acquire) && !(0..state.chunks()).all(|i| state.verify(i)) {
+            drop(state);
+            self.flag();
+        }
+        !self.is_tampered()
+    }
+
+    /// Verify up to `max_chunks` clean chunks from where the last step stopped
+    pub fn verify_step(&self, max_chunks: usize) -> bool {
+        let mut state = self.lock();
+        if state.data.is_null() {
+            return !self.is_tampered();
+        }
+        let mut clean = true;
+        for _ in 0..max_chunks.min(state.chunks()) {
+            let index = state.cursor;
+            clean &= state.verify(index);
+            state.cursor = (index + 1) % state.chunks();
+        }
+        drop(state);
+        if !clean {
+            self.flag();
+        }
+        !self.is_tampered()
+    }
+}
+
+struct Scheduled {
+    target: Weak<ChunkIntegrity>,
+    interval: Duration,
+    chunks_per_tick: usize,
+    next_due: Instant,
+}
+
+struct Scheduler {
+    entries: Mutex<Vec<Scheduled>>,
+    changed: Condvar,
+}
+
+fn scheduler() -> &'static Scheduler {
+    static SCHEDULER: OnceLock<&'static Scheduler> = OnceLock::new();
+    SCHEDULER.get_or_init(|| {
+        let scheduler: &'static Scheduler = Box::leak(Box::new(Scheduler { entries: Mutex::new(Vec::new()), changed: Condvar::new() }));
+        std::thread::Builder::new()
+            .name("securebuffer-integrity".into())
+            .spawn(move || scheduler.run())
+            .expect("spawn integrity scheduler");
+        scheduler
+    })
+}
+
+impl Scheduler {
+    fn run(&self) {
+        let mut entries = self.entries.lock().unwrap_or_else(|e| e.into_inner());
+        loop {
+            let now = Instant::now();
+            let mut due = Vec::new();
+            entries.retain_mut(|entry| match entry.target.upgrade() {
+                Some(target) if target.scheduled.load(Ordering::Acquire) => {
+                    if entry.next_due <= now {
+                        entry.next_due = now + entry.interval;
+                        due.push((target, entry.chunks_per_tick));
+                    }
+                    true
+                }
+                _ => false,
+            });
+            if !due.is_empty() {
+                // Verify without holding the registry so scheduling calls never wait on a sweep
+                drop(entries);
+                for (target, chunks) in due {
+                    target.verify_step(chunks);
+                }
+                entries = self.entries.lock().unwrap_or_else(|e| e.into_inner());
+                continue;
+            }
+            let wait = entries.iter().map(|e| e.next_due.saturating_duration_since(now)).min();
+            entries = match wait {
+                Some(wait) => self.changed.wait_timeout(entries, wait).unwrap_or_else(|e| e.into_inner()).0,
+                None => self.changed.wait(entries).unwrap_or_else(|e| e.into_inner()),
+            };
+        }
+    }
+}
+
+/// Verify `chunks_per_tick` chunks of `target` every `interval` on the shared background
+/// thread until rescheduled, cancelled (`interval` zero) or dropped
+pub(crate) fn schedule(target: &Arc<ChunkIntegrity>, interval: Duration, chunks_per_tick: usize) {
+    let scheduler = scheduler();
+    let mut entries = scheduler.entries.lock().unwrap_or_else(|e| e.into_inner());
+    entries.retain(|entry| !std::ptr::eq(entry.target.as_ptr(), Arc::as_ptr(target)));
+    let active = !interval.is_zero() && chunks_per_tick > 0;
+    target.scheduled.store(active, Ordering::Release);
+    if active {
+        entries.push(Scheduled { target: Arc::downgrade(target), interval, chunks_per_tick, next_due: Instant::now() + interval });
+    }
+    scheduler.changed.notify_one();
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_chunk_integrity_tracks_writes_and_catches_stray_ones() {
+        assert_eq!(crc32c(0, b"123456789"), 0xe306_9283);
+        let sample: Vec<u8> = (0..10_000u32).map(|i| (i * 7) as u8).collect();
+        assert_eq!(crc32c(5, &sample), !crc32c_table(!5, &sample));
+
+        let mut memory = vec![0u8; 5 * INTEGRITY_CHUNK + 100];
+        let integrity = ChunkIntegrity::new(memory.as_ptr(), memory.len(), 0);
+        assert!(integrity.check());
+
+        // A tracked write retags only what it covers
+        let before = GLOBAL_INTEGRITY_COUNTERS.chunks_retagged.load(Ordering::Relaxed);
+        integrity.mark_dirty(0, 5000);
+        memory[..5000].fill(0xaa);
+        integrity.retag(5000);
+        assert!(GLOBAL_INTEGRITY_COUNTERS.chunks_retagged.load(Ordering::Relaxed) - before >= 2);
+        assert!(integrity.check());
+
+        // Dirty chunks are skipped by the sweep and retagged by the next check
+        integrity.mark_dirty(3 * INTEGRITY_CHUNK, 3 * INTEGRITY_CHUNK + 1);
+        memory[3 * INTEGRITY_CHUNK] = 1;
+        assert!(integrity.verify_step(6));
+        assert!(integrity.check());
+
+        // A scheduled sweep finds an untracked write without a foreground full pass
+        schedule(&integrity, Duration::from_millis(1), 2);
+        memory[5 * INTEGRITY_CHUNK + 50] ^= 0xff;
+        let deadline = Instant::now() + Duration::from_secs(5);
+        while !integrity.is_tampered() && Instant::now() < deadline {
+            std::thread::sleep(Duration::from_millis(1));
+        }
+        assert!(integrity.is_tampered());
+        assert!(!integrity.check());
+        schedule(&integrity, Duration::ZERO, 0);
+        integrity.detach();
+    }
+}
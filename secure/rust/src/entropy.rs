@@ -10,6 +10,8 @@
 use base64;
 use hex;
 
+use crate::entropy_reservoir;
+
 // Static jitter accumulator for CPU timing entropy
 static JITTER_COUNTER: AtomicU64 = AtomicU64::new(0);
 
@@ -41,7 +43,7 @@ pub fn new() -> Self {
     }
 
     /// Collect high-resolution timing jitter (supplemental entropy only)
-    fn collect_jitter(&self) -> u64 {
+    pub(crate) fn collect_jitter(&self) -> u64 {
         let start = std::time::Instant::now();
 
         // Perform some unpredictable operations to create timing variance
@@ -120,10 +122,14 @@ fn get_os_entropy(&mut self, output: &mut [u8]) -> Result<(), EntropyError> {
     }
 }
 
-/// Generate fast, cryptographically secure entropy (32 bytes)
+/// Generate fast, cryptographically secure entropy (32 bytes) from the calling thread's
+/// reservoir, falling back to a direct OS RNG read if the reservoir cannot be seeded
 pub fn fast_entropy() -> [u8; 32] {
-    let mut collector = EntropyCollector::new();
     let mut output = [0u8; 32];
+    if entropy_reservoir::fill_entropy(&mut output).is_ok() {
+        return output;
+    }
+    let mut collector = EntropyCollector::new();
 
     // Use cryptographically secure OS randomness as primary source
     if collector.get_os_entropy(&mut output).is_ok() {
@@ -144,10 +150,16 @@ fn get_os_entropy(&mut self, output: &mut [u8]) -> Result<(), EntropyError> {
     output
 }
 
-/// Generate hybrid entropy using Bitcoin headers + OS randomness + timing jitter
+/// Generate hybrid entropy using Bitcoin headers + OS randomness + timing jitter. The
+/// headers reseed the shared reservoir (once per distinct header set) and output is drawn
+/// from it, so repeated calls with the current tip cost no syscall.
 pub fn hybrid_entropy(headers: &[Vec<u8>]) -> [u8; 32] {
-    let mut collector = EntropyCollector::new();
     let mut output = [0u8; 32];
+    entropy_reservoir::mix_headers(headers);
+    if entropy_reservoir::fill_entropy(&mut output).is_ok() {
+        return output;
+    }
+    let mut collector = EntropyCollector::new();
 
     // Start with cryptographically secure OS entropy
     let _ = collector.get_os_entropy(&mut output);
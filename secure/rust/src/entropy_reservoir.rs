@@ -0,0 +1,321 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - Per-thread entropy reservoir
+// Each thread keeps a ChaCha20 keystream buffer keyed from OS randomness, timing jitter and
+// the latest block headers mixed in through `mix_headers`. Serving bytes is a copy out of
+// the buffer; refills rekey from the keystream itself (fast key erasure), so earlier output
+// cannot be reconstructed from the live state. The OS RNG is only consulted on first use,
+// every RESERVOIR_RESEED_INTERVAL_BYTES of output and after fork.
+
+use std::cell::RefCell;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Mutex, Once};
+
+use rand::rngs::OsRng;
+use rand::RngCore;
+use sha2::{Digest, Sha256};
+use zeroize::Zeroize;
+
+use crate::entropy::{EntropyCollector, EntropyError};
+use crate::memory;
+
+/// Keystream blocks generated per refill
+const RESERVOIR_BLOCKS: usize = 4;
+const RESERVOIR_BYTES: usize = RESERVOIR_BLOCKS * 64;
+/// Output served between OS RNG reseeds
+pub const RESERVOIR_RESEED_INTERVAL_BYTES: usize = 1 << 20;
+/// Requests at least this large are written straight from the keystream
+const DIRECT_FILL_BYTES: usize = 1024;
+
+/// Bumped when new block headers are mixed in; reservoirs fold the seed in on next use
+static HEADER_EPOCH: AtomicU64 = AtomicU64::new(0);
+/// Accumulated header seed and the digest of the last header set mixed in
+static HEADER_SEED: Mutex<([u8; 32], [u8; 32])> = Mutex::new(([0u8; 32], [0u8; 32]));
+/// Bumped in the child after fork so parent and child never share a keystream
+static OS_EPOCH: AtomicU64 = AtomicU64::new(0);
+static ATFORK: Once = Once::new();
+
+#[inline(always)]
+fn quarter_round(s: &mut [u32; 16], a: usize, b: usize, c: usize, d: usize) {
+    s[a] = s[a].wrapping_add(s[b]);
+    s[d] = (s[d] ^ s[a]).rotate_left(16);
+    s[c] = s[c].wrapping_add(s[d]);
+    s[b] = (s[b] ^ s[c]).rotate_left(12);
+    s[a] = s[a].wrapping_add(s[b]);
+    s[d] = (s[d] ^ s[a]).rotate_left(8);
+    s[c] = s[c].wrapping_add(s[d]);
+    s[b] = (s[b] ^ s[c]).rotate_left(7);
+}
+
+/// One ChaCha20 block (RFC 8439); `tail` is state words 12..16 (counter and nonce)
+fn chacha20_block(key: &[u32; 8], tail: [u32; 4], out: &mut [u8]) {
+    let mut input = [0u32; 16];
+    input[..4].copy_from_slice(&[0x6170_7865, 0x3320_646e, 0x7962_2d32, 0x6b20_6574]);
+    input[4..12].copy_from_slice(key);
+    input[12..].copy_from_slice(&tail);
+
+    let mut s = input;
+    for _ in 0..10 {
+        quarter_round(&mut s, 0, 4, 8, 12);
+        quarter_round(&mut s, 1, 5, 9, 13);
+        quarter_round(&mut s, 2, 6, 10, 14);
+        quarter_round(&mut s, 3, 7, 11, 15);
+        quarter_round(&mut s, 0, 5, 10, 15);
+        quarter_round(&mut s, 1, 6, 11, 12);
+        quarter_round(&mut s, 2, 7, 8, 13);
+        quarter_round(&mut s, 3, 4, 9, 14);
+    }
+    for ((chunk, word), init) in out.chunks_exact_mut(4).zip(&s).zip(&input) {
+        chunk.copy_from_slice(&word.wrapping_add(*init).to_le_bytes());
+    }
+    s.zeroize();
+    input.zeroize();
+}
+
+/// Counter words for keystream block `index`; the nonce is always zero since keys are single-use
+fn counter(index: u64) -> [u32; 4] {
+    [index as u32, (index >> 32) as u32, 0, 0]
+}
+
+#[cfg(unix)]
+extern "C" fn after_fork_child() {
+    OS_EPOCH.fetch_add(1, Ordering::Relaxed);
+}
+
+struct Reservoir {
+    key: [u32; 8],
+    stream: [u8; RESERVOIR_BYTES],
+    /// Next unserved byte of `stream`
+    pos: usize,
+    since_os_seed: usize,
+    header_epoch: u64,
+    os_epoch: u64,
+    seeded: bool,
+    locked: bool,
+}
+
+impl Reservoir {
+    fn new() -> Box<Self> {
+        ATFORK.call_once(|| {
+            #[cfg(unix)]
+            unsafe {
+                libc::pthread_atfork(None, None, Some(after_fork_child));
+            }
+        });
+        let mut reservoir = Box::new(Self {
+            key: [0; 8],
+            stream: [0; RESERVOIR_BYTES],
+            pos: RESERVOIR_BYTES,
+            since_os_seed: 0,
+            header_epoch: 0,
+            os_epoch: 0,
+            seeded: false,
+            locked: false,
+        });
+        let (ptr, len) = (&mut *reservoir as *mut Self as *mut u8, std::mem::size_of::<Self>());
+        reservoir.locked = unsafe { memory::lock_memory(ptr, len) }.is_ok();
+        reservoir
+    }
+
+    /// Fold fresh material into the key. `from_os` pulls OS randomness and jitter; otherwise
+    /// only the shared header seed is mixed in, which costs no syscall.
+    fn reseed(&mut self, from_os: bool) -> Result<(), EntropyError> {
+        let mut hasher = Sha256::new();
+        hasher.update(b"securebuffer-entropy-reservoir");
+        for word in &self.key {
+            hasher.update(word.to_le_bytes());
+        }
+        if from_os {
+            let mut seed = [0u8; 32];
+            let os_ok = OsRng.try_fill_bytes(&mut seed).is_ok();
+            if !os_ok && !self.seeded {
+                return Err(EntropyError::SystemError("OS RNG unavailable for reservoir seed".into()));
+            }
+            hasher.update(seed);
+            hasher.update(EntropyCollector::new().collect_jitter().to_le_bytes());
+            seed.zeroize();
+            self.os_epoch = OS_EPOCH.load(Ordering::Relaxed);
+            self.since_os_seed = 0;
+        }
+        self.header_epoch = HEADER_EPOCH.load(Ordering::Acquire);
+        hasher.update(HEADER_SEED.lock().unwrap_or_else(|e| e.into_inner()).0);
+
+        let mut digest: [u8; 32] = hasher.finalize().into();
+        for (word, chunk) in self.key.iter_mut().zip(digest.chunks_exact(4)) {
+            *word = u32::from_le_bytes(chunk.try_into().unwrap());
+        }
+        digest.zeroize();
+        // Discard keystream from the previous key
+        self.stream.zeroize();
+        self.pos = RESERVOIR_BYTES;
+        self.seeded = true;
+        Ok(())
+    }
+
+    fn maybe_reseed(&mut self) -> Result<(), EntropyError> {
+        if !self.seeded
+            || self.since_os_seed >= RESERVOIR_RESEED_INTERVAL_BYTES
+            || self.os_epoch != OS_EPOCH.load(Ordering::Relaxed)
+        {
+            self.reseed(true)
+        } else if self.header_epoch != HEADER_EPOCH.load(Ordering::Relaxed) {
+            self.reseed(false)
+        } else {
+            Ok(())
+        }
+    }
+
+    /// Take the first 32 keystream bytes as the next key and wipe them
+    fn rekey_from(&mut self, block: &mut [u8]) {
+        for (word, chunk) in self.key.iter_mut().zip(block[..32].chunks_exact(4)) {
+            *word = u32::from_le_bytes(chunk.try_into().unwrap());
+        }
+        block[..32].zeroize();
+    }
+
+    fn refill(&mut self) {
+        for (index, block) in self.stream.chunks_exact_mut(64).enumerate() {
+            chacha20_block(&self.key, counter(index as u64), block);
+        }
+        let mut head = [0u8; 32];
+        head.copy_from_slice(&self.stream[..32]);
+        self.rekey_from(&mut head);
+        self.stream[..32].zeroize();
+        self.pos = 32;
+    }
+
+    fn fill(&mut self, mut out: &mut [u8]) -> Result<(), EntropyError> {
+        self.maybe_reseed()?;
+        self.since_os_seed = self.since_os_seed.saturating_add(out.len());
+
+        if out.len() >= DIRECT_FILL_BYTES {
+            // Block 0 keys the next generation; blocks 1.. go straight to the caller
+            let mut next = [0u8; 64];
+            chacha20_block(&self.key, counter(0), &mut next);
+            for (index, chunk) in (1u64..).zip(out.chunks_mut(64)) {
+                if chunk.len() == 64 {
+                    chacha20_block(&self.key, counter(index), chunk);
+                } else {
+                    let mut tail = [0u8; 64];
+                    chacha20_block(&self.key, counter(index), &mut tail);
+                    chunk.copy_from_slice(&tail[..chunk.len()]);
+                    tail.zeroize();
+                }
+            }
+            self.rekey_from(&mut next);
+            next.zeroize();
+            // Buffered keystream came from the retired key
+            self.stream.zeroize();
+            self.pos = RESERVOIR_BYTES;
+            return Ok(());
+        }
+
+        while !out.is_empty() {
+            if self.pos == RESERVOIR_BYTES {
+                self.refill();
+            }
+            let n = out.len().min(RESERVOIR_BYTES - self.pos);
+            let served = &mut self.stream[self.pos..self.pos + n];
+            out[..n].copy_from_slice(served);
+            served.zeroize();
+            self.pos += n;
+            out = &mut out[n..];
+        }
+        Ok(())
+    }
+}
+
+impl Drop for Reservoir {
+    fn drop(&mut self) {
+        let (ptr, len) = (self as *mut Self as *mut u8, std::mem::size_of::<Self>());
+        unsafe {
+            memory::explicit_bzero(ptr, len);
+            if self.locked {
+                let _ = memory::unlock_memory(ptr, len);
+            }
+        }
+    }
+}
+
+thread_local! {
+    static RESERVOIR: RefCell<Option<Box<Reservoir>>> = const { RefCell::new(None) };
+}
+
+/// Fill `out` from this thread's reservoir. Fails only if the OS RNG has never been
+/// available to this thread or thread-local storage is already torn down.
+pub fn fill_entropy(out: &mut [u8]) -> Result<(), EntropyError> {
+    RESERVOIR
+        .try_with(|cell| {
+            let mut slot = cell.try_borrow_mut().map_err(|_| EntropyError::InsufficientEntropy)?;
+            slot.get_or_insert_with(Reservoir::new).fill(out)
+        })
+        .map_err(|_| EntropyError::SystemError("Thread-local reservoir unavailable".into()))?
+}
+
+/// Mix block headers into the seed shared by all reservoirs. Re-mixing the same headers
+/// is a no-op, so callers can pass the current tip on every call.
+pub fn mix_headers(headers: &[Vec<u8>]) {
+    let valid = || headers.iter().filter(|h| !h.is_empty());
+    if valid().next().is_none() {
+        return;
+    }
+    let mut hasher = Sha256::new();
+    for header in valid() {
+        hasher.update((header.len() as u64).to_le_bytes());
+        hasher.update(header);
+    }
+    let digest: [u8; 32] = hasher.finalize().into();
+
+    let mut guard = HEADER_SEED.lock().unwrap_or_else(|e| e.into_inner());
+    let (seed, last) = &mut *guard;
+    if *last == digest {
+        return;
+    }
+    *last = digest;
+    let mut next = Sha256::new();
+    next.update(*seed);
+    next.update(digest);
+    *seed = next.finalize().into();
+    HEADER_EPOCH.fetch_add(1, Ordering::Release);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_entropy_reservoir() {
+        // RFC 8439 section 2.3.2
+        let key: Vec<u32> = (0u8..32).collect::<Vec<_>>().chunks(4).map(|c| u32::from_le_bytes(c.try_into().unwrap())).collect();
+        let mut block = [0u8; 64];
+        chacha20_block(&key.try_into().unwrap(), [1, 0x0900_0000, 0x4a00_0000, 0], &mut block);
+        assert_eq!(
+            hex::encode(block),
+            "10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4ed2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e"
+        );
+
+        // Successive draws, small and bulk, never repeat
+        let mut seen = std::collections::HashSet::new();
+        for len in [32, 32, 7, 200, 300, DIRECT_FILL_BYTES, 4097, 32] {
+            let mut out = vec![0u8; len];
+            fill_entropy(&mut out).unwrap();
+            assert!(out.iter().any(|&b| b != 0));
+            assert!(seen.insert(out[..7].to_vec()));
+        }
+
+        // Header mixing reseeds other threads without disturbing their output
+        mix_headers(&[vec![0x11; 80]]);
+        let epoch = HEADER_EPOCH.load(Ordering::Relaxed);
+        mix_headers(&[vec![0x11; 80]]);
+        assert_eq!(HEADER_EPOCH.load(Ordering::Relaxed), epoch);
+        let other = std::thread::spawn(|| {
+            let mut out = [0u8; 32];
+            fill_entropy(&mut out).unwrap();
+            out
+        })
+        .join()
+        .unwrap();
+        let mut mine = [0u8; 32];
+        fill_entropy(&mut mine).unwrap();
+        assert_ne!(other, mine);
+    }
+}
@@ -2,15 +2,33 @@
 // BitcoinCab.inc - SecureBuffer core with thread-safety and production hardening
 
 use std::alloc::{alloc, dealloc, Layout};
-use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::atomic::{fence, AtomicBool, AtomicU32, AtomicU64, Ordering};
+use std::sync::Arc;
 use std::io;
 use std::ffi::{CStr, c_char, CString};
 use std::os::raw::{c_void, c_int};
-use std::time::{SystemTime, UNIX_EPOCH};
 use thiserror::Error;
 // Import the bloom filter module and its traits
 pub mod bloom_filter;
-use bloom_filter::{BlockchainHash, TransactionId, UniversalBloomFilter, NetworkConfig, BloomConfig, BlockData};
+pub mod bloom_storage;
+pub mod bloom_registry;
+pub mod bloom_seen;
+pub mod secure_pool;
+pub mod secure_hmac;
+pub mod sha256_batch;
+pub mod secure_aead;
+pub mod secure_kdf;
+pub mod buffer_integrity;
+pub mod op_metrics;
+pub mod audit_log;
+// Pooled, pipelined TLS channels behind the securechannel_pool_* exports
+pub mod secure_channel_pool;
+// NUMA topology, memory placement and node-pinned workers
+pub mod numa;
+// Sealed-memfd record ring for zero-copy hand-off between processes
+#[cfg(target_os = "linux")]
+pub mod shm_ring;
+use bloom_filter::{BlockchainHash, TransactionId, UniversalBloomFilter, NetworkConfig, BloomConfig};
 
 // Storage verification module (optional IPFS support)
 pub mod storage_verifier;
@@ -31,6 +49,9 @@
 // Entropy module for hybrid Bitcoin + OS + jitter randomness
 pub mod entropy;
 
+// Per-thread ChaCha20 reservoir behind fast_entropy and securebuffer_fill_entropy
+pub mod entropy_reservoir;
+
 // SecureBuffer entropy integration
 pub mod securebuffer_entropy;
 
@@ -149,6 +170,29 @@ pub enum SecureBufferError {
     InvalidState,
 }
 
+/// Process-wide live-buffer gauges for `securebuffer_get_global_metrics`. Totals are
+/// counted per thread in `op_metrics`; the peak needs one shared value to compare against.
+struct BufferCounters {
+    active: AtomicU64,
+    peak_active: AtomicU64,
+}
+
+static BUFFER_COUNTERS: BufferCounters = BufferCounters {
+    active: AtomicU64::new(0),
+    peak_active: AtomicU64::new(0),
+};
+
+/// Source of `SecureBuffer::id`; 0 is reserved for process-wide audit events
+static NEXT_BUFFER_ID: AtomicU64 = AtomicU64::new(1);
+
+/// Raw HMAC digest size and its hex / unpadded base64url text lengths
+pub const HMAC_DIGEST_LEN: usize = 32;
+pub const HMAC_HEX_LEN: usize = 64;
+pub const HMAC_BASE64URL_LEN: usize = 43;
+
+/// Largest batch accepted by the batch HMAC entry points (`SECUREBUFFER_BATCH_MAX_SIZE`)
+pub const SECUREBUFFER_BATCH_MAX_SIZE: usize = 1024;
+
 /// Thread-safe secure buffer with memory locking and hardened zeroization
 pub struct SecureBuffer {
     data: *mut u8,
@@ -156,14 +200,23 @@ pub struct SecureBuffer {
     length: usize,
     is_valid: AtomicBool,
     is_locked: AtomicBool,
+    key_epoch: Arc<AtomicU64>, // Bumped whenever the contents change; shared with HMAC contexts
+    seq: AtomicU64, // Seqlock for rewrites that may race `read_consistent`; odd mid-write
+    integrity: Option<Arc<buffer_integrity::ChunkIntegrity>>, // Per-chunk tags once tamper detection is on
+    id: u64, // Never reused; names the buffer in audit records
+    access: AtomicU32, // Advisory reader count for C callers, or ACCESS_WRITER
 }
 
+/// `SecureBuffer::access` while a writer holds it
+const ACCESS_WRITER: u32 = u32::MAX;
+
 impl SecureBuffer {
     /// Create a new secure buffer with the specified capacity
     pub fn new(capacity: usize) -> Result<Self, String> {
         if capacity == 0 {
             return Err("Capacity must be greater than 0".to_string());
         }
+        let _timer = op_metrics::timer(op_metrics::MetricOp::Alloc);
         
         // Use aligned allocation for better security and performance
         let layout = Layout::from_size_align(capacity, 32)
@@ -182,13 +235,24 @@ pub fn new(capacity: usize) -> Result<Self, String> {
     // Attempt to lock memory (non-fatal if it fails)
     let is_locked = unsafe { memory::lock_memory(data, capacity) }.is_ok();
 
+    op_metrics::add(op_metrics::Counter::Allocations, 1);
+    op_metrics::add(op_metrics::Counter::BytesAllocated, capacity as u64);
+    let active = BUFFER_COUNTERS.active.fetch_add(1, Ordering::Relaxed) + 1;
+    BUFFER_COUNTERS.peak_active.fetch_max(active, Ordering::Relaxed);
+
     let buffer = SecureBuffer {
         data,
         capacity,
         length: 0,
         is_valid: AtomicBool::new(true),
         is_locked: AtomicBool::new(is_locked),
+        key_epoch: Arc::new(AtomicU64::new(0)),
+        seq: AtomicU64::new(0),
+        integrity: None,
+        id: NEXT_BUFFER_ID.fetch_add(1, Ordering::Relaxed),
+        access: AtomicU32::new(0),
     };
+    audit_log::record(audit_log::AuditKind::BufferCreated, buffer.id, capacity as u64, 0);
 
     Ok(buffer)
     }
@@ -203,6 +267,8 @@ pub fn write(&mut self, data: &[u8]) -> Result<(), String> {
             return Err("Data exceeds buffer capacity".to_string());
         }
 
+        let changed = self.length.max(data.len());
+        self.begin_change(changed);
         unsafe {
             // Zero any existing data first
             memory::explicit_bzero(self.data, self.capacity);
@@ -211,6 +277,8 @@ pub fn write(&mut self, data: &[u8]) -> Result<(), String> {
         }
         
         self.length = data.len();
+        self.key_epoch.fetch_add(1, Ordering::Release);
+        self.end_change(changed);
         Ok(())
     }
 
@@ -263,10 +331,14 @@ pub fn capacity(&self) -> usize {
     /// Clear all data from the buffer with secure zeroization
     pub fn clear(&mut self) {
         if self.is_valid.load(Ordering::SeqCst) {
+            let changed = self.length;
+            self.begin_change(changed);
             unsafe {
                 memory::explicit_bzero(self.data, self.capacity);
             }
             self.length = 0;
+            self.key_epoch.fetch_add(1, Ordering::Release);
+            self.end_change(changed);
         }
     }
 
@@ -285,6 +357,12 @@ pub fn is_locked(&self) -> bool {
         self.is_locked.load(Ordering::SeqCst)
     }
 
+    /// Fault in the buffer's pages from the calling thread, so first-touch places them on
+    /// its NUMA node. Contents are unchanged; locked buffers are already resident.
+    pub fn prefault(&self) {
+        unsafe { numa::populate(self.data, self.capacity, true) };
+    }
+
     /// Enable hardware-backed security features
     pub fn enable_hardware_protection(&mut self) -> Result<(), String> {
         // Implementation for hardware security module integration
@@ -315,8 +393,7 @@ pub fn disable_audit_logging(&mut self) {
 
     /// Check if audit logging is enabled
     pub fn is_audit_logging_enabled(&self) -> bool {
-        // Implementation to check audit logging status
-        self.is_valid.load(Ordering::SeqCst)
+        self.is_valid.load(Ordering::SeqCst) && audit_log::is_enabled()
     }
 
     /// Bind buffer to hardware security features
@@ -335,20 +412,21 @@ pub fn is_hardware_backed(&self) -> bool {
         self.is_valid.load(Ordering::SeqCst) && self.is_locked.load(Ordering::SeqCst)
     }
 
-    /// Enable tamper detection mechanisms
+    /// Enable tamper detection: tag every 4 KiB chunk of the current contents. Tracked
+    /// writes keep the tags current at a cost proportional to what they change.
     pub fn enable_tamper_detection(&mut self) -> Result<(), String> {
-        // Implementation for tamper detection
-        if self.is_valid.load(Ordering::SeqCst) {
-            Ok(())
-        } else {
-            Err("Buffer is invalid".to_string())
+        if !self.is_valid.load(Ordering::SeqCst) {
+            return Err("Buffer is invalid".to_string());
+        }
+        if self.integrity.is_none() {
+            self.integrity = Some(buffer_integrity::ChunkIntegrity::new(self.data, self.capacity, self.id));
         }
+        Ok(())
     }
 
     /// Check if buffer has been tampered with
     pub fn is_tampered(&self) -> bool {
-        // Implementation for tamper detection check
-        !self.is_valid.load(Ordering::SeqCst)
+        !self.is_valid.load(Ordering::SeqCst) || self.integrity.as_ref().is_some_and(|i| i.is_tampered())
     }
 
     /// Enable side-channel attack protection
@@ -387,48 +465,197 @@ pub fn get_compliance_report(&self) -> String {
         }
     }
 
-    /// Get security audit log
+    /// Get security audit log: a summary line, then this buffer's recent audit records
     pub fn get_security_audit_log(&self) -> String {
-        // Implementation for audit log retrieval
-        format!("AUDIT_LOG: Buffer created with capacity {}, current length {}", 
-                self.capacity, self.length)
+        let mut log = format!("AUDIT_LOG: Buffer {} with capacity {}, current length {}\n",
+                self.id, self.capacity, self.length);
+        log.push_str(&audit_log::recent(self.id));
+        log
     }
 
-    /// Generate HMAC in hexadecimal format
-    pub fn hmac_hex(&self, key: &[u8]) -> Result<String, String> {
+    /// Identifier used in audit records; unique for the life of the process
+    pub fn id(&self) -> u64 {
+        self.id
+    }
+
+    /// Compute the 32-byte HMAC digest of the buffer contents, on the stack
+    pub fn hmac_digest(&self, key: &[u8]) -> Result<[u8; HMAC_DIGEST_LEN], String> {
         use sha2::{Sha256, Digest};
-        
+
         if !self.is_valid.load(Ordering::SeqCst) || key.is_empty() {
             return Err("Invalid buffer or key".to_string());
         }
+        let _timer = op_metrics::timer(op_metrics::MetricOp::Hmac);
 
         // Simple HMAC implementation using SHA-256
-        let mut hasher = Sha256::new();
-        hasher.update(key);
-        unsafe {
-            hasher.update(std::slice::from_raw_parts(self.data, self.length));
-        }
-        let result = hasher.finalize();
-        Ok(hex::encode(result))
+        self.read_consistent(|contents| {
+            let mut hasher = Sha256::new();
+            hasher.update(key);
+            hasher.update(contents);
+            hasher.finalize().into()
+        })
+    }
+
+    /// Generate HMAC in hexadecimal format
+    pub fn hmac_hex(&self, key: &[u8]) -> Result<String, String> {
+        Ok(hex::encode(self.hmac_digest(key)?))
     }
 
     /// Generate HMAC in base64url format
     pub fn hmac_base64url(&self, key: &[u8]) -> Result<String, String> {
-        use sha2::{Sha256, Digest};
         use base64::{Engine as _, engine::general_purpose};
-        
-        if !self.is_valid.load(Ordering::SeqCst) || key.is_empty() {
+
+        Ok(general_purpose::URL_SAFE_NO_PAD.encode(self.hmac_digest(key)?))
+    }
+
+    /// Write the raw HMAC digest into `out`, returning the bytes written
+    pub fn hmac_into(&self, key: &[u8], out: &mut [u8]) -> Result<usize, String> {
+        let digest = self.hmac_digest(key)?;
+        out.get_mut(..HMAC_DIGEST_LEN).ok_or("Output buffer too small")?.copy_from_slice(&digest);
+        Ok(HMAC_DIGEST_LEN)
+    }
+
+    /// Write the HMAC as lowercase hex into `out` (no terminator), returning its length
+    pub fn hmac_hex_into(&self, key: &[u8], out: &mut [u8]) -> Result<usize, String> {
+        let digest = self.hmac_digest(key)?;
+        let out = out.get_mut(..HMAC_HEX_LEN).ok_or("Output buffer too small")?;
+        hex::encode_to_slice(digest, out).map_err(|_| "Output buffer too small".to_string())?;
+        Ok(HMAC_HEX_LEN)
+    }
+
+    /// Write the HMAC as unpadded base64url into `out` (no terminator), returning its length
+    pub fn hmac_base64url_into(&self, key: &[u8], out: &mut [u8]) -> Result<usize, String> {
+        use base64::{Engine as _, engine::general_purpose};
+
+        let digest = self.hmac_digest(key)?;
+        general_purpose::URL_SAFE_NO_PAD.encode_slice(digest, out).map_err(|_| "Output buffer too small".to_string())
+    }
+
+    /// HMAC of the contents under each of `keys`, hashed side by side on the multi-buffer engine
+    pub fn hmac_digest_many(&self, keys: &[&[u8]], out: &mut [[u8; HMAC_DIGEST_LEN]]) -> Result<(), String> {
+        if !self.is_valid.load(Ordering::SeqCst) || keys.iter().any(|key| key.is_empty()) {
             return Err("Invalid buffer or key".to_string());
         }
+        if out.len() < keys.len() {
+            return Err("Output buffer too small".to_string());
+        }
+        let _timer = op_metrics::timer(op_metrics::MetricOp::Hmac);
+
+        self.read_consistent(|contents| {
+            let jobs: Vec<sha256_batch::Sha256Job> = keys.iter()
+                .map(|key| sha256_batch::Sha256Job::chain([key, contents, &[]]))
+                .collect();
+            sha256_batch::digest_many(&jobs, out);
+        })
+    }
 
-        // Simple HMAC implementation using SHA-256
-        let mut hasher = Sha256::new();
-        hasher.update(key);
+    /// AES-256-GCM seal the contents into `output` as ciphertext || tag. The plaintext is
+    /// copied once into `output` and encrypted there. On any error `output` is wiped and
+    /// left empty, so staged plaintext never survives a failed seal.
+    pub fn encrypt_aes256_gcm_into(&self, key: &[u8], nonce: &[u8], output: &mut SecureBuffer) -> Result<(), String> {
+        let plaintext = self.as_slice()?;
+        let _timer = op_metrics::timer(op_metrics::MetricOp::Aead);
+        let mut seal = || {
+            let mut ctx = secure_aead::SecureAeadContext::new(key, nonce, secure_aead::AeadDirection::Encrypt)
+                .map_err(|e| e.to_string())?;
+            let sealed = output.staged(plaintext, secure_aead::AEAD_TAG_LEN)?;
+            let (body, tag) = sealed.split_at_mut(plaintext.len());
+            ctx.update_in_place(body).map_err(|e| e.to_string())?;
+            tag.copy_from_slice(&ctx.finalize().map_err(|e| e.to_string())?);
+            Ok(())
+        };
+        seal().inspect_err(|_| output.clear())
+    }
+
+    /// AES-256-GCM open ciphertext || tag from the contents into `output`. On a tag
+    /// mismatch `output` is wiped and left empty.
+    pub fn decrypt_aes256_gcm_into(&self, key: &[u8], nonce: &[u8], output: &mut SecureBuffer) -> Result<(), secure_aead::AeadError> {
+        let sealed = self.as_slice().map_err(|_| secure_aead::AeadError::TagMismatch)?;
+        if sealed.len() < secure_aead::AEAD_TAG_LEN {
+            return Err(secure_aead::AeadError::TagMismatch);
+        }
+        let (ciphertext, tag) = sealed.split_at(sealed.len() - secure_aead::AEAD_TAG_LEN);
+        let _timer = op_metrics::timer(op_metrics::MetricOp::Aead);
+        let mut ctx = secure_aead::SecureAeadContext::new(key, nonce, secure_aead::AeadDirection::Decrypt)?;
+        let body = output.staged(ciphertext, 0).map_err(|_| secure_aead::AeadError::LimitExceeded)?;
+        ctx.update_in_place(body)?;
+        ctx.verify(tag).inspect_err(|_| output.clear())
+    }
+
+    /// Current contents for in-place updates that keep the length
+    pub(crate) fn contents_mut(&mut self) -> &mut [u8] {
+        if !self.is_valid.load(Ordering::SeqCst) {
+            return &mut [];
+        }
+        self.begin_change(self.length);
+        unsafe { std::slice::from_raw_parts_mut(self.data, self.length) }
+    }
+
+    /// Seal the contents in place and append the tag; the capacity must leave room for it
+    pub fn encrypt_aes256_gcm_in_place(&mut self, key: &[u8], nonce: &[u8]) -> Result<(), String> {
+        if !self.is_valid.load(Ordering::SeqCst) || self.length + secure_aead::AEAD_TAG_LEN > self.capacity {
+            return Err("Buffer is invalid or has no room for the tag".to_string());
+        }
+        let _timer = op_metrics::timer(op_metrics::MetricOp::Aead);
+        let mut ctx = secure_aead::SecureAeadContext::new(key, nonce, secure_aead::AeadDirection::Encrypt)
+            .map_err(|e| e.to_string())?;
+        let changed = self.length + secure_aead::AEAD_TAG_LEN;
+        self.begin_change(changed);
+        let sealed = unsafe { std::slice::from_raw_parts_mut(self.data, changed) };
+        let (body, tag) = sealed.split_at_mut(self.length);
+        let result = ctx.update_in_place(body).and_then(|()| ctx.finalize()).map(|t| tag.copy_from_slice(&t));
+        if result.is_ok() {
+            self.length = changed;
+        }
+        self.key_epoch.fetch_add(1, Ordering::Release);
+        self.end_change(changed);
+        result.map_err(|e| e.to_string())
+    }
+
+    /// Open ciphertext || tag in place, leaving the plaintext; wiped on a tag mismatch
+    pub fn decrypt_aes256_gcm_in_place(&mut self, key: &[u8], nonce: &[u8]) -> Result<(), secure_aead::AeadError> {
+        if !self.is_valid.load(Ordering::SeqCst) || self.length < secure_aead::AEAD_TAG_LEN {
+            return Err(secure_aead::AeadError::TagMismatch);
+        }
+        let _timer = op_metrics::timer(op_metrics::MetricOp::Aead);
+        let mut ctx = secure_aead::SecureAeadContext::new(key, nonce, secure_aead::AeadDirection::Decrypt)?;
+        let (changed, body_len) = (self.length, self.length - secure_aead::AEAD_TAG_LEN);
+        self.begin_change(changed);
+        let sealed = unsafe { std::slice::from_raw_parts_mut(self.data, self.length) };
+        let (body, tag) = sealed.split_at_mut(body_len);
+        if let Err(e) = ctx.update_in_place(body) {
+            self.end_change(changed);
+            return Err(e);
+        }
+        let verified = ctx.verify(tag);
+        if verified.is_ok() {
+            tag.fill(0);
+            self.length = body_len;
+        }
+        self.key_epoch.fetch_add(1, Ordering::Release);
+        self.end_change(changed);
+        if verified.is_err() {
+            self.clear();
+        }
+        verified
+    }
+
+    /// Replace the contents with `data` plus `extra` zeroed bytes and return them for
+    /// in-place processing
+    pub(crate) fn staged(&mut self, data: &[u8], extra: usize) -> Result<&mut [u8], String> {
+        let len = data.len() + extra;
+        if !self.is_valid.load(Ordering::SeqCst) || len > self.capacity {
+            return Err("Output buffer too small".to_string());
+        }
+        // The caller finishes the contents, so they stay dirty until the next check
+        self.begin_change(self.length.max(len));
         unsafe {
-            hasher.update(std::slice::from_raw_parts(self.data, self.length));
+            memory::explicit_bzero(self.data, self.capacity);
+            std::ptr::copy_nonoverlapping(data.as_ptr(), self.data, data.len());
         }
-        let result = hasher.finalize();
-        Ok(general_purpose::URL_SAFE_NO_PAD.encode(result))
+        self.length = len;
+        self.key_epoch.fetch_add(1, Ordering::Release);
+        Ok(unsafe { std::slice::from_raw_parts_mut(self.data, len) })
     }
 
     /// Lock the buffer for exclusive access
@@ -449,27 +676,181 @@ pub fn unlock(&mut self) -> Result<(), String> {
         }
     }
 
-    /// Perform integrity check on buffer
+    /// Perform integrity check on buffer. With tamper detection on, this retags chunks
+    /// edited in place since the last check and compares the rest against their tags; under
+    /// `schedule_integrity_verification` the comparison is left to the background sweep.
     pub fn integrity_check(&self) -> bool {
-        self.is_valid.load(Ordering::SeqCst)
+        self.is_valid.load(Ordering::SeqCst) && self.integrity.as_ref().map_or(true, |i| i.check())
+    }
+
+    /// Verify `chunks_per_tick` 4 KiB chunks every `interval` on a shared background thread,
+    /// so a tampered chunk is found within `chunks / chunks_per_tick` ticks. A zero interval
+    /// cancels; tamper detection must be enabled first.
+    pub fn schedule_integrity_verification(&self, interval: std::time::Duration, chunks_per_tick: usize) -> Result<(), String> {
+        let integrity = self.integrity.as_ref().ok_or("Tamper detection is not enabled")?;
+        buffer_integrity::schedule(integrity, interval, chunks_per_tick);
+        Ok(())
+    }
+
+    /// Integrity bookkeeping ahead of an in-place change to `[0, end)`
+    fn begin_change(&self, end: usize) {
+        if let Some(integrity) = &self.integrity {
+            integrity.mark_dirty(0, end);
+        }
+    }
+
+    /// Retag `[0, end)` once an in-place change is complete
+    fn end_change(&self, end: usize) {
+        if let Some(integrity) = &self.integrity {
+            integrity.retag(end);
+        }
     }
 
     /// Securely zeroize buffer contents
     pub fn zeroize(&mut self) {
         if self.is_valid.load(Ordering::SeqCst) {
+            let changed = self.length;
+            self.begin_change(changed);
             unsafe {
                 memory::explicit_bzero(self.data, self.capacity);
             }
             self.length = 0;
+            self.key_epoch.fetch_add(1, Ordering::Release);
+            self.end_change(changed);
+        }
+    }
+
+    /// Replace the contents with fresh random bytes of the same length, invalidating
+    /// every `SecureHmacContext` derived from the old key. Safe to call while other
+    /// threads read through `read_consistent`.
+    pub fn rotate_key(&self) -> Result<(), String> {
+        use rand::RngCore;
+
+        if !self.is_valid.load(Ordering::SeqCst) || self.length == 0 {
+            return Err("Buffer is invalid or empty".to_string());
+        }
+        self.publish_with(|contents| rand::thread_rng().fill_bytes(contents));
+        Ok(())
+    }
+
+    /// Rewrite the contents in place as one seqlock write: readers that overlap it retry.
+    /// Concurrent writers are serialized; the length never changes here.
+    pub(crate) fn publish_with(&self, write: impl FnOnce(&mut [u8])) {
+        let mut seq = self.seq.load(Ordering::Relaxed);
+        loop {
+            if seq & 1 == 0 {
+                match self.seq.compare_exchange_weak(seq, seq + 1, Ordering::Acquire, Ordering::Relaxed) {
+                    Ok(_) => break,
+                    Err(current) => seq = current,
+                }
+            } else {
+                std::hint::spin_loop();
+                seq = self.seq.load(Ordering::Relaxed);
+            }
+        }
+        // Order the odd sequence before the data stores
+        fence(Ordering::Release);
+        self.begin_change(self.length);
+        write(unsafe { std::slice::from_raw_parts_mut(self.data, self.length) });
+        let epoch = self.key_epoch.fetch_add(1, Ordering::Release) + 1;
+        self.end_change(self.length);
+        self.seq.store(seq + 2, Ordering::Release);
+        audit_log::record(audit_log::AuditKind::KeyRotated, self.id, epoch, 0);
+    }
+
+    /// Take the advisory lock shared (`exclusive` false) or exclusive, spinning briefly and
+    /// then yielding. It guards nothing by itself: C callers wrap multi-call sequences in it.
+    pub fn acquire_access(&self, exclusive: bool) {
+        let mut spins = 0u32;
+        loop {
+            let current = self.access.load(Ordering::Relaxed);
+            let next = match (exclusive, current) {
+                (true, 0) => Some(ACCESS_WRITER),
+                (false, n) if n < ACCESS_WRITER - 1 => Some(n + 1),
+                _ => None,
+            };
+            if let Some(next) = next {
+                if self.access.compare_exchange_weak(current, next, Ordering::Acquire, Ordering::Relaxed).is_ok() {
+                    return;
+                }
+            } else if spins < 64 {
+                spins += 1;
+                std::hint::spin_loop();
+            } else {
+                std::thread::yield_now();
+            }
+        }
+    }
+
+    /// Drop one hold of the advisory lock; false if it was not held
+    pub fn release_access(&self) -> bool {
+        self.access
+            .fetch_update(Ordering::Release, Ordering::Relaxed, |current| match current {
+                0 => None,
+                ACCESS_WRITER => Some(0),
+                n => Some(n - 1),
+            })
+            .is_ok()
+    }
+
+    /// Run `f` over the contents without a lock or any shared write, so readers scale with
+    /// cores. If a `rotate_key` overlaps the read, `f`'s result is discarded and it runs
+    /// again on the new key: `f` must only compute from the bytes it is given.
+    pub fn read_consistent<T>(&self, mut f: impl FnMut(&[u8]) -> T) -> Result<T, String> {
+        loop {
+            let start = self.seq.load(Ordering::Acquire);
+            if start & 1 == 1 {
+                std::hint::spin_loop();
+                continue;
+            }
+            if !self.is_valid.load(Ordering::SeqCst) {
+                return Err("Buffer is not valid".to_string());
+            }
+            let result = f(unsafe { std::slice::from_raw_parts(self.data, self.length) });
+            // Order the data loads before the sequence re-check
+            fence(Ordering::Acquire);
+            if self.seq.load(Ordering::Relaxed) == start {
+                return Ok(result);
+            }
+        }
+    }
+
+    /// Copy the contents into `out` under `read_consistent`, returning the length
+    pub fn read_consistent_into(&self, out: &mut [u8]) -> Result<usize, String> {
+        if out.len() < self.len() {
+            return Err("Output buffer too small".to_string());
+        }
+        self.read_consistent(|contents| {
+            out[..contents.len()].copy_from_slice(contents);
+            contents.len()
+        })
+    }
+
+    /// HMAC-SHA256 of `message` keyed with the contents (RFC 2104), computed under
+    /// `read_consistent` so a signer never sees half of a rotated key
+    pub fn sign_hmac_sha256(&self, message: &[u8]) -> Result<[u8; HMAC_DIGEST_LEN], String> {
+        if self.is_empty() {
+            return Err("Buffer is invalid or empty".to_string());
         }
+        let _timer = op_metrics::timer(op_metrics::MetricOp::Hmac);
+        self.read_consistent(|key| secure_hmac::hmac_sha256(key, message))
+    }
+
+    /// Content generation counter that derived key state checks against
+    pub(crate) fn key_epoch(&self) -> &Arc<AtomicU64> {
+        &self.key_epoch
     }
 
     /// Safely destroy the buffer, ensuring all data is zeroed
     pub fn destroy(&mut self) {
         // Mark as invalid first to prevent concurrent access
         self.is_valid.store(false, Ordering::SeqCst);
+        if let Some(integrity) = self.integrity.take() {
+            integrity.detach();
+        }
         
         if !self.data.is_null() {
+            audit_log::record(audit_log::AuditKind::BufferDestroyed, self.id, self.capacity as u64, 0);
             unsafe {
                 // Multiple-pass zeroization for extra security
                 memory::explicit_bzero(self.data, self.capacity);
@@ -484,11 +865,15 @@ pub fn destroy(&mut self) {
                 let layout = Layout::from_size_align_unchecked(self.capacity, 32);
                 dealloc(self.data, layout);
             }
+            op_metrics::add(op_metrics::Counter::Deallocations, 1);
+            op_metrics::add(op_metrics::Counter::BytesDeallocated, self.capacity as u64);
+            BUFFER_COUNTERS.active.fetch_sub(1, Ordering::Relaxed);
             
             // Clear pointers and sizes
             self.data = std::ptr::null_mut();
             self.capacity = 0;
             self.length = 0;
+            self.key_epoch.fetch_add(1, Ordering::Release);
         }
     }
 }
@@ -688,6 +1073,8 @@ pub enum UniversalBloomFilterError {
         tweak,
         flags,
         max_age_seconds,
+        generations: 1,
+        storage: 0,
         batch_size,
         enable_compression: false,
         enable_metrics: true,
@@ -742,8 +1129,7 @@ pub enum UniversalBloomFilterError {
     let filter_ref = unsafe { &*(filter as *const UniversalBloomFilter) };
     let txid_slice = unsafe { std::slice::from_raw_parts(txid_bytes, 32) };
 
-    let txid = TransactionId::from_bytes(txid_slice).unwrap_or_else(|| TransactionId::new("bitcoin", txid_slice));
-    match filter_ref.insert_utxo(&txid, vout) {
+    match filter_ref.insert_outpoint(txid_slice, vout) {
         Ok(_) => UniversalBloomFilterError::Success as c_int,
         Err(_) => UniversalBloomFilterError::InvalidInput as c_int,
     }
@@ -804,8 +1190,7 @@ pub enum UniversalBloomFilterError {
     let filter_ref = unsafe { &*(filter as *const UniversalBloomFilter) };
     let txid_slice = unsafe { std::slice::from_raw_parts(txid_bytes, 32) };
 
-    let txid = TransactionId::from_bytes(txid_slice).unwrap_or_else(|| TransactionId::new("bitcoin", txid_slice));
-    match filter_ref.contains_utxo(&txid, vout) {
+    match filter_ref.contains_outpoint(txid_slice, vout) {
         Ok(true) => 1, // Found
         Ok(false) => 0, // Not found
         Err(_) => UniversalBloomFilterError::InvalidInput as c_int,
@@ -834,25 +1219,9 @@ pub enum UniversalBloomFilterError {
     let vouts_slice = unsafe { std::slice::from_raw_parts(vouts, count) };
     let results_slice = unsafe { std::slice::from_raw_parts_mut(results, count) };
 
-    let mut batch = Vec::with_capacity(count);
-    for (i, &vout) in vouts_slice.iter().enumerate().take(count) {
-        let txid_start = i * 32;
-        let txid_end = txid_start + 32;
-        if txid_end > txids_slice.len() {
-            return UniversalBloomFilterError::InvalidSize as c_int;
-        }
-
-        let txid = TransactionId::from_bytes(&txids_slice[txid_start..txid_end]).unwrap_or_else(|| TransactionId::new("bitcoin", &txids_slice[txid_start..txid_end]));
-        batch.push((txid, vout));
-    }
-
-    match filter_ref.contains_batch(&batch) {
-        Ok(batch_results) => {
-            for (i, &result) in batch_results.iter().enumerate() {
-                results_slice[i] = result;
-            }
-            UniversalBloomFilterError::Success as c_int
-        },
+    // Hash, prefetch and test straight from the caller's flat arrays
+    match filter_ref.contains_outpoints(txids_slice, vouts_slice, results_slice) {
+        Ok(()) => UniversalBloomFilterError::Success as c_int,
         Err(_) => UniversalBloomFilterError::InvalidInput as c_int,
     }
 }
@@ -874,43 +1243,8 @@ pub enum UniversalBloomFilterError {
     let filter_ref = unsafe { &*(filter as *const UniversalBloomFilter) };
     let block_slice = unsafe { std::slice::from_raw_parts(block_data, block_size) };
 
-    // For now, create a simple BlockData from raw bytes
-    // In a full implementation, this would parse the block format
-    let mut transactions = Vec::new();
-
-    // Simple parsing: assume each transaction is 32 bytes (txid) + 4 bytes (vout count) + (vout count * 8 bytes for outputs)
-    let mut offset = 0;
-    while offset + 36 <= block_size {
-        let txid_bytes = &block_slice[offset..offset + 32];
-        let txid = TransactionId::from_bytes(txid_bytes).unwrap_or_else(|| TransactionId::new("bitcoin", txid_bytes));
-        offset += 32;
-
-        let vout_count = u32::from_le_bytes(block_slice[offset..offset + 4].try_into().unwrap_or([0; 4]));
-        offset += 4;
-
-        let mut outputs = Vec::new();
-        for _ in 0..vout_count {
-            if offset + 8 <= block_size {
-                outputs.push(block_slice[offset..offset + 8].to_vec());
-                offset += 8;
-            }
-        }
-
-        transactions.push(TransactionId {
-            network: "bitcoin".to_string(),
-            hash: txid.as_bytes().to_vec(),
-        });
-    }
-
-    let block_data_struct = BlockData {
-        network: "bitcoin".to_string(),
-        height: 0, // Unknown height
-        hash: block_slice[0..32].to_vec(), // Use first 32 bytes as block hash
-        transactions,
-        timestamp: SystemTime::now().duration_since(UNIX_EPOCH).unwrap_or_default().as_secs(),
-    };
-
-    match filter_ref.load_block(&block_data_struct) {
+    // Parse the wire-format block in place and insert every created outpoint
+    match filter_ref.load_raw_block(block_slice) {
         Ok(_) => UniversalBloomFilterError::Success as c_int,
         Err(_) => UniversalBloomFilterError::InvalidInput as c_int,
     }
@@ -1022,6 +1356,24 @@ pub enum UniversalBloomFilterError {
     0 // Success
 }
 
+/// Fill `len` bytes from the calling thread's entropy reservoir - Direct FFI export
+#[no_mangle]
+/// # Safety
+///
+/// `output` must be valid for `len` writable bytes (or null with `len` 0).
+pub unsafe extern "C" fn securebuffer_fill_entropy(output: *mut u8, len: usize) -> c_int {
+    if len == 0 {
+        return SECUREBUFFER_SUCCESS;
+    }
+    if output.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    match entropy_reservoir::fill_entropy(std::slice::from_raw_parts_mut(output, len)) {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(_) => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    }
+}
+
 /// Generate hybrid entropy with Bitcoin headers (32 bytes) - Direct FFI export
 #[no_mangle]
 /// # Safety
@@ -1215,369 +1567,2823 @@ pub extern "C" fn get_cpu_temperature_c() -> f32 {
 #[allow(dead_code)]
 pub struct BloomFilterHandle(*mut bloom_filter::UniversalBloomFilter);
 
+/// C-compatible configuration, mirrors `BloomConfig` in bloom_filter.h
+#[repr(C)]
+pub struct CBloomConfig {
+    pub network: *const c_char,
+    pub size: u64,
+    pub num_hashes: u8,
+    pub tweak: u32,
+    pub flags: u8,
+    pub max_age_seconds: u64,
+    pub batch_size: u64,
+    pub enable_compression: bool,
+    pub enable_metrics: bool,
+    pub generations: u8,
+    pub storage: u8,
+}
+
+/// Error codes for the generic bloom filter API, mirrors `BloomFilterErrorCode` in bloom_filter.h
+#[repr(C)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum BloomFilterErrorCode {
+    Ok = 0,
+    InvalidConfig = 1,
+    InvalidInput = 2,
+    HashError = 3,
+    Memory = 4,
+    Concurrency = 5,
+    Io = 6,
+}
+
+impl From<&bloom_filter::BloomFilterError> for BloomFilterErrorCode {
+    fn from(err: &bloom_filter::BloomFilterError) -> Self {
+        use bloom_filter::BloomFilterError as E;
+        match err {
+            E::InvalidConfiguration(_) => BloomFilterErrorCode::InvalidConfig,
+            E::InvalidInput(_) | E::SystemTimeError => BloomFilterErrorCode::InvalidInput,
+            E::HashComputationError => BloomFilterErrorCode::HashError,
+            E::MemoryError => BloomFilterErrorCode::Memory,
+            E::ConcurrencyError => BloomFilterErrorCode::Concurrency,
+            E::SnapshotError(_) => BloomFilterErrorCode::Io,
+        }
+    }
+}
+
+/// Translate a C `BloomConfig` into the Rust configuration
+unsafe fn config_from_c(c_config: &CBloomConfig) -> BloomConfig {
+    let network_str = if c_config.network.is_null() {
+        "bitcoin"
+    } else {
+        CStr::from_ptr(c_config.network).to_str().unwrap_or("bitcoin")
+    };
+    let mut config = BloomConfig::for_network(NetworkConfig::by_name(network_str));
+    config.size = c_config.size as usize;
+    config.num_hashes = c_config.num_hashes;
+    config.tweak = c_config.tweak;
+    config.flags = c_config.flags;
+    config.max_age_seconds = c_config.max_age_seconds;
+    if c_config.batch_size > 0 {
+        config.batch_size = c_config.batch_size as usize;
+    }
+    config.enable_compression = c_config.enable_compression;
+    config.enable_metrics = c_config.enable_metrics;
+    config.generations = c_config.generations;
+    config.storage = c_config.storage;
+    config
+}
+
 /// C FFI: Create new bloom filter
 #[no_mangle]
 /// # Safety
 ///
-/// `size` and `num_hashes` must be reasonable values. The returned pointer is
-/// owned by the caller and must be freed with `bloom_filter_free` to avoid leaks.
-pub unsafe extern "C" fn bloom_filter_new(size: usize, num_hashes: usize) -> *mut c_void {
-    let network = bloom_filter::NetworkConfig::bitcoin();
-    let mut config = bloom_filter::BloomConfig::for_network(network);
-    config.size = size;
-    config.num_hashes = num_hashes as u8; // Convert usize to u8
-    
+/// `config` must point to a valid `BloomConfig`; its `network` field (if non-null) must be a
+/// NUL-terminated C string. `err` may be null, otherwise it must be writable. The returned
+/// pointer is owned by the caller and must be freed with `bloom_filter_free` to avoid leaks.
+pub unsafe extern "C" fn bloom_filter_new(config: *const CBloomConfig, err: *mut BloomFilterErrorCode) -> *mut c_void {
+    let set_err = |code: BloomFilterErrorCode| {
+        if !err.is_null() {
+            *err = code;
+        }
+    };
+
+    if config.is_null() {
+        set_err(BloomFilterErrorCode::InvalidConfig);
+        return std::ptr::null_mut();
+    }
+    let config = config_from_c(&*config);
+
     match bloom_filter::UniversalBloomFilter::new(Some(config)) {
-        Ok(filter) => Box::into_raw(Box::new(filter)) as *mut c_void,
-        Err(_) => std::ptr::null_mut(),
+        Ok(filter) => {
+            set_err(BloomFilterErrorCode::Ok);
+            Box::into_raw(Box::new(filter)) as *mut c_void
+        }
+        Err(e) => {
+            set_err(BloomFilterErrorCode::from(&e));
+            std::ptr::null_mut()
+        }
     }
 }
 
-/// C FFI: Insert data into bloom filter
+/// C FFI: Insert data into bloom filter, returns true on success
 #[no_mangle]
 /// # Safety
 ///
 /// `filter` must be a pointer returned by `bloom_filter_new`. `data` must point
 /// to `len` readable bytes. The function will read from `data`.
-pub unsafe extern "C" fn bloom_filter_insert(filter: *mut c_void, data: *const u8, len: usize) -> c_int {
+pub unsafe extern "C" fn bloom_filter_insert(filter: *mut c_void, data: *const u8, len: usize) -> bool {
     if filter.is_null() || data.is_null() || len == 0 {
-        return -1;
-    }
-    
-    let filter = &*(filter as *mut bloom_filter::UniversalBloomFilter);
-    let slice = std::slice::from_raw_parts(data, len);
-    
-    match filter.insert_data(slice) {
-        Ok(_) => 0,
-        Err(_) => -1,
+        return false;
     }
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.insert_data(std::slice::from_raw_parts(data, len)).is_ok()
 }
 
-/// C FFI: Check if data exists in bloom filter
+/// C FFI: Insert `count` keys packed back to back, `stride` bytes each
 #[no_mangle]
 /// # Safety
 ///
-/// `filter` must be a pointer returned by `bloom_filter_new`. `data` must point
-/// to `len` readable bytes.
-pub unsafe extern "C" fn bloom_filter_contains(filter: *mut c_void, data: *const u8, len: usize) -> c_int {
-    if filter.is_null() || data.is_null() || len == 0 {
-        return -1;
-    }
-    
-    let filter = &*(filter as *mut bloom_filter::UniversalBloomFilter);
-    let slice = std::slice::from_raw_parts(data, len);
-    
-    match filter.contains_data(slice) {
-        Ok(result) => if result { 1 } else { 0 },
-        Err(_) => -1,
+/// `filter` must be a pointer returned by `bloom_filter_new`. `keys` must point to
+/// `count * stride` readable bytes.
+pub unsafe extern "C" fn bloom_filter_insert_batch(filter: *mut c_void, keys: *const u8, stride: usize, count: usize) -> bool {
+    if filter.is_null() || keys.is_null() || count == 0 {
+        return false;
     }
+
+    let Some(len) = count.checked_mul(stride).filter(|&len| len <= isize::MAX as usize) else {
+        return false;
+    };
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    let keys = std::slice::from_raw_parts(keys, len);
+    filter.insert_packed(keys, stride).is_ok()
 }
 
-/// C FFI: Get item count in bloom filter
+/// Borrow the `count + 1` offsets and `offsets[count]` key bytes of an offsets batch, or
+/// `None` when either length overflows or exceeds what a slice may span
+unsafe fn offset_batch<'a>(keys: *const u8, offsets: *const u64, count: usize) -> Option<(&'a [u8], &'a [u64])> {
+    let entries = count.checked_add(1).filter(|&n| n <= isize::MAX as usize / 8)?;
+    let offsets = std::slice::from_raw_parts(offsets, entries);
+    let len = usize::try_from(offsets[count]).ok().filter(|&len| len <= isize::MAX as usize)?;
+    Some((std::slice::from_raw_parts(keys, len), offsets))
+}
+
+/// C FFI: Insert `count` variable-width keys, key `i` at `keys[offsets[i]..offsets[i + 1]]`
 #[no_mangle]
 /// # Safety
 ///
-/// `filter` must be a pointer returned by `bloom_filter_new`.
-pub unsafe extern "C" fn bloom_filter_count(filter: *mut c_void) -> usize {
-    if filter.is_null() {
-        return 0;
+/// `offsets` must hold `count + 1` entries and `keys` at least `offsets[count]` bytes.
+pub unsafe extern "C" fn bloom_filter_insert_batch_offsets(filter: *mut c_void, keys: *const u8, offsets: *const u64, count: usize) -> bool {
+    if filter.is_null() || keys.is_null() || offsets.is_null() || count == 0 {
+        return false;
     }
-    
-    let filter = &*(filter as *mut bloom_filter::UniversalBloomFilter);
-    filter.get_item_count()
+
+    let Some((keys, offsets)) = offset_batch(keys, offsets, count) else {
+        return false;
+    };
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.insert_offsets(keys, offsets).is_ok()
 }
 
-/// C FFI: Get false positive rate
+/// C FFI: Test `count` packed keys into `bitmap` (bit i of byte i / 8), returns the hit
+/// count or -1 on invalid input
 #[no_mangle]
 /// # Safety
 ///
-/// `filter` must be a pointer returned by `bloom_filter_new`.
-pub unsafe extern "C" fn bloom_filter_false_positive_rate(filter: *mut c_void) -> f64 {
-    if filter.is_null() {
-        return 1.0;
+/// `keys` must point to `count * stride` readable bytes and `bitmap` to `(count + 7) / 8`
+/// writable bytes.
+pub unsafe extern "C" fn bloom_filter_contains_batch(filter: *const c_void, keys: *const u8, stride: usize, count: usize, bitmap: *mut u8) -> i64 {
+    if filter.is_null() || keys.is_null() || bitmap.is_null() {
+        return -1;
     }
-    
-    let filter = &*(filter as *mut bloom_filter::UniversalBloomFilter);
-    filter.get_false_positive_count()
+
+    let Some(len) = count.checked_mul(stride).filter(|&len| len <= isize::MAX as usize) else {
+        return -1;
+    };
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    let keys = std::slice::from_raw_parts(keys, len);
+    let bitmap = std::slice::from_raw_parts_mut(bitmap, count.div_ceil(8));
+    filter.contains_packed(keys, stride, bitmap).map_or(-1, |hits| hits as i64)
 }
 
-/// C FFI: Free bloom filter
+/// C FFI: Test `count` variable-width keys into `bitmap`, returns the hit count or -1
 #[no_mangle]
 /// # Safety
 ///
-/// `filter` must be a pointer previously returned by `bloom_filter_new`. After
-/// this call the pointer must not be used.
-pub unsafe extern "C" fn bloom_filter_free(filter: *mut c_void) {
-    if !filter.is_null() {
-        let _ = Box::from_raw(filter as *mut bloom_filter::UniversalBloomFilter);
+/// `offsets` must hold `count + 1` entries, `keys` at least `offsets[count]` bytes and
+/// `bitmap` `(count + 7) / 8` writable bytes.
+pub unsafe extern "C" fn bloom_filter_contains_batch_offsets(
+    filter: *const c_void,
+    keys: *const u8,
+    offsets: *const u64,
+    count: usize,
+    bitmap: *mut u8,
+) -> i64 {
+    if filter.is_null() || keys.is_null() || offsets.is_null() || bitmap.is_null() {
+        return -1;
     }
-}
 
-// ============================================================================
-// SECUREBUFFER C FFI EXPORTS
-// ============================================================================
+    let Some((keys, offsets)) = offset_batch(keys, offsets, count) else {
+        return -1;
+    };
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    let bitmap = std::slice::from_raw_parts_mut(bitmap, count.div_ceil(8));
+    filter.contains_offsets(keys, offsets, bitmap).map_or(-1, |hits| hits as i64)
+}
 
-/// C FFI: Create new secure buffer with security level
+/// C FFI: Remove data from a counting filter, returns true if it was present
 #[no_mangle]
 /// # Safety
 ///
-/// `capacity` must be a reasonable positive value. The returned pointer is
-/// owned by the caller and must be freed with `secure_buffer_free` or equivalent.
-pub unsafe extern "C" fn securebuffer_new_with_security_level(capacity: usize, security_level: c_int) -> *mut c_void {
-    match SecureBuffer::new(capacity) {
-        Ok(mut buffer) => {
-            if security_level > 0 {
-                let _ = buffer.enable_hardware_protection();
-            }
-            Box::into_raw(Box::new(buffer)) as *mut c_void
-        },
-        Err(_) => std::ptr::null_mut(),
+/// `filter` must be a pointer returned by `bloom_filter_new`. `data` must point
+/// to `len` readable bytes.
+pub unsafe extern "C" fn bloom_filter_remove(filter: *mut c_void, data: *const u8, len: usize) -> bool {
+    if filter.is_null() || data.is_null() || len == 0 {
+        return false;
     }
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.remove(std::slice::from_raw_parts(data, len)).unwrap_or(false)
 }
 
-/// C FFI: Enable audit logging
+/// C FFI: Insert data and report whether it was already present: 1 seen, 0 new, -1 error
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-pub unsafe extern "C" fn securebuffer_enable_audit_logging(buffer: *mut c_void) -> c_int {
-    if buffer.is_null() {
+/// `filter` must be a pointer returned by `bloom_filter_new`. `data` must point
+/// to `len` readable bytes.
+pub unsafe extern "C" fn bloom_filter_test_and_insert(filter: *mut c_void, data: *const u8, len: usize) -> i32 {
+    if filter.is_null() || data.is_null() || len == 0 {
         return -1;
     }
-    let buffer = &mut *(buffer as *mut SecureBuffer);
-    match buffer.enable_audit_logging() {
-        Ok(_) => 0,
-        Err(_) => -1,
-    }
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.test_and_insert(std::slice::from_raw_parts(data, len)).map_or(-1, |seen| seen as i32)
 }
 
-/// C FFI: Disable audit logging
+/// C FFI: Load a wire-format block, inserting every outpoint it creates (and removing the
+/// ones it spends under `BLOOM_FLAG_REMOVE_SPENT`). Returns the outpoints inserted, or -1.
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-pub unsafe extern "C" fn securebuffer_disable_audit_logging(buffer: *mut c_void) -> c_int {
-    if buffer.is_null() {
+/// `filter` must be a pointer returned by `bloom_filter_new`. `block` must point to `len`
+/// readable bytes.
+pub unsafe extern "C" fn bloom_filter_load_block(filter: *mut c_void, block: *const u8, len: usize) -> i64 {
+    if filter.is_null() || block.is_null() || len == 0 {
         return -1;
     }
-    let buffer = &mut *(buffer as *mut SecureBuffer);
-    buffer.disable_audit_logging();
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.load_raw_block(std::slice::from_raw_parts(block, len)).map_or(-1, |inserted| inserted as i64)
+}
+
+/// C FFI: Create a buffered writer for one ingest thread; free with `bloom_writer_free`
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new` and must outlive the writer.
+pub unsafe extern "C" fn bloom_filter_writer_new(filter: *mut c_void) -> *mut c_void {
+    if filter.is_null() {
+        return std::ptr::null_mut();
+    }
+
+    let filter: &'static bloom_filter::UniversalBloomFilter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    Box::into_raw(Box::new(filter.writer())) as *mut c_void
+}
+
+/// C FFI: Buffer data for insertion, returns true on success
+#[no_mangle]
+/// # Safety
+///
+/// `writer` must be a pointer returned by `bloom_filter_writer_new`, used by one thread
+/// at a time. `data` must point to `len` readable bytes.
+pub unsafe extern "C" fn bloom_writer_insert(writer: *mut c_void, data: *const u8, len: usize) -> bool {
+    if writer.is_null() || data.is_null() || len == 0 {
+        return false;
+    }
+
+    let writer = &mut *(writer as *mut bloom_filter::BloomWriter<'static>);
+    writer.insert(std::slice::from_raw_parts(data, len)).is_ok()
+}
+
+/// C FFI: Make every buffered key visible to lookups
+#[no_mangle]
+/// # Safety
+///
+/// `writer` must be a pointer returned by `bloom_filter_writer_new`.
+pub unsafe extern "C" fn bloom_writer_flush(writer: *mut c_void) {
+    if writer.is_null() {
+        return;
+    }
+
+    let writer = &mut *(writer as *mut bloom_filter::BloomWriter<'static>);
+    writer.flush();
+}
+
+/// C FFI: Flush and destroy a writer
+#[no_mangle]
+/// # Safety
+///
+/// `writer` must be a pointer returned by `bloom_filter_writer_new`, freed once.
+pub unsafe extern "C" fn bloom_writer_free(writer: *mut c_void) {
+    if !writer.is_null() {
+        drop(Box::from_raw(writer as *mut bloom_filter::BloomWriter<'static>));
+    }
+}
+
+/// C FFI: Check if data may exist in bloom filter (false on invalid input)
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new`. `data` must point
+/// to `len` readable bytes.
+pub unsafe extern "C" fn bloom_filter_contains(filter: *const c_void, data: *const u8, len: usize) -> bool {
+    if filter.is_null() || data.is_null() || len == 0 {
+        return false;
+    }
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.contains_data(std::slice::from_raw_parts(data, len)).unwrap_or(false)
+}
+
+/// C FFI: Get item count in bloom filter
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new`.
+pub unsafe extern "C" fn bloom_filter_count(filter: *mut c_void) -> usize {
+    if filter.is_null() {
+        return 0;
+    }
+    
+    let filter = &*(filter as *mut bloom_filter::UniversalBloomFilter);
+    filter.get_item_count()
+}
+
+/// C FFI: Get false positive rate
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new`.
+pub unsafe extern "C" fn bloom_filter_false_positive_rate(filter: *mut c_void) -> f64 {
+    if filter.is_null() {
+        return 1.0;
+    }
+    
+    let filter = &*(filter as *mut bloom_filter::UniversalBloomFilter);
+    // Theoretical rate for the configured layout (classic or cache-blocked)
+    filter.false_positive_rate()
+}
+
+/// C FFI: Expire the oldest generation, returns the number of items that aged out
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new`.
+pub unsafe extern "C" fn bloom_filter_rotate(filter: *mut c_void) -> u64 {
+    if filter.is_null() {
+        return 0;
+    }
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.rotate()
+}
+
+/// C FFI: Write a snapshot of the filter to `path`
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new` or `bloom_filter_open_mmap`,
+/// and `path` a valid NUL-terminated string.
+pub unsafe extern "C" fn bloom_filter_save(filter: *const c_void, path: *const c_char) -> BloomFilterErrorCode {
+    if filter.is_null() || path.is_null() {
+        return BloomFilterErrorCode::InvalidInput;
+    }
+    let path = match CStr::from_ptr(path).to_str() {
+        Ok(path) => std::path::Path::new(path),
+        Err(_) => return BloomFilterErrorCode::InvalidInput,
+    };
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    match filter.save(path) {
+        Ok(()) => BloomFilterErrorCode::Ok,
+        Err(e) => BloomFilterErrorCode::from(&e),
+    }
+}
+
+/// C FFI: Map a snapshot written by `bloom_filter_save`; free with `bloom_filter_free`
+#[no_mangle]
+/// # Safety
+///
+/// `path` must be a valid NUL-terminated string. `err` may be null.
+pub unsafe extern "C" fn bloom_filter_open_mmap(path: *const c_char, verify_data: bool, err: *mut BloomFilterErrorCode) -> *mut c_void {
+    let set_err = |code: BloomFilterErrorCode| {
+        if !err.is_null() {
+            *err = code;
+        }
+    };
+
+    let path = match (!path.is_null()).then(|| CStr::from_ptr(path).to_str()) {
+        Some(Ok(path)) => std::path::Path::new(path),
+        _ => {
+            set_err(BloomFilterErrorCode::InvalidInput);
+            return std::ptr::null_mut();
+        }
+    };
+
+    match bloom_filter::UniversalBloomFilter::open_mmap(path, verify_data) {
+        Ok(filter) => {
+            set_err(BloomFilterErrorCode::Ok);
+            Box::into_raw(Box::new(filter)) as *mut c_void
+        }
+        Err(e) => {
+            set_err(BloomFilterErrorCode::from(&e));
+            std::ptr::null_mut()
+        }
+    }
+}
+
+/// C FFI: Height of the newest block covered by the filter
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new` or `bloom_filter_open_mmap`.
+pub unsafe extern "C" fn bloom_filter_chain_tip(filter: *const c_void) -> u64 {
+    if filter.is_null() {
+        return 0;
+    }
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.chain_tip()
+}
+
+/// C FFI: Record the newest block height covered by the filter
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new` or `bloom_filter_open_mmap`.
+pub unsafe extern "C" fn bloom_filter_set_chain_tip(filter: *mut c_void, height: u64) {
+    if filter.is_null() {
+        return;
+    }
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.set_chain_tip(height);
+}
+
+/// C FFI: Bytes reserved for the filter's bit array
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new`.
+pub unsafe extern "C" fn bloom_filter_memory_usage(filter: *const c_void) -> u64 {
+    if filter.is_null() {
+        return 0;
+    }
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.memory_usage() as u64
+}
+
+/// C FFI: Fault in the whole bit array now (each NUMA replica from its own node) instead of
+/// on first lookup; false for a null filter
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new`.
+pub unsafe extern "C" fn bloom_filter_prefault(filter: *const c_void) -> bool {
+    if filter.is_null() {
+        return false;
+    }
+
+    let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+    filter.prefault();
+    true
+}
+
+/// C FFI: Fill `config.size` and `config.num_hashes` for a target item count and FP rate,
+/// taking the layout from `config.flags`. Other fields are left untouched.
+#[no_mangle]
+/// # Safety
+///
+/// `config` must be a valid writable pointer.
+pub unsafe extern "C" fn bloom_filter_config_for_capacity(expected_items: u64, fp_rate: f64, config: *mut CBloomConfig) -> bool {
+    if config.is_null() {
+        return false;
+    }
+    let c_config = &mut *config;
+
+    let mut sizing = BloomConfig::for_network(NetworkConfig::bitcoin());
+    sizing.flags = c_config.flags;
+    if sizing.fit_capacity(expected_items, fp_rate).is_err() {
+        return false;
+    }
+
+    c_config.size = sizing.size as u64;
+    c_config.num_hashes = sizing.num_hashes;
+    true
+}
+
+/// C FFI: Clear all bits, generations and counters
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer returned by `bloom_filter_new`.
+pub unsafe extern "C" fn bloom_filter_reset(filter: *mut c_void) {
+    if !filter.is_null() {
+        let filter = &*(filter as *const bloom_filter::UniversalBloomFilter);
+        filter.reset();
+    }
+}
+
+/// C FFI: Free bloom filter
+#[no_mangle]
+/// # Safety
+///
+/// `filter` must be a pointer previously returned by `bloom_filter_new`. After
+/// this call the pointer must not be used.
+pub unsafe extern "C" fn bloom_filter_free(filter: *mut c_void) {
+    if !filter.is_null() {
+        let _ = Box::from_raw(filter as *mut bloom_filter::UniversalBloomFilter);
+    }
+}
+
+/// Per-network statistics for the registry API, mirrors `BloomNetworkStats` in bloom_filter.h
+#[repr(C)]
+pub struct CBloomNetworkStats {
+    pub transactions_processed: u64,
+    pub blocks_processed: u64,
+    pub queries_per_second: u64,
+    pub average_query_time_ns: u64,
+    pub false_positive_rate: f64,
+    pub memory_usage_bytes: u64,
+    pub last_updated: u64,
+}
+
+/// C FFI: Create an empty multi-network registry
+#[no_mangle]
+pub extern "C" fn bloom_registry_new() -> *mut c_void {
+    Box::into_raw(Box::new(bloom_registry::BloomRegistry::new())) as *mut c_void
+}
+
+/// C FFI: Register a network filter, returns its tag or -1 on error
+#[no_mangle]
+/// # Safety
+///
+/// `registry` must be a pointer returned by `bloom_registry_new` that no other thread is
+/// using yet. `config` must point to a valid `BloomConfig`. `err` may be null.
+pub unsafe extern "C" fn bloom_registry_add(
+    registry: *mut c_void,
+    config: *const CBloomConfig,
+    key_width: u32,
+    err: *mut BloomFilterErrorCode,
+) -> i32 {
+    let set_err = |code: BloomFilterErrorCode| {
+        if !err.is_null() {
+            *err = code;
+        }
+    };
+
+    if registry.is_null() || config.is_null() {
+        set_err(BloomFilterErrorCode::InvalidConfig);
+        return -1;
+    }
+    let registry = &mut *(registry as *mut bloom_registry::BloomRegistry);
+    let width = if key_width == 0 { None } else { Some(key_width as usize) };
+
+    match registry.add(config_from_c(&*config), width) {
+        Ok(tag) => {
+            set_err(BloomFilterErrorCode::Ok);
+            tag as i32
+        }
+        Err(e) => {
+            set_err(BloomFilterErrorCode::from(&e));
+            -1
+        }
+    }
+}
+
+/// C FFI: Tag of a registered network, or -1 if unknown
+#[no_mangle]
+/// # Safety
+///
+/// `registry` must be a pointer returned by `bloom_registry_new`; `name` a NUL-terminated string.
+pub unsafe extern "C" fn bloom_registry_network_id(registry: *const c_void, name: *const c_char) -> i32 {
+    if registry.is_null() || name.is_null() {
+        return -1;
+    }
+
+    let registry = &*(registry as *const bloom_registry::BloomRegistry);
+    match CStr::from_ptr(name).to_str() {
+        Ok(name) => registry.network_id(name).map_or(-1, |tag| tag as i32),
+        Err(_) => -1,
+    }
+}
+
+/// C FFI: Insert `count` tagged keys, returns false (inserting nothing) on a bad tag or width
+#[no_mangle]
+/// # Safety
+///
+/// `tags` must hold `count` entries and `offsets` `count + 1`; `keys` must hold
+/// `offsets[count]` bytes.
+pub unsafe extern "C" fn bloom_registry_insert_batch(
+    registry: *const c_void,
+    tags: *const u16,
+    keys: *const u8,
+    offsets: *const u64,
+    count: usize,
+) -> bool {
+    if registry.is_null() || tags.is_null() || keys.is_null() || offsets.is_null() {
+        return false;
+    }
+
+    // `offset_batch` caps `count` below `isize::MAX / 8`, which also bounds the tag slice
+    let Some((keys, offsets)) = offset_batch(keys, offsets, count) else {
+        return false;
+    };
+    let registry = &*(registry as *const bloom_registry::BloomRegistry);
+    registry.insert_batch(std::slice::from_raw_parts(tags, count), keys, offsets).is_ok()
+}
+
+/// C FFI: Look up `count` tagged keys into `results`
+#[no_mangle]
+/// # Safety
+///
+/// As for `bloom_registry_insert_batch`; `results` must hold `count` writable entries.
+pub unsafe extern "C" fn bloom_registry_contains_batch(
+    registry: *const c_void,
+    tags: *const u16,
+    keys: *const u8,
+    offsets: *const u64,
+    count: usize,
+    results: *mut bool,
+) -> bool {
+    if registry.is_null() || tags.is_null() || keys.is_null() || offsets.is_null() || results.is_null() {
+        return false;
+    }
+
+    // `offset_batch` caps `count` below `isize::MAX / 8`, which also bounds tags and results
+    let Some((keys, offsets)) = offset_batch(keys, offsets, count) else {
+        return false;
+    };
+    let registry = &*(registry as *const bloom_registry::BloomRegistry);
+    let results = std::slice::from_raw_parts_mut(results, count);
+    registry.contains_batch(std::slice::from_raw_parts(tags, count), keys, offsets, results).is_ok()
+}
+
+/// C FFI: Load a wire-format block into one network's filter
+#[no_mangle]
+/// # Safety
+///
+/// `registry` must be a pointer returned by `bloom_registry_new`; `block` must hold `len` bytes.
+pub unsafe extern "C" fn bloom_registry_load_block(registry: *const c_void, network: u16, block: *const u8, len: usize) -> bool {
+    if registry.is_null() || block.is_null() {
+        return false;
+    }
+
+    let registry = &*(registry as *const bloom_registry::BloomRegistry);
+    registry.load_raw_block(network, std::slice::from_raw_parts(block, len)).is_ok()
+}
+
+/// C FFI: Network statistics; rates cover the window since the previous call
+#[no_mangle]
+/// # Safety
+///
+/// `registry` must be a pointer returned by `bloom_registry_new`; `out` must be writable.
+pub unsafe extern "C" fn bloom_registry_stats(registry: *const c_void, network: u16, out: *mut CBloomNetworkStats) -> bool {
+    if registry.is_null() || out.is_null() {
+        return false;
+    }
+
+    let registry = &*(registry as *const bloom_registry::BloomRegistry);
+    match registry.stats(network) {
+        Ok(stats) => {
+            *out = CBloomNetworkStats {
+                transactions_processed: stats.transactions_processed,
+                blocks_processed: stats.blocks_processed,
+                queries_per_second: stats.queries_per_second,
+                average_query_time_ns: stats.average_query_time_ns,
+                false_positive_rate: stats.false_positive_rate,
+                memory_usage_bytes: stats.memory_usage_bytes,
+                last_updated: stats.last_updated,
+            };
+            true
+        }
+        Err(_) => false,
+    }
+}
+
+/// C FFI: Free a registry and all of its filters
+#[no_mangle]
+/// # Safety
+///
+/// `registry` must be a pointer returned by `bloom_registry_new`. After this call the
+/// pointer must not be used.
+pub unsafe extern "C" fn bloom_registry_free(registry: *mut c_void) {
+    if !registry.is_null() {
+        let _ = Box::from_raw(registry as *mut bloom_registry::BloomRegistry);
+    }
+}
+
+/// Seen-set counters, mirrors `BloomSeenStats` in bloom_filter.h
+#[repr(C)]
+pub struct CBloomSeenStats {
+    pub queries: u64,
+    pub duplicates: u64,
+    pub false_positives_avoided: u64,
+    pub rotations: u64,
+    pub cached_keys: u64,
+}
+
+/// C FFI: Create a seen-set from a windowed config with `cache_entries` exact keys
+#[no_mangle]
+/// # Safety
+///
+/// `config` must point to a valid `BloomConfig`. `err` may be null.
+pub unsafe extern "C" fn bloom_seen_new(config: *const CBloomConfig, cache_entries: u64, err: *mut BloomFilterErrorCode) -> *mut c_void {
+    let set_err = |code: BloomFilterErrorCode| {
+        if !err.is_null() {
+            *err = code;
+        }
+    };
+
+    if config.is_null() {
+        set_err(BloomFilterErrorCode::InvalidConfig);
+        return std::ptr::null_mut();
+    }
+
+    match bloom_seen::SeenSet::new(config_from_c(&*config), cache_entries as usize) {
+        Ok(seen) => {
+            set_err(BloomFilterErrorCode::Ok);
+            Box::into_raw(Box::new(seen)) as *mut c_void
+        }
+        Err(e) => {
+            set_err(BloomFilterErrorCode::from(&e));
+            std::ptr::null_mut()
+        }
+    }
+}
+
+/// C FFI: Record a key, returns 1 if it was seen within the window, 0 if new, -1 on error
+#[no_mangle]
+/// # Safety
+///
+/// `seen` must be a pointer returned by `bloom_seen_new`. `data` must point to `len` readable bytes.
+pub unsafe extern "C" fn bloom_seen_test_and_insert(seen: *const c_void, data: *const u8, len: usize) -> i32 {
+    if seen.is_null() || data.is_null() || len == 0 {
+        return -1;
+    }
+
+    let seen = &*(seen as *const bloom_seen::SeenSet);
+    seen.test_and_insert(std::slice::from_raw_parts(data, len)).map_or(-1, |hit| hit as i32)
+}
+
+/// C FFI: Record `count` packed keys, setting bit i of `bitmap` for each duplicate.
+/// Returns the duplicate count or -1 on invalid input.
+#[no_mangle]
+/// # Safety
+///
+/// `keys` must point to `count * stride` readable bytes and `bitmap` to `(count + 7) / 8`
+/// writable bytes.
+pub unsafe extern "C" fn bloom_seen_test_and_insert_batch(
+    seen: *const c_void,
+    keys: *const u8,
+    stride: usize,
+    count: usize,
+    bitmap: *mut u8,
+) -> i64 {
+    if seen.is_null() || keys.is_null() || bitmap.is_null() {
+        return -1;
+    }
+
+    let Some(len) = count.checked_mul(stride).filter(|&len| len <= isize::MAX as usize) else {
+        return -1;
+    };
+    let seen = &*(seen as *const bloom_seen::SeenSet);
+    let keys = std::slice::from_raw_parts(keys, len);
+    let bitmap = std::slice::from_raw_parts_mut(bitmap, count.div_ceil(8));
+    seen.test_and_insert_packed(keys, stride, bitmap).map_or(-1, |dups| dups as i64)
+}
+
+/// C FFI: Fill `stats` with the seen-set counters
+#[no_mangle]
+/// # Safety
+///
+/// `seen` must be a pointer returned by `bloom_seen_new`; `stats` must be writable.
+pub unsafe extern "C" fn bloom_seen_stats(seen: *const c_void, stats: *mut CBloomSeenStats) -> bool {
+    if seen.is_null() || stats.is_null() {
+        return false;
+    }
+
+    let s = (*(seen as *const bloom_seen::SeenSet)).stats();
+    *stats = CBloomSeenStats {
+        queries: s.queries,
+        duplicates: s.duplicates,
+        false_positives_avoided: s.false_positives_avoided,
+        rotations: s.rotations,
+        cached_keys: s.cached_keys,
+    };
+    true
+}
+
+/// C FFI: Free a seen-set
+#[no_mangle]
+/// # Safety
+///
+/// `seen` must be a pointer returned by `bloom_seen_new` (or null), freed only once.
+pub unsafe extern "C" fn bloom_seen_free(seen: *mut c_void) {
+    if !seen.is_null() {
+        let _ = Box::from_raw(seen as *mut bloom_seen::SeenSet);
+    }
+}
+
+// ============================================================================
+// SECUREBUFFER C FFI EXPORTS
+// ============================================================================
+
+/// C FFI: Create a secure buffer; free with `securebuffer_free`
+#[no_mangle]
+pub extern "C" fn securebuffer_new(capacity: usize) -> *mut c_void {
+    match SecureBuffer::new(capacity) {
+        Ok(buffer) => Box::into_raw(Box::new(buffer)) as *mut c_void,
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: Zeroize and free a buffer from any `securebuffer_new*` constructor
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be null or a pointer from a `securebuffer_new*` constructor, not used afterwards.
+pub unsafe extern "C" fn securebuffer_free(buffer: *mut c_void) {
+    if !buffer.is_null() {
+        let _ = Box::from_raw(buffer as *mut SecureBuffer);
+    }
+}
+
+/// C FFI: Replace the contents with `len` bytes from `data`
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer and `data` readable for `len` bytes.
+pub unsafe extern "C" fn securebuffer_copy(buffer: *mut c_void, data: *const u8, len: usize) -> c_int {
+    if buffer.is_null() || (data.is_null() && len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
+    if len > buffer.capacity {
+        return SECUREBUFFER_ERROR_BUFFER_OVERFLOW;
+    }
+    let data = if len == 0 { &[][..] } else { std::slice::from_raw_parts(data, len) };
+    match buffer.write(data) {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(_) => SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED,
+    }
+}
+
+/// C FFI: The contents, valid for `securebuffer_len` bytes until the next change; null
+/// once the buffer is invalid
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer.
+pub unsafe extern "C" fn securebuffer_data_readonly(buffer: *const c_void) -> *const u8 {
+    if buffer.is_null() {
+        return std::ptr::null();
+    }
+    let buffer = &*(buffer as *const SecureBuffer);
+    if buffer.is_valid.load(Ordering::SeqCst) { buffer.data } else { std::ptr::null() }
+}
+
+/// C FFI: Length of the contents
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be null or a valid pointer.
+pub unsafe extern "C" fn securebuffer_len(buffer: *const c_void) -> usize {
+    if buffer.is_null() { 0 } else { (*(buffer as *const SecureBuffer)).len() }
+}
+
+/// C FFI: Capacity of the buffer
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be null or a valid pointer.
+pub unsafe extern "C" fn securebuffer_capacity(buffer: *const c_void) -> usize {
+    if buffer.is_null() { 0 } else { (*(buffer as *const SecureBuffer)).capacity }
+}
+
+/// C FFI: Take the buffer's advisory lock shared, waiting for any writer
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer.
+pub unsafe extern "C" fn securebuffer_acquire_read_lock(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    (*(buffer as *const SecureBuffer)).acquire_access(false);
+    SECUREBUFFER_SUCCESS
+}
+
+/// C FFI: Take the buffer's advisory lock exclusively, waiting for readers and writers
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer.
+pub unsafe extern "C" fn securebuffer_acquire_write_lock(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    (*(buffer as *const SecureBuffer)).acquire_access(true);
+    SECUREBUFFER_SUCCESS
+}
+
+/// C FFI: Release one read or write hold; SECUREBUFFER_ERROR_THREAD_SAFETY_VIOLATION if
+/// none is held
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer.
+pub unsafe extern "C" fn securebuffer_release_lock(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    if (*(buffer as *const SecureBuffer)).release_access() {
+        SECUREBUFFER_SUCCESS
+    } else {
+        SECUREBUFFER_ERROR_THREAD_SAFETY_VIOLATION
+    }
+}
+
+/// C FFI: Buffers are Send + Sync and support the advisory lock
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be null or a valid pointer.
+pub unsafe extern "C" fn securebuffer_is_thread_safe(buffer: *const c_void) -> bool {
+    !buffer.is_null()
+}
+
+/// C FFI: Create new secure buffer with security level
+#[no_mangle]
+/// # Safety
+///
+/// `capacity` must be a reasonable positive value. The returned pointer is
+/// owned by the caller and must be freed with `secure_buffer_free` or equivalent.
+pub unsafe extern "C" fn securebuffer_new_with_security_level(capacity: usize, security_level: c_int) -> *mut c_void {
+    match SecureBuffer::new(capacity) {
+        Ok(mut buffer) => {
+            if security_level > 0 {
+                let _ = buffer.enable_hardware_protection();
+            }
+            Box::into_raw(Box::new(buffer)) as *mut c_void
+        },
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: Start the asynchronous audit log, appending binary records to `log_path`
+#[no_mangle]
+/// # Safety
+///
+/// `log_path` must be a valid NUL-terminated string.
+pub unsafe extern "C" fn securebuffer_enable_audit_logging(log_path: *const c_char) -> c_int {
+    if log_path.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let Ok(path) = CStr::from_ptr(log_path).to_str() else {
+        return SECUREBUFFER_ERROR_POLICY_VIOLATION;
+    };
+    match audit_log::enable(std::path::Path::new(path)) {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(_) => SECUREBUFFER_ERROR_POLICY_VIOLATION,
+    }
+}
+
+/// C FFI: Stop audit logging once queued records are written
+#[no_mangle]
+pub extern "C" fn securebuffer_disable_audit_logging() -> c_int {
+    audit_log::disable();
+    SECUREBUFFER_SUCCESS
+}
+
+/// C FFI: Check if audit logging is enabled
+#[no_mangle]
+pub extern "C" fn securebuffer_is_audit_logging_enabled() -> bool {
+    audit_log::is_enabled()
+}
+
+/// C FFI: Choose what a thread does when its audit queue is full: 0 drops the record
+/// (counted in securebuffer_audit_dropped_total), 1 waits for the writer
+#[no_mangle]
+pub extern "C" fn securebuffer_set_audit_backpressure(policy: c_int) -> c_int {
+    match policy {
+        0 => audit_log::set_backpressure(audit_log::Backpressure::Drop),
+        1 => audit_log::set_backpressure(audit_log::Backpressure::Block),
+        _ => return SECUREBUFFER_ERROR_INVALID_SIZE,
+    }
+    SECUREBUFFER_SUCCESS
+}
+
+/// C FFI: Write and sync every audit record queued so far
+#[no_mangle]
+pub extern "C" fn securebuffer_flush_audit_log() -> c_int {
+    audit_log::flush();
+    SECUREBUFFER_SUCCESS
+}
+
+/// C FFI: Bind to hardware
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
+pub unsafe extern "C" fn securebuffer_bind_to_hardware(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return -1;
+    }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
+    match buffer.bind_to_hardware() {
+        Ok(_) => 0,
+        Err(_) => -1,
+    }
+}
+
+/// C FFI: Check if hardware backed
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
+pub unsafe extern "C" fn securebuffer_is_hardware_backed(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return 0;
+    }
+    let buffer = &*(buffer as *mut SecureBuffer);
+    if buffer.is_hardware_backed() { 1 } else { 0 }
+}
+
+/// C FFI: Enable tamper detection
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
+pub unsafe extern "C" fn securebuffer_enable_tamper_detection(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return -1;
+    }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
+    match buffer.enable_tamper_detection() {
+        Ok(_) => 0,
+        Err(_) => -1,
+    }
+}
+
+/// C FFI: Check if tampered
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
+pub unsafe extern "C" fn securebuffer_is_tampered(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return 1; // Consider null as tampered
+    }
+    let buffer = &*(buffer as *mut SecureBuffer);
+    if buffer.is_tampered() { 1 } else { 0 }
+}
+
+/// C FFI: Integrity check; with tamper detection on, costs only the chunks edited since
+/// the last check when a background verification schedule is active
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer with no concurrent writers.
+pub unsafe extern "C" fn securebuffer_integrity_check(buffer: *const c_void) -> bool {
+    !buffer.is_null() && (*(buffer as *const SecureBuffer)).integrity_check()
+}
+
+/// C FFI: Verify `chunks_per_tick` 4 KiB chunks every `interval_ms` on a background
+/// thread; 0 cancels. Requires `securebuffer_enable_tamper_detection`.
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer. The schedule ends by itself when the buffer is freed.
+pub unsafe extern "C" fn securebuffer_schedule_integrity_verification(
+    buffer: *const c_void,
+    interval_ms: u64,
+    chunks_per_tick: usize,
+) -> c_int {
+    if buffer.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let interval = std::time::Duration::from_millis(interval_ms);
+    match (*(buffer as *const SecureBuffer)).schedule_integrity_verification(interval, chunks_per_tick) {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(_) => SECUREBUFFER_ERROR_POLICY_VIOLATION,
+    }
+}
+
+/// C FFI: Enable side channel protection
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
+pub unsafe extern "C" fn securebuffer_enable_side_channel_protection(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return -1;
+    }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
+    match buffer.enable_side_channel_protection() {
+        Ok(_) => 0,
+        Err(_) => -1,
+    }
+}
+
+/// C FFI: Set enterprise policy
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer and `policy` must be a valid NUL-terminated C string.
+pub unsafe extern "C" fn securebuffer_set_enterprise_policy(buffer: *mut c_void, policy: *const c_char) -> c_int {
+    if buffer.is_null() || policy.is_null() {
+        return -1;
+    }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
+    let policy_cstr = CStr::from_ptr(policy);
+    match policy_cstr.to_str() {
+        Ok(policy_str) => {
+            match buffer.set_enterprise_policy(policy_str) {
+                Ok(_) => 0,
+                Err(_) => -1,
+            }
+        },
+        Err(_) => -1,
+    }
+}
+
+/// C FFI: Validate policy compliance
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
+pub unsafe extern "C" fn securebuffer_validate_policy_compliance(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return -1;
+    }
+    let buffer = &*(buffer as *mut SecureBuffer);
+    if buffer.validate_policy_compliance() { 0 } else { -1 }
+}
+
+/// C FFI: Get compliance report
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
+/// Caller receives ownership of the returned C string and must free it with `securebuffer_free_cstr`.
+pub unsafe extern "C" fn securebuffer_get_compliance_report(buffer: *mut c_void) -> *mut c_char {
+    if buffer.is_null() {
+        return std::ptr::null_mut();
+    }
+    let buffer = &*(buffer as *mut SecureBuffer);
+    let report = buffer.get_compliance_report();
+    match CString::new(report) {
+        Ok(c_str) => c_str.into_raw(),
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: Get security audit log
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
+/// Caller receives ownership of the returned C string and must free it with `securebuffer_free_cstr`.
+pub unsafe extern "C" fn securebuffer_get_security_audit_log(buffer: *mut c_void) -> *mut c_char {
+    if buffer.is_null() {
+        return std::ptr::null_mut();
+    }
+    let buffer = &*(buffer as *mut SecureBuffer);
+    let log = buffer.get_security_audit_log();
+    match CString::new(log) {
+        Ok(c_str) => c_str.into_raw(),
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: HMAC as hex
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer. `key` must point to `key_len` readable bytes.
+/// Caller receives ownership of the returned C string and must free it with `securebuffer_free_cstr`.
+pub unsafe extern "C" fn securebuffer_hmac_hex(buffer: *mut c_void, key: *const u8, key_len: usize) -> *mut c_char {
+    if buffer.is_null() || key.is_null() || key_len == 0 {
+        return std::ptr::null_mut();
+    }
+    let buffer = &*(buffer as *mut SecureBuffer);
+    let key_slice = std::slice::from_raw_parts(key, key_len);
+    match buffer.hmac_hex(key_slice) {
+        Ok(hmac) => {
+            match CString::new(hmac) {
+                Ok(c_str) => c_str.into_raw(),
+                Err(_) => std::ptr::null_mut(),
+            }
+        },
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: HMAC as base64url
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer. `key` must point to `key_len` readable bytes.
+/// Caller receives ownership of the returned C string and must free it with `securebuffer_free_cstr`.
+pub unsafe extern "C" fn securebuffer_hmac_base64url(buffer: *mut c_void, key: *const u8, key_len: usize) -> *mut c_char {
+    if buffer.is_null() || key.is_null() || key_len == 0 {
+        return std::ptr::null_mut();
+    }
+    let buffer = &*(buffer as *mut SecureBuffer);
+    let key_slice = std::slice::from_raw_parts(key, key_len);
+    match buffer.hmac_base64url(key_slice) {
+        Ok(hmac) => {
+            match CString::new(hmac) {
+                Ok(c_str) => c_str.into_raw(),
+                Err(_) => std::ptr::null_mut(),
+            }
+        },
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// Error codes shared with securebuffer.h's `SecureBufferError`
+const SECUREBUFFER_SUCCESS: c_int = 0;
+const SECUREBUFFER_ERROR_NULL_POINTER: c_int = -1;
+const SECUREBUFFER_ERROR_BUFFER_OVERFLOW: c_int = -4;
+const SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED: c_int = -5;
+const SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED: c_int = -6;
+const SECUREBUFFER_ERROR_THREAD_SAFETY_VIOLATION: c_int = -7;
+const SECUREBUFFER_ERROR_INVALID_SIZE: c_int = -2;
+const SECUREBUFFER_ERROR_POLICY_VIOLATION: c_int = -10;
+const SECUREBUFFER_ERROR_EXPIRED: c_int = -11;
+const SECUREBUFFER_ERROR_ZERO_COPY_FAILED: c_int = -13;
+const SECUREBUFFER_ERROR_QUEUE_FULL: c_int = -15;
+
+/// Shared body of the `_into` HMAC exports: size check against `needed`, then `write`.
+/// `out_len` always receives the size the result needs, so a short buffer can be retried.
+unsafe fn hmac_into_ffi(
+    buffer: *mut c_void,
+    key: *const u8,
+    key_len: usize,
+    out: *mut u8,
+    out_cap: usize,
+    out_len: *mut usize,
+    needed: usize,
+    write: impl FnOnce(&SecureBuffer, &[u8], &mut [u8]) -> Result<usize, String>,
+) -> c_int {
+    if buffer.is_null() || key.is_null() || out.is_null() || out_len.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    *out_len = needed;
+    if out_cap < needed {
+        return SECUREBUFFER_ERROR_BUFFER_OVERFLOW;
+    }
+    if key_len == 0 {
+        return SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED;
+    }
+
+    let buffer = &*(buffer as *const SecureBuffer);
+    let key = std::slice::from_raw_parts(key, key_len);
+    match write(buffer, key, std::slice::from_raw_parts_mut(out, out_cap)) {
+        Ok(written) => {
+            *out_len = written;
+            SECUREBUFFER_SUCCESS
+        }
+        Err(_) => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    }
+}
+
+/// C FFI: Raw 32-byte HMAC into a caller buffer
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer. `key` must point to `key_len` readable bytes, `out` to
+/// `out_cap` writable bytes, and `out_len` must be writable. Nothing is allocated.
+pub unsafe extern "C" fn securebuffer_hmac_into(
+    buffer: *mut c_void,
+    key: *const u8,
+    key_len: usize,
+    out: *mut u8,
+    out_cap: usize,
+    out_len: *mut usize,
+) -> c_int {
+    hmac_into_ffi(buffer, key, key_len, out, out_cap, out_len, HMAC_DIGEST_LEN, |b, k, o| b.hmac_into(k, o))
+}
+
+/// C FFI: HMAC as 64 hex characters into a caller buffer (not NUL-terminated)
+#[no_mangle]
+/// # Safety
+///
+/// Same contract as `securebuffer_hmac_into`.
+pub unsafe extern "C" fn securebuffer_hmac_hex_into(
+    buffer: *mut c_void,
+    key: *const u8,
+    key_len: usize,
+    out: *mut u8,
+    out_cap: usize,
+    out_len: *mut usize,
+) -> c_int {
+    hmac_into_ffi(buffer, key, key_len, out, out_cap, out_len, HMAC_HEX_LEN, |b, k, o| b.hmac_hex_into(k, o))
+}
+
+/// C FFI: HMAC as 43 unpadded base64url characters into a caller buffer (not NUL-terminated)
+#[no_mangle]
+/// # Safety
+///
+/// Same contract as `securebuffer_hmac_into`.
+pub unsafe extern "C" fn securebuffer_hmac_base64url_into(
+    buffer: *mut c_void,
+    key: *const u8,
+    key_len: usize,
+    out: *mut u8,
+    out_cap: usize,
+    out_len: *mut usize,
+) -> c_int {
+    hmac_into_ffi(buffer, key, key_len, out, out_cap, out_len, HMAC_BASE64URL_LEN, |b, k, o| b.hmac_base64url_into(k, o))
+}
+
+/// C FFI: Raw HMACs for `count` keys, digest i at `out[32 * i]`. Fails as a whole, before
+/// writing, if `out_cap` is short of `32 * count` or any key is empty.
+#[no_mangle]
+/// # Safety
+///
+/// `key_list` and `key_lens` must hold `count` entries, each key readable for its length;
+/// `out` must be writable for `out_cap` bytes.
+pub unsafe extern "C" fn securebuffer_hmac_batch_into(
+    buffer: *mut c_void,
+    key_list: *const *const u8,
+    key_lens: *const usize,
+    count: usize,
+    out: *mut u8,
+    out_cap: usize,
+) -> c_int {
+    if buffer.is_null() || key_list.is_null() || key_lens.is_null() || out.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    if count.checked_mul(HMAC_DIGEST_LEN).map_or(true, |needed| out_cap < needed) {
+        return SECUREBUFFER_ERROR_BUFFER_OVERFLOW;
+    }
+
+    let buffer = &*(buffer as *const SecureBuffer);
+    let Some(keys) = batch_slices(key_list, key_lens, count) else {
+        return SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED;
+    };
+
+    let out = std::slice::from_raw_parts_mut(out as *mut [u8; HMAC_DIGEST_LEN], count);
+    match buffer.hmac_digest_many(&keys, out) {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(_) => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    }
+}
+
+/// Borrow `count` caller slices, or None if any pointer is null or any length is zero
+unsafe fn batch_slices<'a>(list: *const *const u8, lens: *const usize, count: usize) -> Option<Vec<&'a [u8]>> {
+    let ptrs = std::slice::from_raw_parts(list, count);
+    let lens = std::slice::from_raw_parts(lens, count);
+    ptrs.iter().zip(lens)
+        .map(|(&ptr, &len)| (!ptr.is_null() && len > 0).then(|| std::slice::from_raw_parts(ptr, len)))
+        .collect()
+}
+
+/// C FFI: Hex HMACs for up to SECUREBUFFER_BATCH_MAX_SIZE keys, or null on any failure
+#[no_mangle]
+/// # Safety
+///
+/// `data_list` and `data_lens` must hold `count` entries, each readable for its length.
+/// Free the result with `securebuffer_free_batch_results` and the same `count`.
+pub unsafe extern "C" fn securebuffer_hmac_batch(
+    buffer: *mut c_void,
+    data_list: *const *const u8,
+    data_lens: *const usize,
+    count: usize,
+) -> *mut *mut c_char {
+    if buffer.is_null() || data_list.is_null() || data_lens.is_null() || count == 0 || count > SECUREBUFFER_BATCH_MAX_SIZE {
+        return std::ptr::null_mut();
+    }
+    let buffer = &*(buffer as *const SecureBuffer);
+    let Some(keys) = batch_slices(data_list, data_lens, count) else {
+        return std::ptr::null_mut();
+    };
+
+    let mut digests = vec![[0u8; HMAC_DIGEST_LEN]; count];
+    if buffer.hmac_digest_many(&keys, &mut digests).is_err() {
+        return std::ptr::null_mut();
+    }
+    let results: Box<[*mut c_char]> = digests.iter()
+        .map(|digest| CString::new(hex::encode(digest)).unwrap_or_default().into_raw())
+        .collect();
+    Box::into_raw(results) as *mut *mut c_char
+}
+
+/// C FFI: Free the array returned by `securebuffer_hmac_batch`
+#[no_mangle]
+/// # Safety
+///
+/// `results` must come from `securebuffer_hmac_batch` called with the same `count`.
+pub unsafe extern "C" fn securebuffer_free_batch_results(results: *mut *mut c_char, count: usize) {
+    if results.is_null() {
+        return;
+    }
+    let results = Box::from_raw(std::ptr::slice_from_raw_parts_mut(results, count));
+    for &ptr in results.iter().filter(|ptr| !ptr.is_null()) {
+        drop(CString::from_raw(ptr));
+    }
+}
+
+/// C FFI: Whether hashing or AES-GCM runs on dedicated instructions or vector lanes on this CPU
+#[no_mangle]
+pub extern "C" fn securebuffer_has_hardware_acceleration() -> bool {
+    sha256_batch::backend().is_accelerated() || secure_aead::backend() != secure_aead::AeadBackend::Portable
+}
+
+/// C FFI: Describe the selected kernels, e.g. "sha256=avx2-8way lanes=8 aes-gcm=aes-ni+pclmul crc32c=sse4.2";
+/// free with `securebuffer_free_cstr`
+#[no_mangle]
+pub extern "C" fn securebuffer_get_acceleration_info() -> *mut c_char {
+    let backend = sha256_batch::backend();
+    let info = format!(
+        "sha256={} lanes={} aes-gcm={} crc32c={}",
+        backend.name(),
+        backend.lanes(),
+        secure_aead::backend().name(),
+        buffer_integrity::crc32c_backend().name()
+    );
+    match CString::new(info) {
+        Ok(info) => info.into_raw(),
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: HMAC-SHA256 operations per second over `buffer_size`-byte messages, measured for
+/// `iterations` calls; 0.0 on invalid arguments. A one-number health check: the per-entry-point
+/// suite is `cargo run --release --example ffi_bench`.
+#[no_mangle]
+pub extern "C" fn securebuffer_benchmark_operations(buffer_size: usize, iterations: usize) -> f64 {
+    if buffer_size == 0 || iterations == 0 {
+        return 0.0;
+    }
+    let Ok(mut key) = SecureBuffer::new(HMAC_DIGEST_LEN) else {
+        return 0.0;
+    };
+    let mut seed = [0u8; HMAC_DIGEST_LEN];
+    if entropy_reservoir::fill_entropy(&mut seed).is_err() || key.write(&seed).is_err() {
+        return 0.0;
+    }
+    let message = vec![0x5au8; buffer_size];
+    let mut digest = [0u8; HMAC_DIGEST_LEN];
+
+    let start = std::time::Instant::now();
+    for _ in 0..iterations {
+        if key.hmac_into(std::hint::black_box(&message), &mut digest).is_err() {
+            return 0.0;
+        }
+    }
+    iterations as f64 / start.elapsed().as_secs_f64().max(1e-9)
+}
+
+/// C FFI: Fault in the buffer's pages from the calling thread; call it from a thread on the
+/// node that will use the buffer
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer.
+pub unsafe extern "C" fn securebuffer_prefault_pages(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    (*(buffer as *const SecureBuffer)).prefault();
+    SECUREBUFFER_SUCCESS
+}
+
+/// C FFI: NUMA nodes with CPUs (1 on single-node hosts and outside Linux)
+#[no_mangle]
+pub extern "C" fn securebuffer_numa_node_count() -> usize {
+    numa::node_count()
+}
+
+/// C FFI: Replace the buffer's key with fresh random bytes of the same length, published
+/// as one version; HMAC contexts built from the old key stop working
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer. Other threads may use `securebuffer_read_consistent`,
+/// `securebuffer_sign_hmac_sha256_into` or the `securebuffer_hmac_*` functions concurrently;
+/// other writers and `securebuffer_data_readonly` callers must be excluded.
+pub unsafe extern "C" fn securebuffer_rotate_key(buffer: *mut c_void) -> c_int {
+    if buffer.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    match (*(buffer as *const SecureBuffer)).rotate_key() {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(_) => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    }
+}
+
+/// C FFI: Copy the contents into `out` as of one key version, without taking a lock.
+/// `out_len` always receives the contents' length, so a short buffer can be retried.
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer, `out` writable for `out_cap` bytes and `out_len` writable.
+pub unsafe extern "C" fn securebuffer_read_consistent(
+    buffer: *const c_void,
+    out: *mut u8,
+    out_cap: usize,
+    out_len: *mut usize,
+) -> c_int {
+    if buffer.is_null() || out.is_null() || out_len.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let buffer = &*(buffer as *const SecureBuffer);
+    *out_len = buffer.len();
+    if out_cap < *out_len {
+        return SECUREBUFFER_ERROR_BUFFER_OVERFLOW;
+    }
+    match buffer.read_consistent_into(std::slice::from_raw_parts_mut(out, out_cap)) {
+        Ok(len) => {
+            *out_len = len;
+            SECUREBUFFER_SUCCESS
+        }
+        Err(_) => SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED,
+    }
+}
+
+/// C FFI: HMAC-SHA256 of `message` keyed with the buffer's contents, into 32 bytes at
+/// `out`, as of one key version and without taking a lock
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer, `message` readable for `message_len` bytes and `out`
+/// writable for `SECUREBUFFER_HMAC_SIZE` bytes.
+pub unsafe extern "C" fn securebuffer_sign_hmac_sha256_into(
+    buffer: *const c_void,
+    message: *const u8,
+    message_len: usize,
+    out: *mut u8,
+) -> c_int {
+    if buffer.is_null() || out.is_null() || (message.is_null() && message_len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let message = if message_len == 0 { &[][..] } else { std::slice::from_raw_parts(message, message_len) };
+    match (*(buffer as *const SecureBuffer)).sign_hmac_sha256(message) {
+        Ok(digest) => {
+            std::ptr::copy_nonoverlapping(digest.as_ptr(), out, HMAC_DIGEST_LEN);
+            SECUREBUFFER_SUCCESS
+        }
+        Err(_) => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    }
+}
+
+/// C FFI: Precompute an HMAC context keyed with the buffer's contents, or null for an
+/// empty buffer or unsupported algorithm
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer. The context does not borrow the buffer; free it with
+/// `securebuffer_hmac_context_free`.
+pub unsafe extern "C" fn securebuffer_hmac_context_new(buffer: *const c_void, algorithm: c_int) -> *mut c_void {
+    if buffer.is_null() {
+        return std::ptr::null_mut();
+    }
+    let Some(algorithm) = secure_hmac::HmacAlgorithm::from_raw(algorithm) else {
+        return std::ptr::null_mut();
+    };
+    match secure_hmac::SecureHmacContext::new(&*(buffer as *const SecureBuffer), algorithm) {
+        Ok(ctx) => Box::into_raw(Box::new(ctx)) as *mut c_void,
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: MAC `data` into a caller buffer from the cached midstates. Returns
+/// SECUREBUFFER_ERROR_EXPIRED once the source buffer's key has changed.
+#[no_mangle]
+/// # Safety
+///
+/// `ctx` must come from `securebuffer_hmac_context_new`. `data` must point to `data_len`
+/// readable bytes (it may be null when `data_len` is 0), `out` to `out_cap` writable bytes.
+pub unsafe extern "C" fn securebuffer_hmac_context_compute_into(
+    ctx: *const c_void,
+    data: *const u8,
+    data_len: usize,
+    out: *mut u8,
+    out_cap: usize,
+    out_len: *mut usize,
+) -> c_int {
+    if ctx.is_null() || (data.is_null() && data_len > 0) || out.is_null() || out_len.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let ctx = &*(ctx as *const secure_hmac::SecureHmacContext);
+    *out_len = ctx.algorithm().digest_len();
+    if out_cap < *out_len {
+        return SECUREBUFFER_ERROR_BUFFER_OVERFLOW;
+    }
+    if !ctx.is_current() {
+        return SECUREBUFFER_ERROR_EXPIRED;
+    }
+
+    let data = if data_len == 0 { &[][..] } else { std::slice::from_raw_parts(data, data_len) };
+    match ctx.mac_into(data, std::slice::from_raw_parts_mut(out, out_cap)) {
+        Ok(_) => SECUREBUFFER_SUCCESS,
+        Err(_) => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    }
+}
+
+/// C FFI: MAC `count` messages from the cached midstates, digest i at
+/// `out[i * digest_len]`; `*out_len` receives the total size needed
+#[no_mangle]
+/// # Safety
+///
+/// `ctx` must come from `securebuffer_hmac_context_new`. `data_list` and `data_lens` must
+/// hold `count` entries (a null entry is allowed only with length 0), `out` must be
+/// writable for `out_cap` bytes.
+pub unsafe extern "C" fn securebuffer_hmac_context_compute_batch_into(
+    ctx: *const c_void,
+    data_list: *const *const u8,
+    data_lens: *const usize,
+    count: usize,
+    out: *mut u8,
+    out_cap: usize,
+    out_len: *mut usize,
+) -> c_int {
+    if ctx.is_null() || data_list.is_null() || data_lens.is_null() || out.is_null() || out_len.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let ctx = &*(ctx as *const secure_hmac::SecureHmacContext);
+    let Some(needed) = count.checked_mul(ctx.algorithm().digest_len()) else {
+        return SECUREBUFFER_ERROR_BUFFER_OVERFLOW;
+    };
+    *out_len = needed;
+    if out_cap < needed {
+        return SECUREBUFFER_ERROR_BUFFER_OVERFLOW;
+    }
+    if !ctx.is_current() {
+        return SECUREBUFFER_ERROR_EXPIRED;
+    }
+
+    let ptrs = std::slice::from_raw_parts(data_list, count);
+    let lens = std::slice::from_raw_parts(data_lens, count);
+    let mut messages = Vec::with_capacity(count);
+    for (&ptr, &len) in ptrs.iter().zip(lens) {
+        match (ptr.is_null(), len) {
+            (_, 0) => messages.push(&[][..]),
+            (false, len) => messages.push(std::slice::from_raw_parts(ptr, len)),
+            (true, _) => return SECUREBUFFER_ERROR_NULL_POINTER,
+        }
+    }
+    match ctx.mac_many_into(&messages, std::slice::from_raw_parts_mut(out, out_cap)) {
+        Ok(_) => SECUREBUFFER_SUCCESS,
+        Err(_) => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    }
+}
+
+/// C FFI: Wipe and free an HMAC context
+#[no_mangle]
+/// # Safety
+///
+/// `ctx` must come from `securebuffer_hmac_context_new` (or be null) and is freed only once.
+pub unsafe extern "C" fn securebuffer_hmac_context_free(ctx: *mut c_void) {
+    if !ctx.is_null() {
+        let _ = Box::from_raw(ctx as *mut secure_hmac::SecureHmacContext);
+    }
+}
+
+/// C FFI: AES-256-GCM seal `buffer` into `output` as ciphertext || tag (32-byte key,
+/// 12-byte nonce). Passing the same buffer twice encrypts in place.
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` and `output` must be valid pointers, `key` readable for 32 bytes and `nonce`
+/// for 12 bytes.
+pub unsafe extern "C" fn securebuffer_encrypt_aes256_gcm(
+    buffer: *mut c_void,
+    key: *const u8,
+    nonce: *const u8,
+    output: *mut c_void,
+) -> c_int {
+    if buffer.is_null() || key.is_null() || nonce.is_null() || output.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let key = std::slice::from_raw_parts(key, secure_aead::AEAD_KEY_LEN);
+    let nonce = std::slice::from_raw_parts(nonce, secure_aead::AEAD_NONCE_LEN);
+    let result = if buffer == output {
+        (*(buffer as *mut SecureBuffer)).encrypt_aes256_gcm_in_place(key, nonce)
+    } else {
+        (*(buffer as *const SecureBuffer)).encrypt_aes256_gcm_into(key, nonce, &mut *(output as *mut SecureBuffer))
+    };
+    let status = match result {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(_) => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    };
+    audit_aead(audit_log::AuditKind::Sealed, buffer, output, status)
+}
+
+/// C FFI: AES-256-GCM open ciphertext || tag from `buffer` into `output`; in place when
+/// both are the same buffer. SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED (output wiped)
+/// when the tag does not match.
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` and `output` must be valid pointers, `key` readable for 32 bytes and `nonce`
+/// for 12 bytes.
+pub unsafe extern "C" fn securebuffer_decrypt_aes256_gcm(
+    buffer: *mut c_void,
+    key: *const u8,
+    nonce: *const u8,
+    output: *mut c_void,
+) -> c_int {
+    if buffer.is_null() || key.is_null() || nonce.is_null() || output.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let key = std::slice::from_raw_parts(key, secure_aead::AEAD_KEY_LEN);
+    let nonce = std::slice::from_raw_parts(nonce, secure_aead::AEAD_NONCE_LEN);
+    let result = if buffer == output {
+        (*(buffer as *mut SecureBuffer)).decrypt_aes256_gcm_in_place(key, nonce)
+    } else {
+        (*(buffer as *const SecureBuffer)).decrypt_aes256_gcm_into(key, nonce, &mut *(output as *mut SecureBuffer))
+    };
+    audit_aead(audit_log::AuditKind::Opened, buffer, output, aead_status(result))
+}
+
+/// Audit a whole-buffer seal or open against the source buffer, with the output length
+unsafe fn audit_aead(kind: audit_log::AuditKind, buffer: *mut c_void, output: *mut c_void, status: c_int) -> c_int {
+    if audit_log::is_enabled() {
+        let (buffer, output) = (&*(buffer as *const SecureBuffer), &*(output as *const SecureBuffer));
+        audit_log::record(kind, buffer.id, output.length as u64, status);
+    }
+    status
+}
+
+fn aead_status(result: Result<(), secure_aead::AeadError>) -> c_int {
+    match result {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(secure_aead::AeadError::TagMismatch) => SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED,
+        Err(_) => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    }
+}
+
+/// Scatter-gather element for `securebuffer_aead_update_iov` and the ring functions
+#[repr(C)]
+pub struct CSecureBufferIoVec {
+    pub base: *mut u8,
+    pub len: usize,
+}
+
+/// C FFI: Start a streaming AES-256-GCM operation, or null for a bad key or nonce length
+#[no_mangle]
+/// # Safety
+///
+/// `key` must be readable for `key_len` bytes and `nonce` for `nonce_len` bytes. Free the
+/// context with `securebuffer_aead_free`.
+pub unsafe extern "C" fn securebuffer_aead_new(
+    key: *const u8,
+    key_len: usize,
+    nonce: *const u8,
+    nonce_len: usize,
+    encrypt: bool,
+) -> *mut c_void {
+    if key.is_null() || nonce.is_null() {
+        return std::ptr::null_mut();
+    }
+    let direction = if encrypt { secure_aead::AeadDirection::Encrypt } else { secure_aead::AeadDirection::Decrypt };
+    match secure_aead::SecureAeadContext::new(
+        std::slice::from_raw_parts(key, key_len),
+        std::slice::from_raw_parts(nonce, nonce_len),
+        direction,
+    ) {
+        Ok(ctx) => Box::into_raw(Box::new(ctx)) as *mut c_void,
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: Authenticate associated data; only before the first payload update
+#[no_mangle]
+/// # Safety
+///
+/// `ctx` must come from `securebuffer_aead_new`; `aad` must be readable for `aad_len` bytes.
+pub unsafe extern "C" fn securebuffer_aead_update_aad(ctx: *mut c_void, aad: *const u8, aad_len: usize) -> c_int {
+    if ctx.is_null() || (aad.is_null() && aad_len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let aad = if aad_len == 0 { &[][..] } else { std::slice::from_raw_parts(aad, aad_len) };
+    aead_status((*(ctx as *mut secure_aead::SecureAeadContext)).update_aad(aad))
+}
+
+/// C FFI: Encrypt or decrypt the next `len` payload bytes from `input` to `output`;
+/// `input == output` works in place
+#[no_mangle]
+/// # Safety
+///
+/// `ctx` must come from `securebuffer_aead_new`. `input` must be readable and `output`
+/// writable for `len` bytes; they must be the same pointer or not overlap.
+pub unsafe extern "C" fn securebuffer_aead_update(ctx: *mut c_void, input: *const u8, output: *mut u8, len: usize) -> c_int {
+    if ctx.is_null() || (len > 0 && (input.is_null() || output.is_null())) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    if len == 0 {
+        return SECUREBUFFER_SUCCESS;
+    }
+    if input != output as *const u8 {
+        std::ptr::copy_nonoverlapping(input, output, len);
+    }
+    let result = (*(ctx as *mut secure_aead::SecureAeadContext)).update_in_place(std::slice::from_raw_parts_mut(output, len));
+    aead_status(result)
+}
+
+/// C FFI: Encrypt or decrypt `count` buffers in place, as one continuous stream
+#[no_mangle]
+/// # Safety
+///
+/// `ctx` must come from `securebuffer_aead_new`; `iov` must hold `count` entries, each
+/// writable for its length and not overlapping the others.
+pub unsafe extern "C" fn securebuffer_aead_update_iov(ctx: *mut c_void, iov: *const CSecureBufferIoVec, count: usize) -> c_int {
+    if ctx.is_null() || (iov.is_null() && count > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let iov = if count == 0 { &[][..] } else { std::slice::from_raw_parts(iov, count) };
+    if iov.iter().any(|v| v.base.is_null() && v.len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let mut chunks: Vec<&mut [u8]> = iov.iter()
+        .filter(|v| v.len > 0)
+        .map(|v| std::slice::from_raw_parts_mut(v.base, v.len))
+        .collect();
+    aead_status((*(ctx as *mut secure_aead::SecureAeadContext)).update_vectored(&mut chunks))
+}
+
+/// C FFI: Finish an encryption and write the 16-byte tag
+#[no_mangle]
+/// # Safety
+///
+/// `ctx` must come from `securebuffer_aead_new`; `tag` must be writable for 16 bytes.
+pub unsafe extern "C" fn securebuffer_aead_final(ctx: *mut c_void, tag: *mut u8) -> c_int {
+    if ctx.is_null() || tag.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    match (*(ctx as *mut secure_aead::SecureAeadContext)).finalize() {
+        Ok(computed) => {
+            std::ptr::copy_nonoverlapping(computed.as_ptr(), tag, computed.len());
+            SECUREBUFFER_SUCCESS
+        }
+        Err(e) => aead_status(Err(e)),
+    }
+}
+
+/// C FFI: Finish a decryption against the expected tag. On
+/// SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED every decrypted byte must be discarded.
+#[no_mangle]
+/// # Safety
+///
+/// `ctx` must come from `securebuffer_aead_new`; `tag` must be readable for `tag_len` bytes.
+pub unsafe extern "C" fn securebuffer_aead_verify(ctx: *mut c_void, tag: *const u8, tag_len: usize) -> c_int {
+    if ctx.is_null() || tag.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    aead_status((*(ctx as *mut secure_aead::SecureAeadContext)).verify(std::slice::from_raw_parts(tag, tag_len)))
+}
+
+/// C FFI: Wipe and free a streaming AEAD context
+#[no_mangle]
+/// # Safety
+///
+/// `ctx` must come from `securebuffer_aead_new` (or be null) and is freed only once.
+pub unsafe extern "C" fn securebuffer_aead_free(ctx: *mut c_void) {
+    if !ctx.is_null() {
+        let _ = Box::from_raw(ctx as *mut secure_aead::SecureAeadContext);
+    }
+}
+
+/// C FFI: Derive `capacity` bytes into the buffer with PBKDF2-HMAC-SHA256 on the calling
+/// thread; prefer `securebuffer_kdf_submit` on request paths
+#[no_mangle]
+/// # Safety
+///
+/// `buffer` must be a valid pointer; `password` and `salt` must be readable for their lengths.
+pub unsafe extern "C" fn securebuffer_derive_key(
+    buffer: *mut c_void,
+    password: *const u8,
+    password_len: usize,
+    salt: *const u8,
+    salt_len: usize,
+    iterations: u32,
+) -> c_int {
+    if buffer.is_null() || (password.is_null() && password_len > 0) || (salt.is_null() && salt_len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
+    let password = if password_len == 0 { &[][..] } else { std::slice::from_raw_parts(password, password_len) };
+    let salt = if salt_len == 0 { &[][..] } else { std::slice::from_raw_parts(salt, salt_len) };
+    let capacity = buffer.capacity;
+    let Ok(out) = buffer.staged(&[], capacity) else {
+        return SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED;
+    };
+    let _timer = op_metrics::timer(op_metrics::MetricOp::Derive);
+    let status = match secure_kdf::pbkdf2_hmac_sha256(password, salt, iterations, out) {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(_) => {
+            buffer.clear();
+            SECUREBUFFER_ERROR_INVALID_SIZE
+        }
+    };
+    audit_log::record(audit_log::AuditKind::KeyDerived, buffer.id, u64::from(iterations), status);
+    status
+}
+
+/// C FFI statistics for a key-derivation service
+#[repr(C)]
+#[derive(Default)]
+pub struct CSecureKdfStats {
+    pub submitted: u64,
+    pub completed: u64,
+    pub rejected: u64,
+    pub queued: u64,
+    pub workers: u64,
+}
+
+/// Completion callback: the job and the registered user data, called on a worker thread
+pub type CSecureKdfCallback = Option<unsafe extern "C" fn(job: *mut c_void, user_data: *mut c_void)>;
+
+/// C FFI: Start a key-derivation service with `workers` threads (0 = half the cores),
+/// at most `max_queue` waiting jobs and a cap on iterations (0 = default)
+#[no_mangle]
+pub extern "C" fn securebuffer_kdf_service_new(workers: usize, max_queue: usize, max_iterations: u32) -> *mut c_void {
+    match secure_kdf::KdfService::new(workers, max_queue, max_iterations) {
+        Ok(service) => Box::into_raw(Box::new(service)) as *mut c_void,
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: Queue a PBKDF2-HMAC-SHA256 derivation of `out_len` bytes. The password is not
+/// retained past this call. SECUREBUFFER_ERROR_QUEUE_FULL or _POLICY_VIOLATION (iteration
+/// cap) are returned immediately instead of waiting.
+#[no_mangle]
+/// # Safety
+///
+/// `service` must come from `securebuffer_kdf_service_new`; `password` and `salt` must be
+/// readable for their lengths and `job_out` writable. `callback`, if set, runs on a worker
+/// thread and must not block or free the service. Free the job with `securebuffer_kdf_job_free`.
+pub unsafe extern "C" fn securebuffer_kdf_submit(
+    service: *const c_void,
+    password: *const u8,
+    password_len: usize,
+    salt: *const u8,
+    salt_len: usize,
+    iterations: u32,
+    out_len: usize,
+    callback: CSecureKdfCallback,
+    user_data: *mut c_void,
+    job_out: *mut *mut c_void,
+) -> c_int {
+    if service.is_null() || job_out.is_null() || (password.is_null() && password_len > 0) || (salt.is_null() && salt_len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let service = &*(service as *const secure_kdf::KdfService);
+    let password = if password_len == 0 { &[][..] } else { std::slice::from_raw_parts(password, password_len) };
+    let salt = if salt_len == 0 { &[][..] } else { std::slice::from_raw_parts(salt, salt_len) };
+    let user_data = user_data as usize;
+    let callback = callback.map(|cb| -> secure_kdf::KdfCallback {
+        Box::new(move |job| unsafe { cb(job as *const secure_kdf::KdfJob as *mut c_void, user_data as *mut c_void) })
+    });
+
+    match service.submit(password, salt, iterations, out_len, callback) {
+        Ok(job) => {
+            *job_out = Arc::into_raw(job) as *mut c_void;
+            SECUREBUFFER_SUCCESS
+        }
+        Err(secure_kdf::KdfError::QueueFull) => SECUREBUFFER_ERROR_QUEUE_FULL,
+        Err(secure_kdf::KdfError::CostExceeded) => SECUREBUFFER_ERROR_POLICY_VIOLATION,
+        Err(secure_kdf::KdfError::InvalidInput) => SECUREBUFFER_ERROR_INVALID_SIZE,
+    }
+}
+
+/// C FFI: 1 when the job's key is ready, 0 while pending, -1 for a null job
+#[no_mangle]
+/// # Safety
+///
+/// `job` must come from `securebuffer_kdf_submit`.
+pub unsafe extern "C" fn securebuffer_kdf_poll(job: *const c_void) -> c_int {
+    if job.is_null() {
+        return -1;
+    }
+    (*(job as *const secure_kdf::KdfJob)).is_ready() as c_int
+}
+
+/// C FFI: Wait up to `timeout_ms` (0 = forever) for the job; SECUREBUFFER_ERROR_EXPIRED on timeout
+#[no_mangle]
+/// # Safety
+///
+/// `job` must come from `securebuffer_kdf_submit`.
+pub unsafe extern "C" fn securebuffer_kdf_wait(job: *const c_void, timeout_ms: u64) -> c_int {
+    if job.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let timeout = (timeout_ms > 0).then(|| std::time::Duration::from_millis(timeout_ms));
+    if (*(job as *const secure_kdf::KdfJob)).wait(timeout) {
+        SECUREBUFFER_SUCCESS
+    } else {
+        SECUREBUFFER_ERROR_EXPIRED
+    }
+}
+
+/// C FFI: Move the derived key into `dest` (capacity at least out_len) and wipe the job's
+/// copy. SECUREBUFFER_ERROR_EXPIRED while pending or after the key was already taken.
+#[no_mangle]
+/// # Safety
+///
+/// `job` must come from `securebuffer_kdf_submit` and `dest` must be a valid buffer.
+pub unsafe extern "C" fn securebuffer_kdf_take(job: *const c_void, dest: *mut c_void) -> c_int {
+    if job.is_null() || dest.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    match (*(job as *const secure_kdf::KdfJob)).take_into(&mut *(dest as *mut SecureBuffer)) {
+        Some(Ok(())) => SECUREBUFFER_SUCCESS,
+        Some(Err(_)) => SECUREBUFFER_ERROR_BUFFER_OVERFLOW,
+        None => SECUREBUFFER_ERROR_EXPIRED,
+    }
+}
+
+/// C FFI: Release a job handle; a job still running completes and is then discarded
+#[no_mangle]
+/// # Safety
+///
+/// `job` must come from `securebuffer_kdf_submit` (or be null) and is freed only once.
+pub unsafe extern "C" fn securebuffer_kdf_job_free(job: *mut c_void) {
+    if !job.is_null() {
+        drop(Arc::from_raw(job as *const secure_kdf::KdfJob));
+    }
+}
+
+/// C FFI: Snapshot a service's counters into `stats`; 0 on success, -1 on null
+#[no_mangle]
+/// # Safety
+///
+/// `service` must come from `securebuffer_kdf_service_new`; `stats` must be writable.
+pub unsafe extern "C" fn securebuffer_kdf_get_stats(service: *const c_void, stats: *mut CSecureKdfStats) -> c_int {
+    if service.is_null() || stats.is_null() {
+        return -1;
+    }
+    let s = (*(service as *const secure_kdf::KdfService)).stats();
+    *stats = CSecureKdfStats {
+        submitted: s.submitted,
+        completed: s.completed,
+        rejected: s.rejected,
+        queued: s.queued,
+        workers: s.workers,
+    };
     0
 }
 
-/// C FFI: Check if audit logging is enabled
+/// C FFI: Stop a service after its queued jobs finish
+#[no_mangle]
+/// # Safety
+///
+/// `service` must come from `securebuffer_kdf_service_new` (or be null) and is freed only
+/// once, never from a completion callback.
+pub unsafe extern "C" fn securebuffer_kdf_service_free(service: *mut c_void) {
+    if !service.is_null() {
+        let _ = Box::from_raw(service as *mut secure_kdf::KdfService);
+    }
+}
+
+/// Channel pool errors as FFI status codes
+fn channel_status(error: secure_channel_pool::ChannelError) -> c_int {
+    use secure_channel_pool::ChannelError;
+    match error {
+        ChannelError::FrameTooLarge | ChannelError::InvalidEndpoint => SECUREBUFFER_ERROR_INVALID_SIZE,
+        ChannelError::ResponseTooLarge => SECUREBUFFER_ERROR_BUFFER_OVERFLOW,
+        ChannelError::QueueFull | ChannelError::Exhausted => SECUREBUFFER_ERROR_QUEUE_FULL,
+        ChannelError::CircuitOpen => SECUREBUFFER_ERROR_POLICY_VIOLATION,
+        ChannelError::TimedOut => SECUREBUFFER_ERROR_EXPIRED,
+        ChannelError::NoRoots | ChannelError::Io(_) | ChannelError::Closed => SECUREBUFFER_ERROR_CRYPTO_OPERATION_FAILED,
+    }
+}
+
+/// Completion callback: the request and the registered user data, called on a pool thread
+pub type CSecureChannelCallback = Option<unsafe extern "C" fn(request: *mut c_void, user_data: *mut c_void)>;
+
+/// C FFI: Open a pool of up to `max_connections` (0 = 100) TLS channels to `endpoint`
+/// (`host:port`), verified against the platform's root certificates, and start opening
+/// 10 idle ones. Null on a bad endpoint or when no roots can be loaded.
+#[no_mangle]
+/// # Safety
+///
+/// `endpoint` must be a valid NUL-terminated string. Free the pool with `securechannel_pool_free`.
+pub unsafe extern "C" fn securechannel_pool_new(max_connections: usize, endpoint: *const c_char) -> *mut c_void {
+    if endpoint.is_null() {
+        return std::ptr::null_mut();
+    }
+    let Ok(endpoint) = CStr::from_ptr(endpoint).to_str() else {
+        return std::ptr::null_mut();
+    };
+    let mut config = secure_channel_pool::ChannelPoolConfig::default();
+    if max_connections > 0 {
+        config.max_connections = max_connections;
+    }
+    match secure_channel_pool::SecureChannelPool::new(endpoint, config) {
+        Ok(pool) => Box::into_raw(Box::new(pool)) as *mut c_void,
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI pool options; zero sizes and timeouts take the `securechannel_pool_new` defaults
+#[repr(C)]
+#[derive(Default)]
+pub struct CSecureChannelPoolOptions {
+    pub max_connections: usize,
+    /// Channels opened at creation and kept idle by the health task; 0 = none
+    pub min_idle: usize,
+    pub pipeline_depth: usize,
+    pub connect_timeout_ms: u32,
+    /// Let the *_idempotent calls send as 0-RTT early data
+    pub enable_early_data: bool,
+    /// Block up to this long for the min_idle handshakes; 0 = return at once
+    pub prewarm_wait_ms: u32,
+}
+
+/// C FFI: Open a pool with explicit options; null options behave like `securechannel_pool_new(0, endpoint)`
+#[no_mangle]
+/// # Safety
+///
+/// `endpoint` must be a valid NUL-terminated string and `options` null or readable. Free
+/// the pool with `securechannel_pool_free`.
+pub unsafe extern "C" fn securechannel_pool_new_with_options(endpoint: *const c_char, options: *const CSecureChannelPoolOptions) -> *mut c_void {
+    if endpoint.is_null() {
+        return std::ptr::null_mut();
+    }
+    let Ok(endpoint) = CStr::from_ptr(endpoint).to_str() else {
+        return std::ptr::null_mut();
+    };
+    let mut config = secure_channel_pool::ChannelPoolConfig::default();
+    if let Some(options) = options.as_ref() {
+        if options.max_connections > 0 {
+            config.max_connections = options.max_connections;
+        }
+        if options.pipeline_depth > 0 {
+            config.pipeline_depth = options.pipeline_depth;
+        }
+        if options.connect_timeout_ms > 0 {
+            config.connect_timeout = std::time::Duration::from_millis(u64::from(options.connect_timeout_ms));
+        }
+        config.min_idle = options.min_idle;
+        config.enable_early_data = options.enable_early_data;
+        config.prewarm_wait = std::time::Duration::from_millis(u64::from(options.prewarm_wait_ms));
+    }
+    match secure_channel_pool::SecureChannelPool::new(endpoint, config) {
+        Ok(pool) => Box::into_raw(Box::new(pool)) as *mut c_void,
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: Close every channel; requests still queued complete with an error
+#[no_mangle]
+/// # Safety
+///
+/// `pool` must come from `securechannel_pool_new` (or be null) and is freed only once,
+/// never from a completion callback.
+pub unsafe extern "C" fn securechannel_pool_free(pool: *mut c_void) {
+    if !pool.is_null() {
+        let _ = Box::from_raw(pool as *mut secure_channel_pool::SecureChannelPool);
+    }
+}
+
+/// C FFI: Send one framed request and block until its response is in `response`
+#[no_mangle]
+/// # Safety
+///
+/// `pool` must come from `securechannel_pool_new`, `data` must be readable for `len` bytes
+/// and `response` must be a valid buffer. Not callable from a completion callback.
+pub unsafe extern "C" fn securechannel_pool_send(pool: *const c_void, data: *const u8, len: usize, response: *mut c_void) -> c_int {
+    channel_send(pool, data, len, false, response)
+}
+
+/// C FFI: `securechannel_pool_send` for a request that is safe to process twice: on a new
+/// channel it may travel as 0-RTT early data, which an attacker can replay
+#[no_mangle]
+/// # Safety
+///
+/// Same as `securechannel_pool_send`.
+pub unsafe extern "C" fn securechannel_pool_send_idempotent(pool: *const c_void, data: *const u8, len: usize, response: *mut c_void) -> c_int {
+    channel_send(pool, data, len, true, response)
+}
+
+unsafe fn channel_send(pool: *const c_void, data: *const u8, len: usize, idempotent: bool, response: *mut c_void) -> c_int {
+    if pool.is_null() || response.is_null() || (data.is_null() && len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let pool = &*(pool as *const secure_channel_pool::SecureChannelPool);
+    let data = if len == 0 { Vec::new() } else { std::slice::from_raw_parts(data, len).to_vec() };
+    let submitted = if idempotent { pool.submit_idempotent(data, None) } else { pool.submit(data, None) };
+    let request = match submitted {
+        Ok(request) => request,
+        Err(e) => return channel_status(e),
+    };
+    request.wait(None);
+    match request.take_into(&mut *(response as *mut SecureBuffer)) {
+        Some(Ok(())) => SECUREBUFFER_SUCCESS,
+        Some(Err(e)) => channel_status(e),
+        None => SECUREBUFFER_ERROR_EXPIRED,
+    }
+}
+
+/// C FFI: Queue a request for the pipelined dispatcher without blocking.
+/// SECUREBUFFER_ERROR_QUEUE_FULL when the submission queue is full.
+#[no_mangle]
+/// # Safety
+///
+/// `pool` must come from `securechannel_pool_new`; `data` must be readable for `len` bytes
+/// and `request_out` writable. `callback`, if set, runs on a pool thread and must not block
+/// or free the pool. Free the request with `securechannel_request_free`.
+pub unsafe extern "C" fn securechannel_pool_submit(
+    pool: *const c_void,
+    data: *const u8,
+    len: usize,
+    callback: CSecureChannelCallback,
+    user_data: *mut c_void,
+    request_out: *mut *mut c_void,
+) -> c_int {
+    channel_submit(pool, data, len, false, callback, user_data, request_out)
+}
+
+/// C FFI: `securechannel_pool_submit` for a request that is safe to process twice; see
+/// `securechannel_pool_send_idempotent`
+#[no_mangle]
+/// # Safety
+///
+/// Same as `securechannel_pool_submit`.
+pub unsafe extern "C" fn securechannel_pool_submit_idempotent(
+    pool: *const c_void,
+    data: *const u8,
+    len: usize,
+    callback: CSecureChannelCallback,
+    user_data: *mut c_void,
+    request_out: *mut *mut c_void,
+) -> c_int {
+    channel_submit(pool, data, len, true, callback, user_data, request_out)
+}
+
+unsafe fn channel_submit(
+    pool: *const c_void,
+    data: *const u8,
+    len: usize,
+    idempotent: bool,
+    callback: CSecureChannelCallback,
+    user_data: *mut c_void,
+    request_out: *mut *mut c_void,
+) -> c_int {
+    if pool.is_null() || request_out.is_null() || (data.is_null() && len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let pool = &*(pool as *const secure_channel_pool::SecureChannelPool);
+    let data = if len == 0 { Vec::new() } else { std::slice::from_raw_parts(data, len).to_vec() };
+    let user_data = user_data as usize;
+    let callback = callback.map(|cb| -> secure_channel_pool::ChannelCallback {
+        Box::new(move |request| unsafe {
+            cb(request as *const secure_channel_pool::ChannelRequest as *mut c_void, user_data as *mut c_void)
+        })
+    });
+    let submitted = if idempotent { pool.submit_idempotent(data, callback) } else { pool.submit(data, callback) };
+    match submitted {
+        Ok(request) => {
+            *request_out = Arc::into_raw(request) as *mut c_void;
+            SECUREBUFFER_SUCCESS
+        }
+        Err(e) => channel_status(e),
+    }
+}
+
+/// C FFI: 1 when the request has completed (response or error), 0 while pending, -1 for null
+#[no_mangle]
+/// # Safety
+///
+/// `request` must come from `securechannel_pool_submit`.
+pub unsafe extern "C" fn securechannel_request_poll(request: *const c_void) -> c_int {
+    if request.is_null() {
+        return -1;
+    }
+    (*(request as *const secure_channel_pool::ChannelRequest)).is_ready() as c_int
+}
+
+/// C FFI: Wait up to `timeout_ms` (0 = forever) for the request; SECUREBUFFER_ERROR_EXPIRED on timeout
+#[no_mangle]
+/// # Safety
+///
+/// `request` must come from `securechannel_pool_submit`.
+pub unsafe extern "C" fn securechannel_request_wait(request: *const c_void, timeout_ms: u64) -> c_int {
+    if request.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let timeout = (timeout_ms > 0).then(|| std::time::Duration::from_millis(timeout_ms));
+    if (*(request as *const secure_channel_pool::ChannelRequest)).wait(timeout) {
+        SECUREBUFFER_SUCCESS
+    } else {
+        SECUREBUFFER_ERROR_EXPIRED
+    }
+}
+
+/// C FFI: Move the response into `response` and wipe the request's copy, or return the
+/// request's failure. SECUREBUFFER_ERROR_EXPIRED while pending or once already taken.
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-pub unsafe extern "C" fn securebuffer_is_audit_logging_enabled(buffer: *mut c_void) -> c_int {
-    if buffer.is_null() {
-        return 0;
+/// `request` must come from `securechannel_pool_submit` and `response` must be a valid buffer.
+pub unsafe extern "C" fn securechannel_request_take(request: *const c_void, response: *mut c_void) -> c_int {
+    if request.is_null() || response.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    match (*(request as *const secure_channel_pool::ChannelRequest)).take_into(&mut *(response as *mut SecureBuffer)) {
+        Some(Ok(())) => SECUREBUFFER_SUCCESS,
+        Some(Err(e)) => channel_status(e),
+        None => SECUREBUFFER_ERROR_EXPIRED,
     }
-    let buffer = &*(buffer as *mut SecureBuffer);
-    if buffer.is_audit_logging_enabled() { 1 } else { 0 }
 }
 
-/// C FFI: Bind to hardware
+/// C FFI: Release a request handle; a request still in flight completes and is then discarded
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-pub unsafe extern "C" fn securebuffer_bind_to_hardware(buffer: *mut c_void) -> c_int {
-    if buffer.is_null() {
-        return -1;
+/// `request` must come from `securechannel_pool_submit` (or be null) and is freed only once.
+pub unsafe extern "C" fn securechannel_request_free(request: *mut c_void) {
+    if !request.is_null() {
+        drop(Arc::from_raw(request as *const secure_channel_pool::ChannelRequest));
     }
-    let buffer = &mut *(buffer as *mut SecureBuffer);
-    match buffer.bind_to_hardware() {
-        Ok(_) => 0,
-        Err(_) => -1,
+}
+
+/// C FFI: False while the circuit breaker is open or most requests are failing
+#[no_mangle]
+/// # Safety
+///
+/// `pool` must come from `securechannel_pool_new`.
+pub unsafe extern "C" fn securechannel_pool_is_healthy(pool: *const c_void) -> bool {
+    !pool.is_null() && (*(pool as *const secure_channel_pool::SecureChannelPool)).is_healthy()
+}
+
+/// C FFI: Pool counters as a JSON object; free with `securebuffer_free_cstr`
+#[no_mangle]
+/// # Safety
+///
+/// `pool` must come from `securechannel_pool_new`.
+pub unsafe extern "C" fn securechannel_pool_get_status_json(pool: *const c_void) -> *mut c_char {
+    if pool.is_null() {
+        return std::ptr::null_mut();
     }
+    let json = (*(pool as *const secure_channel_pool::SecureChannelPool)).status_json();
+    CString::new(json).map(CString::into_raw).unwrap_or(std::ptr::null_mut())
 }
 
-/// C FFI: Check if hardware backed
+/// C FFI: Share of requests that succeeded, 0.0 while the circuit breaker is open
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-pub unsafe extern "C" fn securebuffer_is_hardware_backed(buffer: *mut c_void) -> c_int {
-    if buffer.is_null() {
-        return 0;
+/// `pool` must come from `securechannel_pool_new`.
+pub unsafe extern "C" fn securechannel_pool_get_health_score(pool: *const c_void) -> f64 {
+    if pool.is_null() {
+        return 0.0;
     }
-    let buffer = &*(buffer as *mut SecureBuffer);
-    if buffer.is_hardware_backed() { 1 } else { 0 }
+    (*(pool as *const secure_channel_pool::SecureChannelPool)).health_score()
 }
 
-/// C FFI: Enable tamper detection
+/// Ring status: full (bounded push timed out) and empty (bounded read timed out) are
+/// reported as QUEUE_FULL and EXPIRED
+#[cfg(target_os = "linux")]
+fn ring_status(result: Result<(), shm_ring::RingError>) -> c_int {
+    match result {
+        Ok(()) => SECUREBUFFER_SUCCESS,
+        Err(shm_ring::RingError::Full) => SECUREBUFFER_ERROR_QUEUE_FULL,
+        Err(shm_ring::RingError::RecordTooLarge) => SECUREBUFFER_ERROR_BUFFER_OVERFLOW,
+        Err(shm_ring::RingError::InvalidCapacity) => SECUREBUFFER_ERROR_INVALID_SIZE,
+        Err(shm_ring::RingError::Corrupt) => SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED,
+        Err(shm_ring::RingError::Incompatible | shm_ring::RingError::Os(_)) => SECUREBUFFER_ERROR_ZERO_COPY_FAILED,
+    }
+}
+
+/// 0 never waits, u64::MAX waits forever
+#[cfg(target_os = "linux")]
+fn ring_timeout(timeout_ms: u64) -> Option<std::time::Duration> {
+    (timeout_ms != u64::MAX).then(|| std::time::Duration::from_millis(timeout_ms))
+}
+
+/// C FFI: Create a shared ring with `capacity` data bytes (power of two, 4 KiB..1 GiB);
+/// `mpsc` allows producers in several threads or processes. Null on failure.
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub extern "C" fn securebuffer_ring_create(capacity: usize, mpsc: bool) -> *mut c_void {
+    let mode = if mpsc { shm_ring::RingMode::Mpsc } else { shm_ring::RingMode::Spsc };
+    match shm_ring::ShmRing::create(capacity, mode) {
+        Ok(ring) => Box::into_raw(Box::new(ring)) as *mut c_void,
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: Map a ring from an fd passed by its creator (SCM_RIGHTS or /proc/<pid>/fd/<n>).
+/// The fd is duplicated; the caller still owns it. Null if it is not a sealed ring.
+#[cfg(target_os = "linux")]
+#[no_mangle]
+pub extern "C" fn securebuffer_ring_attach(fd: c_int) -> *mut c_void {
+    match shm_ring::ShmRing::attach(fd) {
+        Ok(ring) => Box::into_raw(Box::new(ring)) as *mut c_void,
+        Err(_) => std::ptr::null_mut(),
+    }
+}
+
+/// C FFI: The ring's memfd, valid until the ring is freed; -1 for a null ring
+#[cfg(target_os = "linux")]
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-pub unsafe extern "C" fn securebuffer_enable_tamper_detection(buffer: *mut c_void) -> c_int {
-    if buffer.is_null() {
+/// `ring` must come from `securebuffer_ring_create` or `securebuffer_ring_attach`.
+pub unsafe extern "C" fn securebuffer_ring_fd(ring: *const c_void) -> c_int {
+    if ring.is_null() {
         return -1;
     }
-    let buffer = &mut *(buffer as *mut SecureBuffer);
-    match buffer.enable_tamper_detection() {
-        Ok(_) => 0,
-        Err(_) => -1,
-    }
+    (*(ring as *const shm_ring::ShmRing)).fd()
 }
 
-/// C FFI: Check if tampered
+/// C FFI: Append one record, waiting up to `timeout_ms` for room (0 = fail fast with
+/// SECUREBUFFER_ERROR_QUEUE_FULL, UINT64_MAX = forever)
+#[cfg(target_os = "linux")]
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-pub unsafe extern "C" fn securebuffer_is_tampered(buffer: *mut c_void) -> c_int {
-    if buffer.is_null() {
-        return 1; // Consider null as tampered
+/// `ring` must be a valid ring handle and `data` readable for `len` bytes.
+pub unsafe extern "C" fn securebuffer_ring_push(ring: *const c_void, data: *const u8, len: usize, timeout_ms: u64) -> c_int {
+    if ring.is_null() || (data.is_null() && len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
     }
-    let buffer = &*(buffer as *mut SecureBuffer);
-    if buffer.is_tampered() { 1 } else { 0 }
+    let data = if len == 0 { &[][..] } else { std::slice::from_raw_parts(data, len) };
+    ring_status((*(ring as *const shm_ring::ShmRing)).push(data, ring_timeout(timeout_ms)))
 }
 
-/// C FFI: Enable side channel protection
+/// C FFI: Append the concatenation of `count` buffers as one record, e.g. a header and a
+/// payload without joining them first
+#[cfg(target_os = "linux")]
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-pub unsafe extern "C" fn securebuffer_enable_side_channel_protection(buffer: *mut c_void) -> c_int {
-    if buffer.is_null() {
-        return -1;
+/// `ring` must be a valid ring handle; `iov` must hold `count` entries, each readable for its length.
+pub unsafe extern "C" fn securebuffer_ring_push_iov(
+    ring: *const c_void,
+    iov: *const CSecureBufferIoVec,
+    count: usize,
+    timeout_ms: u64,
+) -> c_int {
+    if ring.is_null() || (iov.is_null() && count > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
     }
-    let buffer = &mut *(buffer as *mut SecureBuffer);
-    match buffer.enable_side_channel_protection() {
-        Ok(_) => 0,
-        Err(_) => -1,
+    let iov = if count == 0 { &[][..] } else { std::slice::from_raw_parts(iov, count) };
+    if iov.iter().any(|v| v.base.is_null() && v.len > 0) {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
     }
+    let parts: Vec<&[u8]> = iov.iter()
+        .filter(|v| v.len > 0)
+        .map(|v| std::slice::from_raw_parts(v.base as *const u8, v.len))
+        .collect();
+    ring_status((*(ring as *const shm_ring::ShmRing)).push_vectored(&parts, ring_timeout(timeout_ms)))
 }
 
-/// C FFI: Set enterprise policy
+/// C FFI: Consumer only. Wait up to `timeout_ms` for records, then describe up to `max` of
+/// them in `out` as pointers into the shared mapping, without copying. They stay valid
+/// until `securebuffer_ring_commit_read`. SECUREBUFFER_ERROR_EXPIRED when none arrived,
+/// SECUREBUFFER_ERROR_INTEGRITY_CHECK_FAILED once a producer has written a malformed record.
+#[cfg(target_os = "linux")]
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer and `policy` must be a valid NUL-terminated C string.
-pub unsafe extern "C" fn securebuffer_set_enterprise_policy(buffer: *mut c_void, policy: *const c_char) -> c_int {
-    if buffer.is_null() || policy.is_null() {
-        return -1;
+/// `ring` must be a valid ring handle used by a single consumer; `out` must hold `max`
+/// entries and `count` be writable. The records must not be written through.
+pub unsafe extern "C" fn securebuffer_ring_read_batch(
+    ring: *const c_void,
+    out: *mut CSecureBufferIoVec,
+    max: usize,
+    timeout_ms: u64,
+    count: *mut usize,
+) -> c_int {
+    if ring.is_null() || out.is_null() || count.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
     }
-    let buffer = &mut *(buffer as *mut SecureBuffer);
-    let policy_cstr = CStr::from_ptr(policy);
-    match policy_cstr.to_str() {
-        Ok(policy_str) => {
-            match buffer.set_enterprise_policy(policy_str) {
-                Ok(_) => 0,
-                Err(_) => -1,
-            }
-        },
-        Err(_) => -1,
+    let mut records = Vec::with_capacity(max.min(256));
+    let n = match (*(ring as *const shm_ring::ShmRing)).wait_batch(max, ring_timeout(timeout_ms), &mut records) {
+        Ok(n) => n,
+        Err(e) => {
+            *count = 0;
+            return ring_status(Err(e));
+        }
+    };
+    for (i, &(base, len)) in records.iter().enumerate() {
+        *out.add(i) = CSecureBufferIoVec { base: base as *mut u8, len };
     }
+    *count = n;
+    if n == 0 { SECUREBUFFER_ERROR_EXPIRED } else { SECUREBUFFER_SUCCESS }
 }
 
-/// C FFI: Validate policy compliance
+/// C FFI: Consumer only. Wipe and free every record returned by earlier read batches.
+#[cfg(target_os = "linux")]
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-pub unsafe extern "C" fn securebuffer_validate_policy_compliance(buffer: *mut c_void) -> c_int {
-    if buffer.is_null() {
-        return -1;
+/// `ring` must be a valid ring handle; pointers from earlier read batches become invalid.
+pub unsafe extern "C" fn securebuffer_ring_commit_read(ring: *const c_void) {
+    if !ring.is_null() {
+        (*(ring as *const shm_ring::ShmRing)).release();
     }
-    let buffer = &*(buffer as *mut SecureBuffer);
-    if buffer.validate_policy_compliance() { 0 } else { -1 }
 }
 
-/// C FFI: Get compliance report
+/// C FFI: Unmap a ring and close its fd; the memory lives on while other processes map it
+#[cfg(target_os = "linux")]
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-/// Caller receives ownership of the returned C string and must free it with `securebuffer_free_cstr`.
-pub unsafe extern "C" fn securebuffer_get_compliance_report(buffer: *mut c_void) -> *mut c_char {
-    if buffer.is_null() {
-        return std::ptr::null_mut();
+/// `ring` must be a ring handle (or null) and is freed only once.
+pub unsafe extern "C" fn securebuffer_ring_free(ring: *mut c_void) {
+    if !ring.is_null() {
+        let _ = Box::from_raw(ring as *mut shm_ring::ShmRing);
     }
-    let buffer = &*(buffer as *mut SecureBuffer);
-    let report = buffer.get_compliance_report();
-    match CString::new(report) {
-        Ok(c_str) => c_str.into_raw(),
-        Err(_) => std::ptr::null_mut(),
+}
+
+/// C FFI: Free C string
+#[no_mangle]
+/// # Safety
+///
+/// `ptr` must be a pointer previously returned by one of the functions that returns a C string
+/// (ownership is transferred to the caller). After this call the pointer must not be used.
+pub unsafe extern "C" fn securebuffer_free_cstr(ptr: *mut c_char) {
+    if !ptr.is_null() {
+        let _ = CString::from_raw(ptr);
     }
 }
 
-/// C FFI: Get security audit log
+// ============================================================================
+// SECUREBUFFER POOL C FFI EXPORTS
+// ============================================================================
+
+/// Global metrics, mirrors `SecureBufferMetrics` in securebuffer.h
+#[repr(C)]
+#[derive(Default)]
+pub struct CSecureBufferMetrics {
+    pub total_allocations: u64,
+    pub total_deallocations: u64,
+    pub current_active_buffers: u64,
+    pub peak_active_buffers: u64,
+    pub total_bytes_allocated: u64,
+    pub total_bytes_deallocated: u64,
+    pub integrity_checks_performed: u64,
+    pub integrity_check_failures: u64,
+    pub average_operation_time_ns: f64,
+    pub crypto_operations_count: u64,
+    pub hardware_operations_count: u64,
+    pub batch_operations_count: u64,
+    pub zero_copy_operations_count: u64,
+    pub tamper_detection_events: u64,
+    pub side_channel_protection_activations: u64,
+    pub pool_acquisitions: u64,
+    pub pool_releases: u64,
+    pub pool_exhaustions: u64,
+    pub pool_bytes_locked: u64,
+}
+
+/// Pool statistics, mirrors `SecureBufferPoolStats` in securebuffer.h
+#[repr(C)]
+pub struct CSecureBufferPoolStats {
+    pub acquisitions: u64,
+    pub releases: u64,
+    pub exhaustions: u64,
+    pub invalid_releases: u64,
+    pub in_use: u64,
+    pub bytes_reserved: u64,
+    pub bytes_locked: u64,
+}
+
+/// Process-wide counters with the crypto call count and mean latency taken from `ops`
+fn global_metrics(ops: &[op_metrics::LatencySummary; op_metrics::METRIC_OP_COUNT]) -> CSecureBufferMetrics {
+    use op_metrics::{Counter, MetricOp};
+
+    let pool = &secure_pool::GLOBAL_POOL_COUNTERS;
+    let integrity = &buffer_integrity::GLOBAL_INTEGRITY_COUNTERS;
+    let crypto = [MetricOp::Hmac, MetricOp::Aead, MetricOp::Derive].map(|op| ops[op as usize]);
+    let (samples, sum_ns) = ops.iter().fold((0, 0), |(n, sum), op| (n + op.samples, sum + op.sum_ns));
+    CSecureBufferMetrics {
+        total_allocations: op_metrics::counter(Counter::Allocations),
+        total_deallocations: op_metrics::counter(Counter::Deallocations),
+        current_active_buffers: BUFFER_COUNTERS.active.load(Ordering::Relaxed),
+        peak_active_buffers: BUFFER_COUNTERS.peak_active.load(Ordering::Relaxed),
+        total_bytes_allocated: op_metrics::counter(Counter::BytesAllocated),
+        total_bytes_deallocated: op_metrics::counter(Counter::BytesDeallocated),
+        crypto_operations_count: crypto.iter().map(|op| op.count).sum(),
+        average_operation_time_ns: if samples == 0 { 0.0 } else { sum_ns as f64 / samples as f64 },
+        pool_acquisitions: pool.acquisitions.load(Ordering::Relaxed),
+        pool_releases: pool.releases.load(Ordering::Relaxed),
+        pool_exhaustions: pool.exhaustions.load(Ordering::Relaxed),
+        pool_bytes_locked: pool.bytes_locked.load(Ordering::Relaxed),
+        integrity_checks_performed: integrity.chunks_verified.load(Ordering::Relaxed),
+        integrity_check_failures: integrity.failures.load(Ordering::Relaxed),
+        tamper_detection_events: integrity.tamper_events.load(Ordering::Relaxed),
+        ..Default::default()
+    }
+}
+
+fn latency_summaries() -> [op_metrics::LatencySummary; op_metrics::METRIC_OP_COUNT] {
+    op_metrics::MetricOp::ALL.map(op_metrics::summary)
+}
+
+/// C FFI: Process-wide buffer and pool counters
+#[no_mangle]
+pub extern "C" fn securebuffer_get_global_metrics() -> CSecureBufferMetrics {
+    global_metrics(&latency_summaries())
+}
+
+/// Per-operation latency, mirrors `SecureBufferLatency` in securebuffer.h
+#[repr(C)]
+#[derive(Default, Clone, Copy)]
+pub struct CSecureBufferLatency {
+    pub count: u64,
+    pub samples: u64,
+    pub sum_ns: u64,
+    pub max_ns: u64,
+    pub p50_ns: u64,
+    pub p99_ns: u64,
+    pub p999_ns: u64,
+}
+
+/// Totals plus one latency entry per `SecureBufferOp`, mirrors `SecureBufferMetricsSnapshot`
+#[repr(C)]
+pub struct CSecureBufferMetricsSnapshot {
+    pub totals: CSecureBufferMetrics,
+    pub ops: [CSecureBufferLatency; op_metrics::METRIC_OP_COUNT],
+}
+
+/// C FFI: Fill `out` with every counter and per-operation percentiles. Merges the
+/// per-thread shards on the stack and allocates nothing, so it is safe to poll often.
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer returned by `securebuffer_new_with_security_level` or related constructors.
-/// Caller receives ownership of the returned C string and must free it with `securebuffer_free_cstr`.
-pub unsafe extern "C" fn securebuffer_get_security_audit_log(buffer: *mut c_void) -> *mut c_char {
-    if buffer.is_null() {
-        return std::ptr::null_mut();
+/// `out` must be a valid pointer to a `SecureBufferMetricsSnapshot`.
+pub unsafe extern "C" fn securebuffer_get_metrics_snapshot(out: *mut CSecureBufferMetricsSnapshot) -> c_int {
+    if out.is_null() {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
     }
-    let buffer = &*(buffer as *mut SecureBuffer);
-    let log = buffer.get_security_audit_log();
-    match CString::new(log) {
-        Ok(c_str) => c_str.into_raw(),
+    let ops = latency_summaries();
+    out.write(CSecureBufferMetricsSnapshot {
+        totals: global_metrics(&ops),
+        ops: ops.map(|op| CSecureBufferLatency {
+            count: op.count,
+            samples: op.samples,
+            sum_ns: op.sum_ns,
+            max_ns: op.max_ns,
+            p50_ns: op.p50_ns,
+            p99_ns: op.p99_ns,
+            p999_ns: op.p999_ns,
+        }),
+    });
+    SECUREBUFFER_SUCCESS
+}
+
+/// C FFI: Copy the aggregated latency histogram of `op` into `counts` and return the
+/// bucket count (`SECUREBUFFER_LATENCY_BUCKETS`), or a negative error. With a smaller
+/// `capacity` only the first buckets are copied.
+#[no_mangle]
+/// # Safety
+///
+/// `counts` must be writable for `capacity` elements, or null with `capacity` 0.
+pub unsafe extern "C" fn securebuffer_get_latency_histogram(op: c_int, counts: *mut u64, capacity: usize) -> c_int {
+    let Some(op) = op_metrics::MetricOp::from_raw(op) else {
+        return SECUREBUFFER_ERROR_INVALID_SIZE;
+    };
+    if counts.is_null() && capacity > 0 {
+        return SECUREBUFFER_ERROR_NULL_POINTER;
+    }
+    let mut buckets = [0u64; op_metrics::LATENCY_BUCKETS];
+    op_metrics::latency_histogram(op, &mut buckets);
+    let copied = capacity.min(buckets.len());
+    if copied > 0 {
+        std::ptr::copy_nonoverlapping(buckets.as_ptr(), counts, copied);
+    }
+    op_metrics::LATENCY_BUCKETS as c_int
+}
+
+/// C FFI: Largest latency in nanoseconds counted by histogram bucket `index`
+#[no_mangle]
+pub extern "C" fn securebuffer_latency_bucket_upper_ns(index: usize) -> u64 {
+    op_metrics::bucket_upper_ns(index.min(op_metrics::LATENCY_BUCKETS - 1))
+}
+
+/// C FFI: Buffer, pool and key-derivation metrics in Prometheus text format; free with
+/// `securebuffer_free_cstr`
+#[no_mangle]
+pub extern "C" fn securebuffer_get_prometheus_metrics() -> *mut c_char {
+    use std::fmt::Write as _;
+
+    let ops = latency_summaries();
+    let metrics = global_metrics(&ops);
+    let mut out = String::with_capacity(8192);
+    for (name, kind, help, value) in [
+        ("securebuffer_allocations_total", "counter", "SecureBuffers created", metrics.total_allocations),
+        ("securebuffer_deallocations_total", "counter", "SecureBuffers destroyed", metrics.total_deallocations),
+        ("securebuffer_active_buffers", "gauge", "Live SecureBuffers", metrics.current_active_buffers),
+        ("securebuffer_peak_active_buffers", "gauge", "Most SecureBuffers live at once", metrics.peak_active_buffers),
+        ("securebuffer_allocated_bytes_total", "counter", "Capacity allocated", metrics.total_bytes_allocated),
+        ("securebuffer_pool_acquisitions_total", "counter", "Pool slots handed out", metrics.pool_acquisitions),
+        ("securebuffer_pool_releases_total", "counter", "Pool slots returned", metrics.pool_releases),
+        ("securebuffer_pool_exhaustions_total", "counter", "Pool acquires refused because a class was full", metrics.pool_exhaustions),
+        ("securebuffer_pool_locked_bytes", "gauge", "Arena bytes pinned across all pools", metrics.pool_bytes_locked),
+        ("securebuffer_integrity_chunks_verified_total", "counter", "4 KiB chunks checked against their tags", metrics.integrity_checks_performed),
+        ("securebuffer_integrity_failures_total", "counter", "Chunk verifications that found a mismatch", metrics.integrity_check_failures),
+        ("securebuffer_tamper_events_total", "counter", "Buffers newly flagged as tampered", metrics.tamper_detection_events),
+    ] {
+        let _ = writeln!(out, "# HELP {name} {help}\n# TYPE {name} {kind}\n{name} {value}");
+    }
+    let name = "securebuffer_operation_latency_seconds";
+    let _ = writeln!(out, "# HELP {name} Operation latency by op, from per-thread histograms\n# TYPE {name} summary");
+    for (op, latency) in op_metrics::MetricOp::ALL.iter().zip(&ops) {
+        let op = op.name();
+        for (quantile, nanos) in [("0.5", latency.p50_ns), ("0.99", latency.p99_ns), ("0.999", latency.p999_ns)] {
+            let _ = writeln!(out, "{name}{{op=\"{op}\",quantile=\"{quantile}\"}} {:.9}", nanos as f64 / 1e9);
+        }
+        let _ = writeln!(out, "{name}_sum{{op=\"{op}\"}} {:.9}", latency.sum_ns as f64 / 1e9);
+        let _ = writeln!(out, "{name}_count{{op=\"{op}\"}} {}", latency.samples);
+    }
+    secure_kdf::GLOBAL_KDF_COUNTERS.write_prometheus(&mut out);
+    audit_log::GLOBAL_AUDIT_COUNTERS.write_prometheus(&mut out);
+
+    match CString::new(out) {
+        Ok(text) => text.into_raw(),
         Err(_) => std::ptr::null_mut(),
     }
 }
 
-/// C FFI: HMAC as hex
+/// C FFI: Create a buffer pool with `arena_bytes` of slots per size class (0 = 1 MiB)
+#[no_mangle]
+pub extern "C" fn securebuffer_pool_new(arena_bytes: usize) -> *mut c_void {
+    Box::into_raw(Box::new(secure_pool::SecureBufferPool::new(arena_bytes))) as *mut c_void
+}
+
+/// C FFI: Create a pool with `arena_bytes` of slots per size class on every NUMA node
+/// (0 = 1 MiB); threads acquire from their own node first. Free with `securebuffer_pool_free`.
+#[no_mangle]
+pub extern "C" fn securebuffer_pool_new_numa(arena_bytes: usize) -> *mut c_void {
+    Box::into_raw(Box::new(secure_pool::SecureBufferPool::new_numa(arena_bytes))) as *mut c_void
+}
+
+/// C FFI: Acquire a zeroed, locked slot of at least `size` bytes (at most 4096).
+/// Returns null when the size class is exhausted; fall back to `securebuffer_new`.
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer. `key` must point to `key_len` readable bytes.
-/// Caller receives ownership of the returned C string and must free it with `securebuffer_free_cstr`.
-pub unsafe extern "C" fn securebuffer_hmac_hex(buffer: *mut c_void, key: *const u8, key_len: usize) -> *mut c_char {
-    if buffer.is_null() || key.is_null() || key_len == 0 {
+/// `pool` must be a pointer returned by `securebuffer_pool_new`.
+pub unsafe extern "C" fn securebuffer_pool_acquire(pool: *const c_void, size: usize) -> *mut u8 {
+    if pool.is_null() {
         return std::ptr::null_mut();
     }
-    let buffer = &*(buffer as *mut SecureBuffer);
-    let key_slice = std::slice::from_raw_parts(key, key_len);
-    match buffer.hmac_hex(key_slice) {
-        Ok(hmac) => {
-            match CString::new(hmac) {
-                Ok(c_str) => c_str.into_raw(),
-                Err(_) => std::ptr::null_mut(),
-            }
-        },
-        Err(_) => std::ptr::null_mut(),
+    let pool = &*(pool as *const secure_pool::SecureBufferPool);
+    pool.acquire_raw(size).unwrap_or(std::ptr::null_mut())
+}
+
+/// C FFI: Zeroize and return a slot, 0 on success or -1 for a pointer that is not a live slot
+#[no_mangle]
+/// # Safety
+///
+/// `pool` must be a pointer returned by `securebuffer_pool_new`. `slot` is only compared
+/// against the pool's arenas before being written, so foreign pointers are rejected.
+pub unsafe extern "C" fn securebuffer_pool_release(pool: *const c_void, slot: *mut u8) -> c_int {
+    if pool.is_null() || slot.is_null() {
+        return -1;
+    }
+    let pool = &*(pool as *const secure_pool::SecureBufferPool);
+    match pool.release_raw(slot) {
+        Ok(()) => 0,
+        Err(_) => -1,
     }
 }
 
-/// C FFI: HMAC as base64url
+/// C FFI: Usable size of a slot, or 0 if `slot` does not belong to the pool
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid pointer. `key` must point to `key_len` readable bytes.
-/// Caller receives ownership of the returned C string and must free it with `securebuffer_free_cstr`.
-pub unsafe extern "C" fn securebuffer_hmac_base64url(buffer: *mut c_void, key: *const u8, key_len: usize) -> *mut c_char {
-    if buffer.is_null() || key.is_null() || key_len == 0 {
-        return std::ptr::null_mut();
+/// `pool` must be a pointer returned by `securebuffer_pool_new`.
+pub unsafe extern "C" fn securebuffer_pool_slot_size(pool: *const c_void, slot: *const u8) -> usize {
+    if pool.is_null() {
+        return 0;
     }
-    let buffer = &*(buffer as *mut SecureBuffer);
-    let key_slice = std::slice::from_raw_parts(key, key_len);
-    match buffer.hmac_base64url(key_slice) {
-        Ok(hmac) => {
-            match CString::new(hmac) {
-                Ok(c_str) => c_str.into_raw(),
-                Err(_) => std::ptr::null_mut(),
-            }
-        },
-        Err(_) => std::ptr::null_mut(),
+    (*(pool as *const secure_pool::SecureBufferPool)).slot_size(slot)
+}
+
+/// C FFI: Fill `stats` with the pool's counters
+#[no_mangle]
+/// # Safety
+///
+/// `pool` must be a pointer returned by `securebuffer_pool_new`; `stats` must be writable.
+pub unsafe extern "C" fn securebuffer_pool_get_stats(pool: *const c_void, stats: *mut CSecureBufferPoolStats) -> c_int {
+    if pool.is_null() || stats.is_null() {
+        return -1;
     }
+    let s = (*(pool as *const secure_pool::SecureBufferPool)).stats();
+    *stats = CSecureBufferPoolStats {
+        acquisitions: s.acquisitions,
+        releases: s.releases,
+        exhaustions: s.exhaustions,
+        invalid_releases: s.invalid_releases,
+        in_use: s.in_use,
+        bytes_reserved: s.bytes_reserved,
+        bytes_locked: s.bytes_locked,
+    };
+    0
 }
 
-/// C FFI: Free C string
+/// C FFI: Free a pool, zeroizing and unmapping its arenas
 #[no_mangle]
 /// # Safety
 ///
-/// `ptr` must be a pointer previously returned by one of the functions that returns a C string
-/// (ownership is transferred to the caller). After this call the pointer must not be used.
-pub unsafe extern "C" fn securebuffer_free_cstr(ptr: *mut c_char) {
-    if !ptr.is_null() {
-        let _ = CString::from_raw(ptr);
+/// `pool` must be a pointer returned by `securebuffer_pool_new` (or null). Every slot
+/// acquired from it becomes invalid.
+pub unsafe extern "C" fn securebuffer_pool_free(pool: *mut c_void) {
+    if !pool.is_null() {
+        let _ = Box::from_raw(pool as *mut secure_pool::SecureBufferPool);
     }
 }
 
@@ -1700,3 +4506,208 @@ pub extern "C" fn get_cpu_temperature_c() -> f32 {
         let _ = Box::from_raw(buffer as *mut SecureBuffer);
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_hmac_into_matches_string_variants() {
+        let mut buffer = SecureBuffer::new(64).unwrap();
+        buffer.write(b"GET /v1/blocks 1700000000").unwrap();
+        let key = b"request-signing-key";
+
+        let mut raw = [0u8; HMAC_DIGEST_LEN];
+        let mut text = [0u8; HMAC_HEX_LEN];
+        assert_eq!(buffer.hmac_into(key, &mut raw).unwrap(), HMAC_DIGEST_LEN);
+        assert_eq!(hex::encode(raw), buffer.hmac_hex(key).unwrap());
+        assert_eq!(buffer.hmac_hex_into(key, &mut text).unwrap(), HMAC_HEX_LEN);
+        assert_eq!(&text[..], buffer.hmac_hex(key).unwrap().as_bytes());
+        let n = buffer.hmac_base64url_into(key, &mut text).unwrap();
+        assert_eq!(n, HMAC_BASE64URL_LEN);
+        assert_eq!(&text[..n], buffer.hmac_base64url(key).unwrap().as_bytes());
+
+        // Short output reports the size needed
+        let mut short = [0u8; 16];
+        let mut needed = 0usize;
+        let ptr = &mut buffer as *mut SecureBuffer as *mut c_void;
+        let code = unsafe { securebuffer_hmac_hex_into(ptr, key.as_ptr(), key.len(), short.as_mut_ptr(), short.len(), &mut needed) };
+        assert_eq!((code, needed), (SECUREBUFFER_ERROR_BUFFER_OVERFLOW, HMAC_HEX_LEN));
+
+        let keys = [key.as_ptr(), b"second".as_ptr()];
+        let lens = [key.len(), 6];
+        let mut digests = [0u8; 2 * HMAC_DIGEST_LEN];
+        let code = unsafe { securebuffer_hmac_batch_into(ptr, keys.as_ptr(), lens.as_ptr(), 2, digests.as_mut_ptr(), digests.len()) };
+        assert_eq!(code, SECUREBUFFER_SUCCESS);
+        assert_eq!(digests[..HMAC_DIGEST_LEN], raw);
+        assert_eq!(digests[HMAC_DIGEST_LEN..], buffer.hmac_digest(b"second").unwrap());
+
+        let results = unsafe { securebuffer_hmac_batch(ptr, keys.as_ptr(), lens.as_ptr(), 2) };
+        assert!(!results.is_null());
+        let second = unsafe { CStr::from_ptr(*results.add(1)) }.to_str().unwrap().to_string();
+        assert_eq!(second, buffer.hmac_hex(b"second").unwrap());
+        unsafe { securebuffer_free_batch_results(results, 2) };
+    }
+
+    #[test]
+    fn test_aes256_gcm_buffers() {
+        let key = [9u8; 32];
+        let nonce = [3u8; 12];
+        let mut plain = SecureBuffer::new(128).unwrap();
+        plain.write(b"snapshot payload that spans more than one block").unwrap();
+        let mut sealed = SecureBuffer::new(128).unwrap();
+        plain.encrypt_aes256_gcm_into(&key, &nonce, &mut sealed).unwrap();
+        assert_eq!(sealed.len(), plain.len() + secure_aead::AEAD_TAG_LEN);
+
+        // In place yields the same ciphertext || tag
+        let mut in_place = SecureBuffer::new(128).unwrap();
+        in_place.write(plain.as_slice().unwrap()).unwrap();
+        let (ptr, key_ptr, nonce_ptr) = (&mut in_place as *mut SecureBuffer as *mut c_void, key.as_ptr(), nonce.as_ptr());
+        assert_eq!(unsafe { securebuffer_encrypt_aes256_gcm(ptr, key_ptr, nonce_ptr, ptr) }, SECUREBUFFER_SUCCESS);
+        assert_eq!(in_place.as_slice().unwrap(), sealed.as_slice().unwrap());
+        assert_eq!(unsafe { securebuffer_decrypt_aes256_gcm(ptr, key_ptr, nonce_ptr, ptr) }, SECUREBUFFER_SUCCESS);
+        assert_eq!(in_place.as_slice().unwrap(), plain.as_slice().unwrap());
+
+        let mut opened = SecureBuffer::new(128).unwrap();
+        sealed.decrypt_aes256_gcm_into(&key, &nonce, &mut opened).unwrap();
+        assert_eq!(opened.as_slice().unwrap(), plain.as_slice().unwrap());
+        assert!(sealed.decrypt_aes256_gcm_into(&[8u8; 32], &nonce, &mut opened).is_err());
+        assert!(opened.is_empty());
+
+        // A failed seal leaves nothing behind in the output either
+        assert!(plain.encrypt_aes256_gcm_into(&key, &nonce[..8], &mut sealed).is_err());
+        assert!(sealed.is_empty());
+    }
+
+    #[test]
+    fn test_read_consistent_never_sees_a_torn_key() {
+        let mut key = SecureBuffer::new(256).unwrap();
+        key.write(&[0u8; 256]).unwrap();
+        let key = Arc::new(key);
+        let (stop, reads) = (Arc::new(AtomicBool::new(false)), Arc::new(AtomicU64::new(0)));
+
+        // Each version is one repeated byte, so a torn read would mix two values
+        let readers: Vec<_> = (0..4)
+            .map(|_| {
+                let (key, stop, reads) = (Arc::clone(&key), Arc::clone(&stop), Arc::clone(&reads));
+                std::thread::spawn(move || {
+                    let mut snapshot = [0u8; 256];
+                    while !stop.load(Ordering::Relaxed) {
+                        assert_eq!(key.read_consistent_into(&mut snapshot).unwrap(), 256);
+                        assert!(snapshot.iter().all(|&b| b == snapshot[0]));
+                        reads.fetch_add(1, Ordering::Relaxed);
+                    }
+                })
+            })
+            .collect();
+        let mut version = 0u32;
+        while version < 2000 || reads.load(Ordering::Relaxed) < 20_000 {
+            version += 1;
+            key.publish_with(|contents| contents.fill(version as u8));
+        }
+        stop.store(true, Ordering::Relaxed);
+        readers.into_iter().for_each(|r| r.join().unwrap());
+
+        // Signing matches the RFC 4231 case-2 HMAC and follows rotation
+        let mut signer = SecureBuffer::new(32).unwrap();
+        signer.write(b"Jefe").unwrap();
+        let mut digest = [0u8; HMAC_DIGEST_LEN];
+        let (ptr, message) = (&signer as *const SecureBuffer as *const c_void, b"what do ya want for nothing?");
+        let code = unsafe { securebuffer_sign_hmac_sha256_into(ptr, message.as_ptr(), message.len(), digest.as_mut_ptr()) };
+        assert_eq!(code, SECUREBUFFER_SUCCESS);
+        assert_eq!(hex::encode(digest), "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+        assert_eq!(unsafe { securebuffer_rotate_key(ptr as *mut c_void) }, SECUREBUFFER_SUCCESS);
+        assert_ne!(signer.sign_hmac_sha256(message).unwrap(), digest);
+
+        let (mut short, mut len) = ([0u8; 2], 0usize);
+        let code = unsafe { securebuffer_read_consistent(ptr, short.as_mut_ptr(), short.len(), &mut len) };
+        assert_eq!((code, len), (SECUREBUFFER_ERROR_BUFFER_OVERFLOW, 4));
+    }
+
+    #[test]
+    fn test_core_ffi_and_advisory_lock() {
+        let buffer = securebuffer_new(64);
+        assert!(!buffer.is_null());
+        let data = b"header-api";
+        unsafe {
+            assert_eq!(securebuffer_copy(buffer, data.as_ptr(), data.len()), SECUREBUFFER_SUCCESS);
+            assert_eq!(securebuffer_copy(buffer, [0u8; 65].as_ptr(), 65), SECUREBUFFER_ERROR_BUFFER_OVERFLOW);
+            assert_eq!((securebuffer_len(buffer), securebuffer_capacity(buffer)), (data.len(), 64));
+            assert_eq!(std::slice::from_raw_parts(securebuffer_data_readonly(buffer), data.len()), data);
+
+            // Readers share, a writer waits for them, and an unmatched release is refused
+            assert_eq!(securebuffer_acquire_read_lock(buffer), SECUREBUFFER_SUCCESS);
+            assert_eq!(securebuffer_acquire_read_lock(buffer), SECUREBUFFER_SUCCESS);
+            let shared = buffer as usize;
+            let writer = std::thread::spawn(move || {
+                securebuffer_acquire_write_lock(shared as *mut c_void);
+                securebuffer_release_lock(shared as *mut c_void)
+            });
+            std::thread::sleep(std::time::Duration::from_millis(20));
+            assert!(!writer.is_finished());
+            assert_eq!(securebuffer_release_lock(buffer), SECUREBUFFER_SUCCESS);
+            assert_eq!(securebuffer_release_lock(buffer), SECUREBUFFER_SUCCESS);
+            assert_eq!(writer.join().unwrap(), SECUREBUFFER_SUCCESS);
+            assert_eq!(securebuffer_release_lock(buffer), SECUREBUFFER_ERROR_THREAD_SAFETY_VIOLATION);
+            securebuffer_free(buffer);
+        }
+    }
+
+    #[test]
+    fn test_tamper_detection_follows_tracked_writes() {
+        let mut buffer = SecureBuffer::new(3 * buffer_integrity::INTEGRITY_CHUNK).unwrap();
+        buffer.write(&[7u8; 5000]).unwrap();
+        buffer.enable_tamper_detection().unwrap();
+        assert!(buffer.integrity_check());
+
+        // Every library write path keeps the tags current
+        buffer.write(b"short").unwrap();
+        buffer.rotate_key().unwrap();
+        buffer.encrypt_aes256_gcm_in_place(&[1u8; 32], &[2u8; 12]).unwrap();
+        buffer.decrypt_aes256_gcm_in_place(&[1u8; 32], &[2u8; 12]).unwrap();
+        buffer.staged(b"derived", 64).unwrap().fill(9);
+        assert!(buffer.integrity_check());
+        assert!(!buffer.is_tampered());
+
+        // A write behind the library's back is caught
+        unsafe { *buffer.data.add(2 * buffer_integrity::INTEGRITY_CHUNK + 1) ^= 1 };
+        assert!(!buffer.integrity_check());
+        assert!(buffer.is_tampered());
+        assert!(buffer.schedule_integrity_verification(std::time::Duration::from_secs(1), 1).is_ok());
+    }
+
+    #[test]
+    fn test_batch_calls_reject_overflowing_lengths() {
+        let filter = Box::into_raw(Box::new(bloom_filter::UniversalBloomFilter::new(None).unwrap())) as *mut c_void;
+        let keys = [0u8; 4];
+        let mut bitmap = [0u8; 1];
+        unsafe {
+            // count * stride wraps
+            assert!(!bloom_filter_insert_batch(filter, keys.as_ptr(), usize::MAX, 2));
+            assert_eq!(bloom_filter_contains_batch(filter, keys.as_ptr(), 2, usize::MAX, bitmap.as_mut_ptr()), -1);
+
+            // count + 1 wraps, or the offsets or key span cannot be a slice
+            let offsets = [0u64, u64::MAX];
+            assert!(!bloom_filter_insert_batch_offsets(filter, keys.as_ptr(), offsets.as_ptr(), u64::MAX as usize));
+            assert_eq!(bloom_filter_contains_batch_offsets(filter, keys.as_ptr(), offsets.as_ptr(), u64::MAX as usize, bitmap.as_mut_ptr()), -1);
+            assert!(!bloom_filter_insert_batch_offsets(filter, keys.as_ptr(), offsets.as_ptr(), isize::MAX as usize / 8));
+            assert!(!bloom_filter_insert_batch_offsets(filter, keys.as_ptr(), offsets.as_ptr(), 1));
+            assert_eq!(bloom_filter_contains_batch_offsets(filter, keys.as_ptr(), offsets.as_ptr(), 1, bitmap.as_mut_ptr()), -1);
+
+            let offsets = [0u64, 4];
+            assert!(bloom_filter_insert_batch_offsets(filter, keys.as_ptr(), offsets.as_ptr(), 1));
+            assert_eq!(bloom_filter_contains_batch_offsets(filter, keys.as_ptr(), offsets.as_ptr(), 1, bitmap.as_mut_ptr()), 1);
+            bloom_filter_free(filter);
+
+            let registry = bloom_registry_new();
+            let tags = [0u16; 1];
+            let mut results = [false; 1];
+            let offsets = [0u64, u64::MAX];
+            for count in [u64::MAX as usize, isize::MAX as usize / 8, 1] {
+                assert!(!bloom_registry_insert_batch(registry, tags.as_ptr(), keys.as_ptr(), offsets.as_ptr(), count));
+                assert!(!bloom_registry_contains_batch(registry, tags.as_ptr(), keys.as_ptr(), offsets.as_ptr(), count, results.as_mut_ptr()));
+            }
+            bloom_registry_free(registry);
+        }
+    }
+}
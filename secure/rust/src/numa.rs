@@ -0,0 +1,302 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - NUMA topology and placement
+// Finds the nodes that have CPUs, binds fresh mappings to one node or interleaves them,
+// faults pages in from the node that will use them and keeps one pinned rayon pool per
+// node. On single-node hosts and outside Linux every call is a cheap no-op.
+
+use std::cell::Cell;
+use std::sync::atomic::{AtomicU8, Ordering};
+use std::sync::OnceLock;
+
+/// Where a mapping's pages should live
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Placement {
+    /// Prefer one node (index into `Topology`); the kernel falls back when it is full
+    Node(usize),
+    /// Spread pages round-robin over every node with CPUs
+    Interleave,
+}
+
+/// Nodes that have CPUs, indexed 0.. in kernel id order. Memory-only nodes (CXL, PMEM)
+/// are left out: nothing runs there, so nothing should be placed there either.
+pub struct Topology {
+    node_ids: Vec<usize>,
+    node_cpus: Vec<Vec<usize>>,
+    cpu_node: Vec<usize>,
+}
+
+impl Topology {
+    #[cfg(target_os = "linux")]
+    fn discover() -> Self {
+        let mut nodes: Vec<(usize, Vec<usize>)> = std::fs::read_dir("/sys/devices/system/node")
+            .into_iter()
+            .flatten()
+            .filter_map(|entry| {
+                let id = entry.ok()?.file_name().to_str()?.strip_prefix("node")?.parse().ok()?;
+                let list = std::fs::read_to_string(format!("/sys/devices/system/node/node{}/cpulist", id)).ok()?;
+                let cpus = parse_cpulist(&list);
+                (!cpus.is_empty()).then_some((id, cpus))
+            })
+            .collect();
+        nodes.sort_unstable_by_key(|(id, _)| *id);
+        if nodes.is_empty() {
+            return Self::single();
+        }
+
+        let max_cpu = nodes.iter().flat_map(|(_, cpus)| cpus.iter().copied()).max().unwrap_or(0);
+        let mut cpu_node = vec![0; max_cpu + 1];
+        for (index, (_, cpus)) in nodes.iter().enumerate() {
+            for &cpu in cpus {
+                cpu_node[cpu] = index;
+            }
+        }
+        let (node_ids, node_cpus) = nodes.into_iter().unzip();
+        Self { node_ids, node_cpus, cpu_node }
+    }
+
+    #[cfg(not(target_os = "linux"))]
+    fn discover() -> Self {
+        Self::single()
+    }
+
+    fn single() -> Self {
+        let cpus = std::thread::available_parallelism().map_or(1, |n| n.get());
+        Self { node_ids: vec![0], node_cpus: vec![(0..cpus).collect()], cpu_node: vec![0; cpus] }
+    }
+
+    pub fn node_count(&self) -> usize {
+        self.node_ids.len()
+    }
+
+    /// CPUs belonging to node `node`
+    pub fn cpus(&self, node: usize) -> &[usize] {
+        self.node_cpus.get(node).map_or(&[], Vec::as_slice)
+    }
+
+    /// Node index of `cpu` (0 for CPUs that were offline at discovery)
+    pub fn node_of_cpu(&self, cpu: usize) -> usize {
+        self.cpu_node.get(cpu).copied().unwrap_or(0)
+    }
+}
+
+/// Parse a sysfs cpulist such as "0-3,8-11,16"
+pub fn parse_cpulist(list: &str) -> Vec<usize> {
+    let mut cpus = Vec::new();
+    for range in list.trim().split(',').filter(|r| !r.is_empty()) {
+        let (first, last) = range.split_once('-').unwrap_or((range, range));
+        if let (Ok(first), Ok(last)) = (first.parse::<usize>(), last.parse::<usize>()) {
+            cpus.extend(first..=last);
+        }
+    }
+    cpus
+}
+
+pub fn topology() -> &'static Topology {
+    static TOPOLOGY: OnceLock<Topology> = OnceLock::new();
+    TOPOLOGY.get_or_init(Topology::discover)
+}
+
+pub fn node_count() -> usize {
+    topology().node_count()
+}
+
+/// Whether there is more than one node to place memory on
+pub fn is_numa() -> bool {
+    node_count() > 1
+}
+
+thread_local! {
+    // Set by `pin_current_thread`, so pinned workers skip the per-call CPU lookup
+    static PINNED_NODE: Cell<Option<usize>> = const { Cell::new(None) };
+}
+
+/// Node of the CPU this thread is running on
+#[inline]
+pub fn current_node() -> usize {
+    if let Some(node) = PINNED_NODE.with(Cell::get) {
+        return node;
+    }
+    if !is_numa() {
+        return 0;
+    }
+    #[cfg(target_os = "linux")]
+    {
+        let cpu = unsafe { libc::sched_getcpu() };
+        if cpu >= 0 {
+            return topology().node_of_cpu(cpu as usize);
+        }
+    }
+    0
+}
+
+/// Restrict the calling thread to the CPUs of `node`
+pub fn pin_current_thread(node: usize) -> bool {
+    let cpus = topology().cpus(node);
+    if cpus.is_empty() {
+        return false;
+    }
+    #[cfg(target_os = "linux")]
+    unsafe {
+        let mut set: libc::cpu_set_t = std::mem::zeroed();
+        for &cpu in cpus {
+            libc::CPU_SET(cpu, &mut set);
+        }
+        if libc::sched_setaffinity(0, std::mem::size_of::<libc::cpu_set_t>(), &set) != 0 {
+            return false;
+        }
+    }
+    PINNED_NODE.with(|pinned| pinned.set(Some(node)));
+    true
+}
+
+/// One rayon pool per node, its workers pinned to that node; None on single-node hosts
+pub fn workers(node: usize) -> Option<&'static rayon::ThreadPool> {
+    static POOLS: OnceLock<Vec<OnceLock<Option<rayon::ThreadPool>>>> = OnceLock::new();
+    if !is_numa() {
+        return None;
+    }
+    let pools = POOLS.get_or_init(|| (0..node_count()).map(|_| OnceLock::new()).collect());
+    pools.get(node)?
+        .get_or_init(|| {
+            rayon::ThreadPoolBuilder::new()
+                .num_threads(topology().cpus(node).len())
+                .thread_name(move |i| format!("bloom-numa{}-{}", node, i))
+                .start_handler(move |_| {
+                    pin_current_thread(node);
+                })
+                .build()
+                .ok()
+        })
+        .as_ref()
+}
+
+/// Run `f` (and any rayon work it spawns) on the workers of the caller's node
+pub fn install_local<R: Send>(f: impl FnOnce() -> R + Send) -> R {
+    match workers(current_node()) {
+        Some(pool) => pool.install(f),
+        None => f(),
+    }
+}
+
+/// Run `f` on a worker pinned to `node`, or inline on single-node hosts
+pub fn on_node<R: Send>(node: usize, f: impl FnOnce() -> R + Send) -> R {
+    match workers(node) {
+        Some(pool) => pool.install(f),
+        None => f(),
+    }
+}
+
+#[cfg(target_os = "linux")]
+const MPOL_PREFERRED: libc::c_int = 1;
+#[cfg(target_os = "linux")]
+const MPOL_INTERLEAVE: libc::c_int = 3;
+#[cfg(target_os = "linux")]
+const MADV_POPULATE_READ: libc::c_int = 22;
+#[cfg(target_os = "linux")]
+const MADV_POPULATE_WRITE: libc::c_int = 23;
+
+/// Set the memory policy of a fresh, page-aligned mapping before anything touches it.
+/// Returns false (leaving first-touch placement) on single-node hosts or if mbind fails.
+///
+/// # Safety
+///
+/// `ptr..ptr + len` must be a mapping owned by the caller.
+pub unsafe fn bind(ptr: *mut u8, len: usize, placement: Placement) -> bool {
+    if !is_numa() || len == 0 {
+        return false;
+    }
+    #[cfg(target_os = "linux")]
+    {
+        let topology = topology();
+        let (mode, ids) = match placement {
+            Placement::Node(node) => match topology.node_ids.get(node) {
+                Some(id) => (MPOL_PREFERRED, std::slice::from_ref(id)),
+                None => return false,
+            },
+            Placement::Interleave => (MPOL_INTERLEAVE, topology.node_ids.as_slice()),
+        };
+        let max_id = ids.iter().copied().max().unwrap_or(0);
+        let mut mask = vec![0 as libc::c_ulong; max_id / libc::c_ulong::BITS as usize + 1];
+        for &id in ids {
+            mask[id / libc::c_ulong::BITS as usize] |= 1 << (id % libc::c_ulong::BITS as usize);
+        }
+        // maxnode counts one past the last bit the kernel should read
+        let maxnode = mask.len() * libc::c_ulong::BITS as usize + 1;
+        libc::syscall(libc::SYS_mbind, ptr as *mut libc::c_void, len, mode, mask.as_ptr(), maxnode, 0u32) == 0
+    }
+    #[cfg(not(target_os = "linux"))]
+    {
+        let _ = (ptr, placement);
+        false
+    }
+}
+
+/// Fault in every page of `ptr..ptr + len` from the calling thread, so first-touch (or
+/// the mapping's policy) decides placement now rather than on the first hot-path access.
+/// `write` populates private writable pages; read-only population leaves file-backed
+/// copy-on-write pages shared. Contents are never changed.
+///
+/// # Safety
+///
+/// `ptr..ptr + len` must be mapped, and writable when `write` is set.
+pub unsafe fn populate(ptr: *mut u8, len: usize, write: bool) {
+    if len == 0 {
+        return;
+    }
+    let page = page_size();
+    let start = ptr as usize & !(page - 1);
+    let end = ptr as usize + len;
+
+    #[cfg(target_os = "linux")]
+    {
+        let advice = if write { MADV_POPULATE_WRITE } else { MADV_POPULATE_READ };
+        if libc::madvise(start as *mut libc::c_void, end - start, advice) == 0 {
+            return;
+        }
+    }
+
+    // Kernels before 5.14: touch one byte per page. The atomic no-op write is safe
+    // against concurrent writers of the same word.
+    let mut addr = ptr as usize;
+    while addr < end {
+        let byte = &*(addr as *const AtomicU8);
+        if write {
+            byte.fetch_or(0, Ordering::Relaxed);
+        } else {
+            byte.load(Ordering::Relaxed);
+        }
+        addr = (addr & !(page - 1)) + page;
+    }
+}
+
+fn page_size() -> usize {
+    #[cfg(unix)]
+    {
+        (unsafe { libc::sysconf(libc::_SC_PAGESIZE) }.max(4096)) as usize
+    }
+    #[cfg(not(unix))]
+    {
+        4096
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_topology_and_populate() {
+        assert_eq!(parse_cpulist("0-3,8-9,12\n"), vec![0, 1, 2, 3, 8, 9, 12]);
+        assert!(parse_cpulist("").is_empty());
+
+        let topology = topology();
+        assert!(topology.node_count() >= 1);
+        assert!(current_node() < topology.node_count());
+        assert!((0..topology.node_count()).all(|node| !topology.cpus(node).is_empty()));
+        assert_eq!(on_node(0, || 7), 7);
+
+        let mut data = vec![0x5au8; 3 * 4096 + 17];
+        unsafe { populate(data.as_mut_ptr().add(5), data.len() - 5, true) };
+        assert!(data.iter().all(|&b| b == 0x5a));
+    }
+}
@@ -0,0 +1,360 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - Per-thread operation metrics
+// Each thread records into its own cache-line aligned shard: call counts and a log-linear
+// latency histogram per operation, plus the buffer allocation counters. Nothing is shared
+// on the hot path; readers sum the shards. Shards outlive their threads and are handed to
+// the next thread that starts, so memory stays bounded by the peak thread count.
+//
+// Histogram buckets are exact below 32 ns and then split every power of two into 16
+// linear steps, so a reported percentile is within 1/16 (6.25%) of the true value, up to
+// about 68 s. Bloom filter operations are cheap enough that two clock reads would
+// dominate them; they are counted on every call but timed on one call in 16.
+
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::Mutex;
+use std::time::{Duration, Instant};
+
+/// Operations with a latency histogram; values match `SecureBufferOp`
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum MetricOp {
+    Alloc = 0,
+    Hmac = 1,
+    Aead = 2,
+    Derive = 3,
+    /// Channel pool request, submit to completion
+    PoolSend = 4,
+    BloomInsert = 5,
+    BloomContains = 6,
+}
+
+pub const METRIC_OP_COUNT: usize = 7;
+
+impl MetricOp {
+    pub const ALL: [MetricOp; METRIC_OP_COUNT] =
+        [Self::Alloc, Self::Hmac, Self::Aead, Self::Derive, Self::PoolSend, Self::BloomInsert, Self::BloomContains];
+
+    pub fn from_raw(raw: i32) -> Option<Self> {
+        Self::ALL.get(usize::try_from(raw).ok()?).copied()
+    }
+
+    pub fn name(self) -> &'static str {
+        match self {
+            Self::Alloc => "alloc",
+            Self::Hmac => "hmac",
+            Self::Aead => "aead",
+            Self::Derive => "derive",
+            Self::PoolSend => "pool_send",
+            Self::BloomInsert => "bloom_insert",
+            Self::BloomContains => "bloom_contains",
+        }
+    }
+}
+
+/// Plain counters kept per thread
+#[derive(Clone, Copy)]
+pub(crate) enum Counter {
+    Allocations = 0,
+    Deallocations = 1,
+    BytesAllocated = 2,
+    BytesDeallocated = 3,
+}
+
+const COUNTER_COUNT: usize = 4;
+
+const SUB_BUCKET_BITS: u32 = 4;
+const SUB_BUCKETS: usize = 1 << SUB_BUCKET_BITS;
+/// Values below this land in their own bucket
+const EXACT_LIMIT: u64 = 2 * SUB_BUCKETS as u64;
+/// Largest tracked exponent; longer operations count in the last bucket
+const MAX_SHIFT: u32 = 32;
+
+/// Buckets per histogram, as exported by `latency_histogram`
+pub const LATENCY_BUCKETS: usize = EXACT_LIMIT as usize + MAX_SHIFT as usize * SUB_BUCKETS;
+
+/// Bloom operations are timed once per this many calls
+const BLOOM_SAMPLE_EVERY: u64 = 16;
+
+fn bucket_index(nanos: u64) -> usize {
+    if nanos < EXACT_LIMIT {
+        return nanos as usize;
+    }
+    let shift = (63 - nanos.leading_zeros() - SUB_BUCKET_BITS).min(MAX_SHIFT);
+    let top = (nanos >> shift).min(2 * SUB_BUCKETS as u64 - 1) as usize;
+    EXACT_LIMIT as usize + (shift as usize - 1) * SUB_BUCKETS + top - SUB_BUCKETS
+}
+
+/// Largest value counted in bucket `index`
+pub fn bucket_upper_ns(index: usize) -> u64 {
+    if index < EXACT_LIMIT as usize {
+        return index as u64;
+    }
+    let offset = index - EXACT_LIMIT as usize;
+    let shift = (offset / SUB_BUCKETS + 1) as u32;
+    let top = (offset % SUB_BUCKETS + SUB_BUCKETS) as u64;
+    ((top + 1) << shift) - 1
+}
+
+#[repr(C, align(128))]
+struct OpShard {
+    calls: AtomicU64,
+    samples: AtomicU64,
+    sum_ns: AtomicU64,
+    max_ns: AtomicU64,
+    buckets: [AtomicU64; LATENCY_BUCKETS],
+}
+
+#[repr(C, align(128))]
+struct ThreadShard {
+    ops: [OpShard; METRIC_OP_COUNT],
+    counters: [AtomicU64; COUNTER_COUNT],
+    in_use: AtomicBool,
+}
+
+impl ThreadShard {
+    fn new() -> Self {
+        Self {
+            ops: std::array::from_fn(|_| OpShard {
+                calls: AtomicU64::new(0),
+                samples: AtomicU64::new(0),
+                sum_ns: AtomicU64::new(0),
+                max_ns: AtomicU64::new(0),
+                buckets: std::array::from_fn(|_| AtomicU64::new(0)),
+            }),
+            counters: std::array::from_fn(|_| AtomicU64::new(0)),
+            in_use: AtomicBool::new(true),
+        }
+    }
+}
+
+/// Every shard ever created; threads only take this lock when they start or end
+static SHARDS: Mutex<Vec<&'static ThreadShard>> = Mutex::new(Vec::new());
+
+/// Owns a shard for the life of one thread
+struct ShardLease(&'static ThreadShard);
+
+impl ShardLease {
+    fn claim() -> Self {
+        let mut shards = SHARDS.lock().unwrap_or_else(|e| e.into_inner());
+        if let Some(shard) = shards.iter().find(|s| !s.in_use.load(Ordering::Relaxed)) {
+            shard.in_use.store(true, Ordering::Relaxed);
+            return Self(shard);
+        }
+        let shard: &'static ThreadShard = Box::leak(Box::new(ThreadShard::new()));
+        shards.push(shard);
+        Self(shard)
+    }
+}
+
+impl Drop for ShardLease {
+    fn drop(&mut self) {
+        let _shards = SHARDS.lock().unwrap_or_else(|e| e.into_inner());
+        self.0.in_use.store(false, Ordering::Relaxed);
+    }
+}
+
+thread_local! {
+    static SHARD: ShardLease = ShardLease::claim();
+}
+
+/// Shard for threads whose own has already been torn down (thread-local destructors)
+static LATE_SHARD: std::sync::OnceLock<&'static ThreadShard> = std::sync::OnceLock::new();
+
+fn with_shard(f: impl FnOnce(&ThreadShard)) {
+    let mut f = Some(f);
+    if SHARD.try_with(|lease| (f.take().unwrap())(lease.0)).is_err() {
+        let late = *LATE_SHARD.get_or_init(|| {
+            let shard = ShardLease::claim().0;
+            // Leased forever: never handed to another thread
+            std::mem::forget(ShardLease(shard));
+            shard
+        });
+        (f.take().unwrap())(late);
+    }
+}
+
+fn observe(shard: &OpShard, nanos: u64) {
+    shard.samples.fetch_add(1, Ordering::Relaxed);
+    shard.sum_ns.fetch_add(nanos, Ordering::Relaxed);
+    shard.max_ns.fetch_max(nanos, Ordering::Relaxed);
+    shard.buckets[bucket_index(nanos)].fetch_add(1, Ordering::Relaxed);
+}
+
+/// Count one `op` that took `elapsed`
+pub fn record(op: MetricOp, elapsed: Duration) {
+    let nanos = u64::try_from(elapsed.as_nanos()).unwrap_or(u64::MAX);
+    with_shard(|shard| {
+        let shard = &shard.ops[op as usize];
+        shard.calls.fetch_add(1, Ordering::Relaxed);
+        observe(shard, nanos);
+    });
+}
+
+pub(crate) fn add(counter: Counter, value: u64) {
+    with_shard(|shard| {
+        shard.counters[counter as usize].fetch_add(value, Ordering::Relaxed);
+    });
+}
+
+/// Records its operation's latency when dropped
+pub struct OpTimer {
+    op: MetricOp,
+    start: Instant,
+}
+
+impl Drop for OpTimer {
+    fn drop(&mut self) {
+        let nanos = u64::try_from(self.start.elapsed().as_nanos()).unwrap_or(u64::MAX);
+        with_shard(|shard| observe(&shard.ops[self.op as usize], nanos));
+    }
+}
+
+/// Count `op` now and time it until the returned guard drops
+pub fn timer(op: MetricOp) -> OpTimer {
+    with_shard(|shard| {
+        shard.ops[op as usize].calls.fetch_add(1, Ordering::Relaxed);
+    });
+    OpTimer { op, start: Instant::now() }
+}
+
+/// Count `op` now and time one call in `BLOOM_SAMPLE_EVERY`
+pub fn sampled_timer(op: MetricOp) -> Option<OpTimer> {
+    let mut sampled = false;
+    with_shard(|shard| {
+        sampled = shard.ops[op as usize].calls.fetch_add(1, Ordering::Relaxed) % BLOOM_SAMPLE_EVERY == 0;
+    });
+    sampled.then(|| OpTimer { op, start: Instant::now() })
+}
+
+/// Aggregated view of one operation across all threads
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct LatencySummary {
+    /// Calls, including untimed Bloom calls
+    pub count: u64,
+    /// Timed calls behind the percentiles
+    pub samples: u64,
+    pub sum_ns: u64,
+    pub max_ns: u64,
+    pub p50_ns: u64,
+    pub p99_ns: u64,
+    pub p999_ns: u64,
+}
+
+/// Sum every shard's histogram for `op` into `out`, returning (calls, samples, sum, max)
+fn merge(op: MetricOp, out: &mut [u64; LATENCY_BUCKETS]) -> (u64, u64, u64, u64) {
+    let shards = SHARDS.lock().unwrap_or_else(|e| e.into_inner());
+    let (mut calls, mut samples, mut sum, mut max) = (0, 0, 0, 0);
+    for shard in shards.iter() {
+        let op = &shard.ops[op as usize];
+        calls += op.calls.load(Ordering::Relaxed);
+        samples += op.samples.load(Ordering::Relaxed);
+        sum += op.sum_ns.load(Ordering::Relaxed);
+        max = max.max(op.max_ns.load(Ordering::Relaxed));
+        for (total, bucket) in out.iter_mut().zip(&op.buckets) {
+            *total += bucket.load(Ordering::Relaxed);
+        }
+    }
+    (calls, samples, sum, max)
+}
+
+/// Smallest bucket bound covering `quantile` of `total` samples
+fn percentile(buckets: &[u64; LATENCY_BUCKETS], total: u64, quantile: f64, max: u64) -> u64 {
+    if total == 0 {
+        return 0;
+    }
+    let rank = ((total as f64 * quantile).ceil() as u64).clamp(1, total);
+    let mut seen = 0;
+    for (index, &count) in buckets.iter().enumerate() {
+        seen += count;
+        if seen >= rank {
+            return bucket_upper_ns(index).min(max);
+        }
+    }
+    max
+}
+
+/// Aggregate `op` across threads; allocation-free
+pub fn summary(op: MetricOp) -> LatencySummary {
+    let mut buckets = [0u64; LATENCY_BUCKETS];
+    let (count, samples, sum_ns, max_ns) = merge(op, &mut buckets);
+    // Shards are read without stopping writers, so bucket totals may run a sample ahead
+    let total = buckets.iter().sum::<u64>();
+    LatencySummary {
+        count,
+        samples,
+        sum_ns,
+        max_ns,
+        p50_ns: percentile(&buckets, total, 0.50, max_ns),
+        p99_ns: percentile(&buckets, total, 0.99, max_ns),
+        p999_ns: percentile(&buckets, total, 0.999, max_ns),
+    }
+}
+
+/// Aggregated bucket counts for `op`; bucket `i` holds values up to `bucket_upper_ns(i)`
+pub fn latency_histogram(op: MetricOp, out: &mut [u64; LATENCY_BUCKETS]) {
+    out.fill(0);
+    merge(op, out);
+}
+
+pub(crate) fn counter(counter: Counter) -> u64 {
+    let shards = SHARDS.lock().unwrap_or_else(|e| e.into_inner());
+    shards.iter().map(|s| s.counters[counter as usize].load(Ordering::Relaxed)).sum()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_histogram_buckets_and_percentiles() {
+        // Buckets are contiguous, monotonic and within 1/16 of their values
+        let mut previous = None;
+        for nanos in (0..5000u64).chain([1 << 20, (1 << 20) + 12_345, 1 << 35, u64::MAX]) {
+            let index = bucket_index(nanos);
+            assert!(index < LATENCY_BUCKETS);
+            if nanos < 1 << 36 {
+                assert!(bucket_upper_ns(index) >= nanos);
+                assert!(bucket_upper_ns(index) - nanos <= nanos / 16);
+            }
+            if let Some(prev) = previous {
+                assert!(index >= prev);
+            }
+            previous = (nanos < 5000).then_some(index);
+        }
+        for index in 1..LATENCY_BUCKETS {
+            assert_eq!(bucket_index(bucket_upper_ns(index - 1) + 1), index);
+        }
+
+        // Samples from several threads aggregate into one distribution: 990 fast calls
+        // and 10 slow ones put the slow tail above p99 but below p999
+        let before = summary(MetricOp::PoolSend);
+        let handles: Vec<_> = (0..4)
+            .map(|t| {
+                std::thread::spawn(move || {
+                    for i in 0..250 {
+                        let slow = t == 0 && i < 10;
+                        record(MetricOp::PoolSend, Duration::from_micros(if slow { 5_000 } else { 100 }));
+                    }
+                })
+            })
+            .collect();
+        handles.into_iter().for_each(|h| h.join().unwrap());
+        let after = summary(MetricOp::PoolSend);
+        assert_eq!(after.count - before.count, 1000);
+        assert!(after.p50_ns >= 100_000 && after.p50_ns <= 106_250);
+        assert!(after.p999_ns >= 5_000_000);
+        assert_eq!(after.max_ns, 5_000_000);
+
+        // Bloom calls are all counted, one in sixteen timed; the thread may inherit a
+        // used shard, so compare against its starting counts
+        std::thread::spawn(|| {
+            let samples = || SHARD.with(|lease| lease.0.ops[MetricOp::BloomContains as usize].samples.load(Ordering::Relaxed));
+            let before = samples();
+            for _ in 0..64 {
+                let _timer = sampled_timer(MetricOp::BloomContains);
+            }
+            assert_eq!(samples() - before, 4);
+        })
+        .join()
+        .unwrap();
+    }
+}
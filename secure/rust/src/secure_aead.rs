@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - Streaming AES-256-GCM
+// Incremental AEAD (NIST SP 800-38D): associated data, then the payload in any number of
+// chunks of any size, then the tag. Chunks are transformed in place, so a large payload is
+// never held twice in locked memory. The block cipher, CTR keystream and GHASH come from
+// the RustCrypto `aes`, `ctr` and `ghash` crates, which pick AES-NI and CLMUL at run time
+// and otherwise fall back to their constant-time software implementations.
+
+use std::sync::OnceLock;
+
+use aes::cipher::generic_array::GenericArray;
+use aes::cipher::{BlockEncrypt, KeyInit, KeyIvInit, StreamCipher};
+use aes::Aes256;
+use ghash::universal_hash::UniversalHash;
+use ghash::GHash;
+use zeroize::Zeroize;
+
+use crate::memory;
+
+pub const AEAD_KEY_LEN: usize = 32;
+pub const AEAD_NONCE_LEN: usize = 12;
+pub const AEAD_TAG_LEN: usize = 16;
+
+/// CTR over the last 32 bits of the counter block, as GCM specifies
+type Aes256Ctr = ctr::Ctr32BE<Aes256>;
+
+/// Bytes transformed per pass, so the GHASH pass reads ciphertext the CTR pass left in L1
+const STRIDE: usize = 4096;
+
+/// Payload limit for one key/nonce pair: 2^32 - 2 counter blocks
+const MAX_DATA_LEN: u64 = ((1u64 << 32) - 2) * 16;
+
+#[derive(Debug, thiserror::Error, PartialEq, Eq)]
+pub enum AeadError {
+    #[error("Key must be {AEAD_KEY_LEN} bytes")]
+    InvalidKey,
+    #[error("Nonce must be {AEAD_NONCE_LEN} bytes")]
+    InvalidNonce,
+    #[error("Operation not valid in the current phase")]
+    InvalidPhase,
+    #[error("Payload exceeds the GCM limit for one nonce")]
+    LimitExceeded,
+    #[error("Authentication tag mismatch")]
+    TagMismatch,
+}
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum AeadDirection {
+    Encrypt,
+    Decrypt,
+}
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+enum Phase {
+    Aad,
+    Data,
+    Done,
+}
+
+/// Kernel the crates select on this CPU
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum AeadBackend {
+    Portable,
+    AesNiClmul,
+}
+
+impl AeadBackend {
+    pub fn name(self) -> &'static str {
+        match self {
+            Self::Portable => "portable",
+            Self::AesNiClmul => "aes-ni+pclmul",
+        }
+    }
+}
+
+/// Detect the AES-GCM kernel once per process, for reporting
+pub fn backend() -> AeadBackend {
+    static BACKEND: OnceLock<AeadBackend> = OnceLock::new();
+    *BACKEND.get_or_init(|| {
+        #[cfg(target_arch = "x86_64")]
+        {
+            if is_x86_feature_detected!("aes") && is_x86_feature_detected!("pclmulqdq") {
+                return AeadBackend::AesNiClmul;
+            }
+        }
+        AeadBackend::Portable
+    })
+}
+
+// --- Context ----------------------------------------------------------------------------
+
+/// Cipher and running GHASH state; lives in locked memory and is wiped on drop
+struct AeadState {
+    /// Keystream from counter block J0 + 1 onwards
+    ctr: Aes256Ctr,
+    ghash: GHash,
+    /// E(K, J0), XORed into the final GHASH value to form the tag
+    tag_mask: [u8; 16],
+    /// Bytes of the GHASH block still being filled (AAD first, then ciphertext)
+    partial: [u8; 16],
+    partial_len: usize,
+    aad_len: u64,
+    data_len: u64,
+}
+
+impl AeadState {
+    /// Feed bytes into GHASH, whole blocks straight through and the rest via the partial block
+    fn absorb(&mut self, mut bytes: &[u8]) {
+        if self.partial_len > 0 {
+            let take = bytes.len().min(16 - self.partial_len);
+            self.partial[self.partial_len..self.partial_len + take].copy_from_slice(&bytes[..take]);
+            self.partial_len += take;
+            bytes = &bytes[take..];
+            if self.partial_len < 16 {
+                return;
+            }
+            self.ghash.update(&[GenericArray::from(self.partial)]);
+            self.partial_len = 0;
+        }
+
+        let (whole, rest) = bytes.split_at(bytes.len() / 16 * 16);
+        let mut staged = [ghash::Block::default(); 8];
+        for group in whole.chunks(staged.len() * 16) {
+            let count = group.len() / 16;
+            for (block, chunk) in staged.iter_mut().zip(group.chunks_exact(16)) {
+                block.copy_from_slice(chunk);
+            }
+            self.ghash.update(&staged[..count]);
+        }
+        self.partial[..rest.len()].copy_from_slice(rest);
+        self.partial_len = rest.len();
+    }
+
+    /// Zero-pad and hash the unfinished GHASH block, if any
+    fn flush(&mut self) {
+        if self.partial_len > 0 {
+            self.partial[self.partial_len..].fill(0);
+            self.ghash.update(&[GenericArray::from(self.partial)]);
+            self.partial_len = 0;
+        }
+    }
+}
+
+/// Incremental AES-256-GCM for one key/nonce pair. Feed AAD with `update_aad`, then the
+/// payload with `update_in_place` / `update_vectored`, then call `finalize` (encrypt) or
+/// `verify` (decrypt). When decrypting, plaintext is released before the tag is checked:
+/// callers must discard everything if `verify` fails.
+pub struct SecureAeadContext {
+    state: Box<AeadState>,
+    direction: AeadDirection,
+    phase: Phase,
+    locked: bool,
+}
+
+impl SecureAeadContext {
+    pub fn new(key: &[u8], nonce: &[u8], direction: AeadDirection) -> Result<Self, AeadError> {
+        let key: &[u8; AEAD_KEY_LEN] = key.try_into().map_err(|_| AeadError::InvalidKey)?;
+        let nonce: &[u8; AEAD_NONCE_LEN] = nonce.try_into().map_err(|_| AeadError::InvalidNonce)?;
+
+        let cipher = Aes256::new(GenericArray::from_slice(key));
+        let mut h = GenericArray::default();
+        cipher.encrypt_block(&mut h);
+        let mut j0 = [0u8; 16];
+        j0[..AEAD_NONCE_LEN].copy_from_slice(nonce);
+        j0[15] = 1;
+        let mut tag_mask = GenericArray::from(j0);
+        cipher.encrypt_block(&mut tag_mask);
+        j0[15] = 2;
+
+        let mut state = Box::new(AeadState {
+            ctr: Aes256Ctr::new(GenericArray::from_slice(key), &GenericArray::from(j0)),
+            ghash: GHash::new(&h),
+            tag_mask: tag_mask.into(),
+            partial: [0; 16],
+            partial_len: 0,
+            aad_len: 0,
+            data_len: 0,
+        });
+        h.as_mut_slice().zeroize();
+        tag_mask.as_mut_slice().zeroize();
+        let ptr = &mut *state as *mut AeadState as *mut u8;
+        let locked = unsafe { memory::lock_memory(ptr, std::mem::size_of::<AeadState>()) }.is_ok();
+
+        Ok(Self { state, direction, phase: Phase::Aad, locked })
+    }
+
+    pub fn direction(&self) -> AeadDirection {
+        self.direction
+    }
+
+    /// Authenticate associated data; only allowed before the first payload byte
+    pub fn update_aad(&mut self, aad: &[u8]) -> Result<(), AeadError> {
+        if self.phase != Phase::Aad {
+            return Err(AeadError::InvalidPhase);
+        }
+        self.state.absorb(aad);
+        self.state.aad_len += aad.len() as u64;
+        Ok(())
+    }
+
+    /// Encrypt or decrypt `data` in place; chunks may be any length
+    pub fn update_in_place(&mut self, data: &mut [u8]) -> Result<(), AeadError> {
+        match self.phase {
+            Phase::Aad => {
+                self.state.flush();
+                self.phase = Phase::Data;
+            }
+            Phase::Data => {}
+            Phase::Done => return Err(AeadError::InvalidPhase),
+        }
+        if self.state.data_len.checked_add(data.len() as u64).map_or(true, |total| total > MAX_DATA_LEN) {
+            return Err(AeadError::LimitExceeded);
+        }
+
+        let decrypt = self.direction == AeadDirection::Decrypt;
+        let state = &mut *self.state;
+        for stride in data.chunks_mut(STRIDE) {
+            if decrypt {
+                state.absorb(stride);
+            }
+            state.ctr.try_apply_keystream(stride).map_err(|_| AeadError::LimitExceeded)?;
+            if !decrypt {
+                state.absorb(stride);
+            }
+            state.data_len += stride.len() as u64;
+        }
+        Ok(())
+    }
+
+    /// Scatter-gather form of `update_in_place`: chunks are processed in order as one stream
+    pub fn update_vectored(&mut self, chunks: &mut [&mut [u8]]) -> Result<(), AeadError> {
+        let total = chunks.iter().try_fold(0u64, |sum, c| sum.checked_add(c.len() as u64)).ok_or(AeadError::LimitExceeded)?;
+        if self.state.data_len.checked_add(total).map_or(true, |t| t > MAX_DATA_LEN) {
+            return Err(AeadError::LimitExceeded);
+        }
+        chunks.iter_mut().try_for_each(|chunk| self.update_in_place(chunk))
+    }
+
+    fn compute_tag(&mut self) -> Result<[u8; AEAD_TAG_LEN], AeadError> {
+        if self.phase == Phase::Done {
+            return Err(AeadError::InvalidPhase);
+        }
+        self.phase = Phase::Done;
+        let state = &mut *self.state;
+        state.flush();
+
+        let mut lengths = [0u8; 16];
+        lengths[..8].copy_from_slice(&(state.aad_len * 8).to_be_bytes());
+        lengths[8..].copy_from_slice(&(state.data_len * 8).to_be_bytes());
+        state.ghash.update(&[GenericArray::from(lengths)]);
+
+        let mut tag = state.tag_mask;
+        for (t, g) in tag.iter_mut().zip(state.ghash.clone().finalize()) {
+            *t ^= g;
+        }
+        Ok(tag)
+    }
+
+    /// Finish encryption and return the tag
+    pub fn finalize(&mut self) -> Result<[u8; AEAD_TAG_LEN], AeadError> {
+        if self.direction != AeadDirection::Encrypt {
+            return Err(AeadError::InvalidPhase);
+        }
+        self.compute_tag()
+    }
+
+    /// Finish decryption, comparing the tag in constant time
+    pub fn verify(&mut self, tag: &[u8]) -> Result<(), AeadError> {
+        if self.direction != AeadDirection::Decrypt {
+            return Err(AeadError::InvalidPhase);
+        }
+        let mut expected = self.compute_tag()?;
+        let diff = if tag.len() == AEAD_TAG_LEN {
+            expected.iter().zip(tag).fold(0u8, |acc, (a, b)| acc | (a ^ b))
+        } else {
+            1
+        };
+        expected.zeroize();
+        if diff == 0 {
+            Ok(())
+        } else {
+            Err(AeadError::TagMismatch)
+        }
+    }
+}
+
+impl Drop for SecureAeadContext {
+    fn drop(&mut self) {
+        // Replace the key schedules while the pages are still locked; both zeroize on drop
+        let state = &mut *self.state;
+        state.ctr = Aes256Ctr::new(&Default::default(), &Default::default());
+        state.ghash = GHash::new(&Default::default());
+        state.tag_mask.zeroize();
+        state.partial.zeroize();
+        if self.locked {
+            let _ = unsafe { memory::unlock_memory(state as *mut AeadState as *mut u8, std::mem::size_of::<AeadState>()) };
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn unhex(s: &str) -> Vec<u8> {
+        hex::decode(s).unwrap()
+    }
+
+    #[test]
+    fn test_streaming_gcm() {
+        // GCM spec (McGrew & Viega) test case 16: AES-256, 96-bit IV, AAD
+        let key = unhex("feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308");
+        let nonce = unhex("cafebabefacedbaddecaf888");
+        let aad = unhex("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+        let plaintext = unhex(
+            "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+        );
+        let ciphertext = "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662";
+        let tag = "76fc6ece0f4e1768cddf8853bb2d551b";
+
+        // Chunkings that split AAD and data off block boundaries
+        for split in [0usize, 1, 15, 16, 17, 33, plaintext.len()] {
+            let mut ctx = SecureAeadContext::new(&key, &nonce, AeadDirection::Encrypt).unwrap();
+            let (a0, a1) = aad.split_at(split.min(aad.len()));
+            ctx.update_aad(a0).unwrap();
+            ctx.update_aad(a1).unwrap();
+            let mut data = plaintext.clone();
+            let (d0, d1) = data.split_at_mut(split);
+            ctx.update_vectored(&mut [d0, d1]).unwrap();
+            assert_eq!(hex::encode(&data), ciphertext, "split {split}");
+            assert_eq!(hex::encode(ctx.finalize().unwrap()), tag);
+            assert!(ctx.update_in_place(&mut [0u8; 4]).is_err());
+
+            let mut ctx = SecureAeadContext::new(&key, &nonce, AeadDirection::Decrypt).unwrap();
+            ctx.update_aad(&aad).unwrap();
+            let (d0, d1) = data.split_at_mut(split);
+            ctx.update_in_place(d0).unwrap();
+            ctx.update_in_place(d1).unwrap();
+            assert_eq!(data, plaintext);
+            ctx.verify(&unhex(tag)).unwrap();
+        }
+
+        // Test case 14: one zero block, no AAD; and a forged tag
+        let mut block = [0u8; 16];
+        let mut ctx = SecureAeadContext::new(&[0u8; 32], &[0u8; 12], AeadDirection::Encrypt).unwrap();
+        ctx.update_in_place(&mut block).unwrap();
+        assert_eq!(hex::encode(block), "cea7403d4d606b6e074ec5d3baf39d18");
+        assert_eq!(hex::encode(ctx.finalize().unwrap()), "d0d1c8a799996bf0265b98b5d48ab919");
+        let mut ctx = SecureAeadContext::new(&[0u8; 32], &[0u8; 12], AeadDirection::Decrypt).unwrap();
+        ctx.update_in_place(&mut block).unwrap();
+        assert_eq!(ctx.verify(&[0u8; 16]), Err(AeadError::TagMismatch));
+    }
+
+    #[test]
+    fn test_chunking_agrees() {
+        // Chunks that straddle block and stride boundaries match a one-shot pass
+        let key = [0x42u8; 32];
+        let nonce = [7u8; 12];
+        let plaintext: Vec<u8> = (0..2 * STRIDE as u32 + 1000).map(|i| (i * 13) as u8).collect();
+
+        let seal = |chunk: usize| {
+            let mut ctx = SecureAeadContext::new(&key, &nonce, AeadDirection::Encrypt).unwrap();
+            ctx.update_aad(b"header").unwrap();
+            let mut data = plaintext.clone();
+            for part in data.chunks_mut(chunk) {
+                ctx.update_in_place(part).unwrap();
+            }
+            (data, ctx.finalize().unwrap())
+        };
+        let (ciphertext, tag) = seal(plaintext.len());
+        assert_ne!(ciphertext, plaintext);
+        for chunk in [1, 15, 333, STRIDE + 3] {
+            assert_eq!(seal(chunk), (ciphertext.clone(), tag), "chunk {chunk}");
+        }
+
+        let mut ctx = SecureAeadContext::new(&key, &nonce, AeadDirection::Decrypt).unwrap();
+        ctx.update_aad(b"header").unwrap();
+        let mut data = ciphertext;
+        ctx.update_in_place(&mut data).unwrap();
+        ctx.verify(&tag).unwrap();
+        assert_eq!(data, plaintext);
+    }
+}
@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - Precomputed HMAC contexts
+// HMAC (RFC 2104) keyed from a SecureBuffer once: the inner and outer padded-key blocks are
+// absorbed up front and each message starts from a copy of those midstates, so a short
+// message costs two compression calls instead of four. SHA-256 midstates are raw state words
+// so batches can run on the multi-buffer engine. BLAKE3 needs no HMAC construction: its keyed
+// mode is absorbed once the same way, and the crate spreads each message's chunks across SIMD
+// lanes (and across threads for large inputs).
+
+use std::mem::ManuallyDrop;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+
+use sha2::{Digest, Sha256, Sha512};
+use zeroize::Zeroize;
+
+use crate::op_metrics::{self, MetricOp};
+use crate::sha256_batch::{self, Sha256Job, SHA256_IV};
+use crate::{memory, SecureBuffer};
+
+/// Digest algorithms a context can be keyed for; values match `SecureBufferHashAlgorithm`
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum HmacAlgorithm {
+    Sha256 = 0,
+    Sha512 = 1,
+    /// BLAKE3 keyed hash rather than HMAC
+    Blake3 = 2,
+}
+
+impl HmacAlgorithm {
+    pub fn from_raw(raw: i32) -> Option<Self> {
+        match raw {
+            0 => Some(Self::Sha256),
+            1 => Some(Self::Sha512),
+            2 => Some(Self::Blake3),
+            _ => None,
+        }
+    }
+
+    pub fn digest_len(self) -> usize {
+        match self {
+            Self::Sha256 | Self::Blake3 => 32,
+            Self::Sha512 => 64,
+        }
+    }
+}
+
+enum Midstate {
+    Sha256 { inner: [u32; 8], outer: [u32; 8] },
+    Sha512 { inner: Sha512, outer: Sha512 },
+    Blake3 { keyed: blake3::Hasher },
+}
+
+/// Context string for deriving a BLAKE3 key from source keys that are not 32 bytes
+const BLAKE3_KEY_CONTEXT: &str = "securebuffer 2024 hmac-context blake3 key";
+
+/// Inputs at least this long are hashed with BLAKE3's multithreaded update
+const BLAKE3_RAYON_MIN: usize = 128 * 1024;
+
+/// Run `absorb` over `key` padded with `ipad` and then `opad`, wiping the padded copies
+fn keyed<D: Digest, const BLOCK: usize, T>(key: &[u8], absorb: impl Fn(&[u8; BLOCK]) -> T) -> (T, T) {
+    let mut block = [0u8; BLOCK];
+    if key.len() > BLOCK {
+        let digest = D::digest(key);
+        block[..digest.len()].copy_from_slice(&digest);
+    } else {
+        block[..key.len()].copy_from_slice(key);
+    }
+
+    let mut pad = [0u8; BLOCK];
+    let mut absorb_pad = |xor: u8| {
+        for (p, k) in pad.iter_mut().zip(&block) {
+            *p = k ^ xor;
+        }
+        absorb(&pad)
+    };
+    let pair = (absorb_pad(0x36), absorb_pad(0x5c));
+    pad.zeroize();
+    block.zeroize();
+    pair
+}
+
+/// Fresh hasher that has absorbed one padded-key block
+fn hasher_from<D: Digest, const BLOCK: usize>(pad: &[u8; BLOCK]) -> D {
+    let mut hasher = D::new();
+    hasher.update(pad);
+    hasher
+}
+
+/// SHA-256 state words after one padded-key block
+fn words_from(pad: &[u8; 64]) -> [u32; 8] {
+    let mut state = SHA256_IV;
+    sha256_batch::compress_block(&mut state, pad);
+    state
+}
+
+/// SHA-256 inner and outer midstates for `key`, as used by PBKDF2
+pub(crate) fn sha256_midstates(key: &[u8]) -> ([u32; 8], [u32; 8]) {
+    keyed::<Sha256, 64, _>(key, words_from)
+}
+
+/// One-shot HMAC-SHA256 for callers without a context; the midstates are wiped after use
+pub(crate) fn hmac_sha256(key: &[u8], message: &[u8]) -> [u8; 32] {
+    let (mut inner, mut outer) = sha256_midstates(key);
+    let mut digest = [[0u8; 32]];
+    finish_sha256_many(&inner, &outer, &[message], &mut digest);
+    inner.zeroize();
+    outer.zeroize();
+    digest[0]
+}
+
+/// Finish SHA-256 MACs for every message: all inner hashes in one multi-buffer pass,
+/// then all outer hashes in a second. The inner digests are keyed intermediates and are
+/// wiped once the outer pass has consumed them.
+fn finish_sha256_many(inner: &[u32; 8], outer: &[u32; 8], messages: &[&[u8]], out: &mut [[u8; 32]]) {
+    let jobs: Vec<Sha256Job> = messages.iter().map(|m| Sha256Job::resume(*inner, 64, [*m, &[], &[]])).collect();
+    sha256_batch::digest_many(&jobs, out);
+    let mut inner_digests = out[..messages.len()].to_vec();
+    {
+        let jobs: Vec<Sha256Job> = inner_digests.iter().map(|d| Sha256Job::resume(*outer, 64, [&d[..], &[], &[]])).collect();
+        sha256_batch::digest_many(&jobs, out);
+    }
+    inner_digests.zeroize();
+}
+
+/// Finish one MAC from copies of the midstates
+fn finish<D: Digest + Clone>(inner: &D, outer: &D, message: &[u8], out: &mut [u8]) {
+    let mut inner = inner.clone();
+    inner.update(message);
+    let mut outer = outer.clone();
+    outer.update(inner.finalize());
+    out.copy_from_slice(&outer.finalize());
+}
+
+/// Keyed BLAKE3 hasher: 32-byte keys are used as-is, any other length goes through
+/// `derive_key` first. The derived key copy is wiped.
+fn blake3_keyed(key: &[u8]) -> blake3::Hasher {
+    let mut key32 = match <[u8; 32]>::try_from(key) {
+        Ok(key32) => key32,
+        Err(_) => blake3::derive_key(BLAKE3_KEY_CONTEXT, key),
+    };
+    let hasher = blake3::Hasher::new_keyed(&key32);
+    key32.zeroize();
+    hasher
+}
+
+/// Finish one keyed BLAKE3 hash from a copy of the keyed state
+fn finish_blake3(keyed: &blake3::Hasher, message: &[u8], out: &mut [u8]) {
+    let mut hasher = keyed.clone();
+    if message.len() >= BLAKE3_RAYON_MIN {
+        hasher.update_rayon(message);
+    } else {
+        hasher.update(message);
+    }
+    out.copy_from_slice(hasher.finalize().as_bytes());
+    // The clone holds keyed chaining values
+    hasher.zeroize();
+}
+
+/// HMAC keyed from a SecureBuffer's contents. The midstates live in locked memory and
+/// are wiped on drop. Any change to the source buffer (write, clear, `rotate_key`,
+/// destroy) invalidates the context; `mac_into` then fails until it is rebuilt.
+pub struct SecureHmacContext {
+    state: Box<ManuallyDrop<Midstate>>,
+    algorithm: HmacAlgorithm,
+    locked: bool,
+    key_epoch: Arc<AtomicU64>,
+    created_epoch: u64,
+}
+
+// The midstates are only read after construction
+unsafe impl Send for SecureHmacContext {}
+unsafe impl Sync for SecureHmacContext {}
+
+impl SecureHmacContext {
+    /// Key a context from `buffer`. The key is read under `read_consistent` together with
+    /// the epoch it belongs to, so a concurrent `rotate_key` can never pair midstates from
+    /// one key with the epoch of the next.
+    pub fn new(buffer: &SecureBuffer, algorithm: HmacAlgorithm) -> Result<Self, String> {
+        if buffer.is_empty() {
+            return Err("Buffer is invalid or empty".to_string());
+        }
+
+        // A retried read overwrites the previous attempt's midstates in place
+        let mut slot: Option<Box<ManuallyDrop<Midstate>>> = None;
+        let created_epoch = buffer
+            .read_consistent(|key| {
+                let epoch = buffer.key_epoch().load(Ordering::Acquire);
+                let midstate = ManuallyDrop::new(Self::midstate(key, algorithm));
+                match slot.as_mut() {
+                    Some(state) => **state = midstate,
+                    None => slot = Some(Box::new(midstate)),
+                }
+                epoch
+            })
+            .map_err(|_| "Buffer is invalid or empty".to_string())?;
+        let state = slot.expect("read_consistent ran the closure");
+        let (ptr, len) = (&**state as *const Midstate as *mut u8, std::mem::size_of::<Midstate>());
+        let locked = unsafe { memory::lock_memory(ptr, len) }.is_ok();
+
+        Ok(Self { state, algorithm, locked, key_epoch: Arc::clone(buffer.key_epoch()), created_epoch })
+    }
+
+    fn midstate(key: &[u8], algorithm: HmacAlgorithm) -> Midstate {
+        match algorithm {
+            HmacAlgorithm::Sha256 => {
+                let (inner, outer) = sha256_midstates(key);
+                Midstate::Sha256 { inner, outer }
+            }
+            HmacAlgorithm::Sha512 => {
+                let (inner, outer) = keyed::<Sha512, 128, _>(key, hasher_from::<Sha512, 128>);
+                Midstate::Sha512 { inner, outer }
+            }
+            HmacAlgorithm::Blake3 => Midstate::Blake3 { keyed: blake3_keyed(key) },
+        }
+    }
+
+    pub fn algorithm(&self) -> HmacAlgorithm {
+        self.algorithm
+    }
+
+    /// Whether the source buffer still holds the key this context was built from
+    pub fn is_current(&self) -> bool {
+        self.key_epoch.load(Ordering::Acquire) == self.created_epoch
+    }
+
+    /// MAC `message` into `out`, returning the digest length
+    pub fn mac_into(&self, message: &[u8], out: &mut [u8]) -> Result<usize, String> {
+        if !self.is_current() {
+            return Err("Key changed since the context was created".to_string());
+        }
+        let _timer = op_metrics::timer(MetricOp::Hmac);
+        let len = self.algorithm.digest_len();
+        let out = out.get_mut(..len).ok_or("Output buffer too small")?;
+        match &**self.state {
+            Midstate::Sha256 { inner, outer } => {
+                let mut digest = [[0u8; 32]];
+                finish_sha256_many(inner, outer, &[message], &mut digest);
+                out.copy_from_slice(&digest[0]);
+                digest.zeroize();
+            }
+            Midstate::Sha512 { inner, outer } => finish(inner, outer, message, out),
+            Midstate::Blake3 { keyed } => finish_blake3(keyed, message, out),
+        }
+        Ok(len)
+    }
+
+    /// MAC every message, digest i at `out[i * digest_len..]`. SHA-256 contexts hash the
+    /// whole batch on the multi-buffer engine; BLAKE3 parallelizes within each message.
+    pub fn mac_many_into(&self, messages: &[&[u8]], out: &mut [u8]) -> Result<usize, String> {
+        if !self.is_current() {
+            return Err("Key changed since the context was created".to_string());
+        }
+        let len = self.algorithm.digest_len();
+        let needed = messages.len().checked_mul(len).ok_or("Batch too large")?;
+        let out = out.get_mut(..needed).ok_or("Output buffer too small")?;
+        match &**self.state {
+            Midstate::Sha256 { inner, outer } => {
+                let mut digests = vec![[0u8; 32]; messages.len()];
+                finish_sha256_many(inner, outer, messages, &mut digests);
+                for (chunk, digest) in out.chunks_exact_mut(len).zip(&digests) {
+                    chunk.copy_from_slice(digest);
+                }
+                digests.zeroize();
+            }
+            Midstate::Sha512 { inner, outer } => {
+                for (message, chunk) in messages.iter().zip(out.chunks_exact_mut(len)) {
+                    finish(inner, outer, message, chunk);
+                }
+            }
+            Midstate::Blake3 { keyed } => {
+                for (message, chunk) in messages.iter().zip(out.chunks_exact_mut(len)) {
+                    finish_blake3(keyed, message, chunk);
+                }
+            }
+        }
+        Ok(needed)
+    }
+}
+
+impl Drop for SecureHmacContext {
+    fn drop(&mut self) {
+        let (ptr, len) = (&mut **self.state as *mut Midstate as *mut u8, std::mem::size_of::<Midstate>());
+        // The hashers hold only inline state, so they are wiped in place instead of dropped
+        unsafe {
+            memory::explicit_bzero(ptr, len);
+            if self.locked {
+                let _ = memory::unlock_memory(ptr, len);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_hmac_context_rfc4231() {
+        // RFC 4231 test case 2
+        let mut key = SecureBuffer::new(64).unwrap();
+        key.write(b"Jefe").unwrap();
+        let ctx = SecureHmacContext::new(&key, HmacAlgorithm::Sha256).unwrap();
+
+        let mut out = [0u8; 64];
+        assert_eq!(ctx.mac_into(b"what do ya want for nothing?", &mut out).unwrap(), 32);
+        assert_eq!(hex::encode(&out[..32]), "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+        // Midstates are reused, not consumed
+        ctx.mac_into(b"what do ya want for nothing?", &mut out).unwrap();
+        assert_eq!(hex::encode(&out[..32]), "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+
+        let ctx512 = SecureHmacContext::new(&key, HmacAlgorithm::Sha512).unwrap();
+        assert_eq!(ctx512.mac_into(b"what do ya want for nothing?", &mut out).unwrap(), 64);
+        assert_eq!(
+            hex::encode(out),
+            "164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea2505549758bf75c05a994a6d034f65f8f0e6fdcaeab1a34d4a6b4b636e070a38bce737"
+        );
+
+        // BLAKE3 keyed mode: a 32-byte key is used as-is, others are derived first
+        let mut key32 = SecureBuffer::new(32).unwrap();
+        key32.write(&[0x42; 32]).unwrap();
+        let ctx_b3 = SecureHmacContext::new(&key32, HmacAlgorithm::Blake3).unwrap();
+        assert_eq!(ctx_b3.mac_into(b"what do ya want for nothing?", &mut out).unwrap(), 32);
+        assert_eq!(&out[..32], blake3::keyed_hash(&[0x42; 32], b"what do ya want for nothing?").as_bytes());
+        let large = vec![0x5a; BLAKE3_RAYON_MIN + 1];
+        ctx_b3.mac_into(&large, &mut out).unwrap();
+        assert_eq!(&out[..32], blake3::keyed_hash(&[0x42; 32], &large).as_bytes());
+        let derived = SecureHmacContext::new(&key, HmacAlgorithm::Blake3).unwrap();
+        derived.mac_into(b"x", &mut out).unwrap();
+        assert_eq!(&out[..32], blake3::keyed_hash(&blake3::derive_key(BLAKE3_KEY_CONTEXT, b"Jefe"), b"x").as_bytes());
+
+        // Batches match one-at-a-time MACs
+        let messages: [&[u8]; 5] = [b"what do ya want for nothing?", b"", &[0xab; 100], b"x", &[7; 64]];
+        for algorithm in [HmacAlgorithm::Sha256, HmacAlgorithm::Sha512, HmacAlgorithm::Blake3] {
+            let ctx = SecureHmacContext::new(&key, algorithm).unwrap();
+            let len = algorithm.digest_len();
+            let mut batch = vec![0u8; messages.len() * len];
+            assert_eq!(ctx.mac_many_into(&messages, &mut batch).unwrap(), batch.len());
+            for (message, digest) in messages.iter().zip(batch.chunks_exact(len)) {
+                ctx.mac_into(message, &mut out).unwrap();
+                assert_eq!(digest, &out[..len]);
+            }
+        }
+
+        // Rotation invalidates contexts built from the old key
+        key.rotate_key().unwrap();
+        assert!(!ctx.is_current());
+        assert!(ctx.mac_into(b"msg", &mut out).is_err());
+        assert!(SecureHmacContext::new(&key, HmacAlgorithm::Sha256).unwrap().is_current());
+    }
+
+    #[test]
+    fn test_hmac_context_built_during_rotation() {
+        let mut key = SecureBuffer::new(64).unwrap();
+        key.write(&[0x11; 64]).unwrap();
+        let midstates_now = || key.read_consistent(|bytes| (key.key_epoch().load(Ordering::Acquire), sha256_midstates(bytes))).unwrap();
+        let done = std::sync::atomic::AtomicBool::new(false);
+
+        // The rotating thread records the midstates of every key it installs
+        let (rotated, built) = std::thread::scope(|scope| {
+            let rotator = scope.spawn(|| {
+                let mut rotated = vec![midstates_now()];
+                for _ in 0..5_000 {
+                    key.rotate_key().unwrap();
+                    rotated.push(midstates_now());
+                }
+                done.store(true, Ordering::Release);
+                rotated
+            });
+            let mut built = Vec::new();
+            while !done.load(Ordering::Acquire) {
+                let ctx = SecureHmacContext::new(&key, HmacAlgorithm::Sha256).unwrap();
+                let Midstate::Sha256 { inner, outer } = &**ctx.state else { unreachable!() };
+                built.push((ctx.created_epoch, (*inner, *outer)));
+            }
+            (rotator.join().unwrap(), built)
+        });
+
+        // Every context holds the midstates of the key its epoch names
+        let rotated: std::collections::HashMap<_, _> = rotated.into_iter().collect();
+        for (epoch, midstates) in built {
+            assert_eq!(rotated[&epoch], midstates);
+        }
+    }
+}
@@ -0,0 +1,561 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - PBKDF2 derivation service
+// PBKDF2-HMAC-SHA256 (RFC 8018) off the caller's thread. The password is reduced to HMAC
+// midstates at submission, so it never crosses threads; a fixed set of workers then
+// runs the iteration chains of up to eight derivations in lockstep on the multi-buffer
+// SHA-256 engine, pulling the next queued request as soon as a lane frees up. Work beyond
+// the queue bound or the iteration cap is refused instead of queued, so a login storm
+// cannot stretch latency for everything else.
+
+use std::collections::VecDeque;
+use std::fmt::Write as _;
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::JoinHandle;
+use std::time::{Duration, Instant};
+
+use zeroize::Zeroize;
+
+use crate::audit_log::{self, AuditKind};
+use crate::op_metrics::{self, MetricOp};
+use crate::secure_hmac::sha256_midstates;
+use crate::sha256_batch::{self, Sha256Job, SHA256_LANES};
+use crate::SecureBuffer;
+
+/// Default cap on `iterations` for one request
+pub const KDF_DEFAULT_MAX_ITERATIONS: u32 = 2_000_000;
+
+/// Largest derived key a job may request
+pub const KDF_MAX_OUTPUT: usize = 1024;
+
+/// Upper bounds (microseconds) of the latency histogram buckets, before +Inf
+const LATENCY_BUCKETS_US: [u64; 10] = [1_000, 5_000, 10_000, 25_000, 50_000, 100_000, 250_000, 500_000, 1_000_000, 2_500_000];
+
+#[derive(Debug, thiserror::Error, PartialEq, Eq)]
+pub enum KdfError {
+    #[error("Invalid derivation parameters")]
+    InvalidInput,
+    #[error("Iteration count above the service cap")]
+    CostExceeded,
+    #[error("Derivation queue is full")]
+    QueueFull,
+}
+
+/// Process-wide derivation counters for `securebuffer_get_prometheus_metrics`
+pub(crate) struct KdfCounters {
+    pub submitted: AtomicU64,
+    pub completed: AtomicU64,
+    pub rejected: AtomicU64,
+    pub queued: AtomicU64,
+    pub running: AtomicU64,
+    latency_buckets: [AtomicU64; LATENCY_BUCKETS_US.len() + 1],
+    latency_sum_us: AtomicU64,
+    queue_wait_sum_us: AtomicU64,
+}
+
+pub(crate) static GLOBAL_KDF_COUNTERS: KdfCounters = KdfCounters {
+    submitted: AtomicU64::new(0),
+    completed: AtomicU64::new(0),
+    rejected: AtomicU64::new(0),
+    queued: AtomicU64::new(0),
+    running: AtomicU64::new(0),
+    latency_buckets: [const { AtomicU64::new(0) }; LATENCY_BUCKETS_US.len() + 1],
+    latency_sum_us: AtomicU64::new(0),
+    queue_wait_sum_us: AtomicU64::new(0),
+};
+
+impl KdfCounters {
+    fn observe(&self, queue_wait: Duration, total: Duration) {
+        let total_us = total.as_micros() as u64;
+        let bucket = LATENCY_BUCKETS_US.iter().position(|&le| total_us <= le).unwrap_or(LATENCY_BUCKETS_US.len());
+        self.latency_buckets[bucket].fetch_add(1, Ordering::Relaxed);
+        self.latency_sum_us.fetch_add(total_us, Ordering::Relaxed);
+        self.queue_wait_sum_us.fetch_add(queue_wait.as_micros() as u64, Ordering::Relaxed);
+        self.completed.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Append the derivation metrics in Prometheus text format
+    pub(crate) fn write_prometheus(&self, out: &mut String) {
+        let load = |c: &AtomicU64| c.load(Ordering::Relaxed);
+        for (name, kind, help, value) in [
+            ("securebuffer_kdf_submitted_total", "counter", "Derivations accepted", load(&self.submitted)),
+            ("securebuffer_kdf_rejected_total", "counter", "Derivations refused by the queue bound or cost cap", load(&self.rejected)),
+            ("securebuffer_kdf_queue_depth", "gauge", "Derivations waiting for a worker", load(&self.queued)),
+            ("securebuffer_kdf_running", "gauge", "Derivations on a worker", load(&self.running)),
+        ] {
+            let _ = writeln!(out, "# HELP {name} {help}\n# TYPE {name} {kind}\n{name} {value}");
+        }
+
+        let name = "securebuffer_kdf_latency_seconds";
+        let _ = writeln!(out, "# HELP {name} Submission to completion time\n# TYPE {name} histogram");
+        let mut cumulative = 0;
+        for (i, bucket) in self.latency_buckets.iter().enumerate() {
+            cumulative += load(bucket);
+            match LATENCY_BUCKETS_US.get(i) {
+                Some(le) => { let _ = writeln!(out, "{name}_bucket{{le=\"{}\"}} {cumulative}", *le as f64 / 1e6); }
+                None => { let _ = writeln!(out, "{name}_bucket{{le=\"+Inf\"}} {cumulative}"); }
+            }
+        }
+        let _ = writeln!(out, "{name}_sum {}\n{name}_count {cumulative}", load(&self.latency_sum_us) as f64 / 1e6);
+        let _ = writeln!(
+            out,
+            "# HELP securebuffer_kdf_queue_wait_seconds_total Time derivations spent queued\n# TYPE securebuffer_kdf_queue_wait_seconds_total counter\nsecurebuffer_kdf_queue_wait_seconds_total {}",
+            load(&self.queue_wait_sum_us) as f64 / 1e6
+        );
+    }
+}
+
+/// One PBKDF2 output block: T_i = U_1 ^ ... ^ U_c
+struct Chain {
+    inner: [u32; 8],
+    outer: [u32; 8],
+    u: [u32; 8],
+    t: [u32; 8],
+    remaining: u32,
+    block: usize,
+    job: Option<Arc<KdfJob>>,
+}
+
+impl Drop for Chain {
+    fn drop(&mut self) {
+        self.inner.zeroize();
+        self.outer.zeroize();
+        self.u.zeroize();
+        self.t.zeroize();
+    }
+}
+
+fn words(bytes: &[u8; 32]) -> [u32; 8] {
+    std::array::from_fn(|i| u32::from_be_bytes(bytes[4 * i..4 * i + 4].try_into().unwrap_or_default()))
+}
+
+/// The single padded block holding a 32-byte message after a 64-byte HMAC key block
+fn hmac_block(message: &[u32; 8]) -> [u8; 64] {
+    let mut block = [0u8; 64];
+    for (chunk, word) in block.chunks_exact_mut(4).zip(message) {
+        chunk.copy_from_slice(&word.to_be_bytes());
+    }
+    block[32] = 0x80;
+    block[56..].copy_from_slice(&(96u64 * 8).to_be_bytes());
+    block
+}
+
+/// Chains for every output block, with U_1 already computed
+fn start_chains(password: &[u8], salt: &[u8], iterations: u32, out_len: usize, job: Option<&Arc<KdfJob>>) -> Vec<Chain> {
+    let (inner, outer) = sha256_midstates(password);
+    (0..out_len.div_ceil(32))
+        .map(|block| {
+            let index = (block as u32 + 1).to_be_bytes();
+            let mut digest = [[0u8; 32]];
+            sha256_batch::digest_many(&[Sha256Job::resume(inner, 64, [salt, &index, &[]])], &mut digest);
+            let inner_digest = digest[0];
+            sha256_batch::digest_many(&[Sha256Job::resume(outer, 64, [&inner_digest[..], &[], &[]])], &mut digest);
+            let u = words(&digest[0]);
+            digest.zeroize();
+            Chain { inner, outer, u, t: u, remaining: iterations - 1, block, job: job.cloned() }
+        })
+        .collect()
+}
+
+/// One iteration (two compressions) for every chain, eight lanes per pass
+fn step(chains: &mut [&mut Chain]) {
+    for group in chains.chunks_mut(SHA256_LANES) {
+        let mut states = [[0u32; 8]; SHA256_LANES];
+        let mut blocks = [[0u8; 64]; SHA256_LANES];
+        let n = group.len();
+        for (k, chain) in group.iter().enumerate() {
+            states[k] = chain.inner;
+            blocks[k] = hmac_block(&chain.u);
+        }
+        sha256_batch::compress_many(&mut states[..n], &blocks[..n]);
+        for (k, chain) in group.iter().enumerate() {
+            blocks[k] = hmac_block(&states[k]);
+            states[k] = chain.outer;
+        }
+        sha256_batch::compress_many(&mut states[..n], &blocks[..n]);
+        for (k, chain) in group.iter_mut().enumerate() {
+            chain.u = states[k];
+            for (t, u) in chain.t.iter_mut().zip(&chain.u) {
+                *t ^= u;
+            }
+            chain.remaining -= 1;
+        }
+        states.zeroize();
+        blocks.zeroize();
+    }
+}
+
+/// Run chains until every one has finished its iterations
+fn run_to_completion(chains: &mut [Chain]) {
+    loop {
+        let mut live: Vec<&mut Chain> = chains.iter_mut().filter(|c| c.remaining > 0).collect();
+        if live.is_empty() {
+            return;
+        }
+        step(&mut live);
+    }
+}
+
+fn write_block(out: &mut [u8], chain: &Chain) {
+    let start = chain.block * 32;
+    let end = (start + 32).min(out.len());
+    for (i, byte) in out[start..end].iter_mut().enumerate() {
+        *byte = chain.t[i / 4].to_be_bytes()[i % 4];
+    }
+}
+
+/// Synchronous PBKDF2-HMAC-SHA256 into `out`; multi-block outputs run their chains side by side
+pub fn pbkdf2_hmac_sha256(password: &[u8], salt: &[u8], iterations: u32, out: &mut [u8]) -> Result<(), KdfError> {
+    if iterations == 0 || out.is_empty() {
+        return Err(KdfError::InvalidInput);
+    }
+    let mut chains = start_chains(password, salt, iterations, out.len(), None);
+    run_to_completion(&mut chains);
+    for chain in &chains {
+        write_block(out, chain);
+    }
+    Ok(())
+}
+
+/// Callback run on the worker thread when a job completes, before polls and waiters see it
+/// ready; it may take the key. Keep it short.
+pub type KdfCallback = Box<dyn Fn(&KdfJob) + Send + Sync>;
+
+enum JobState {
+    Pending,
+    Completing, // Key derived and takeable, callback running; not yet reported ready
+    Ready,
+    Taken,
+}
+
+impl JobState {
+    fn is_finished(&self) -> bool {
+        matches!(self, JobState::Ready | JobState::Taken)
+    }
+}
+
+/// Handle to one queued derivation
+pub struct KdfJob {
+    state: Mutex<JobState>,
+    done: Condvar,
+    /// Derived key, filled block by block in locked memory
+    output: Mutex<SecureBuffer>,
+    chains_left: AtomicUsize,
+    callback: Option<KdfCallback>,
+    submitted: Instant,
+    queue_wait_us: AtomicU64,
+}
+
+impl KdfJob {
+    pub fn is_ready(&self) -> bool {
+        self.state.lock().unwrap_or_else(|e| e.into_inner()).is_finished()
+    }
+
+    /// Block until the key is derived or `timeout` passes; true once ready
+    pub fn wait(&self, timeout: Option<Duration>) -> bool {
+        let state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+        let pending = |s: &mut JobState| !s.is_finished();
+        let state = match timeout {
+            Some(t) => self.done.wait_timeout_while(state, t, pending).unwrap_or_else(|e| e.into_inner()).0,
+            None => self.done.wait_while(state, pending).unwrap_or_else(|e| e.into_inner()),
+        };
+        state.is_finished()
+    }
+
+    /// Copy the derived key into `dest` and wipe the job's copy; None unless ready
+    pub fn take_into(&self, dest: &mut SecureBuffer) -> Option<Result<(), String>> {
+        let mut state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+        if !matches!(*state, JobState::Ready | JobState::Completing) {
+            return None;
+        }
+        let mut output = self.output.lock().unwrap_or_else(|e| e.into_inner());
+        let result = output.as_slice().and_then(|key| dest.write(key));
+        if result.is_ok() {
+            output.clear();
+            *state = JobState::Taken;
+        }
+        Some(result)
+    }
+
+    /// Store a finished block; true when it was the job's last
+    fn finish_chain(&self, chain: &Chain) -> bool {
+        write_block(self.output.lock().unwrap_or_else(|e| e.into_inner()).contents_mut(), chain);
+        self.chains_left.fetch_sub(1, Ordering::AcqRel) == 1
+    }
+
+    fn complete(&self) {
+        let wait = Duration::from_micros(self.queue_wait_us.load(Ordering::Relaxed));
+        let total = self.submitted.elapsed();
+        GLOBAL_KDF_COUNTERS.observe(wait, total);
+        op_metrics::record(MetricOp::Derive, total);
+        if audit_log::is_enabled() {
+            let output = self.output.lock().unwrap_or_else(|e| e.into_inner());
+            audit_log::record(AuditKind::KeyDerived, output.id(), output.len() as u64, 0);
+        }
+        *self.state.lock().unwrap_or_else(|e| e.into_inner()) = JobState::Completing;
+        if let Some(callback) = &self.callback {
+            callback(self);
+        }
+        // Published after the callback, so a woken waiter knows it has run
+        let mut state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+        if matches!(*state, JobState::Completing) {
+            *state = JobState::Ready;
+        }
+        drop(state);
+        self.done.notify_all();
+    }
+}
+
+struct Request {
+    job: Arc<KdfJob>,
+    chains: Vec<Chain>,
+}
+
+struct Shared {
+    queue: Mutex<VecDeque<Request>>,
+    ready: Condvar,
+    shutdown: AtomicBool,
+    max_queue: usize,
+    max_iterations: u32,
+    submitted: AtomicU64,
+    completed: AtomicU64,
+    rejected: AtomicU64,
+}
+
+/// Service statistics
+#[derive(Clone, Debug, Default)]
+pub struct KdfStats {
+    pub submitted: u64,
+    pub completed: u64,
+    pub rejected: u64,
+    pub queued: u64,
+    pub workers: u64,
+}
+
+/// Bounded worker pool for PBKDF2 derivations. Dropping the service lets the workers
+/// finish everything already queued.
+pub struct KdfService {
+    shared: Arc<Shared>,
+    workers: Vec<JoinHandle<()>>,
+}
+
+impl KdfService {
+    /// `workers` == 0 uses half the available cores; `max_iterations` == 0 uses
+    /// `KDF_DEFAULT_MAX_ITERATIONS`
+    pub fn new(workers: usize, max_queue: usize, max_iterations: u32) -> Result<Self, String> {
+        if max_queue == 0 {
+            return Err("Queue bound must be greater than 0".to_string());
+        }
+        let workers = match workers {
+            0 => std::thread::available_parallelism().map_or(1, |n| (n.get() / 2).max(1)),
+            n => n,
+        };
+        let shared = Arc::new(Shared {
+            queue: Mutex::new(VecDeque::with_capacity(max_queue)),
+            ready: Condvar::new(),
+            shutdown: AtomicBool::new(false),
+            max_queue,
+            max_iterations: if max_iterations == 0 { KDF_DEFAULT_MAX_ITERATIONS } else { max_iterations },
+            submitted: AtomicU64::new(0),
+            completed: AtomicU64::new(0),
+            rejected: AtomicU64::new(0),
+        });
+
+        let workers = (0..workers)
+            .map(|i| {
+                let shared = Arc::clone(&shared);
+                std::thread::Builder::new()
+                    .name(format!("securebuffer-kdf-{i}"))
+                    .spawn(move || worker(&shared))
+                    .map_err(|e| e.to_string())
+            })
+            .collect::<Result<Vec<_>, _>>()?;
+        Ok(Self { shared, workers })
+    }
+
+    /// Queue a derivation of `out_len` bytes. Fails fast with `QueueFull` instead of waiting.
+    pub fn submit(
+        &self,
+        password: &[u8],
+        salt: &[u8],
+        iterations: u32,
+        out_len: usize,
+        callback: Option<KdfCallback>,
+    ) -> Result<Arc<KdfJob>, KdfError> {
+        let reject = |e: KdfError| {
+            self.shared.rejected.fetch_add(1, Ordering::Relaxed);
+            GLOBAL_KDF_COUNTERS.rejected.fetch_add(1, Ordering::Relaxed);
+            Err(e)
+        };
+        if iterations == 0 || out_len == 0 || out_len > KDF_MAX_OUTPUT {
+            return reject(KdfError::InvalidInput);
+        }
+        if iterations > self.shared.max_iterations {
+            return reject(KdfError::CostExceeded);
+        }
+        // Cheap early check so a full queue costs no hashing
+        if self.shared.queue.lock().unwrap_or_else(|e| e.into_inner()).len() >= self.shared.max_queue {
+            return reject(KdfError::QueueFull);
+        }
+
+        let mut output = SecureBuffer::new(out_len).map_err(|_| KdfError::InvalidInput)?;
+        output.staged(&[], out_len).map_err(|_| KdfError::InvalidInput)?;
+        let job = Arc::new(KdfJob {
+            state: Mutex::new(JobState::Pending),
+            done: Condvar::new(),
+            output: Mutex::new(output),
+            chains_left: AtomicUsize::new(out_len.div_ceil(32)),
+            callback,
+            submitted: Instant::now(),
+            queue_wait_us: AtomicU64::new(0),
+        });
+        let chains = start_chains(password, salt, iterations, out_len, Some(&job));
+
+        {
+            let mut queue = self.shared.queue.lock().unwrap_or_else(|e| e.into_inner());
+            if queue.len() >= self.shared.max_queue {
+                drop(queue);
+                return reject(KdfError::QueueFull);
+            }
+            queue.push_back(Request { job: Arc::clone(&job), chains });
+        }
+        self.shared.submitted.fetch_add(1, Ordering::Relaxed);
+        GLOBAL_KDF_COUNTERS.submitted.fetch_add(1, Ordering::Relaxed);
+        GLOBAL_KDF_COUNTERS.queued.fetch_add(1, Ordering::Relaxed);
+        self.shared.ready.notify_one();
+        Ok(job)
+    }
+
+    pub fn stats(&self) -> KdfStats {
+        KdfStats {
+            submitted: self.shared.submitted.load(Ordering::Relaxed),
+            completed: self.shared.completed.load(Ordering::Relaxed),
+            rejected: self.shared.rejected.load(Ordering::Relaxed),
+            queued: self.shared.queue.lock().unwrap_or_else(|e| e.into_inner()).len() as u64,
+            workers: self.workers.len() as u64,
+        }
+    }
+}
+
+impl Drop for KdfService {
+    fn drop(&mut self) {
+        self.shared.shutdown.store(true, Ordering::Release);
+        self.shared.ready.notify_all();
+        for worker in self.workers.drain(..) {
+            let _ = worker.join();
+        }
+    }
+}
+
+/// Next request: waits while the worker is idle, never while it still has chains running
+fn next_request(shared: &Shared, idle: bool) -> Option<Request> {
+    let mut queue = shared.queue.lock().unwrap_or_else(|e| e.into_inner());
+    loop {
+        if let Some(request) = queue.pop_front() {
+            return Some(request);
+        }
+        if !idle || shared.shutdown.load(Ordering::Acquire) {
+            return None;
+        }
+        queue = shared.ready.wait(queue).unwrap_or_else(|e| e.into_inner());
+    }
+}
+
+fn worker(shared: &Shared) {
+    let mut active: Vec<Chain> = Vec::with_capacity(2 * SHA256_LANES);
+    loop {
+        while active.len() < SHA256_LANES {
+            let Some(request) = next_request(shared, active.is_empty()) else { break };
+            GLOBAL_KDF_COUNTERS.queued.fetch_sub(1, Ordering::Relaxed);
+            GLOBAL_KDF_COUNTERS.running.fetch_add(1, Ordering::Relaxed);
+            request.job.queue_wait_us.store(request.job.submitted.elapsed().as_micros() as u64, Ordering::Relaxed);
+            active.extend(request.chains);
+        }
+        if active.is_empty() {
+            return;
+        }
+
+        let mut live: Vec<&mut Chain> = active.iter_mut().filter(|c| c.remaining > 0).collect();
+        if !live.is_empty() {
+            step(&mut live);
+        }
+
+        let mut i = 0;
+        while i < active.len() {
+            if active[i].remaining == 0 {
+                let chain = active.swap_remove(i);
+                if let Some(job) = chain.job.as_ref().filter(|job| job.finish_chain(&chain)) {
+                    GLOBAL_KDF_COUNTERS.running.fetch_sub(1, Ordering::Relaxed);
+                    shared.completed.fetch_add(1, Ordering::Relaxed);
+                    job.complete();
+                }
+            } else {
+                i += 1;
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_pbkdf2_vectors() {
+        // RFC 7914 section 11
+        let mut out = [0u8; 64];
+        pbkdf2_hmac_sha256(b"passwd", b"salt", 1, &mut out).unwrap();
+        assert_eq!(
+            hex::encode(out),
+            "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783"
+        );
+        pbkdf2_hmac_sha256(b"Password", b"NaCl", 80000, &mut out).unwrap();
+        assert_eq!(
+            hex::encode(out),
+            "4ddcd8f60b98be21830cee5ef22701f9641a4418d04c0414aeff08876b34ab56a1d425a1225833549adb841b51c9b3176a272bdebba1d078478f62b397f33c8d"
+        );
+    }
+
+    #[test]
+    fn test_kdf_service() {
+        let service = KdfService::new(2, 4, 10_000).unwrap();
+        assert_eq!(service.submit(b"pw", b"salt", 20_000, 32, None).err(), Some(KdfError::CostExceeded));
+
+        let fired = Arc::new(AtomicUsize::new(0));
+        let jobs: Vec<Arc<KdfJob>> = (0..4u32)
+            .map(|i| {
+                let fired = Arc::clone(&fired);
+                let callback: KdfCallback = Box::new(move |_| {
+                    fired.fetch_add(1, Ordering::SeqCst);
+                });
+                service.submit(format!("pw{i}").as_bytes(), b"salt", 1000 + i * 500, 40, Some(callback)).unwrap()
+            })
+            .collect();
+
+        for (i, job) in jobs.iter().enumerate() {
+            assert!(job.wait(Some(Duration::from_secs(30))));
+            let mut expected = [0u8; 40];
+            pbkdf2_hmac_sha256(format!("pw{i}").as_bytes(), b"salt", 1000 + i as u32 * 500, &mut expected).unwrap();
+            let mut key = SecureBuffer::new(40).unwrap();
+            job.take_into(&mut key).unwrap().unwrap();
+            assert_eq!(key.as_slice().unwrap(), expected);
+            assert!(job.take_into(&mut key).is_none());
+        }
+        assert_eq!(fired.load(Ordering::SeqCst), 4);
+        assert_eq!(service.stats().completed, 4);
+
+        // A callback can take the key before anyone else sees the job ready
+        let taken = Arc::new(AtomicUsize::new(0));
+        let seen = Arc::clone(&taken);
+        let callback: KdfCallback = Box::new(move |job| {
+            let mut key = SecureBuffer::new(32).unwrap();
+            if job.take_into(&mut key).is_some_and(|r| r.is_ok()) {
+                seen.fetch_add(1, Ordering::SeqCst);
+            }
+        });
+        let job = service.submit(b"pw", b"salt", 1000, 32, Some(callback)).unwrap();
+        assert!(job.wait(Some(Duration::from_secs(30))));
+        assert_eq!(taken.load(Ordering::SeqCst), 1);
+        assert!(job.take_into(&mut SecureBuffer::new(32).unwrap()).is_none());
+    }
+}
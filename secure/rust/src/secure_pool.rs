@@ -0,0 +1,425 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - SecureBuffer Pool
+// Size-classed slabs carved from a few large locked, guard-paged arenas, so churning
+// short-lived secrets costs a free-list pop and a zeroize instead of alloc + mlock each.
+// A NUMA pool keeps one set of arenas per node and serves each thread from its own node.
+
+use std::sync::atomic::{AtomicU32, AtomicU64, AtomicU8, Ordering};
+use std::sync::OnceLock;
+
+use crate::memory;
+use crate::numa::{self, Placement};
+
+/// Slot sizes, smallest first; a request gets the smallest class that fits
+pub const POOL_SIZE_CLASSES: [usize; 8] = [32, 64, 128, 256, 512, 1024, 2048, 4096];
+
+/// Largest request a pool can serve; bigger secrets use `SecureBuffer::new`
+pub const POOL_MAX_SLOT: usize = 4096;
+
+/// Default bytes of slots per size class
+pub const POOL_DEFAULT_ARENA_BYTES: usize = 1 << 20;
+
+const SLOT_FREE: u8 = 0;
+const SLOT_IN_USE: u8 = 1;
+
+/// Process-wide pool counters, folded into `securebuffer_get_global_metrics`
+pub(crate) struct PoolCounters {
+    pub acquisitions: AtomicU64,
+    pub releases: AtomicU64,
+    pub exhaustions: AtomicU64,
+    pub bytes_locked: AtomicU64,
+}
+
+pub(crate) static GLOBAL_POOL_COUNTERS: PoolCounters = PoolCounters {
+    acquisitions: AtomicU64::new(0),
+    releases: AtomicU64::new(0),
+    exhaustions: AtomicU64::new(0),
+    bytes_locked: AtomicU64::new(0),
+};
+
+/// Pool statistics
+#[derive(Clone, Debug, Default)]
+pub struct PoolStats {
+    pub acquisitions: u64,
+    pub releases: u64,
+    pub exhaustions: u64,   // Acquires refused because the class was full
+    pub invalid_releases: u64, // Double or foreign releases rejected
+    pub in_use: u64,
+    pub bytes_reserved: u64,
+    pub bytes_locked: u64,
+}
+
+/// One contiguous run of slots, with an inaccessible guard page on either side
+struct Arena {
+    slots: *mut u8,
+    slots_len: usize,
+    map_base: *mut u8,
+    map_len: usize,
+    locked: bool,
+}
+
+impl Arena {
+    #[cfg(unix)]
+    fn map(slots_len: usize, node: Option<usize>) -> Result<Self, String> {
+        let page = unsafe { libc::sysconf(libc::_SC_PAGESIZE) }.max(4096) as usize;
+        let slots_len = slots_len.div_ceil(page) * page;
+        let map_len = slots_len + 2 * page;
+
+        let base = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                map_len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_PRIVATE | libc::MAP_ANONYMOUS,
+                -1,
+                0,
+            )
+        };
+        if base == libc::MAP_FAILED {
+            return Err("Failed to map pool arena".to_string());
+        }
+        let base = base as *mut u8;
+        let slots = unsafe { base.add(page) };
+        unsafe {
+            // Overruns off either end fault instead of reading a neighbour's secret
+            libc::mprotect(base as *mut libc::c_void, page, libc::PROT_NONE);
+            libc::mprotect(slots.add(slots_len) as *mut libc::c_void, page, libc::PROT_NONE);
+            #[cfg(target_os = "linux")]
+            libc::madvise(slots as *mut libc::c_void, slots_len, libc::MADV_DONTDUMP);
+            // Placed before mlock faults the pages in
+            if let Some(node) = node {
+                numa::bind(slots, slots_len, Placement::Node(node));
+            }
+        }
+
+        // One mlock for the whole arena instead of one per buffer
+        let locked = unsafe { memory::lock_memory(slots, slots_len) }.is_ok();
+        Ok(Self { slots, slots_len, map_base: base, map_len, locked })
+    }
+
+    #[cfg(not(unix))]
+    fn map(slots_len: usize, _node: Option<usize>) -> Result<Self, String> {
+        use std::alloc::{alloc_zeroed, Layout};
+
+        let layout = Layout::from_size_align(slots_len, 4096).map_err(|_| "Invalid arena layout".to_string())?;
+        let slots = unsafe { alloc_zeroed(layout) };
+        if slots.is_null() {
+            return Err("Failed to allocate pool arena".to_string());
+        }
+        let locked = unsafe { memory::lock_memory(slots, slots_len) }.is_ok();
+        Ok(Self { slots, slots_len, map_base: slots, map_len: slots_len, locked })
+    }
+}
+
+impl Drop for Arena {
+    fn drop(&mut self) {
+        unsafe {
+            memory::explicit_bzero(self.slots, self.slots_len);
+            if self.locked {
+                let _ = memory::unlock_memory(self.slots, self.slots_len);
+            }
+            #[cfg(unix)]
+            libc::munmap(self.map_base as *mut libc::c_void, self.map_len);
+            #[cfg(not(unix))]
+            std::alloc::dealloc(self.map_base, std::alloc::Layout::from_size_align_unchecked(self.map_len, 4096));
+        }
+    }
+}
+
+/// Slots of one size. The free list is a Treiber stack of slot indices whose links
+/// live outside the secret memory, so released slots stay all-zero; the head packs
+/// an ABA tag (high 32 bits) with the top slot index + 1 (low 32 bits, 0 = empty).
+struct SizeClass {
+    slot_size: usize,
+    slot_count: usize,
+    node: Option<usize>, // NUMA node the arena is placed on; None = first touch
+    arena: OnceLock<Result<Arena, String>>,
+    head: AtomicU64,
+    next: Box<[AtomicU32]>,
+    state: Box<[AtomicU8]>,
+    in_use: AtomicU64,
+}
+
+impl SizeClass {
+    fn new(slot_size: usize, arena_bytes: usize, node: Option<usize>) -> Self {
+        let slot_count = (arena_bytes / slot_size).clamp(1, u32::MAX as usize - 1);
+        // Every slot starts on the free list, lowest address on top
+        let next: Box<[AtomicU32]> = (0..slot_count)
+            .map(|i| AtomicU32::new(if i + 1 < slot_count { i as u32 + 2 } else { 0 }))
+            .collect();
+        Self {
+            slot_size,
+            slot_count,
+            node,
+            arena: OnceLock::new(),
+            head: AtomicU64::new(1),
+            next,
+            state: (0..slot_count).map(|_| AtomicU8::new(SLOT_FREE)).collect(),
+            in_use: AtomicU64::new(0),
+        }
+    }
+
+    /// The arena is mapped on first use, so unused classes cost no locked memory
+    fn arena(&self) -> Option<&Arena> {
+        self.arena
+            .get_or_init(|| {
+                let arena = Arena::map(self.slot_size * self.slot_count, self.node);
+                if let Ok(a) = &arena {
+                    if a.locked {
+                        GLOBAL_POOL_COUNTERS.bytes_locked.fetch_add(a.slots_len as u64, Ordering::Relaxed);
+                    }
+                }
+                arena
+            })
+            .as_ref()
+            .ok()
+    }
+
+    fn pop(&self) -> Option<usize> {
+        let mut head = self.head.load(Ordering::Acquire);
+        loop {
+            let top = head as u32;
+            if top == 0 {
+                return None;
+            }
+            let next = self.next[top as usize - 1].load(Ordering::Relaxed);
+            let new = ((head >> 32).wrapping_add(1) << 32) | next as u64;
+            match self.head.compare_exchange_weak(head, new, Ordering::AcqRel, Ordering::Acquire) {
+                Ok(_) => return Some(top as usize - 1),
+                Err(current) => head = current,
+            }
+        }
+    }
+
+    fn push(&self, slot: usize) {
+        let mut head = self.head.load(Ordering::Acquire);
+        loop {
+            self.next[slot].store(head as u32, Ordering::Relaxed);
+            let new = ((head >> 32).wrapping_add(1) << 32) | (slot as u64 + 1);
+            match self.head.compare_exchange_weak(head, new, Ordering::AcqRel, Ordering::Acquire) {
+                Ok(_) => return,
+                Err(current) => head = current,
+            }
+        }
+    }
+
+    /// Slot index of `ptr` if it is the start of one of this class's slots
+    fn slot_of(&self, ptr: *const u8) -> Option<usize> {
+        let arena = self.arena.get()?.as_ref().ok()?;
+        let offset = (ptr as usize).checked_sub(arena.slots as usize)?;
+        (offset % self.slot_size == 0 && offset / self.slot_size < self.slot_count).then_some(offset / self.slot_size)
+    }
+}
+
+/// Pool of locked secret slots. Acquire and release are lock-free and O(1); a
+/// released slot is zeroized before it goes back on the free list.
+pub struct SecureBufferPool {
+    classes: Vec<SizeClass>, // POOL_SIZE_CLASSES for node 0, then for node 1, ...
+    nodes: usize,
+    acquisitions: AtomicU64,
+    releases: AtomicU64,
+    exhaustions: AtomicU64,
+    invalid_releases: AtomicU64,
+}
+
+// Slots are handed out exclusively and the free lists are atomic
+unsafe impl Send for SecureBufferPool {}
+unsafe impl Sync for SecureBufferPool {}
+
+impl SecureBufferPool {
+    /// Create a pool holding `arena_bytes` of slots per size class (0 = default)
+    pub fn new(arena_bytes: usize) -> Self {
+        Self::with_nodes(arena_bytes, None)
+    }
+
+    /// Create a pool with `arena_bytes` of slots per size class on every NUMA node. Threads
+    /// acquire from their own node's arenas and fall back to another node's when those are
+    /// full. On a single-node host this is `new`.
+    pub fn new_numa(arena_bytes: usize) -> Self {
+        Self::with_nodes(arena_bytes, numa::is_numa().then(numa::node_count))
+    }
+
+    fn with_nodes(arena_bytes: usize, nodes: Option<usize>) -> Self {
+        let arena_bytes = if arena_bytes == 0 { POOL_DEFAULT_ARENA_BYTES } else { arena_bytes };
+        let classes = match nodes {
+            Some(nodes) => (0..nodes)
+                .flat_map(|node| POOL_SIZE_CLASSES.iter().map(move |&size| SizeClass::new(size, arena_bytes, Some(node))))
+                .collect(),
+            None => POOL_SIZE_CLASSES.iter().map(|&size| SizeClass::new(size, arena_bytes, None)).collect(),
+        };
+        Self {
+            classes,
+            nodes: nodes.unwrap_or(1),
+            acquisitions: AtomicU64::new(0),
+            releases: AtomicU64::new(0),
+            exhaustions: AtomicU64::new(0),
+            invalid_releases: AtomicU64::new(0),
+        }
+    }
+
+    /// Acquire a zeroed slot of at least `size` bytes, or None when `size` is 0 or above
+    /// `POOL_MAX_SLOT`, or the class is exhausted
+    pub fn acquire(&self, size: usize) -> Option<PooledBuffer<'_>> {
+        let ptr = self.acquire_raw(size)?;
+        Some(PooledBuffer { pool: self, ptr, len: size })
+    }
+
+    /// `acquire` returning the bare slot pointer; hand it back with `release_raw`
+    pub fn acquire_raw(&self, size: usize) -> Option<*mut u8> {
+        if size == 0 || size > POOL_MAX_SLOT {
+            return None;
+        }
+        let index = POOL_SIZE_CLASSES.iter().position(|&slot_size| slot_size >= size)?;
+        let local = if self.nodes > 1 { numa::current_node() % self.nodes } else { 0 };
+
+        // Own node first; a remote slot still beats an unpooled allocation
+        let found = (0..self.nodes).find_map(|i| {
+            let class = &self.classes[(local + i) % self.nodes * POOL_SIZE_CLASSES.len() + index];
+            let arena = class.arena()?;
+            class.pop().map(|slot| (class, arena, slot))
+        });
+        let Some((class, arena, slot)) = found else {
+            self.exhaustions.fetch_add(1, Ordering::Relaxed);
+            GLOBAL_POOL_COUNTERS.exhaustions.fetch_add(1, Ordering::Relaxed);
+            return None;
+        };
+        class.state[slot].store(SLOT_IN_USE, Ordering::Relaxed);
+        class.in_use.fetch_add(1, Ordering::Relaxed);
+        self.acquisitions.fetch_add(1, Ordering::Relaxed);
+        GLOBAL_POOL_COUNTERS.acquisitions.fetch_add(1, Ordering::Relaxed);
+        Some(unsafe { arena.slots.add(slot * class.slot_size) })
+    }
+
+    /// Zeroize and return a slot. Pointers that are not a live slot of this pool
+    /// (double releases included) are rejected and leave the pool untouched.
+    pub fn release_raw(&self, ptr: *mut u8) -> Result<(), String> {
+        let found = self.classes.iter().find_map(|c| c.slot_of(ptr).map(|slot| (c, slot)));
+        let Some((class, slot)) = found else {
+            self.invalid_releases.fetch_add(1, Ordering::Relaxed);
+            return Err("Pointer is not a pool slot".to_string());
+        };
+        if class.state[slot].compare_exchange(SLOT_IN_USE, SLOT_FREE, Ordering::AcqRel, Ordering::Relaxed).is_err() {
+            self.invalid_releases.fetch_add(1, Ordering::Relaxed);
+            return Err("Slot is not in use".to_string());
+        }
+
+        unsafe {
+            memory::explicit_bzero(ptr, class.slot_size);
+        }
+        class.push(slot);
+        class.in_use.fetch_sub(1, Ordering::Relaxed);
+        self.releases.fetch_add(1, Ordering::Relaxed);
+        GLOBAL_POOL_COUNTERS.releases.fetch_add(1, Ordering::Relaxed);
+        Ok(())
+    }
+
+    /// Usable size of the slot at `ptr`, or 0 if it is not one of this pool's slots
+    pub fn slot_size(&self, ptr: *const u8) -> usize {
+        self.classes.iter().find(|c| c.slot_of(ptr).is_some()).map_or(0, |c| c.slot_size)
+    }
+
+    pub fn stats(&self) -> PoolStats {
+        let arenas = || self.classes.iter().filter_map(|c| c.arena.get().and_then(|a| a.as_ref().ok()));
+        PoolStats {
+            acquisitions: self.acquisitions.load(Ordering::Relaxed),
+            releases: self.releases.load(Ordering::Relaxed),
+            exhaustions: self.exhaustions.load(Ordering::Relaxed),
+            invalid_releases: self.invalid_releases.load(Ordering::Relaxed),
+            in_use: self.classes.iter().map(|c| c.in_use.load(Ordering::Relaxed)).sum(),
+            bytes_reserved: arenas().map(|a| a.slots_len as u64).sum(),
+            bytes_locked: arenas().filter(|a| a.locked).map(|a| a.slots_len as u64).sum(),
+        }
+    }
+}
+
+impl Drop for SecureBufferPool {
+    fn drop(&mut self) {
+        let locked = self.stats().bytes_locked;
+        GLOBAL_POOL_COUNTERS.bytes_locked.fetch_sub(locked, Ordering::Relaxed);
+    }
+}
+
+/// A pool slot that goes back (zeroized) to its pool when dropped
+pub struct PooledBuffer<'a> {
+    pool: &'a SecureBufferPool,
+    ptr: *mut u8,
+    len: usize,
+}
+
+impl PooledBuffer<'_> {
+    pub fn as_slice(&self) -> &[u8] {
+        unsafe { std::slice::from_raw_parts(self.ptr, self.len) }
+    }
+
+    pub fn as_mut_slice(&mut self) -> &mut [u8] {
+        unsafe { std::slice::from_raw_parts_mut(self.ptr, self.len) }
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+}
+
+impl Drop for PooledBuffer<'_> {
+    fn drop(&mut self) {
+        let _ = self.pool.release_raw(self.ptr);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_pool_acquire_release() {
+        let pool = SecureBufferPool::new(4096);
+        {
+            let mut key = pool.acquire(32).unwrap();
+            assert!(key.as_slice().iter().all(|&b| b == 0));
+            key.as_mut_slice().copy_from_slice(&[0xAB; 32]);
+            assert_eq!(pool.stats().in_use, 1);
+        }
+        // Released slots come back zeroized
+        let key = pool.acquire(20).unwrap();
+        assert!(key.as_slice().iter().all(|&b| b == 0));
+        drop(key);
+
+        // 4096 bytes of 4096-byte slots: one slot, then exhaustion
+        let big = pool.acquire_raw(3000).unwrap();
+        assert_eq!(pool.slot_size(big), 4096);
+        assert!(pool.acquire_raw(4096).is_none());
+        assert!(pool.acquire_raw(POOL_MAX_SLOT + 1).is_none());
+        pool.release_raw(big).unwrap();
+        assert!(pool.release_raw(big).is_err());
+        assert!(pool.release_raw(unsafe { big.add(1) }).is_err());
+
+        let stats = pool.stats();
+        assert_eq!(stats.in_use, 0);
+        assert_eq!(stats.exhaustions, 1);
+        assert_eq!(stats.invalid_releases, 2);
+        assert_eq!(stats.acquisitions, stats.releases);
+    }
+
+    #[test]
+    fn test_pool_concurrent_churn() {
+        let pool = SecureBufferPool::new(64 * 64);
+        std::thread::scope(|s| {
+            for t in 0..4u8 {
+                let pool = &pool;
+                s.spawn(move || {
+                    for _ in 0..2000 {
+                        if let Some(mut slot) = pool.acquire(64) {
+                            assert!(slot.as_slice().iter().all(|&b| b == 0));
+                            slot.as_mut_slice().fill(t + 1);
+                        }
+                    }
+                });
+            }
+        });
+        assert_eq!(pool.stats().in_use, 0);
+    }
+}
@@ -1,8 +1,11 @@
 // SPDX-License-Identifier: MIT
 // Bitcoin Sprint - SecureBuffer Entropy Integration
 
-use crate::{SecureBuffer, CSecureBuffer};
+use std::ffi::c_void;
+
+use crate::SecureBuffer;
 use crate::entropy;
+use crate::entropy_reservoir;
 
 impl SecureBuffer {
     /// Fill SecureBuffer with fast entropy (OS RNG + timing jitter)
@@ -38,80 +41,15 @@ pub fn fill_with_enterprise_entropy(&mut self, headers: &[Vec<u8>], additional_d
     /// Create a new SecureBuffer pre-filled with fast entropy
     pub fn new_with_fast_entropy(capacity: usize) -> Result<Self, String> {
         let mut buffer = Self::new(capacity)?;
-        
-    // Fill with entropy up to buffer capacity
-    #[allow(clippy::manual_div_ceil)]
-    let chunks = (capacity + 31) / 32; // Round up to cover full capacity
-        let mut offset = 0;
-        
-        for _ in 0..chunks {
-            let entropy_chunk = entropy::fast_entropy();
-            let remaining = capacity - offset;
-            let write_len = std::cmp::min(32, remaining);
-            
-            if offset == 0 {
-                // First write - use the write method which clears first
-                buffer.write(&entropy_chunk[..write_len])?;
-            } else {
-                // Subsequent writes - append to existing entropy
-                unsafe {
-                    if offset + write_len <= buffer.capacity {
-                        std::ptr::copy_nonoverlapping(
-                            entropy_chunk.as_ptr(),
-                            buffer.data.add(offset),
-                            write_len
-                        );
-                        buffer.length = offset + write_len;
-                    }
-                }
-            }
-            
-            offset += write_len;
-            if offset >= capacity {
-                break;
-            }
-        }
-        
+        let out = buffer.staged(&[], capacity)?;
+        entropy_reservoir::fill_entropy(out).map_err(|e| format!("Entropy unavailable: {:?}", e))?;
         Ok(buffer)
     }
 
     /// Create a new SecureBuffer pre-filled with hybrid entropy
     pub fn new_with_hybrid_entropy(capacity: usize, headers: &[Vec<u8>]) -> Result<Self, String> {
-        let mut buffer = Self::new(capacity)?;
-        
-    // Fill with hybrid entropy up to buffer capacity
-    #[allow(clippy::manual_div_ceil)]
-    let chunks = (capacity + 31) / 32;
-        let mut offset = 0;
-        
-    #[allow(clippy::needless_range_loop)]
-    for _ in 0..chunks {
-            let entropy_chunk = entropy::hybrid_entropy(headers);
-            let remaining = capacity - offset;
-            let write_len = std::cmp::min(32, remaining);
-            
-            if offset == 0 {
-                buffer.write(&entropy_chunk[..write_len])?;
-            } else {
-                unsafe {
-                    if offset + write_len <= buffer.capacity {
-                        std::ptr::copy_nonoverlapping(
-                            entropy_chunk.as_ptr(),
-                            buffer.data.add(offset),
-                            write_len
-                        );
-                        buffer.length = offset + write_len;
-                    }
-                }
-            }
-            
-            offset += write_len;
-            if offset >= capacity {
-                break;
-            }
-        }
-        
-        Ok(buffer)
+        entropy_reservoir::mix_headers(headers);
+        Self::new_with_fast_entropy(capacity)
     }
 
     /// Refresh buffer contents with new entropy (preserves capacity)
@@ -165,21 +103,16 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid, non-null pointer to a `CSecureBuffer` previously
-/// returned by one of the `securebuffer_*` constructors. The function will dereference
-/// the pointer and mutate the underlying buffer. The caller must ensure exclusive
+/// `buffer` must be a valid, non-null handle from a `securebuffer_new*` constructor.
+/// The function will dereference the pointer and mutate the underlying buffer. The caller must ensure exclusive
 /// access if called from multiple threads.
-pub unsafe extern "C" fn securebuffer_fill_fast_entropy(buffer: *mut CSecureBuffer) -> i32 {
+pub unsafe extern "C" fn securebuffer_fill_fast_entropy(buffer: *mut c_void) -> i32 {
     if buffer.is_null() {
         return -1;
     }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
     
-    let c_buffer = &mut *buffer;
-    if c_buffer.inner.is_null() {
-        return -1;
-    }
-    
-    match (*c_buffer.inner).fill_with_fast_entropy() {
+    match buffer.fill_with_fast_entropy() {
         Ok(()) => 0,
         Err(_) => -1,
     }
@@ -188,14 +121,13 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid, non-null pointer to a `CSecureBuffer` previously
-/// returned by one of the `securebuffer_*` constructors. `headers_ptr` (if non-null)
-/// must point to a contiguous memory region containing `headers_len` bytes split into
+/// `buffer` must be a valid, non-null handle from a `securebuffer_new*` constructor.
+/// `headers_ptr` (if non-null) must point to a contiguous memory region containing `headers_len` bytes split into
 /// `header_count` headers; callers must ensure these pointers and lengths are correct.
 /// The function will read from raw pointers and may allocate; caller must ensure
 /// memory validity for the duration of the call.
 pub unsafe extern "C" fn securebuffer_fill_hybrid_entropy(
-    buffer: *mut CSecureBuffer,
+    buffer: *mut c_void,
     headers_ptr: *const u8,
     headers_len: usize,
     header_count: usize,
@@ -203,11 +135,7 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
     if buffer.is_null() || headers_ptr.is_null() {
         return -1;
     }
-    
-    let c_buffer = &mut *buffer;
-    if c_buffer.inner.is_null() {
-        return -1;
-    }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
     
     // Parse headers from flattened byte array
     // Each header is assumed to be 80 bytes (Bitcoin block header size)
@@ -227,7 +155,7 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
         }
     }
     
-    match (*c_buffer.inner).fill_with_hybrid_entropy(&headers) {
+    match buffer.fill_with_hybrid_entropy(&headers) {
         Ok(()) => 0,
         Err(_) => -1,
     }
@@ -236,12 +164,12 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid, non-null pointer to a `CSecureBuffer`.
+/// `buffer` must be a valid, non-null handle from a `securebuffer_new*` constructor.
 /// `headers_ptr` and `additional_data_ptr` (if non-null) must point to valid memory
 /// regions described by their respective length parameters. All pointers must remain
 /// valid for the duration of the call. The caller retains ownership of the input data.
 pub unsafe extern "C" fn securebuffer_fill_enterprise_entropy(
-    buffer: *mut CSecureBuffer,
+    buffer: *mut c_void,
     headers_ptr: *const u8,
     headers_len: usize,
     header_count: usize,
@@ -251,11 +179,7 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
     if buffer.is_null() {
         return -1;
     }
-    
-    let c_buffer = &mut *buffer;
-    if c_buffer.inner.is_null() {
-        return -1;
-    }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
     
     // Parse headers
     let header_size = if headers_len > 0 && header_count > 0 {
@@ -283,7 +207,7 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
         &[]
     };
     
-    match (*c_buffer.inner).fill_with_enterprise_entropy(&headers, additional_data) {
+    match buffer.fill_with_enterprise_entropy(&headers, additional_data) {
         Ok(()) => 0,
         Err(_) => -1,
     }
@@ -292,16 +216,11 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
 #[no_mangle]
 /// # Safety
 ///
-/// The returned pointer must be freed by calling `securebuffer_free` (or the
-/// appropriate destructor). `capacity` must be a sane positive value.
-pub unsafe extern "C" fn securebuffer_new_with_fast_entropy(capacity: usize) -> *mut CSecureBuffer {
+/// The returned handle has the same layout as `securebuffer_new` and must be freed
+/// with `securebuffer_free`. `capacity` must be a sane positive value.
+pub unsafe extern "C" fn securebuffer_new_with_fast_entropy(capacity: usize) -> *mut c_void {
     match SecureBuffer::new_with_fast_entropy(capacity) {
-        Ok(buffer) => {
-            let boxed = Box::new(CSecureBuffer {
-                inner: Box::into_raw(Box::new(buffer)),
-            });
-            Box::into_raw(boxed)
-        }
+        Ok(buffer) => Box::into_raw(Box::new(buffer)) as *mut c_void,
         Err(_) => std::ptr::null_mut(),
     }
 }
@@ -311,13 +230,13 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
 ///
 /// `headers_ptr` (if non-null) must point to a memory region of `headers_len` bytes
 /// split into `header_count` headers; callers must ensure memory is valid for the
-/// duration of this call. The returned pointer must be freed by the caller.
+/// duration of this call. The returned handle must be freed with `securebuffer_free`.
 pub unsafe extern "C" fn securebuffer_new_with_hybrid_entropy(
     capacity: usize,
     headers_ptr: *const u8,
     headers_len: usize,
     header_count: usize,
-) -> *mut CSecureBuffer {
+) -> *mut c_void {
     let header_size = if headers_len > 0 && header_count > 0 {
         headers_len / header_count
     } else {
@@ -337,12 +256,7 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
     }
     
     match SecureBuffer::new_with_hybrid_entropy(capacity, &headers) {
-        Ok(buffer) => {
-            let boxed = Box::new(CSecureBuffer {
-                inner: Box::into_raw(Box::new(buffer)),
-            });
-            Box::into_raw(boxed)
-        }
+        Ok(buffer) => Box::into_raw(Box::new(buffer)) as *mut c_void,
         Err(_) => std::ptr::null_mut(),
     }
 }
@@ -350,19 +264,14 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid, non-null pointer to a `CSecureBuffer` previously
-/// returned by one of the constructors. The function may mutate the buffer contents.
-pub unsafe extern "C" fn securebuffer_refresh_entropy(buffer: *mut CSecureBuffer) -> i32 {
+/// `buffer` must be a valid, non-null handle from a `securebuffer_new*` constructor. The function may mutate the buffer contents.
+pub unsafe extern "C" fn securebuffer_refresh_entropy(buffer: *mut c_void) -> i32 {
     if buffer.is_null() {
         return -1;
     }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
     
-    let c_buffer = &mut *buffer;
-    if c_buffer.inner.is_null() {
-        return -1;
-    }
-    
-    match (*c_buffer.inner).refresh_entropy() {
+    match buffer.refresh_entropy() {
         Ok(()) => 0,
         Err(_) => -1,
     }
@@ -371,11 +280,11 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
 #[no_mangle]
 /// # Safety
 ///
-/// `buffer` must be a valid, non-null `CSecureBuffer` pointer. `headers_ptr` (if
+/// `buffer` must be a valid, non-null handle from a `securebuffer_new*` constructor. `headers_ptr` (if
 /// non-null) must point to valid header data as described by `headers_len` and
 /// `header_count`. The function will read from these pointers and mutate the buffer.
 pub unsafe extern "C" fn securebuffer_mix_entropy(
-    buffer: *mut CSecureBuffer,
+    buffer: *mut c_void,
     headers_ptr: *const u8,
     headers_len: usize,
     header_count: usize,
@@ -383,11 +292,7 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
     if buffer.is_null() {
         return -1;
     }
-    
-    let c_buffer = &mut *buffer;
-    if c_buffer.inner.is_null() {
-        return -1;
-    }
+    let buffer = &mut *(buffer as *mut SecureBuffer);
     
     let header_size = if headers_len > 0 && header_count > 0 {
         headers_len / header_count
@@ -407,7 +312,7 @@ pub fn mix_entropy(&mut self, headers: &[Vec<u8>]) -> Result<(), String> {
         }
     }
     
-    match (*c_buffer.inner).mix_entropy(&headers) {
+    match buffer.mix_entropy(&headers) {
         Ok(()) => 0,
         Err(_) => -1,
     }
@@ -486,4 +391,22 @@ fn test_mix_entropy() {
         // Should be different after mixing
         assert_ne!(initial_data, mixed_data);
     }
+
+    #[test]
+    fn test_ffi_handles_share_securebuffer_layout() {
+        // Entropy constructors hand out the same handle as securebuffer_new, so the
+        // generic accessors and securebuffer_free work on them
+        unsafe {
+            let handle = securebuffer_new_with_fast_entropy(48);
+            assert!(!handle.is_null());
+            assert_eq!(crate::securebuffer_len(handle), 48);
+            assert_eq!(securebuffer_refresh_entropy(handle), 0);
+            crate::securebuffer_free(handle);
+
+            let plain = crate::securebuffer_new(32);
+            assert_eq!(securebuffer_fill_fast_entropy(plain), 0);
+            assert_eq!((*(plain as *const SecureBuffer)).len(), 32);
+            crate::securebuffer_free(plain);
+        }
+    }
 }
@@ -0,0 +1,525 @@
+// SPDX-License-Identifier: MIT
+// Bitcoin Sprint - Shared-memory record ring
+// A lock-free ring of variable-length records in a sealed, locked memfd, so cooperating
+// processes pass headers and payloads through shared pages instead of a loopback socket.
+// One consumer; one producer (Spsc) or any number across processes (Mpsc). Waiting uses
+// futexes on words in the shared header, so neither side needs an extra fd.
+//
+// Records are 8-byte aligned: a state word, a length word, then the payload. A record never
+// straddles the end of the ring; the producer writes a pad record instead. Producers publish
+// by storing the state word last, and the consumer wipes everything it releases, which
+// keeps stale state words from looking committed and leaves no secrets behind.
+
+use std::os::fd::RawFd;
+use std::sync::atomic::{fence, AtomicBool, AtomicU32, AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
+use crate::memory;
+
+const RING_MAGIC: u64 = 0x5342_5249_4e47_0001; // "SBRING" v1
+const RING_VERSION: u32 = 1;
+const HEADER_BYTES: usize = 4096;
+const RECORD_HEADER: usize = 8;
+
+// A zero state word (wiped, or reserved and not yet published) ends the readable run
+const STATE_DATA: u32 = 1;
+const STATE_PAD: u32 = 2;
+
+/// Smallest and largest data area
+pub const RING_MIN_CAPACITY: usize = 4096;
+pub const RING_MAX_CAPACITY: usize = 1 << 30;
+
+#[derive(Debug, thiserror::Error, PartialEq, Eq)]
+pub enum RingError {
+    #[error("Capacity must be a power of two between 4 KiB and 1 GiB")]
+    InvalidCapacity,
+    #[error("Record does not fit in the ring")]
+    RecordTooLarge,
+    #[error("Ring is full")]
+    Full,
+    #[error("File descriptor is not a compatible sealed ring")]
+    Incompatible,
+    #[error("Ring holds a malformed record")]
+    Corrupt,
+    #[error("System call failed: {0}")]
+    Os(String),
+}
+
+/// Producer discipline, fixed when the ring is created
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum RingMode {
+    /// Exactly one producer; reservation is a plain store
+    Spsc = 0,
+    /// Producers in any thread or process reserve with a CAS
+    Mpsc = 1,
+}
+
+#[repr(C, align(64))]
+struct Padded<T>(T);
+
+/// A futex word and the count of sleepers on it
+#[repr(C)]
+struct FutexPair {
+    seq: AtomicU32,
+    waiting: AtomicU32,
+}
+
+/// Lives in the first page of the mapping, shared by every attached process
+#[repr(C)]
+struct RingHeader {
+    magic: u64,
+    version: u32,
+    mode: u32,
+    capacity: u64,
+    /// Next byte producers reserve (monotonic)
+    head: Padded<AtomicU64>,
+    /// First byte not yet released by the consumer (monotonic)
+    tail: Padded<AtomicU64>,
+    /// Bumped on every publish; the consumer's futex word
+    data_seq: Padded<FutexPair>,
+    /// Bumped on every release; producers' futex word
+    space_seq: Padded<FutexPair>,
+}
+
+const _: () = assert!(std::mem::size_of::<RingHeader>() <= HEADER_BYTES);
+
+fn os_error(call: &str) -> RingError {
+    RingError::Os(format!("{}: {}", call, std::io::Error::last_os_error()))
+}
+
+fn futex_wait(word: &AtomicU32, expected: u32, timeout: Option<Duration>) {
+    let ts = timeout.map(|t| libc::timespec { tv_sec: t.as_secs() as libc::time_t, tv_nsec: t.subsec_nanos() as libc::c_long });
+    let ts_ptr = ts.as_ref().map_or(std::ptr::null(), |t| t as *const libc::timespec);
+    // Not FUTEX_PRIVATE: waiters and wakers may be in different processes
+    unsafe {
+        libc::syscall(libc::SYS_futex, word.as_ptr(), libc::FUTEX_WAIT, expected, ts_ptr, std::ptr::null::<u32>(), 0);
+    }
+}
+
+fn futex_wake(word: &AtomicU32, count: i32) {
+    unsafe {
+        libc::syscall(libc::SYS_futex, word.as_ptr(), libc::FUTEX_WAKE, count, std::ptr::null::<libc::timespec>(), std::ptr::null::<u32>(), 0);
+    }
+}
+
+fn record_size(len: usize) -> usize {
+    RECORD_HEADER + ((len + 7) & !7)
+}
+
+/// One process's mapping of a ring. Any number of handles may produce (Mpsc); only one
+/// handle across all processes may consume.
+pub struct ShmRing {
+    fd: RawFd,
+    map: *mut u8,
+    map_len: usize,
+    mask: u64,
+    locked: bool,
+    /// Consumer read cursor: records before it are peeked but not yet released
+    read_pos: AtomicU64,
+    /// Set once the consumer finds a malformed record; the ring is not read past it
+    poisoned: AtomicBool,
+}
+
+unsafe impl Send for ShmRing {}
+unsafe impl Sync for ShmRing {}
+
+impl ShmRing {
+    /// Create a ring with `capacity` data bytes in a new sealed memfd
+    pub fn create(capacity: usize, mode: RingMode) -> Result<Self, RingError> {
+        if !capacity.is_power_of_two() || !(RING_MIN_CAPACITY..=RING_MAX_CAPACITY).contains(&capacity) {
+            return Err(RingError::InvalidCapacity);
+        }
+        let map_len = HEADER_BYTES + capacity;
+        let fd = unsafe { libc::memfd_create(c"securebuffer-ring".as_ptr(), libc::MFD_CLOEXEC | libc::MFD_ALLOW_SEALING) };
+        if fd < 0 {
+            return Err(os_error("memfd_create"));
+        }
+        let sealed = unsafe {
+            libc::ftruncate(fd, map_len as libc::off_t) == 0
+                && libc::fcntl(fd, libc::F_ADD_SEALS, libc::F_SEAL_SHRINK | libc::F_SEAL_GROW | libc::F_SEAL_SEAL) == 0
+        };
+        if !sealed {
+            let err = os_error("memfd seal");
+            unsafe { libc::close(fd) };
+            return Err(err);
+        }
+        let ring = Self::map(fd, map_len)?;
+        let header = ring.header_mut_raw();
+        unsafe {
+            (*header).mode = mode as u32;
+            (*header).capacity = capacity as u64;
+            (*header).version = RING_VERSION;
+            // Magic last: an attach racing creation sees an incompatible ring, not a torn one
+            std::ptr::write_volatile(&mut (*header).magic, RING_MAGIC);
+        }
+        Ok(ring)
+    }
+
+    /// Map a ring created elsewhere, e.g. from an fd received over a Unix socket or opened
+    /// through /proc/<pid>/fd. The fd is duplicated; the caller keeps its own.
+    pub fn attach(fd: RawFd) -> Result<Self, RingError> {
+        let seals = unsafe { libc::fcntl(fd, libc::F_GET_SEALS) };
+        if seals < 0 || seals & (libc::F_SEAL_SHRINK | libc::F_SEAL_GROW) != libc::F_SEAL_SHRINK | libc::F_SEAL_GROW {
+            return Err(RingError::Incompatible);
+        }
+        let mut st: libc::stat = unsafe { std::mem::zeroed() };
+        if unsafe { libc::fstat(fd, &mut st) } != 0 {
+            return Err(os_error("fstat"));
+        }
+        let map_len = st.st_size as usize;
+        if map_len < HEADER_BYTES + RING_MIN_CAPACITY {
+            return Err(RingError::Incompatible);
+        }
+        let dup = unsafe { libc::fcntl(fd, libc::F_DUPFD_CLOEXEC, 0) };
+        if dup < 0 {
+            return Err(os_error("dup"));
+        }
+        let ring = Self::map(dup, map_len)?;
+        let header = ring.header();
+        if header.magic != RING_MAGIC || header.version != RING_VERSION || header.capacity as usize + HEADER_BYTES != map_len
+            || header.mode > RingMode::Mpsc as u32
+        {
+            return Err(RingError::Incompatible);
+        }
+        ring.read_pos.store(header.tail.0.load(Ordering::Acquire), Ordering::Relaxed);
+        Ok(ring)
+    }
+
+    /// Takes ownership of `fd`, closing it on failure
+    fn map(fd: RawFd, map_len: usize) -> Result<Self, RingError> {
+        let map = unsafe {
+            libc::mmap(std::ptr::null_mut(), map_len, libc::PROT_READ | libc::PROT_WRITE, libc::MAP_SHARED, fd, 0)
+        };
+        if map == libc::MAP_FAILED {
+            let err = os_error("mmap");
+            unsafe { libc::close(fd) };
+            return Err(err);
+        }
+        unsafe { libc::madvise(map, map_len, libc::MADV_DONTDUMP) };
+        let locked = unsafe { memory::lock_memory(map as *mut u8, map_len) }.is_ok();
+        let capacity = (map_len - HEADER_BYTES) as u64;
+        Ok(Self { fd, map: map as *mut u8, map_len, mask: capacity.wrapping_sub(1), locked, read_pos: AtomicU64::new(0), poisoned: AtomicBool::new(false) })
+    }
+
+    fn header_mut_raw(&self) -> *mut RingHeader {
+        self.map as *mut RingHeader
+    }
+
+    fn header(&self) -> &RingHeader {
+        unsafe { &*(self.map as *const RingHeader) }
+    }
+
+    fn data(&self) -> *mut u8 {
+        unsafe { self.map.add(HEADER_BYTES) }
+    }
+
+    fn state_at(&self, pos: u64) -> &AtomicU32 {
+        unsafe { &*(self.data().add((pos & self.mask) as usize) as *const AtomicU32) }
+    }
+
+    fn len_at(&self, pos: u64) -> *mut u32 {
+        unsafe { self.data().add((pos & self.mask) as usize + 4) as *mut u32 }
+    }
+
+    /// The memfd to hand to other processes
+    pub fn fd(&self) -> RawFd {
+        self.fd
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.map_len - HEADER_BYTES
+    }
+
+    pub fn mode(&self) -> RingMode {
+        if self.header().mode == RingMode::Mpsc as u32 { RingMode::Mpsc } else { RingMode::Spsc }
+    }
+
+    /// Largest payload one record can carry
+    pub fn max_record(&self) -> usize {
+        self.capacity() / 2 - RECORD_HEADER
+    }
+
+    /// Bytes reserved by producers and not yet released by the consumer
+    pub fn used(&self) -> usize {
+        let header = self.header();
+        (header.head.0.load(Ordering::Acquire) - header.tail.0.load(Ordering::Acquire)) as usize
+    }
+
+    /// Reserve room for a `len`-byte record: returns its position, after writing a pad
+    /// record if it would straddle the end of the ring
+    fn reserve(&self, len: usize) -> Result<u64, RingError> {
+        if len > self.max_record() {
+            return Err(RingError::RecordTooLarge);
+        }
+        let header = self.header();
+        let size = record_size(len) as u64;
+        let capacity = self.capacity() as u64;
+        let mpsc = header.mode == RingMode::Mpsc as u32;
+        let mut head = header.head.0.load(Ordering::Relaxed);
+        loop {
+            let to_end = capacity - (head & self.mask);
+            let pad = if size > to_end { to_end } else { 0 };
+            let tail = header.tail.0.load(Ordering::Acquire);
+            if head + pad + size - tail > capacity {
+                return Err(RingError::Full);
+            }
+            if mpsc {
+                if let Err(current) = header.head.0.compare_exchange_weak(head, head + pad + size, Ordering::AcqRel, Ordering::Relaxed) {
+                    head = current;
+                    continue;
+                }
+            } else {
+                header.head.0.store(head + pad + size, Ordering::Release);
+            }
+            if pad > 0 {
+                unsafe { *self.len_at(head) = (pad as usize - RECORD_HEADER) as u32 };
+                self.state_at(head).store(STATE_PAD, Ordering::Release);
+            }
+            return Ok(head + pad);
+        }
+    }
+
+    fn publish(&self, pos: u64, len: usize) {
+        unsafe { *self.len_at(pos) = len as u32 };
+        self.state_at(pos).store(STATE_DATA, Ordering::Release);
+        let futex = &self.header().data_seq.0;
+        futex.seq.fetch_add(1, Ordering::SeqCst);
+        if futex.waiting.load(Ordering::SeqCst) != 0 {
+            futex_wake(&futex.seq, 1);
+        }
+    }
+
+    /// Append one record built in place by `fill`, without blocking
+    pub fn try_push_with(&self, len: usize, fill: impl FnOnce(&mut [u8])) -> Result<(), RingError> {
+        let pos = self.reserve(len)?;
+        let payload = unsafe {
+            std::slice::from_raw_parts_mut(self.data().add((pos & self.mask) as usize + RECORD_HEADER), len)
+        };
+        fill(payload);
+        self.publish(pos, len);
+        Ok(())
+    }
+
+    /// Append the concatenation of `parts` as one record, waiting up to `timeout` for room
+    /// (None waits forever, zero never waits)
+    pub fn push_vectored(&self, parts: &[&[u8]], timeout: Option<Duration>) -> Result<(), RingError> {
+        let len = parts.iter().map(|p| p.len()).sum();
+        let fill = |out: &mut [u8]| {
+            let mut offset = 0;
+            for part in parts {
+                out[offset..offset + part.len()].copy_from_slice(part);
+                offset += part.len();
+            }
+        };
+        self.wait_until(timeout, &self.header().space_seq.0, || match self.try_push_with(len, fill) {
+            Err(RingError::Full) => None,
+            other => Some(other),
+        })
+        .unwrap_or(Err(RingError::Full))
+    }
+
+    pub fn push(&self, data: &[u8], timeout: Option<Duration>) -> Result<(), RingError> {
+        self.push_vectored(&[data], timeout)
+    }
+
+    /// Retry `attempt` until it yields, sleeping on the futex pair between tries
+    fn wait_until<T>(&self, timeout: Option<Duration>, futex: &FutexPair, mut attempt: impl FnMut() -> Option<T>) -> Option<T> {
+        if let Some(done) = attempt() {
+            return Some(done);
+        }
+        let deadline = timeout.map(|t| Instant::now() + t);
+        let FutexPair { seq, waiting } = futex;
+        loop {
+            let remaining = match deadline {
+                Some(d) => match d.checked_duration_since(Instant::now()) {
+                    Some(r) if !r.is_zero() => Some(r),
+                    _ => return None,
+                },
+                None => None,
+            };
+            let expected = seq.load(Ordering::SeqCst);
+            waiting.fetch_add(1, Ordering::SeqCst);
+            fence(Ordering::SeqCst);
+            let done = attempt();
+            if done.is_none() {
+                futex_wait(seq, expected, remaining);
+            }
+            waiting.fetch_sub(1, Ordering::SeqCst);
+            if let Some(done) = done.or_else(&mut attempt) {
+                return Some(done);
+            }
+        }
+    }
+
+    /// Consumer: up to `max` committed records past the read cursor, in order, as slices
+    /// into the shared mapping. Their space stays reserved until `release`.
+    ///
+    /// Lengths come from another process and are checked before use: a record that would
+    /// run past the ring or past the reserved head poisons this handle. The records before
+    /// it are still returned; once none are left, every call fails with `Corrupt`.
+    pub fn peek_batch(&self, max: usize, out: &mut Vec<(*const u8, usize)>) -> Result<usize, RingError> {
+        if self.poisoned.load(Ordering::Relaxed) {
+            return Err(RingError::Corrupt);
+        }
+        let capacity = self.capacity() as u64;
+        let mut pos = self.read_pos.load(Ordering::Relaxed);
+        let head = self.header().head.0.load(Ordering::Acquire);
+        let mut taken = 0;
+        while taken < max && pos < head {
+            let state = self.state_at(pos).load(Ordering::Acquire);
+            let len = unsafe { std::ptr::read_volatile(self.len_at(pos)) } as usize;
+            match state {
+                STATE_DATA => {
+                    if len > self.max_record()
+                        || (pos & self.mask) + record_size(len) as u64 > capacity
+                        || pos + record_size(len) as u64 > head
+                    {
+                        self.poisoned.store(true, Ordering::Relaxed);
+                        break;
+                    }
+                    let payload = unsafe { self.data().add((pos & self.mask) as usize + RECORD_HEADER) };
+                    out.push((payload as *const u8, len));
+                    taken += 1;
+                    pos += record_size(len) as u64;
+                }
+                STATE_PAD => pos += capacity - (pos & self.mask),
+                // Later records wait behind one that is still being written
+                _ => break,
+            }
+        }
+        self.read_pos.store(pos, Ordering::Relaxed);
+        if taken == 0 && self.poisoned.load(Ordering::Relaxed) {
+            return Err(RingError::Corrupt);
+        }
+        Ok(taken)
+    }
+
+    /// Consumer: wait up to `timeout` for at least one record, then peek like `peek_batch`
+    pub fn wait_batch(&self, max: usize, timeout: Option<Duration>, out: &mut Vec<(*const u8, usize)>) -> Result<usize, RingError> {
+        self.wait_until(timeout, &self.header().data_seq.0, || match self.peek_batch(max, out) {
+            Ok(0) => None,
+            other => Some(other),
+        })
+        .unwrap_or(Ok(0))
+    }
+
+    /// Consumer: wipe and free everything peeked so far; earlier slices become invalid
+    pub fn release(&self) {
+        let header = self.header();
+        let tail = header.tail.0.load(Ordering::Relaxed);
+        let end = self.read_pos.load(Ordering::Relaxed);
+        if end == tail {
+            return;
+        }
+        let (start, len) = ((tail & self.mask) as usize, (end - tail) as usize);
+        let first = len.min(self.capacity() - start);
+        unsafe {
+            memory::explicit_bzero(self.data().add(start), first);
+            memory::explicit_bzero(self.data(), len - first);
+        }
+        header.tail.0.store(end, Ordering::Release);
+        let futex = &header.space_seq.0;
+        futex.seq.fetch_add(1, Ordering::SeqCst);
+        if futex.waiting.load(Ordering::SeqCst) != 0 {
+            futex_wake(&futex.seq, i32::MAX);
+        }
+    }
+
+    /// Consumer: hand up to `max` records to `f` in order, then release them. Waits up to
+    /// `timeout` when the ring is empty; returns the number delivered.
+    pub fn read_batch(&self, max: usize, timeout: Option<Duration>, mut f: impl FnMut(&[u8])) -> Result<usize, RingError> {
+        let mut records = Vec::with_capacity(max.min(64));
+        let n = self.wait_batch(max, timeout, &mut records)?;
+        for &(ptr, len) in &records {
+            f(unsafe { std::slice::from_raw_parts(ptr, len) });
+        }
+        self.release();
+        Ok(n)
+    }
+}
+
+impl Drop for ShmRing {
+    fn drop(&mut self) {
+        unsafe {
+            if self.locked {
+                let _ = memory::unlock_memory(self.map, self.map_len);
+            }
+            libc::munmap(self.map as *mut libc::c_void, self.map_len);
+            libc::close(self.fd);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::Arc;
+
+    #[test]
+    fn test_shm_ring_mpsc_across_mappings() {
+        assert_eq!(ShmRing::create(1000, RingMode::Spsc).err(), Some(RingError::InvalidCapacity));
+
+        let producer = Arc::new(ShmRing::create(RING_MIN_CAPACITY, RingMode::Mpsc).unwrap());
+        // A second mapping of the same memfd stands in for the consumer process
+        let consumer = ShmRing::attach(producer.fd()).unwrap();
+        assert_eq!(consumer.mode(), RingMode::Mpsc);
+        assert_eq!(producer.push(&vec![0u8; producer.max_record() + 1], Some(Duration::ZERO)), Err(RingError::RecordTooLarge));
+
+        // Four producers, 2000 variable-length records each, through a ring far smaller than
+        // the total, so records wrap, pad and wait for space
+        const PER_PRODUCER: u32 = 2000;
+        let handles: Vec<_> = (0..4u32)
+            .map(|p| {
+                let ring = Arc::clone(&producer);
+                std::thread::spawn(move || {
+                    for i in 0..PER_PRODUCER {
+                        let body = vec![(i % 251) as u8; (i % 300) as usize];
+                        ring.push_vectored(&[&p.to_le_bytes(), &i.to_le_bytes(), &body], None).unwrap();
+                    }
+                })
+            })
+            .collect();
+
+        let mut next = [0u32; 4];
+        let mut received = 0;
+        while received < 4 * PER_PRODUCER {
+            received += consumer.read_batch(32, Some(Duration::from_secs(5)), |record| {
+                let p = u32::from_le_bytes(record[..4].try_into().unwrap()) as usize;
+                let i = u32::from_le_bytes(record[4..8].try_into().unwrap());
+                // Per-producer order is preserved
+                assert_eq!(i, next[p]);
+                assert_eq!(record.len(), 8 + (i % 300) as usize);
+                assert!(record[8..].iter().all(|&b| b == (i % 251) as u8));
+                next[p] += 1;
+            }).unwrap() as u32;
+        }
+        for handle in handles {
+            handle.join().unwrap();
+        }
+        assert_eq!(next, [PER_PRODUCER; 4]);
+        assert_eq!(consumer.used(), 0);
+
+        // Empty ring: a bounded wait returns nothing
+        assert_eq!(consumer.read_batch(8, Some(Duration::from_millis(10)), |_| panic!()), Ok(0));
+        // Full ring: a non-blocking push fails fast
+        let ring = ShmRing::create(RING_MIN_CAPACITY, RingMode::Spsc).unwrap();
+        let record = vec![1u8; 1000];
+        while ring.push(&record, Some(Duration::ZERO)).is_ok() {}
+        assert_eq!(ring.push(&record, Some(Duration::ZERO)), Err(RingError::Full));
+    }
+
+    #[test]
+    fn test_shm_ring_rejects_malformed_lengths() {
+        let producer = ShmRing::create(RING_MIN_CAPACITY, RingMode::Spsc).unwrap();
+        let consumer = ShmRing::attach(producer.fd()).unwrap();
+        producer.push(b"first", None).unwrap();
+        producer.push(b"second", None).unwrap();
+        // A faulty producer rewrites the second record's length to run off the ring
+        unsafe { *producer.len_at(record_size(5) as u64) = u32::MAX };
+
+        let mut seen = Vec::new();
+        assert_eq!(consumer.read_batch(8, Some(Duration::ZERO), |r| seen.push(r.to_vec())), Ok(1));
+        assert_eq!(seen, vec![b"first".to_vec()]);
+        assert_eq!(consumer.read_batch(8, Some(Duration::ZERO), |_| panic!()), Err(RingError::Corrupt));
+    }
+}